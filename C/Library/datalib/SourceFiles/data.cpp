@@ -17,6 +17,79 @@
 /*-----------------------------------------------------------------------*/ 
 
 #include "data.h"
+#include <stdarg.h>
+
+static int   data_verbose = 1;
+static FILE *data_stream  = NULL;   // NULL = stdout
+
+//----------------------------------------------------------------------
+// Progress and information messages (file names, table differences,
+// computation reports) go through data_message so that a batch program
+// can turn them off.  Errors and warnings of the library go through
+// data_error and are always printed.  Both are written to stdout unless
+// data_set_stream chooses another stream (stderr for a program that
+// writes its results to stdout).
+//----------------------------------------------------------------------
+void data_set_verbose(int verbose){
+	data_verbose = verbose;
+}
+
+void data_set_stream(FILE *pStream){
+	data_stream = pStream;
+}
+
+void data_message(const char *format, ...){
+	va_list args;
+
+	if( 0 == data_verbose ){
+		return;
+	}
+	va_start(args, format);
+	vfprintf((NULL == data_stream) ? stdout : data_stream, format, args);
+	va_end(args);
+}
+
+void data_error(const char *format, ...){
+	va_list args;
+
+	va_start(args, format);
+	vfprintf((NULL == data_stream) ? stdout : data_stream, format, args);
+	va_end(args);
+}
+
+//----------------------------------------------------------------------
+// Parse an XML file whose root has the element tag.  XMLNode::
+// openFileHelper stops the program on a missing or malformed file;
+// here the error is printed and -1 returned so that a reload of the
+// element tables (or a profile) can be rejected instead.
+//----------------------------------------------------------------------
+int data_parse_xml(char *filename, const char *tag, XMLNode *pMainNode){
+	XMLResults results;
+	FILE *pFile;
+	char buffer[200];
+	int Nbytes;
+
+	//---------------------------------------------------
+	// Guess the character encoding from the first bytes,
+	// as openFileHelper does
+	//---------------------------------------------------
+	pFile = fopen(filename,"rb");
+	if( NULL != pFile ){
+		Nbytes = (int)fread(buffer,1,sizeof(buffer),pFile);
+		XMLNode::setGlobalOptions(XMLNode::guessCharEncoding(buffer,Nbytes));
+		fclose(pFile);
+	}
+	*pMainNode = XMLNode::parseFile(filename, NULL, &results);
+	if( eXMLErrorNone != results.error ){
+		data_error("Error : %s: %s at line %d, column %d\n",filename,XMLNode::getError(results.error),results.nLine,results.nColumn);
+		return -1;
+	}
+	if( pMainNode->getChildNode(tag).isEmpty() ){
+		data_error("Error : %s has no <%s> element\n",filename,tag);
+		return -1;
+	}
+	return 0;
+}
 
 void data_normalize_fractions(struct element_list *pElements){
 	int Nentries;
@@ -43,7 +116,39 @@ void data_normalize_fractions(struct element_list *pElements){
 }
 
 
-void data_read_UserIsotopes(char *path, char *filename, struct element_list *pElements){
+//----------------------------------------------------------------------
+// Free the memory allocated by data_read_NIST and data_read_AtomTabl
+//----------------------------------------------------------------------
+void data_free_elements(struct element_list *pElements){
+	int element_index;
+	int iso_index;
+
+	for(element_index=0; element_index<ELEMENT_TOTAL; element_index++){
+		for(iso_index=0; iso_index<pElements->Element[element_index].IsotopeTotal; iso_index++){
+			free(pElements->Element[element_index].Isotope[iso_index]->Name);
+			free(pElements->Element[element_index].Isotope[iso_index]->Symbol);
+			free(pElements->Element[element_index].Isotope[iso_index]);
+		}
+		free(pElements->Element[element_index].Isotope);
+		free(pElements->Element[element_index].NonzeroIsotopeIndex);
+		free(pElements->Element[element_index].Name);
+		free(pElements->Element[element_index].Symbol);
+		pElements->Element[element_index].Isotope             = NULL;
+		pElements->Element[element_index].IsotopeTotal        = 0;
+		pElements->Element[element_index].NonzeroIsotopeIndex = NULL;
+		pElements->Element[element_index].NonzeroIsotopeTotal = 0;
+		pElements->Element[element_index].Name                = NULL;
+		pElements->Element[element_index].Symbol              = NULL;
+	}
+}
+
+
+//----------------------------------------------------------------------
+// Returns 0, or -1 if the file is missing or malformed or names an
+// element that does not exist (the element list may then be partly
+// updated and should be discarded)
+//----------------------------------------------------------------------
+int data_read_UserIsotopes(char *path, char *filename, struct element_list *pElements){
 	char *pathfilename;
 	char name[30];
 	XMLNode xMainNode,xNode,xNode2;
@@ -65,17 +170,21 @@ void data_read_UserIsotopes(char *path, char *filename, struct element_list *pEl
 	//---------------------------------------------------
 	pathfilename = (char *)malloc((strlen(path)+strlen(filename)+30)*sizeof(char));
 	strcpy(pathfilename,path);
-	strcat(pathfilename,"\\");
+	strcat(pathfilename,DATA_PATH_SEPARATOR);
 	strcat(pathfilename,filename);
-	printf("Reading pathfile: %s\n",pathfilename);
-	printf("Reading file: %s\n",filename);
+	data_message("Reading pathfile: %s\n",pathfilename);
+	data_message("Reading file: %s\n",filename);
 
 	//---------------------------------------------------
     // Open and parse the XML file:
 	//---------------------------------------------------
 	time0 = clock();
-    xMainNode=XMLNode::openFileHelper(pathfilename);
+	if( 0 != data_parse_xml(pathfilename, "user_isotopes", &xMainNode) ){
+		free(pathfilename);
+		return -1;
+	}
 	time1 = clock();
+	free(pathfilename);
 
 	//---------------------------------------------------
 	// Count how many Element entries there are
@@ -90,13 +199,20 @@ void data_read_UserIsotopes(char *path, char *filename, struct element_list *pEl
 		// Get Atomic Number
 		//--------------------------------------------------------------------
 		xNode = xMainNode.getChildNode("user_isotopes").getChildNode("element",Eindex).getChildNode("atomic_number");
-		AtomicNumber = atoi(xNode.getText());
+		AtomicNumber = (NULL == xNode.getText()) ? -1 : atoi(xNode.getText());
+		if( (AtomicNumber < 0) || (AtomicNumber >= ELEMENT_TOTAL) ){
+			data_error("Error : %s: element %d has no valid atomic number\n",filename,Eindex+1);
+			return -1;
+		}
 		//printf("Atomic Number = %d\n",AtomicNumber);
 		//--------------------------------------------------------------------
 		// Get Element Name
 		//--------------------------------------------------------------------
 		xNode = xMainNode.getChildNode("user_isotopes").getChildNode("element",Eindex).getChildNode("name");
-		strcpy(name,xNode.getText());
+		name[0] = '\0';
+		if( NULL != xNode.getText() ){
+			strncat(name,xNode.getText(),sizeof(name)-1);
+		}
 		//printf("    Name   = %s\n",name);
 		//--------------------------------------------------------------------
 		// Get Element Symbol
@@ -112,6 +228,10 @@ void data_read_UserIsotopes(char *path, char *filename, struct element_list *pEl
 			// Get Mass Number
 			//--------------------------------------------------------------------
 			xNode = xMainNode.getChildNode("user_isotopes").getChildNode("element",Eindex).getChildNode("isotope",iso_index).getChildNode("mass_number");
+			if( NULL == xNode.getText() ){
+				data_error("Error : %s: an isotope of element %d has no mass number\n",filename,AtomicNumber);
+				return -1;
+			}
 			MassNumber = atoi(xNode.getText());
 			//printf("    MassNumber = %d\n",MassNumber);
 			//--------------------------------------------------------------------
@@ -120,7 +240,7 @@ void data_read_UserIsotopes(char *path, char *filename, struct element_list *pEl
 			Nmass = xMainNode.getChildNode("user_isotopes").getChildNode("element",Eindex).getChildNode("isotope",iso_index).nChildNode("mass");
 			if(1 == Nmass){
 			    xNode = xMainNode.getChildNode("user_isotopes").getChildNode("element",Eindex).getChildNode("isotope",iso_index).getChildNode("mass");
-			    imass = atof(xNode.getText());
+			    imass = (NULL == xNode.getText()) ? 0 : atof(xNode.getText());
 			}
 			//--------------------------------------------------------------------
 			// Get Fraction if present
@@ -128,7 +248,7 @@ void data_read_UserIsotopes(char *path, char *filename, struct element_list *pEl
 			Nfraction = xMainNode.getChildNode("user_isotopes").getChildNode("element",Eindex).getChildNode("isotope",iso_index).nChildNode("fraction");
 			if(1 == Nfraction){
 				xNode = xMainNode.getChildNode("user_isotopes").getChildNode("element",Eindex).getChildNode("isotope",iso_index).getChildNode("fraction");
-				ifraction = atof(xNode.getText());
+				ifraction = (NULL == xNode.getText()) ? 0 : atof(xNode.getText());
 				//printf("    fraction = %f\n",ifraction);
 			}
 			//--------------------------------------------------------------------
@@ -140,14 +260,14 @@ void data_read_UserIsotopes(char *path, char *filename, struct element_list *pEl
 					if( 1 == Nfraction){
 						fraction = pElements->Element[AtomicNumber].Isotope[i]->CompositionFraction;
 						if( fraction != ifraction ){
-							printf("The composition fraction for %s (atomic number %d, mass number %d) has been changed from %f to %f\n",name,AtomicNumber,MassNumber,pElements->Element[AtomicNumber].Isotope[i]->CompositionFraction,ifraction);
+							data_message("The composition fraction for %s (atomic number %d, mass number %d) has been changed from %f to %f\n",name,AtomicNumber,MassNumber,pElements->Element[AtomicNumber].Isotope[i]->CompositionFraction,ifraction);
 							pElements->Element[AtomicNumber].Isotope[i]->CompositionFraction = ifraction;
 						}
 					}
 					if(1 == Nmass){
 						mass = pElements->Element[AtomicNumber].Isotope[i]->AtomicMass;
 						if( mass != imass ){
-							printf("   The mass for %s (atomic number %d, mass number %d) has been changed from %f to %f\n",name,AtomicNumber,MassNumber,pElements->Element[AtomicNumber].Isotope[i]->AtomicMass,imass);
+							data_message("   The mass for %s (atomic number %d, mass number %d) has been changed from %f to %f\n",name,AtomicNumber,MassNumber,pElements->Element[AtomicNumber].Isotope[i]->AtomicMass,imass);
 							pElements->Element[AtomicNumber].Isotope[i]->AtomicMass = imass;
 						}
 					}
@@ -156,7 +276,7 @@ void data_read_UserIsotopes(char *path, char *filename, struct element_list *pEl
 			 }
 		 }
 	}
-
+	return 0;
 }
 
 
@@ -170,12 +290,12 @@ void data_write_UserIsotopes(char *path, char *filename, struct element_list *pE
 
 	pathfilename = (char *)malloc((strlen(path)+strlen(filename)+1)*sizeof(char));
 	strcpy(pathfilename,path);
-	strcat(pathfilename,"\\");
+	strcat(pathfilename,DATA_PATH_SEPARATOR);
 	strcat(pathfilename,filename);
 	pFile = fopen (pathfilename,"w");
 	if (pFile!=NULL)
 	{
-		printf("Writing user isotopic composition file: %s\n",filename);
+		data_message("Writing user isotopic composition file: %s\n",filename);
 		fprintf(pFile,"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
 		fprintf(pFile,"<!--For isotope entries the <mass_number> must be present. \n");
 		fprintf(pFile,"       The <mass> entry may or may not be present. \n");
@@ -195,7 +315,7 @@ void data_write_UserIsotopes(char *path, char *filename, struct element_list *pE
 		fprintf(pFile,"</user_isotopes>\n");
 		fclose(pFile);
 	}else{
-		printf("Error : writing file: %s\n",filename);
+		data_error("Error : writing file: %s\n",filename);
 	}
 
 }
@@ -242,11 +362,11 @@ void data_read_NIST(char *path, struct element_list *pElements){
   //---------------------------------------------------
   filename = (char *)malloc((strlen(path)+30)*sizeof(char));
   strcpy(filename,path);
-  strcat(filename,"\\NIST_isotopes.txt");
+  strcat(filename,DATA_PATH_SEPARATOR "NIST_isotopes.txt");
   pFile = fopen (filename,"r");
   if (pFile!=NULL)
   {
-    printf("Reading file NIST_isotopes.txt\n");
+    data_message("Reading file NIST_isotopes.txt\n");
 	while (!feof(pFile)) {
 		fgets(line , 100 , pFile);
 		pline = line;
@@ -283,6 +403,7 @@ void data_read_NIST(char *path, struct element_list *pElements){
 				pElements->Element[AtomicNumber].Isotope[AtomicNumber_count[AtomicNumber]-1]->CompositionFraction	= 0;
 				pElements->Element[AtomicNumber].Isotope[AtomicNumber_count[AtomicNumber]-1]->MassNumber			= 0;
 				pElements->Element[AtomicNumber].Isotope[AtomicNumber_count[AtomicNumber]-1]->Name					= NULL;
+				pElements->Element[AtomicNumber].Isotope[AtomicNumber_count[AtomicNumber]-1]->Symbol				= NULL;
 			}
 			//-------------------------------------------------------------
 			// Look for "Atomic Symbol" 
@@ -361,13 +482,16 @@ void data_read_NIST(char *path, struct element_list *pElements){
 	}
     fclose (pFile);
   }else{
-    printf("Error opening file NIST_isotopes.txt\n");
-	printf("filename = %s\n",filename);
+    data_error("Error opening file NIST_isotopes.txt\n");
+	data_error("filename = %s\n",filename);
   }
 }
 
 
-void data_read_AtomTabl(char *path, struct element_list *pElements)
+//----------------------------------------------------------------------
+// Returns 0, or -1 if the file is missing or malformed
+//----------------------------------------------------------------------
+int data_read_AtomTabl(char *path, struct element_list *pElements)
 {
 	char *filename;
 	char symbol[10];
@@ -404,21 +528,24 @@ void data_read_AtomTabl(char *path, struct element_list *pElements)
 	//---------------------------------------------------
 	filename = (char *)malloc((strlen(path)+30)*sizeof(char));
 	strcpy(filename,path);
-	strcat(filename,"\\AtomTabl.XML");
-    printf("Reading file AtomTabl.XML\n");
+	strcat(filename,DATA_PATH_SEPARATOR "AtomTabl.XML");
+    data_message("Reading file AtomTabl.XML\n");
 
 	//---------------------------------------------------
     // Open and parse the XML file:
 	//---------------------------------------------------
 	time0 = clock();
-    xMainNode=XMLNode::openFileHelper(filename);
+	if( 0 != data_parse_xml(filename, "isotope_table", &xMainNode) ){
+		free(filename);
+		return -1;
+	}
 	time1 = clock();
 
 	//---------------------------------------------------
 	// Count how many Element entries there are
 	//---------------------------------------------------
 	Nentries = xMainNode.getChildNode("isotope_table").nChildNode("element");
-	printf("There are %d element nodes\n", Nentries);
+	data_message("There are %d element nodes\n", Nentries);
 	pElements->Element_Total = Nentries;
 
 	//---------------------------------------------------
@@ -457,7 +584,7 @@ void data_read_AtomTabl(char *path, struct element_list *pElements)
 			strcpy(pElements->Element[AtomicNumber].Symbol,symbol);
 		}
 		if( 0 != strcmp(pElements->Element[AtomicNumber].Symbol,symbol)){ // check symbols across files
-			printf("   Warning : Symbols don't match for Atomic Number %d  (%s != %s)  Using %s.\n",AtomicNumber,pElements->Element[AtomicNumber].Symbol,symbol,symbol);
+			data_message("   Warning : Symbols don't match for Atomic Number %d  (%s != %s)  Using %s.\n",AtomicNumber,pElements->Element[AtomicNumber].Symbol,symbol,symbol);
 			// Elements 110 and 110 don't match so defer to the AtomTabl listing
 			strcpy(pElements->Element[AtomicNumber].Symbol,symbol);
 		}
@@ -481,7 +608,7 @@ void data_read_AtomTabl(char *path, struct element_list *pElements)
 		}
 
 		if( (AverageMass != pElements->Element[AtomicNumber].AverageMass) && (0 != AtomicNumber) ){
-			printf("   Warning : Average Masses don't match for Atomic Number %d  \n   (%f != %f)  Using AtomTabl mass %f\n",AtomicNumber,pElements->Element[AtomicNumber].AverageMass,AverageMass,AverageMass);
+			data_message("   Warning : Average Masses don't match for Atomic Number %d  \n   (%f != %f)  Using AtomTabl mass %f\n",AtomicNumber,pElements->Element[AtomicNumber].AverageMass,AverageMass,AverageMass);
 			// Use AtomTabl average mass
 			pElements->Element[AtomicNumber].AverageMass = AverageMass;
 			//strcpy(pElements->Element[AtomicNumber].Symbol,symbol);
@@ -575,11 +702,11 @@ void data_read_AtomTabl(char *path, struct element_list *pElements)
 			// Compare to NIST and default to AtomTabl.xml
 			//--------------------------------------------------------------------
 			if( pElements->Element[AtomicNumber].Isotope[pElement_isotope_index]->AtomicMass != imass ){
-				printf("             mass difference:     %f != %f  (%d %d)\n",pElements->Element[AtomicNumber].Isotope[pElement_isotope_index]->AtomicMass,imass,AtomicNumber,MassNumber);
+				data_message("             mass difference:     %f != %f  (%d %d)\n",pElements->Element[AtomicNumber].Isotope[pElement_isotope_index]->AtomicMass,imass,AtomicNumber,MassNumber);
 				pElements->Element[AtomicNumber].Isotope[pElement_isotope_index]->AtomicMass = imass;
 			}
 			if(  pElements->Element[AtomicNumber].Isotope[pElement_isotope_index]->CompositionFraction != ifraction ){
-				printf("             fraction difference: %f != %f  (%d %d)\n",pElements->Element[AtomicNumber].Isotope[pElement_isotope_index]->CompositionFraction,ifraction,AtomicNumber,MassNumber);
+				data_message("             fraction difference: %f != %f  (%d %d)\n",pElements->Element[AtomicNumber].Isotope[pElement_isotope_index]->CompositionFraction,ifraction,AtomicNumber,MassNumber);
 				pElements->Element[AtomicNumber].Isotope[pElement_isotope_index]->CompositionFraction = ifraction;
 			}
 		}
@@ -609,7 +736,7 @@ void data_read_AtomTabl(char *path, struct element_list *pElements)
 			}
 		}
 		if( nonzero_count == 0 ){
-			printf("Element %d has no isotopes\n",element_index);
+			data_message("Element %d has no isotopes\n",element_index);
 		}
 		pElements->Element[element_index].NonzeroIsotopeTotal    = nonzero_count;
 		pElements->Element[element_index].NonzeroIsotopeIndex = (int *)malloc(nonzero_count*sizeof(int));
@@ -621,6 +748,6 @@ void data_read_AtomTabl(char *path, struct element_list *pElements)
 			}
 		}
 	}
+	return 0;
 }
 
-
@@ -25,20 +25,37 @@
 
 #include <string.h>
 #include <stdio.h>
-#include <conio.h>  // for _kbhit()
+#ifdef WIN32
+	#include <conio.h>  // for _kbhit()
+#endif
 #include <ctype.h>
 #include <stdlib.h>
 #include <time.h>
 #include "isotopes.h"  // isotopes data structures
 #include "xmlParser.h"
 
+//---------------------------------------------------------------------------------------------
+// Separator used to join the data paths and file names
+//---------------------------------------------------------------------------------------------
+#ifdef WIN32
+	#define DATA_PATH_SEPARATOR "\\"
+#else
+	#define DATA_PATH_SEPARATOR "/"
+#endif
+
 
+void data_set_verbose(int);
+void data_set_stream(FILE *);
+void data_message(const char *, ...);
+void data_error(const char *, ...);
+int  data_parse_xml(char *, const char *, XMLNode *);
 void data_read_RESID(char *, struct RESID_info *);
 void data_read_NIST(char *, struct element_list *);
-void data_read_AtomTabl(char *, struct element_list *);
+int  data_read_AtomTabl(char *, struct element_list *);
 void data_write_UserIsotopes(char *, char *, struct element_list *);
-void data_read_UserIsotopes(char *, char *, struct element_list *);
+int  data_read_UserIsotopes(char *, char *, struct element_list *);
 void data_normalize_fractions(struct element_list *);
+void data_free_elements(struct element_list *);
 
 
 
@@ -105,6 +105,21 @@ struct element_list {
 	int                 Element_Total;
 };
 //---------------------------------------------------------------------------------------------
+// Structure to contain a named isotope abundance profile.
+// A profile is a sparse overlay on a base element list: only the elements whose isotope
+// fractions or masses are overridden are copied (copy on write), all other elements are
+// read from the base list.  Once finalized a profile is read only, so any number of
+// computations can share it (and the base list) without locks.
+//---------------------------------------------------------------------------------------------
+struct isotope_profile {
+	char                *Name;
+	struct element_list *pBase;
+	int                  OverrideIndex[ELEMENT_TOTAL];  // index into Element (-1 = use the base element)
+	struct element_info *Element;                       // copies of the overridden elements
+	int                **FractionSet;                   // per isotope, 1 if the fraction was set explicitly
+	int                  ElementTotal;                  // number of overridden elements
+};
+//---------------------------------------------------------------------------------------------
 // Structure to contain information of a molecule
 //---------------------------------------------------------------------------------------------
 struct molecule_info {
@@ -112,6 +127,7 @@ struct molecule_info {
 	int   ElementTotal;
 	int  *AtomCount;     // Number of atoms of each element in the molecule
 	int  *AtomicNumber;  // index values of the elements in the element list Elements
+	int  *MassNumber;    // mass number of a fixed isotope, e.g. 13 for [13C] (0 = natural composition, NULL = all natural)
 };
 
 #endif
@@ -0,0 +1,304 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  profile.cpp                                             */
+/*               Source code for named isotope abundance profiles, i.e.  */
+/*               sparse copy on write overlays of the element list       */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "profile.h"
+
+//----------------------------------------------------------------------
+// Create an empty profile on top of a base element list.
+// Until an element is overridden it is read from the base list.
+//----------------------------------------------------------------------
+struct isotope_profile *profile_create(const char *name, struct element_list *pBase){
+	struct isotope_profile *pProfile;
+	int element_index;
+
+	pProfile = (struct isotope_profile *)malloc(sizeof(struct isotope_profile));
+	pProfile->Name = (char *)malloc((strlen(name)+1)*sizeof(char));
+	strcpy(pProfile->Name,name);
+	pProfile->pBase        = pBase;
+	pProfile->Element      = NULL;
+	pProfile->FractionSet  = NULL;
+	pProfile->ElementTotal = 0;
+	for(element_index=0; element_index<ELEMENT_TOTAL; element_index++){
+		pProfile->OverrideIndex[element_index] = -1;
+	}
+	return pProfile;
+}
+
+//----------------------------------------------------------------------
+// Copy an element of the base list into the profile (first write only)
+// and return its index in pProfile->Element
+//----------------------------------------------------------------------
+static int profile_copy_element(struct isotope_profile *pProfile, int AtomicNumber){
+	struct element_info *pBaseElement;
+	struct element_info *pElement;
+	int override_index;
+	int iso_index;
+
+	if( 0 <= pProfile->OverrideIndex[AtomicNumber] ){
+		return pProfile->OverrideIndex[AtomicNumber];
+	}
+	override_index = pProfile->ElementTotal;
+	pProfile->ElementTotal += 1;
+	pProfile->Element     = (struct element_info *)realloc(pProfile->Element,pProfile->ElementTotal*sizeof(struct element_info));
+	pProfile->FractionSet = (int **)realloc(pProfile->FractionSet,pProfile->ElementTotal*sizeof(int *));
+
+	pBaseElement = &pProfile->pBase->Element[AtomicNumber];
+	pElement     = &pProfile->Element[override_index];
+	*pElement    = *pBaseElement;  // names and symbols stay shared with the base list
+	pElement->Isotope             = (struct isotope_info **)malloc(pBaseElement->IsotopeTotal*sizeof(struct isotope_info *));
+	pElement->NonzeroIsotopeIndex = (int *)malloc(pBaseElement->IsotopeTotal*sizeof(int));
+	pProfile->FractionSet[override_index] = (int *)malloc(pBaseElement->IsotopeTotal*sizeof(int));
+	for(iso_index=0; iso_index<pBaseElement->IsotopeTotal; iso_index++){
+		pElement->Isotope[iso_index]  = (struct isotope_info *)malloc(sizeof(struct isotope_info));
+		*pElement->Isotope[iso_index] = *pBaseElement->Isotope[iso_index];
+		pProfile->FractionSet[override_index][iso_index] = 0;
+	}
+	for(iso_index=0; iso_index<pBaseElement->NonzeroIsotopeTotal; iso_index++){
+		pElement->NonzeroIsotopeIndex[iso_index] = pBaseElement->NonzeroIsotopeIndex[iso_index];
+	}
+	pProfile->OverrideIndex[AtomicNumber] = override_index;
+	return override_index;
+}
+
+static int profile_find_isotope(struct isotope_profile *pProfile, int AtomicNumber, int MassNumber){
+	int iso_index;
+
+	if( (AtomicNumber < 1) || (ELEMENT_TOTAL <= AtomicNumber) ){
+		data_error("Error : profile %s : atomic number %d is out of range\n",pProfile->Name,AtomicNumber);
+		return -1;
+	}
+	for(iso_index=0; iso_index<pProfile->pBase->Element[AtomicNumber].IsotopeTotal; iso_index++){
+		if( pProfile->pBase->Element[AtomicNumber].Isotope[iso_index]->MassNumber == MassNumber ){
+			return iso_index;
+		}
+	}
+	data_error("Error : profile %s : element %d has no isotope with mass number %d\n",pProfile->Name,AtomicNumber,MassNumber);
+	return -1;
+}
+
+//----------------------------------------------------------------------
+// Override the composition fraction of one isotope.  The fractions of
+// the isotopes that are not set are rescaled by profile_finalize so the
+// element sums to 1.0, e.g. setting 13C to 0.99 leaves 0.01 for 12C.
+// Returns 0 on success and -1 on error.
+//----------------------------------------------------------------------
+int profile_set_fraction(struct isotope_profile *pProfile, int AtomicNumber, int MassNumber, double fraction){
+	int iso_index;
+	int override_index;
+
+	iso_index = profile_find_isotope(pProfile, AtomicNumber, MassNumber);
+	if( iso_index < 0 ){
+		return -1;
+	}
+	if( (fraction < 0) || (1.0 < fraction) ){
+		data_error("Error : profile %s : fraction %f of isotope %d (atomic number %d) is not in [0,1]\n",pProfile->Name,fraction,MassNumber,AtomicNumber);
+		return -1;
+	}
+	override_index = profile_copy_element(pProfile, AtomicNumber);
+	pProfile->Element[override_index].Isotope[iso_index]->CompositionFraction = fraction;
+	pProfile->FractionSet[override_index][iso_index] = 1;
+	return 0;
+}
+
+//----------------------------------------------------------------------
+// Override the mass of one isotope.  Returns 0 on success, -1 on error.
+//----------------------------------------------------------------------
+int profile_set_mass(struct isotope_profile *pProfile, int AtomicNumber, int MassNumber, double mass){
+	int iso_index;
+	int override_index;
+
+	iso_index = profile_find_isotope(pProfile, AtomicNumber, MassNumber);
+	if( iso_index < 0 ){
+		return -1;
+	}
+	override_index = profile_copy_element(pProfile, AtomicNumber);
+	pProfile->Element[override_index].Isotope[iso_index]->AtomicMass = mass;
+	return 0;
+}
+
+//----------------------------------------------------------------------
+// Normalize the overridden elements and recompute their nonzero
+// isotope index, most common isotope and average mass.  Only the
+// overridden elements are visited.  Call after the last set and
+// before the profile is used.
+//----------------------------------------------------------------------
+void profile_finalize(struct isotope_profile *pProfile){
+	struct element_info *pElement;
+	int override_index;
+	int iso_index;
+	int nonzero_count;
+	int max_index;
+	double max_fraction;
+	double set_sum;
+	double free_sum;
+	double scale_set;
+	double scale_free;
+	double average_mass;
+
+	for(override_index=0; override_index<pProfile->ElementTotal; override_index++){
+		pElement = &pProfile->Element[override_index];
+		//---------------------------------------------------
+		// Rescale the fractions that were not set
+		//---------------------------------------------------
+		set_sum  = 0;
+		free_sum = 0;
+		for(iso_index=0; iso_index<pElement->IsotopeTotal; iso_index++){
+			if( 1 == pProfile->FractionSet[override_index][iso_index] ){
+				set_sum  += pElement->Isotope[iso_index]->CompositionFraction;
+			}else{
+				free_sum += pElement->Isotope[iso_index]->CompositionFraction;
+			}
+		}
+		scale_set  = 1.0;
+		scale_free = 0.0;
+		if( 1.0 < set_sum ){
+			data_error("Warning : profile %s : fractions set for %s sum to %f, they have been normalized\n",pProfile->Name,pElement->Name,set_sum);
+			scale_set = 1.0/set_sum;
+		}else if( 0 < free_sum ){
+			scale_free = (1.0-set_sum)/free_sum;
+		}else if( 0 < set_sum ){
+			scale_set = 1.0/set_sum;
+		}
+		for(iso_index=0; iso_index<pElement->IsotopeTotal; iso_index++){
+			if( 1 == pProfile->FractionSet[override_index][iso_index] ){
+				pElement->Isotope[iso_index]->CompositionFraction *= scale_set;
+			}else{
+				pElement->Isotope[iso_index]->CompositionFraction *= scale_free;
+			}
+		}
+		//---------------------------------------------------
+		// Nonzero isotopes, most common isotope and the
+		// average mass
+		//---------------------------------------------------
+		nonzero_count = 0;
+		max_index     = 0;
+		max_fraction  = 0;
+		average_mass  = 0;
+		for(iso_index=0; iso_index<pElement->IsotopeTotal; iso_index++){
+			if( 0 < pElement->Isotope[iso_index]->CompositionFraction ){
+				pElement->NonzeroIsotopeIndex[nonzero_count] = iso_index;
+				nonzero_count += 1;
+				average_mass  += pElement->Isotope[iso_index]->CompositionFraction*pElement->Isotope[iso_index]->AtomicMass;
+			}
+			if( pElement->Isotope[iso_index]->CompositionFraction > max_fraction ){
+				max_fraction = pElement->Isotope[iso_index]->CompositionFraction;
+				max_index    = iso_index;
+			}
+		}
+		pElement->NonzeroIsotopeTotal    = nonzero_count;
+		pElement->MostCommonIsotopeIndex = max_index;
+		if( 0 < nonzero_count ){
+			pElement->AverageMass = average_mass;
+		}
+	}
+}
+
+//----------------------------------------------------------------------
+// Read a user isotopes file (same format as data_read_UserIsotopes)
+// into a profile instead of the shared element list.  The profile is
+// finalized when the file has been read.  Returns 0, or -1 if the
+// file is missing or malformed, in which case the profile is left as
+// it was.
+//----------------------------------------------------------------------
+int profile_read_UserIsotopes(char *path, char *filename, struct isotope_profile *pProfile){
+	char *pathfilename;
+	XMLNode xMainNode,xElementNode,xIsotopeNode;
+	int Nentries;
+	int Eindex;
+	int Nisotopes;
+	int iso_index;
+	int AtomicNumber;
+	int MassNumber;
+	int pass;
+
+	pathfilename = (char *)malloc((strlen(path)+strlen(filename)+30)*sizeof(char));
+	strcpy(pathfilename,path);
+	strcat(pathfilename,DATA_PATH_SEPARATOR);
+	strcat(pathfilename,filename);
+	data_message("Reading profile %s from file: %s\n",pProfile->Name,pathfilename);
+	if( 0 != data_parse_xml(pathfilename, "user_isotopes", &xMainNode) ){
+		free(pathfilename);
+		return -1;
+	}
+	free(pathfilename);
+
+	//---------------------------------------------------
+	// Pass 0 checks every field, pass 1 sets them
+	//---------------------------------------------------
+	Nentries = xMainNode.getChildNode("user_isotopes").nChildNode("element");
+	for(pass=0; pass<2; pass++){
+		for(Eindex=0; Eindex<Nentries; Eindex++){
+			xElementNode = xMainNode.getChildNode("user_isotopes").getChildNode("element",Eindex);
+			if( NULL == xElementNode.getChildNode("atomic_number").getText() ){
+				data_error("Error : profile %s : %s: element %d has no atomic number\n",pProfile->Name,filename,Eindex+1);
+				return -1;
+			}
+			AtomicNumber = atoi(xElementNode.getChildNode("atomic_number").getText());
+			Nisotopes    = xElementNode.nChildNode("isotope");
+			for(iso_index=0; iso_index<Nisotopes; iso_index++){
+				xIsotopeNode = xElementNode.getChildNode("isotope",iso_index);
+				if( (NULL == xIsotopeNode.getChildNode("mass_number").getText()) ||
+					((1 == xIsotopeNode.nChildNode("mass")) && (NULL == xIsotopeNode.getChildNode("mass").getText())) ||
+					((1 == xIsotopeNode.nChildNode("fraction")) && (NULL == xIsotopeNode.getChildNode("fraction").getText())) ){
+					data_error("Error : profile %s : %s: isotope %d of element %d is incomplete\n",pProfile->Name,filename,iso_index+1,AtomicNumber);
+					return -1;
+				}
+				if( 0 == pass ){
+					continue;
+				}
+				MassNumber = atoi(xIsotopeNode.getChildNode("mass_number").getText());
+				if( 1 == xIsotopeNode.nChildNode("mass") ){
+					profile_set_mass(pProfile, AtomicNumber, MassNumber, atof(xIsotopeNode.getChildNode("mass").getText()));
+				}
+				if( 1 == xIsotopeNode.nChildNode("fraction") ){
+					profile_set_fraction(pProfile, AtomicNumber, MassNumber, atof(xIsotopeNode.getChildNode("fraction").getText()));
+				}
+			}
+		}
+	}
+	profile_finalize(pProfile);
+	return 0;
+}
+
+//----------------------------------------------------------------------
+// Element lookup through the profile (a NULL profile is not allowed,
+// use the base list directly in that case)
+//----------------------------------------------------------------------
+struct element_info *profile_element(struct isotope_profile *pProfile, int AtomicNumber){
+	if( 0 <= pProfile->OverrideIndex[AtomicNumber] ){
+		return &pProfile->Element[pProfile->OverrideIndex[AtomicNumber]];
+	}
+	return &pProfile->pBase->Element[AtomicNumber];
+}
+
+void profile_free(struct isotope_profile *pProfile){
+	int override_index;
+	int iso_index;
+
+	for(override_index=0; override_index<pProfile->ElementTotal; override_index++){
+		for(iso_index=0; iso_index<pProfile->Element[override_index].IsotopeTotal; iso_index++){
+			free(pProfile->Element[override_index].Isotope[iso_index]);
+		}
+		free(pProfile->Element[override_index].Isotope);
+		free(pProfile->Element[override_index].NonzeroIsotopeIndex);
+		free(pProfile->FractionSet[override_index]);
+	}
+	free(pProfile->Element);
+	free(pProfile->FractionSet);
+	free(pProfile->Name);
+	free(pProfile);
+}
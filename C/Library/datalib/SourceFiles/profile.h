@@ -0,0 +1,31 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  profile.h                                               */
+/*               Header file for profile.cpp, which contains source code */
+/*               for named isotope abundance profiles                    */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef PROFILE_FUNCTIONS
+#define PROFILE_FUNCTIONS
+
+#include "data.h"
+
+struct isotope_profile *profile_create(const char *, struct element_list *);
+int  profile_set_fraction(struct isotope_profile *, int, int, double);
+int  profile_set_mass(struct isotope_profile *, int, int, double);
+void profile_finalize(struct isotope_profile *);
+int  profile_read_UserIsotopes(char *, char *, struct isotope_profile *);
+struct element_info *profile_element(struct isotope_profile *, int);
+void profile_free(struct isotope_profile *);
+
+#endif
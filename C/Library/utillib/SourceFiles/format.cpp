@@ -0,0 +1,380 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  format.cpp                                              */
+/*               Shortest round trip formatting of doubles with the      */
+/*               Grisu2 algorithm (F. Loitsch, Printing floating-point   */
+/*               numbers quickly and accurately with integers, PLDI      */
+/*               2010).  The digits always read back as the same double; */
+/*               in rare cases one more digit than the shortest is used. */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "format.h"
+#include <string.h>
+
+#ifdef _MSC_VER
+	typedef unsigned __int64   format_uint64;
+	#define FORMAT_U64(x)      x##ui64
+#else
+	typedef unsigned long long format_uint64;
+	#define FORMAT_U64(x)      x##ULL
+#endif
+
+#define FORMAT_HIDDEN_BIT    FORMAT_U64(0x0010000000000000)
+#define FORMAT_FRACTION_MASK FORMAT_U64(0x000FFFFFFFFFFFFF)
+
+//--------------------------------------------------------
+// Floating point number with a 64 bit significand,
+// f*2^e (no hidden bit, no sign)
+//--------------------------------------------------------
+struct format_diyfp {
+	format_uint64 f;
+	int           e;
+};
+
+//--------------------------------------------------------
+// Normalized 10^k for k = -348, -340, ..., 340
+//--------------------------------------------------------
+static const format_uint64 format_cached_significand[87] = {
+	FORMAT_U64(0xFA8FD5A0081C0288), FORMAT_U64(0xBAAEE17FA23EBF76), FORMAT_U64(0x8B16FB203055AC76),
+	FORMAT_U64(0xCF42894A5DCE35EA), FORMAT_U64(0x9A6BB0AA55653B2D), FORMAT_U64(0xE61ACF033D1A45DF),
+	FORMAT_U64(0xAB70FE17C79AC6CA), FORMAT_U64(0xFF77B1FCBEBCDC4F), FORMAT_U64(0xBE5691EF416BD60C),
+	FORMAT_U64(0x8DD01FAD907FFC3C), FORMAT_U64(0xD3515C2831559A83), FORMAT_U64(0x9D71AC8FADA6C9B5),
+	FORMAT_U64(0xEA9C227723EE8BCB), FORMAT_U64(0xAECC49914078536D), FORMAT_U64(0x823C12795DB6CE57),
+	FORMAT_U64(0xC21094364DFB5637), FORMAT_U64(0x9096EA6F3848984F), FORMAT_U64(0xD77485CB25823AC7),
+	FORMAT_U64(0xA086CFCD97BF97F4), FORMAT_U64(0xEF340A98172AACE5), FORMAT_U64(0xB23867FB2A35B28E),
+	FORMAT_U64(0x84C8D4DFD2C63F3B), FORMAT_U64(0xC5DD44271AD3CDBA), FORMAT_U64(0x936B9FCEBB25C996),
+	FORMAT_U64(0xDBAC6C247D62A584), FORMAT_U64(0xA3AB66580D5FDAF6), FORMAT_U64(0xF3E2F893DEC3F126),
+	FORMAT_U64(0xB5B5ADA8AAFF80B8), FORMAT_U64(0x87625F056C7C4A8B), FORMAT_U64(0xC9BCFF6034C13053),
+	FORMAT_U64(0x964E858C91BA2655), FORMAT_U64(0xDFF9772470297EBD), FORMAT_U64(0xA6DFBD9FB8E5B88F),
+	FORMAT_U64(0xF8A95FCF88747D94), FORMAT_U64(0xB94470938FA89BCF), FORMAT_U64(0x8A08F0F8BF0F156B),
+	FORMAT_U64(0xCDB02555653131B6), FORMAT_U64(0x993FE2C6D07B7FAC), FORMAT_U64(0xE45C10C42A2B3B06),
+	FORMAT_U64(0xAA242499697392D3), FORMAT_U64(0xFD87B5F28300CA0E), FORMAT_U64(0xBCE5086492111AEB),
+	FORMAT_U64(0x8CBCCC096F5088CC), FORMAT_U64(0xD1B71758E219652C), FORMAT_U64(0x9C40000000000000),
+	FORMAT_U64(0xE8D4A51000000000), FORMAT_U64(0xAD78EBC5AC620000), FORMAT_U64(0x813F3978F8940984),
+	FORMAT_U64(0xC097CE7BC90715B3), FORMAT_U64(0x8F7E32CE7BEA5C70), FORMAT_U64(0xD5D238A4ABE98068),
+	FORMAT_U64(0x9F4F2726179A2245), FORMAT_U64(0xED63A231D4C4FB27), FORMAT_U64(0xB0DE65388CC8ADA8),
+	FORMAT_U64(0x83C7088E1AAB65DB), FORMAT_U64(0xC45D1DF942711D9A), FORMAT_U64(0x924D692CA61BE758),
+	FORMAT_U64(0xDA01EE641A708DEA), FORMAT_U64(0xA26DA3999AEF774A), FORMAT_U64(0xF209787BB47D6B85),
+	FORMAT_U64(0xB454E4A179DD1877), FORMAT_U64(0x865B86925B9BC5C2), FORMAT_U64(0xC83553C5C8965D3D),
+	FORMAT_U64(0x952AB45CFA97A0B3), FORMAT_U64(0xDE469FBD99A05FE3), FORMAT_U64(0xA59BC234DB398C25),
+	FORMAT_U64(0xF6C69A72A3989F5C), FORMAT_U64(0xB7DCBF5354E9BECE), FORMAT_U64(0x88FCF317F22241E2),
+	FORMAT_U64(0xCC20CE9BD35C78A5), FORMAT_U64(0x98165AF37B2153DF), FORMAT_U64(0xE2A0B5DC971F303A),
+	FORMAT_U64(0xA8D9D1535CE3B396), FORMAT_U64(0xFB9B7CD9A4A7443C), FORMAT_U64(0xBB764C4CA7A44410),
+	FORMAT_U64(0x8BAB8EEFB6409C1A), FORMAT_U64(0xD01FEF10A657842C), FORMAT_U64(0x9B10A4E5E9913129),
+	FORMAT_U64(0xE7109BFBA19C0C9D), FORMAT_U64(0xAC2820D9623BF429), FORMAT_U64(0x80444B5E7AA7CF85),
+	FORMAT_U64(0xBF21E44003ACDD2D), FORMAT_U64(0x8E679C2F5E44FF8F), FORMAT_U64(0xD433179D9C8CB841),
+	FORMAT_U64(0x9E19DB92B4E31BA9), FORMAT_U64(0xEB96BF6EBADF77D9), FORMAT_U64(0xAF87023B9BF0EE6B)
+};
+static const short format_cached_exponent[87] = {
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+	-901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+	-582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+	-263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+	56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+	375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+	694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+	1013, 1039, 1066
+};
+
+static const format_uint64 format_pow10[20] = {
+	FORMAT_U64(1), FORMAT_U64(10), FORMAT_U64(100), FORMAT_U64(1000), FORMAT_U64(10000),
+	FORMAT_U64(100000), FORMAT_U64(1000000), FORMAT_U64(10000000), FORMAT_U64(100000000),
+	FORMAT_U64(1000000000), FORMAT_U64(10000000000), FORMAT_U64(100000000000),
+	FORMAT_U64(1000000000000), FORMAT_U64(10000000000000), FORMAT_U64(100000000000000),
+	FORMAT_U64(1000000000000000), FORMAT_U64(10000000000000000), FORMAT_U64(100000000000000000),
+	FORMAT_U64(1000000000000000000), FORMAT_U64(10000000000000000000)
+};
+
+static struct format_diyfp format_normalize(struct format_diyfp x){
+	while( 0 == (x.f & (FORMAT_U64(1) << 63)) ){
+		x.f <<= 1;
+		x.e--;
+	}
+	return x;
+}
+
+//--------------------------------------------------------
+// Upper 64 bits of the 128 bit product, rounded
+//--------------------------------------------------------
+static struct format_diyfp format_multiply(struct format_diyfp x, struct format_diyfp y){
+	struct format_diyfp product;
+	format_uint64 a,b,c,d;
+	format_uint64 ac,bc,ad,bd;
+	format_uint64 middle;
+
+	a  = x.f >> 32;
+	b  = x.f & 0xFFFFFFFF;
+	c  = y.f >> 32;
+	d  = y.f & 0xFFFFFFFF;
+	ac = a*c;
+	bc = b*c;
+	ad = a*d;
+	bd = b*d;
+	middle  = (bd >> 32) + (ad & 0xFFFFFFFF) + (bc & 0xFFFFFFFF);
+	middle += FORMAT_U64(1) << 31;
+	product.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+	product.e = x.e + y.e + 64;
+	return product;
+}
+
+static int format_count_digits(unsigned int n){
+	int digits;
+
+	digits = 1;
+	while( n >= 10 ){
+		n /= 10;
+		digits++;
+	}
+	return digits;
+}
+
+static void format_round(char *buffer, int length, format_uint64 delta, format_uint64 rest, format_uint64 ten_kappa, format_uint64 distance){
+	while( (rest < distance) && (delta - rest >= ten_kappa) &&
+		   ((rest + ten_kappa < distance) || (distance - rest > rest + ten_kappa - distance)) ){
+		buffer[length-1]--;
+		rest += ten_kappa;
+	}
+}
+
+//--------------------------------------------------------
+// Generate the digits of Mp that lie within delta of it
+// and are closest to W.  Returns the number of digits;
+// the value is digits*10^(*pK).
+//--------------------------------------------------------
+static int format_digits(struct format_diyfp W, struct format_diyfp Mp, format_uint64 delta, char *buffer, int *pK){
+	struct format_diyfp one;
+	format_uint64 distance;
+	format_uint64 p2;
+	format_uint64 rest;
+	unsigned int p1;
+	unsigned int digit;
+	int kappa;
+	int length;
+
+	one.f    = FORMAT_U64(1) << -Mp.e;
+	one.e    = Mp.e;
+	distance = Mp.f - W.f;
+	p1       = (unsigned int)(Mp.f >> -one.e);
+	p2       = Mp.f & (one.f - 1);
+	kappa    = format_count_digits(p1);
+	length   = 0;
+
+	while( kappa > 0 ){
+		digit = (unsigned int)(p1 / format_pow10[kappa-1]);
+		p1    = (unsigned int)(p1 % format_pow10[kappa-1]);
+		if( (0 != digit) || (0 != length) ){
+			buffer[length++] = (char)('0' + digit);
+		}
+		kappa--;
+		rest = ((format_uint64)p1 << -one.e) + p2;
+		if( rest <= delta ){
+			*pK += kappa;
+			format_round(buffer, length, delta, rest, format_pow10[kappa] << -one.e, distance);
+			return length;
+		}
+	}
+	while( 1 ){
+		p2    *= 10;
+		delta *= 10;
+		digit  = (unsigned int)(p2 >> -one.e);
+		if( (0 != digit) || (0 != length) ){
+			buffer[length++] = (char)('0' + digit);
+		}
+		p2 &= one.f - 1;
+		kappa--;
+		if( p2 < delta ){
+			*pK += kappa;
+			format_round(buffer, length, delta, p2, one.f, distance * ((-kappa < 20) ? format_pow10[-kappa] : 0));
+			return length;
+		}
+	}
+}
+
+//--------------------------------------------------------
+// Grisu2: digits of a positive finite double
+//--------------------------------------------------------
+static int format_grisu2(double value, char *buffer, int *pK){
+	struct format_diyfp v;
+	struct format_diyfp plus;
+	struct format_diyfp minus;
+	struct format_diyfp cached;
+	struct format_diyfp W,Wp,Wm;
+	format_uint64 bits;
+	int biased_exponent;
+	int index;
+	int k;
+	double dk;
+
+	memcpy(&bits, &value, sizeof(bits));
+	biased_exponent = (int)((bits >> 52) & 0x7FF);
+	if( 0 != biased_exponent ){
+		v.f = (bits & FORMAT_FRACTION_MASK) + FORMAT_HIDDEN_BIT;
+		v.e = biased_exponent - 1075;
+	}else{
+		v.f = bits & FORMAT_FRACTION_MASK;
+		v.e = -1074;
+	}
+
+	//---------------------------------------------------
+	// Boundaries halfway to the neighbouring doubles
+	//---------------------------------------------------
+	plus.f = (v.f << 1) + 1;
+	plus.e = v.e - 1;
+	plus   = format_normalize(plus);
+	if( FORMAT_HIDDEN_BIT == v.f ){
+		minus.f = (v.f << 2) - 1;
+		minus.e = v.e - 2;
+	}else{
+		minus.f = (v.f << 1) - 1;
+		minus.e = v.e - 1;
+	}
+	minus.f <<= minus.e - plus.e;
+	minus.e   = plus.e;
+
+	//---------------------------------------------------
+	// Scale by the cached power of ten that brings the
+	// exponent into [-60,-32]
+	//---------------------------------------------------
+	dk = (double)(-61 - plus.e)*0.30102999566398114 + 347;
+	k  = (int)dk;
+	if( dk - k > 0.0 ){
+		k++;
+	}
+	index    = (k >> 3) + 1;
+	*pK      = -(-348 + index*8);
+	cached.f = format_cached_significand[index];
+	cached.e = format_cached_exponent[index];
+
+	W   = format_multiply(format_normalize(v), cached);
+	Wp  = format_multiply(plus, cached);
+	Wm  = format_multiply(minus, cached);
+	Wm.f++;
+	Wp.f--;
+	return format_digits(W, Wp, Wp.f - Wm.f, buffer, pK);
+}
+
+static int format_exponent(int exponent, char *buffer){
+	int length;
+
+	length = 0;
+	buffer[length++] = 'e';
+	if( exponent < 0 ){
+		buffer[length++] = '-';
+		exponent = -exponent;
+	}
+	if( exponent >= 100 ){
+		buffer[length++] = (char)('0' + exponent/100);
+		exponent %= 100;
+		buffer[length++] = (char)('0' + exponent/10);
+	}else if( exponent >= 10 ){
+		buffer[length++] = (char)('0' + exponent/10);
+	}
+	buffer[length++] = (char)('0' + exponent%10);
+	return length;
+}
+
+//--------------------------------------------------------
+// Place the decimal point: digits*10^k is written in
+// fixed notation when 1e-6 <= value < 1e21 and in
+// exponent notation otherwise
+//--------------------------------------------------------
+static int format_place_point(char *buffer, int length, int k){
+	int kk;
+	int index;
+
+	kk = length + k;   // 10^(kk-1) <= value < 10^kk
+	if( (0 <= k) && (kk <= 21) ){
+		for(index=length; index<kk; index++){
+			buffer[index] = '0';
+		}
+		return kk;
+	}
+	if( (0 < kk) && (kk <= 21) ){
+		memmove(&buffer[kk+1], &buffer[kk], length-kk);
+		buffer[kk] = '.';
+		return length + 1;
+	}
+	if( (-6 < kk) && (kk <= 0) ){
+		memmove(&buffer[2-kk], &buffer[0], length);
+		buffer[0] = '0';
+		buffer[1] = '.';
+		for(index=2; index<2-kk; index++){
+			buffer[index] = '0';
+		}
+		return length + 2 - kk;
+	}
+	if( 1 == length ){
+		return 1 + format_exponent(kk-1, &buffer[1]);
+	}
+	memmove(&buffer[2], &buffer[1], length-1);
+	buffer[1] = '.';
+	return length + 1 + format_exponent(kk-1, &buffer[length+1]);
+}
+
+int format_double(double value, char *buffer){
+	format_uint64 bits;
+	int Ndigits;
+	int length;
+	int sign;
+	int k;
+
+	memcpy(&bits, &value, sizeof(bits));
+	sign = (int)(bits >> 63);
+	if( ((bits >> 52) & 0x7FF) == 0x7FF ){
+		if( 0 != (bits & FORMAT_FRACTION_MASK) ){
+			strcpy(buffer, "nan");
+			return 3;
+		}
+		strcpy(buffer, sign ? "-inf" : "inf");
+		return sign ? 4 : 3;
+	}
+	length = 0;
+	if( sign ){
+		buffer[length++] = '-';
+		value = -value;
+	}
+	if( 0 == value ){
+		buffer[length++] = '0';
+		buffer[length]   = '\0';
+		return length;
+	}
+	k = 0;
+	Ndigits = format_grisu2(value, &buffer[length], &k);
+	length += format_place_point(&buffer[length], Ndigits, k);
+	buffer[length] = '\0';
+	return length;
+}
+
+int format_int(long value, char *buffer){
+	char digits[24];
+	unsigned long magnitude;
+	int Ndigits;
+	int length;
+
+	length = 0;
+	magnitude = (unsigned long)value;
+	if( value < 0 ){
+		buffer[length++] = '-';
+		magnitude = 0 - magnitude;
+	}
+	Ndigits = 0;
+	do{
+		digits[Ndigits++] = (char)('0' + magnitude%10);
+		magnitude /= 10;
+	}while( magnitude > 0 );
+	while( Ndigits > 0 ){
+		buffer[length++] = digits[--Ndigits];
+	}
+	buffer[length] = '\0';
+	return length;
+}
@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  format.h                                                */
+/*               Header file for format.cpp, shortest round trip         */
+/*               formatting of doubles                                   */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef FORMAT_FUNCTIONS
+#define FORMAT_FUNCTIONS
+
+#define FORMAT_DOUBLE_MAX 32   // buffer size that holds any formatted double and the NUL
+
+// Writes the shortest decimal string that reads back (strtod) as the same double,
+// e.g. 0.1, 5732.615402944863, 1.2e-07.  NaN and infinity are written as nan, inf, -inf.
+// Returns the number of characters written (the string is NUL terminated).
+int format_double(double, char *);
+int format_int(long, char *);
+
+#endif
@@ -33,6 +33,9 @@ void heapsort_dbl_up(int Nelements, double *array1) {
 	// so we need to shift the array by 1 so when it references array[1], it is really array[0].
 	array1offset = array1-1; 
 
+	if (Nelements < 2) {  // nothing to sort (the heap loop needs two or more)
+		return;
+	}
 	m = Nelements;
 	k = (Nelements >> 1) + 1;
 	while(1) {
@@ -82,6 +85,9 @@ void heapsort_2dbl_up(int Nelements, double *array1, double *array2) {
 	array1offset = array1-1; 
 	array2offset = array2-1; 
 
+	if (Nelements < 2) {  // nothing to sort (the heap loop needs two or more)
+		return;
+	}
 	m = Nelements;
 	k = (Nelements >> 1) + 1;
 	while(1) {
@@ -137,6 +143,9 @@ void heapsort_2dbl_down(int Nelements, double *array1, double *array2) {
 	array1offset = array1-1; 
 	array2offset = array2-1; 
 
+	if (Nelements < 2) {  // nothing to sort (the heap loop needs two or more)
+		return;
+	}
 	m = Nelements;
 	k = (Nelements >> 1) + 1;
 	while(1) {
@@ -195,6 +204,9 @@ void heapsort_3dbl_up(int Nelements, double *array1, double *array2, double *arr
 	array2offset = array2-1; 
 	array3offset = array3-1; 
 
+	if (Nelements < 2) {  // nothing to sort (the heap loop needs two or more)
+		return;
+	}
 	m = Nelements;
 	k = (Nelements >> 1) + 1;
 	while(1) {
@@ -258,6 +270,9 @@ void heapsort_3int_up(int Nelements, int *array1, int *array2, int *array3) {
 	array2offset = array2-1; 
 	array3offset = array3-1; 
 
+	if (Nelements < 2) {  // nothing to sort (the heap loop needs two or more)
+		return;
+	}
 	m = Nelements;
 	k = (Nelements >> 1) + 1;
 	while(1) {
@@ -322,6 +337,9 @@ void heapsort_1dbl_2int_up(int Nelements, double *array1, int *array2, int *arra
 	array2offset = array2-1; 
 	array3offset = array3-1; 
 
+	if (Nelements < 2) {  // nothing to sort (the heap loop needs two or more)
+		return;
+	}
 	m = Nelements;
 	k = (Nelements >> 1) + 1;
 	while(1) {
@@ -0,0 +1,273 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  thread.cpp                                              */
+/*               Threads, locks and atomic counters for Windows (Win32   */
+/*               API) and POSIX (pthreads and GCC atomic builtins)       */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#ifndef WIN32
+	#include <unistd.h>
+	#include <time.h>
+#endif
+
+#ifdef WIN32
+//-----------------------------------------------------
+// Windows
+//-----------------------------------------------------
+static DWORD WINAPI thread_trampoline(LPVOID argument){
+	struct thread_handle *pThread;
+
+	pThread = (struct thread_handle *)argument;
+	pThread->Function(pThread->Argument);
+	return 0;
+}
+
+// Returns 0 on success.  The handle must stay valid until thread_join.
+int thread_start(struct thread_handle *pThread, void (*function)(void *), void *argument){
+	pThread->Function = function;
+	pThread->Argument = argument;
+	pThread->Handle   = CreateThread(NULL, 0, thread_trampoline, pThread, 0, NULL);
+	return (NULL == pThread->Handle) ? -1 : 0;
+}
+
+void thread_join(struct thread_handle *pThread){
+	WaitForSingleObject(pThread->Handle, INFINITE);
+	CloseHandle(pThread->Handle);
+}
+
+int thread_processor_count(void){
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+}
+
+void thread_sleep_ms(int milliseconds){
+	Sleep(milliseconds);
+}
+
+// Monotonic wall clock in seconds (the origin is arbitrary)
+double thread_wall_seconds(void){
+	LARGE_INTEGER count;
+	LARGE_INTEGER frequency;
+
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return (double)count.QuadPart/(double)frequency.QuadPart;
+}
+
+void thread_mutex_init(thread_mutex *pMutex)    { InitializeCriticalSection(pMutex); }
+void thread_mutex_destroy(thread_mutex *pMutex) { DeleteCriticalSection(pMutex); }
+void thread_mutex_lock(thread_mutex *pMutex)    { EnterCriticalSection(pMutex); }
+void thread_mutex_unlock(thread_mutex *pMutex)  { LeaveCriticalSection(pMutex); }
+void thread_cond_init(thread_cond *pCond)       { InitializeConditionVariable(pCond); }
+void thread_cond_destroy(thread_cond *pCond)    { }
+void thread_cond_wait(thread_cond *pCond, thread_mutex *pMutex) { SleepConditionVariableCS(pCond, pMutex, INFINITE); }
+void thread_cond_signal(thread_cond *pCond)     { WakeConditionVariable(pCond); }
+void thread_cond_broadcast(thread_cond *pCond)  { WakeAllConditionVariable(pCond); }
+
+long thread_atomic_add(volatile long *pValue, long increment){
+	return InterlockedExchangeAdd(pValue, increment) + increment;
+}
+
+long thread_atomic_load(volatile long *pValue){
+	return InterlockedCompareExchange(pValue, 0, 0);
+}
+
+long thread_atomic_compare_exchange(volatile long *pValue, long expected, long desired){
+	return InterlockedCompareExchange(pValue, desired, expected);
+}
+
+void *thread_atomic_load_pointer(void * volatile *pPointer){
+	return InterlockedCompareExchangePointer(pPointer, NULL, NULL);
+}
+
+void *thread_atomic_exchange_pointer(void * volatile *pPointer, void *pointer){
+	return InterlockedExchangePointer(pPointer, pointer);
+}
+
+#else
+//-----------------------------------------------------
+// POSIX
+//-----------------------------------------------------
+static void *thread_trampoline(void *argument){
+	struct thread_handle *pThread;
+
+	pThread = (struct thread_handle *)argument;
+	pThread->Function(pThread->Argument);
+	return NULL;
+}
+
+// Returns 0 on success.  The handle must stay valid until thread_join.
+int thread_start(struct thread_handle *pThread, void (*function)(void *), void *argument){
+	pThread->Function = function;
+	pThread->Argument = argument;
+	return (0 == pthread_create(&pThread->Handle, NULL, thread_trampoline, pThread)) ? 0 : -1;
+}
+
+void thread_join(struct thread_handle *pThread){
+	pthread_join(pThread->Handle, NULL);
+}
+
+int thread_processor_count(void){
+	long count;
+
+	count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count < 1) ? 1 : (int)count;
+}
+
+void thread_sleep_ms(int milliseconds){
+	struct timespec duration;
+
+	duration.tv_sec  = milliseconds/1000;
+	duration.tv_nsec = (long)(milliseconds%1000)*1000000L;
+	nanosleep(&duration, NULL);
+}
+
+// Monotonic wall clock in seconds (the origin is arbitrary)
+double thread_wall_seconds(void){
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + 1e-9*(double)now.tv_nsec;
+}
+
+void thread_mutex_init(thread_mutex *pMutex)    { pthread_mutex_init(pMutex, NULL); }
+void thread_mutex_destroy(thread_mutex *pMutex) { pthread_mutex_destroy(pMutex); }
+void thread_mutex_lock(thread_mutex *pMutex)    { pthread_mutex_lock(pMutex); }
+void thread_mutex_unlock(thread_mutex *pMutex)  { pthread_mutex_unlock(pMutex); }
+void thread_cond_init(thread_cond *pCond)       { pthread_cond_init(pCond, NULL); }
+void thread_cond_destroy(thread_cond *pCond)    { pthread_cond_destroy(pCond); }
+void thread_cond_wait(thread_cond *pCond, thread_mutex *pMutex) { pthread_cond_wait(pCond, pMutex); }
+void thread_cond_signal(thread_cond *pCond)     { pthread_cond_signal(pCond); }
+void thread_cond_broadcast(thread_cond *pCond)  { pthread_cond_broadcast(pCond); }
+
+long thread_atomic_add(volatile long *pValue, long increment){
+	return __atomic_add_fetch(pValue, increment, __ATOMIC_SEQ_CST);
+}
+
+long thread_atomic_load(volatile long *pValue){
+	return __atomic_load_n(pValue, __ATOMIC_SEQ_CST);
+}
+
+long thread_atomic_compare_exchange(volatile long *pValue, long expected, long desired){
+	__atomic_compare_exchange_n(pValue, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return expected;
+}
+
+void *thread_atomic_load_pointer(void * volatile *pPointer){
+	return __atomic_load_n(pPointer, __ATOMIC_SEQ_CST);
+}
+
+void *thread_atomic_exchange_pointer(void * volatile *pPointer, void *pointer){
+	return __atomic_exchange_n(pPointer, pointer, __ATOMIC_SEQ_CST);
+}
+
+#endif
+
+//-----------------------------------------------------
+// Bounded queue (both platforms)
+//-----------------------------------------------------
+void thread_queue_init(struct thread_queue *pQueue, int capacity){
+	pQueue->Item     = (void **)malloc(capacity*sizeof(void *));
+	pQueue->Capacity = capacity;
+	pQueue->Head     = 0;
+	pQueue->Count    = 0;
+	pQueue->Closed   = 0;
+	thread_mutex_init(&pQueue->Mutex);
+	thread_cond_init(&pQueue->NotEmpty);
+	thread_cond_init(&pQueue->NotFull);
+}
+
+void thread_queue_destroy(struct thread_queue *pQueue){
+	thread_cond_destroy(&pQueue->NotFull);
+	thread_cond_destroy(&pQueue->NotEmpty);
+	thread_mutex_destroy(&pQueue->Mutex);
+	free(pQueue->Item);
+}
+
+int thread_queue_push(struct thread_queue *pQueue, void *pItem){
+	thread_mutex_lock(&pQueue->Mutex);
+	while( (pQueue->Count == pQueue->Capacity) && (0 == pQueue->Closed) ){
+		thread_cond_wait(&pQueue->NotFull, &pQueue->Mutex);
+	}
+	if( 0 != pQueue->Closed ){
+		thread_mutex_unlock(&pQueue->Mutex);
+		return -1;
+	}
+	pQueue->Item[(pQueue->Head+pQueue->Count)%pQueue->Capacity] = pItem;
+	pQueue->Count++;
+	thread_cond_signal(&pQueue->NotEmpty);
+	thread_mutex_unlock(&pQueue->Mutex);
+	return 0;
+}
+
+void *thread_queue_pop(struct thread_queue *pQueue){
+	void *pItem;
+
+	thread_mutex_lock(&pQueue->Mutex);
+	while( (0 == pQueue->Count) && (0 == pQueue->Closed) ){
+		thread_cond_wait(&pQueue->NotEmpty, &pQueue->Mutex);
+	}
+	if( 0 == pQueue->Count ){
+		thread_mutex_unlock(&pQueue->Mutex);
+		return NULL;
+	}
+	pItem = pQueue->Item[pQueue->Head];
+	pQueue->Head = (pQueue->Head+1)%pQueue->Capacity;
+	pQueue->Count--;
+	thread_cond_signal(&pQueue->NotFull);
+	thread_mutex_unlock(&pQueue->Mutex);
+	return pItem;
+}
+
+void thread_queue_close(struct thread_queue *pQueue){
+	thread_mutex_lock(&pQueue->Mutex);
+	pQueue->Closed = 1;
+	thread_cond_broadcast(&pQueue->NotEmpty);
+	thread_cond_broadcast(&pQueue->NotFull);
+	thread_mutex_unlock(&pQueue->Mutex);
+}
+
+//-----------------------------------------------------
+// Slices of a parallel loop (both platforms)
+//-----------------------------------------------------
+void thread_run_slices(int count, void (*work)(void *), void *args, size_t stride){
+	struct thread_handle *Thread;
+	int *Started;
+	int slice_index;
+
+	if( count < 1 ){
+		return;
+	}
+	Thread  = (struct thread_handle *)malloc(count*sizeof(struct thread_handle));
+	Started = (int *)calloc(count, sizeof(int));
+	if( (NULL != Thread) && (NULL != Started) ){
+		for(slice_index=1; slice_index<count; slice_index++){
+			Started[slice_index] = (0 == thread_start(&Thread[slice_index], work, (char *)args + slice_index*stride));
+		}
+	}
+	work(args);
+	for(slice_index=1; slice_index<count; slice_index++){
+		if( (NULL != Started) && Started[slice_index] ){
+			thread_join(&Thread[slice_index]);
+		}else{
+			work((char *)args + slice_index*stride);
+		}
+	}
+	free(Thread);
+	free(Started);
+}
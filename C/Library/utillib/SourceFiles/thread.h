@@ -0,0 +1,95 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  thread.h                                                */
+/*               Header file for thread.cpp, a small portability layer  */
+/*               for threads, locks and atomic counters (Windows and     */
+/*               POSIX)                                                  */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef THREAD_FUNCTIONS
+#define THREAD_FUNCTIONS
+
+#ifdef WIN32
+	#include <windows.h>
+	typedef CRITICAL_SECTION   thread_mutex;
+	typedef CONDITION_VARIABLE thread_cond;
+#else
+	#include <pthread.h>
+	typedef pthread_mutex_t    thread_mutex;
+	typedef pthread_cond_t     thread_cond;
+#endif
+#include <stddef.h>
+
+struct thread_handle {
+#ifdef WIN32
+	HANDLE    Handle;
+#else
+	pthread_t Handle;
+#endif
+	void    (*Function)(void *);
+	void     *Argument;
+};
+
+int  thread_start(struct thread_handle *, void (*)(void *), void *);
+void thread_join(struct thread_handle *);
+int  thread_processor_count(void);
+void thread_sleep_ms(int);
+double thread_wall_seconds(void);
+
+void thread_mutex_init(thread_mutex *);
+void thread_mutex_destroy(thread_mutex *);
+void thread_mutex_lock(thread_mutex *);
+void thread_mutex_unlock(thread_mutex *);
+void thread_cond_init(thread_cond *);
+void thread_cond_destroy(thread_cond *);
+void thread_cond_wait(thread_cond *, thread_mutex *);
+void thread_cond_signal(thread_cond *);
+void thread_cond_broadcast(thread_cond *);
+
+//---------------------------------------------------------------------------------------------
+// Bounded first in first out queue of pointers for passing work between threads.
+// A push blocks while the queue is full and a pop blocks while it is empty.  After
+// thread_queue_close, pushes fail and pops drain the queue and then return NULL.
+//---------------------------------------------------------------------------------------------
+struct thread_queue {
+	void       **Item;
+	int          Capacity;
+	int          Head;
+	int          Count;
+	int          Closed;
+	thread_mutex Mutex;
+	thread_cond  NotEmpty;
+	thread_cond  NotFull;
+};
+
+void  thread_queue_init(struct thread_queue *, int);
+void  thread_queue_destroy(struct thread_queue *);
+int   thread_queue_push(struct thread_queue *, void *);  // returns -1 if the queue is closed
+void *thread_queue_pop(struct thread_queue *);          // returns NULL if closed and empty
+void  thread_queue_close(struct thread_queue *);
+
+//---------------------------------------------------------------------------------------------
+// Parallel loop over count slices: work(args + i*stride) for i = 0 to count-1, slice 0 on the
+// calling thread and each other slice on a thread of its own.  A slice whose thread does not
+// start is run by the calling thread, so every slice has run once on return.
+//---------------------------------------------------------------------------------------------
+void  thread_run_slices(int, void (*)(void *), void *, size_t);
+
+// Sequentially consistent atomic operations
+long  thread_atomic_add(volatile long *, long);                  // returns the new value
+long  thread_atomic_load(volatile long *);
+long  thread_atomic_compare_exchange(volatile long *, long, long);  // returns the old value
+void *thread_atomic_load_pointer(void * volatile *);
+void *thread_atomic_exchange_pointer(void * volatile *, void *); // returns the old pointer
+
+#endif
@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  bench_batch.cpp                                         */
+/*               Benchmark of isoDalton_batch_masses.  Reports formulas  */
+/*               per second for random CHNOPS formulas with one thread   */
+/*               and with Nthreads, and checks the masses against a      */
+/*               formula by formula loop.                                */
+/*               Usage: bench_batch [DataPath] [DataPathUser]            */
+/*                                  [Nformulas] [Nthreads]               */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_batch.h"
+#include "thread.h"
+#include <math.h>
+
+#define BENCH_BATCH_ELEMENTS 6
+#define BENCH_BATCH_REPS     5
+
+//--------------------------------------------------------
+// Best wall time of BENCH_BATCH_REPS batches
+//--------------------------------------------------------
+static double bench_batch_time(struct element_list *pElements, struct mass_batch *pBatch, int Nthreads){
+	double best;
+	double seconds;
+	int rep;
+
+	best = 0;
+	for(rep=0; rep<BENCH_BATCH_REPS; rep++){
+		seconds = thread_wall_seconds();
+		isoDalton_batch_masses(pElements, pBatch, Nthreads);
+		seconds = thread_wall_seconds() - seconds;
+		if( (0 == rep) || (seconds < best) ){
+			best = seconds;
+		}
+	}
+	return best;
+}
+
+int main(int argc, char **argv)
+{
+	char *DataPath;
+	char *DataPathUser;
+	char *UserCompFilename;
+	struct element_list   Elements;
+	struct element_list *pElements;
+	struct mass_batch Batch;
+	struct mass_batch MonoBatch;
+	int  AtomicNumber[BENCH_BATCH_ELEMENTS] = {6, 1, 7, 8, 15, 16};   // C H N O P S
+	int  MaxCount[BENCH_BATCH_ELEMENTS]     = {100, 200, 20, 30, 3, 5};
+	int *Count[BENCH_BATCH_ELEMENTS];
+	struct element_info *pElement;
+	unsigned int random;
+	int Nformulas;
+	int Nthreads;
+	int column;
+	int row;
+	double mono,average;
+	double error,max_error;
+	double seconds;
+
+	//--------------------------------------------------------------------------
+	// Paths to the data directories (relative to the C directory, where the
+	// programs are run)
+	//--------------------------------------------------------------------------
+	DataPath         = (char *)"DataFiles";
+	DataPathUser     = (char *)"DataFileUser";
+	UserCompFilename = (char *)"UserIsotopesNIST_HCNOS.xml";
+	Nformulas        = 10000000;
+	Nthreads         = thread_processor_count();
+	if( 2 < argc ){
+		DataPath     = argv[1];
+		DataPathUser = argv[2];
+	}
+	if( 3 < argc ){
+		Nformulas = atoi(argv[3]);
+	}
+	if( 4 < argc ){
+		Nthreads = atoi(argv[4]);
+	}
+
+	pElements = &Elements;
+	isoDalton_get_isotopes(DataPath, DataPathUser, UserCompFilename, pElements);
+
+	//--------------------------------------------------------------------------
+	// Random formulas, by column
+	//--------------------------------------------------------------------------
+	random = 12345;
+	for(column=0; column<BENCH_BATCH_ELEMENTS; column++){
+		Count[column] = (int *)malloc(Nformulas*sizeof(int));
+		if( NULL == Count[column] ){
+			printf("Error : could not allocate %d formulas\n",Nformulas);
+			return 1;
+		}
+		for(row=0; row<Nformulas; row++){
+			random = random*1664525u + 1013904223u;
+			Count[column][row] = (int)((random >> 8) % (unsigned int)(MaxCount[column]+1));
+		}
+	}
+	Batch.FormulaTotal = Nformulas;
+	Batch.ElementTotal = BENCH_BATCH_ELEMENTS;
+	Batch.AtomicNumber = AtomicNumber;
+	Batch.Count        = Count;
+	Batch.Monoisotopic = (double *)malloc(Nformulas*sizeof(double));
+	Batch.Lightest     = (double *)malloc(Nformulas*sizeof(double));
+	Batch.Average      = (double *)malloc(Nformulas*sizeof(double));
+	Batch.Nominal      = (int *)malloc(Nformulas*sizeof(int));
+	Batch.Defect       = (double *)malloc(Nformulas*sizeof(double));
+	if( (NULL == Batch.Monoisotopic) || (NULL == Batch.Lightest) || (NULL == Batch.Average) || (NULL == Batch.Nominal) || (NULL == Batch.Defect) ){
+		printf("Error : could not allocate %d formulas\n",Nformulas);
+		return 1;
+	}
+	printf("-----------------------------------------------------------\n");
+
+	//--------------------------------------------------------------------------
+	// Check against a formula by formula loop
+	//--------------------------------------------------------------------------
+	if( 0 != isoDalton_batch_masses(pElements, &Batch, Nthreads) ){
+		return 1;
+	}
+	max_error = 0;
+	for(row=0; row<Nformulas; row++){
+		mono    = 0;
+		average = 0;
+		for(column=0; column<BENCH_BATCH_ELEMENTS; column++){
+			pElement = &pElements->Element[AtomicNumber[column]];
+			mono    += (double)Count[column][row]*pElement->Isotope[pElement->MostCommonIsotopeIndex]->AtomicMass;
+			average += (double)Count[column][row]*pElement->AverageMass;
+		}
+		error = fabs(mono - Batch.Monoisotopic[row]) + fabs(average - Batch.Average[row]);
+		if( max_error < error ){
+			max_error = error;
+		}
+	}
+	printf("%d formulas, largest difference from the formula loop %g daltons\n",Nformulas,max_error);
+	printf("First formula: monoisotopic %.6f lightest %.6f average %.6f nominal %d defect %.6f\n",Batch.Monoisotopic[0],Batch.Lightest[0],Batch.Average[0],Batch.Nominal[0],Batch.Defect[0]);
+
+	//--------------------------------------------------------------------------
+	// Throughput
+	//--------------------------------------------------------------------------
+	seconds = bench_batch_time(pElements, &Batch, 1);
+	printf("isoDalton_batch_masses  1 thread  : %12.0f formulas/second\n",(double)Nformulas/seconds);
+	if( 1 < Nthreads ){
+		seconds = bench_batch_time(pElements, &Batch, Nthreads);
+		printf("isoDalton_batch_masses %2d threads : %12.0f formulas/second\n",Nthreads,(double)Nformulas/seconds);
+	}
+	MonoBatch          = Batch;
+	MonoBatch.Lightest = NULL;
+	MonoBatch.Average  = NULL;
+	MonoBatch.Nominal  = NULL;
+	MonoBatch.Defect   = NULL;
+	seconds = bench_batch_time(pElements, &MonoBatch, Nthreads);
+	printf("monoisotopic mass only %2d threads : %12.0f formulas/second\n",Nthreads,(double)Nformulas/seconds);
+	printf("-----------------------------------------------------------\n");
+
+	for(column=0; column<BENCH_BATCH_ELEMENTS; column++){
+		free(Count[column]);
+	}
+	free(Batch.Monoisotopic);
+	free(Batch.Lightest);
+	free(Batch.Average);
+	free(Batch.Nominal);
+	free(Batch.Defect);
+	return 0;
+}
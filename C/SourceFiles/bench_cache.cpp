@@ -0,0 +1,147 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  bench_cache.cpp                                         */
+/*               Benchmark of the result cache.  Computes a few formulas */
+/*               with isoDalton_exact_mass, stores them in a cache file  */
+/*               and times repeated lookups against the computation.     */
+/*               Usage: bench_cache [DataPath] [DataPathUser] [Nloop]    */
+/*                      [CacheFile]                                      */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_formula.h"
+#include "isoDalton_cache.h"
+
+#define BENCH_CACHE_FORMULAS 4
+#define BENCH_CACHE_STATES   1000
+
+int main(int argc, char **argv)
+{
+	char *DataPath;
+	char *DataPathUser;
+	char *UserCompFilename;
+	char *CacheFilename;
+	char  canonical[256];
+	struct element_list Elements;
+	struct formula_symbol_table *pTable;
+	struct formula_info Formula[BENCH_CACHE_FORMULAS];
+	struct molecule_info Molecule;
+	struct istates_info States;
+	struct istates_info Cached;
+	struct result_cache Cache;
+	struct cache_key Key;
+	struct cache_stats Stats;
+	int formula_index;
+	int loop_index;
+	int state_index;
+	int Nloop;
+	int Nmismatch;
+	double seconds_compute;
+	double seconds_lookup;
+	clock_t time0,time1;
+	const char *FormulaList[BENCH_CACHE_FORMULAS] = {
+		"C6H12O6",                  // glucose
+		"C10H16N5O13P3",            // ATP
+		"C254H378N65O75S6",         // bovine insulin
+		"C63H88CoN14O14P"           // cobalamin
+	};
+
+	//--------------------------------------------------------------------------
+	// Paths to the data directories (relative to the C directory, where the
+	// programs are run)
+	//--------------------------------------------------------------------------
+	DataPath         = (char *)"DataFiles";
+	DataPathUser     = (char *)"DataFileUser";
+	UserCompFilename = (char *)"UserIsotopesNIST_HCNOS.xml";
+	CacheFilename    = (char *)"bench_cache.bin";
+	Nloop            = 100000;
+	if( 2 < argc ){
+		DataPath     = argv[1];
+		DataPathUser = argv[2];
+	}
+	if( 3 < argc ){
+		Nloop = atoi(argv[3]);
+	}
+	if( 4 < argc ){
+		CacheFilename = argv[4];
+	}
+
+	data_set_verbose(0);
+	isoDalton_get_isotopes(DataPath, DataPathUser, UserCompFilename, &Elements);
+	pTable = (struct formula_symbol_table *)malloc(sizeof(struct formula_symbol_table));
+	if( 0 != isoDalton_formula_build_table(&Elements, pTable) ){
+		return 1;
+	}
+	if( 0 != isoDalton_cache_open(&Cache, CacheFilename, CACHE_MIN_SIZE*16) ){
+		return 1;
+	}
+	States.mass = (double *)malloc(BENCH_CACHE_STATES*sizeof(double));
+	States.prob = (double *)malloc(BENCH_CACHE_STATES*sizeof(double));
+	Cached.mass = (double *)malloc(BENCH_CACHE_STATES*sizeof(double));
+	Cached.prob = (double *)malloc(BENCH_CACHE_STATES*sizeof(double));
+	Key.Formula     = canonical;
+	Key.Mstates     = BENCH_CACHE_STATES;
+	Key.log10flag   = 0;
+	Key.Fingerprint = isoDalton_cache_fingerprint(&Elements);
+	Key.Parameters  = 0;
+
+	//--------------------------------------------------------------------------
+	// Compute each formula once and store it
+	//--------------------------------------------------------------------------
+	printf("-----------------------------------------------------------\n");
+	Nmismatch = 0;
+	seconds_compute = 0.0;
+	for(formula_index=0; formula_index<BENCH_CACHE_FORMULAS; formula_index++){
+		isoDalton_formula_parse(FormulaList[formula_index], pTable, &Formula[formula_index]);
+		isoDalton_formula_canonical(&Formula[formula_index], pTable, canonical, 256);
+		isoDalton_formula_molecule(&Formula[formula_index], (char *)FormulaList[formula_index], &Molecule);
+		time0 = clock();
+		isoDalton_exact_mass(&Molecule, &Elements, BENCH_CACHE_STATES, &States, 0);
+		time1 = clock();
+		seconds_compute += (double)(time1-time0)/(double)(CLOCKS_PER_SEC);
+		isoDalton_cache_insert(&Cache, &Key, &States);
+		if( 1 != isoDalton_cache_lookup(&Cache, &Key, &Cached) ){
+			Nmismatch++;
+			continue;
+		}
+		for(state_index=0; state_index<States.StateTotal; state_index++){
+			Nmismatch += (States.mass[state_index] != Cached.mass[state_index]) || (States.prob[state_index] != Cached.prob[state_index]);
+		}
+	}
+	printf("isoDalton_exact_mass   : %12.1f microseconds per formula\n",1e6*seconds_compute/BENCH_CACHE_FORMULAS);
+
+	//--------------------------------------------------------------------------
+	// Repeated lookups (canonical form and hash included)
+	//--------------------------------------------------------------------------
+	time0 = clock();
+	for(loop_index=0; loop_index<Nloop; loop_index++){
+		formula_index = loop_index%BENCH_CACHE_FORMULAS;
+		isoDalton_formula_canonical(&Formula[formula_index], pTable, canonical, 256);
+		isoDalton_cache_lookup(&Cache, &Key, &Cached);
+	}
+	time1 = clock();
+	seconds_lookup = (double)(time1-time0)/(double)(CLOCKS_PER_SEC);
+	printf("isoDalton_cache_lookup : %12.3f microseconds per formula\n",1e6*seconds_lookup/Nloop);
+	printf("cached states differing from the computed states : %d\n",Nmismatch);
+	isoDalton_cache_stats(&Cache, &Stats);
+	printf("%.0f lookups, %.0f hits, %.0f entries, %.0f bytes used\n",(double)Stats.Lookups,(double)Stats.Hits,(double)Stats.EntryTotal,(double)Stats.DataUsed);
+	printf("-----------------------------------------------------------\n");
+
+	isoDalton_cache_close(&Cache);
+	free(States.mass);
+	free(States.prob);
+	free(Cached.mass);
+	free(Cached.prob);
+	free(pTable);
+	return 0;
+}
@@ -0,0 +1,156 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  bench_formula.cpp                                       */
+/*               Benchmark of the formula parsers.  Reports formulas per */
+/*               second for isoDalton_formula_parse and for the original */
+/*               isoDalton_parse_molecular_formula.                      */
+/*               Usage: bench_formula [DataPath] [DataPathUser] [Nloop]  */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_formula.h"
+
+#define BENCH_FORMULA_TOTAL 8
+
+int main(int argc, char **argv)
+{
+	char *DataPath;
+	char *DataPathUser;
+	char *UserCompFilename;
+	char  canonical[256];
+	char  formula[256];
+	struct element_list   Elements;
+	struct element_list *pElements;
+	struct formula_symbol_table *pTable;
+	struct formula_info Formula;
+	struct molecule_info Molecule;
+	int formula_index;
+	int loop_index;
+	int Nloop;
+	int status;
+	int Nerrors;
+	double seconds;
+	double Nparsed;
+	clock_t time0,time1;
+	// Formulas in the form accepted by both parsers
+	const char *FormulaList[BENCH_FORMULA_TOTAL] = {
+		"C 2 H 5 N 1 O 2",                      // glycine
+		"C 6 H 12 O 6",                         // glucose
+		"C 10 H 16 N 5 O 13 P 3",               // ATP
+		"C 254 H 378 N 65 O 75 S 6",            // bovine insulin
+		"C 63 H 88 Co 1 N 14 O 14 P 1",         // cobalamin
+		"C 12 H 4 Cl 6",                        // PCB
+		"C 8 H 18 Sn 1 Br 2",                   // organotin
+		"C 738 H 1166 Fe 1 N 203 O 208 S 2"     // myoglobin
+	};
+	// Formulas using the extended grammar
+	const char *ExtendedList[BENCH_FORMULA_TOTAL] = {
+		"C2H5NO2",
+		"CH3(CH2)16COOH",
+		"Ca(OH)2",
+		"CuSO4.5H2O",
+		"(CH3)3C(CH2)2OH",
+		"[13C]6H13O6+",
+		"Fe2(SO4)3",
+		"PO4 3-"
+	};
+
+	//--------------------------------------------------------------------------
+	// Paths to the data directories (relative to the C directory, where the
+	// programs are run)
+	//--------------------------------------------------------------------------
+	DataPath         = (char *)"DataFiles";
+	DataPathUser     = (char *)"DataFileUser";
+	UserCompFilename = (char *)"UserIsotopesNIST_HCNOS.xml";
+	Nloop            = 1000000;
+	if( 2 < argc ){
+		DataPath     = argv[1];
+		DataPathUser = argv[2];
+	}
+	if( 3 < argc ){
+		Nloop = atoi(argv[3]);
+	}
+
+	pElements = &Elements;
+	isoDalton_get_isotopes(DataPath, DataPathUser, UserCompFilename, pElements);
+
+	pTable = (struct formula_symbol_table *)malloc(sizeof(struct formula_symbol_table));
+	if( 0 != isoDalton_formula_build_table(pElements, pTable) ){
+		return 1;
+	}
+	printf("-----------------------------------------------------------\n");
+	printf("Perfect hash multiplier = 0x%08X (%d slots)\n",pTable->Multiplier,FORMULA_HASH_SIZE);
+
+	//--------------------------------------------------------------------------
+	// Show the canonical form of each formula
+	//--------------------------------------------------------------------------
+	for(formula_index=0; formula_index<BENCH_FORMULA_TOTAL; formula_index++){
+		status = isoDalton_formula_parse(ExtendedList[formula_index], pTable, &Formula);
+		if( FORMULA_OK == status ){
+			isoDalton_formula_canonical(&Formula, pTable, canonical, 256);
+			printf("%20s -> %s\n",ExtendedList[formula_index],canonical);
+		}else{
+			printf("%20s -> error: %s at position %d\n",ExtendedList[formula_index],isoDalton_formula_error_string(status),Formula.ErrorPosition);
+		}
+	}
+	printf("-----------------------------------------------------------\n");
+
+	//--------------------------------------------------------------------------
+	// New parser
+	//--------------------------------------------------------------------------
+	Nerrors = 0;
+	time0 = clock();
+	for(loop_index=0; loop_index<Nloop; loop_index++){
+		for(formula_index=0; formula_index<BENCH_FORMULA_TOTAL; formula_index++){
+			Nerrors += (FORMULA_OK != isoDalton_formula_parse(FormulaList[formula_index], pTable, &Formula));
+		}
+	}
+	time1 = clock();
+	seconds = (double)(time1-time0)/(double)(CLOCKS_PER_SEC);
+	Nparsed = (double)Nloop*(double)BENCH_FORMULA_TOTAL;
+	printf("isoDalton_formula_parse           : %12.0f formulas/second (%d errors)\n",Nparsed/seconds,Nerrors);
+
+	Nerrors = 0;
+	time0 = clock();
+	for(loop_index=0; loop_index<Nloop; loop_index++){
+		for(formula_index=0; formula_index<BENCH_FORMULA_TOTAL; formula_index++){
+			Nerrors += (FORMULA_OK != isoDalton_formula_parse(ExtendedList[formula_index], pTable, &Formula));
+		}
+	}
+	time1 = clock();
+	seconds = (double)(time1-time0)/(double)(CLOCKS_PER_SEC);
+	printf("isoDalton_formula_parse (extended): %12.0f formulas/second (%d errors)\n",Nparsed/seconds,Nerrors);
+
+	//--------------------------------------------------------------------------
+	// Original parser (allocates and frees for every formula)
+	//--------------------------------------------------------------------------
+	Nloop = Nloop/10 + 1;
+	time0 = clock();
+	for(loop_index=0; loop_index<Nloop; loop_index++){
+		for(formula_index=0; formula_index<BENCH_FORMULA_TOTAL; formula_index++){
+			strcpy(formula,FormulaList[formula_index]);
+			isoDalton_parse_molecular_formula(formula, &Molecule, pElements);
+			free(Molecule.Formula);
+			free(Molecule.AtomicNumber);
+			free(Molecule.AtomCount);
+		}
+	}
+	time1 = clock();
+	seconds = (double)(time1-time0)/(double)(CLOCKS_PER_SEC);
+	Nparsed = (double)Nloop*(double)BENCH_FORMULA_TOTAL;
+	printf("isoDalton_parse_molecular_formula : %12.0f formulas/second\n",Nparsed/seconds);
+	printf("-----------------------------------------------------------\n");
+
+	free(pTable);
+	return 0;
+}
@@ -0,0 +1,204 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  bench_score.cpp                                         */
+/*               Benchmark of isoDalton_score_batch.  Scores a grid of   */
+/*               CHO variations of bovine insulin against the centroids  */
+/*               of insulin and reports candidates per second with one  */
+/*               thread and with Nthreads.                               */
+/*               Usage: bench_score [DataPath] [DataPathUser]            */
+/*                                  [Mstates] [Nthreads]                 */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_score.h"
+#include "thread.h"
+#include "sort.h"
+
+#define BENCH_SCORE_ELEMENTS 5
+#define BENCH_SCORE_C        5     // C 252..256
+#define BENCH_SCORE_H        8     // H 374..381
+#define BENCH_SCORE_O        3     // O 74..76
+#define BENCH_SCORE_REPS     5
+
+//--------------------------------------------------------
+// Best wall time of BENCH_SCORE_REPS batches
+//--------------------------------------------------------
+static double bench_score_time(struct score_spectrum *pSpectrum, struct istates_info *Candidates, int Ncandidates, struct spectrum_score *Scores, int Nthreads){
+	double best;
+	double seconds;
+	int rep;
+
+	best = 0;
+	for(rep=0; rep<BENCH_SCORE_REPS; rep++){
+		seconds = thread_wall_seconds();
+		isoDalton_score_batch(pSpectrum, Candidates, Ncandidates, 0, Scores, Nthreads);
+		seconds = thread_wall_seconds() - seconds;
+		if( (0 == rep) || (seconds < best) ){
+			best = seconds;
+		}
+	}
+	return best;
+}
+
+int main(int argc, char **argv)
+{
+	char *DataPath;
+	char *DataPathUser;
+	char *UserCompFilename;
+	char  formula[64];
+	struct element_list Elements;
+	struct molecule_info Molecule;
+	struct istates_info *Candidates;
+	struct istates_info Peaks;
+	struct score_spectrum Spectrum;
+	struct spectrum_score *Scores;
+	int  AtomicNumber[BENCH_SCORE_ELEMENTS] = {6, 1, 7, 8, 16};   // C H N O S
+	int  AtomCount[BENCH_SCORE_ELEMENTS]    = {254, 378, 65, 75, 6};
+	int  Ncandidates;
+	int  Mstates;
+	int  Nthreads;
+	int  candidate;
+	int  best;
+	int  c,h,o;
+	int  state_index;
+	double mass_first,mass_sum,prob_sum;
+	double seconds;
+
+	//--------------------------------------------------------------------------
+	// Paths to the data directories (relative to the C directory, where the
+	// programs are run)
+	//--------------------------------------------------------------------------
+	DataPath         = (char *)"DataFiles";
+	DataPathUser     = (char *)"DataFileUser";
+	UserCompFilename = (char *)"UserIsotopesNIST_HCNOS.xml";
+	Mstates          = 1000;
+	Nthreads         = thread_processor_count();
+	if( 2 < argc ){
+		DataPath     = argv[1];
+		DataPathUser = argv[2];
+	}
+	if( 3 < argc ){
+		Mstates = atoi(argv[3]);
+	}
+	if( 4 < argc ){
+		Nthreads = atoi(argv[4]);
+	}
+
+	data_set_verbose(0);
+	isoDalton_get_isotopes(DataPath, DataPathUser, UserCompFilename, &Elements);
+	Molecule.Formula      = formula;
+	Molecule.ElementTotal = BENCH_SCORE_ELEMENTS;
+	Molecule.AtomCount    = AtomCount;
+	Molecule.AtomicNumber = AtomicNumber;
+	Molecule.MassNumber   = NULL;
+
+	//--------------------------------------------------------------------------
+	// The observed centroids: the states of insulin summed one nominal
+	// mass at a time
+	//--------------------------------------------------------------------------
+	Peaks.mass = (double *)malloc(Mstates*sizeof(double));
+	Peaks.prob = (double *)malloc(Mstates*sizeof(double));
+	if( (NULL == Peaks.mass) || (NULL == Peaks.prob) ){
+		printf("Error : could not allocate %d states\n",Mstates);
+		return 1;
+	}
+	strcpy(formula, "C254H378N65O75S6");
+	isoDalton_exact_mass(&Molecule, &Elements, Mstates, &Peaks, 0);
+	heapsort_2dbl_up(Peaks.StateTotal, Peaks.mass, Peaks.prob);
+	c          = 0;
+	mass_first = Peaks.mass[0];
+	mass_sum   = 0;
+	prob_sum   = 0;
+	for(state_index=0; state_index<Peaks.StateTotal; state_index++){
+		if( Peaks.mass[state_index] - mass_first > 0.5 ){
+			Peaks.mass[c] = mass_sum/prob_sum;
+			Peaks.prob[c] = prob_sum;
+			c++;
+			mass_first = Peaks.mass[state_index];
+			mass_sum   = 0;
+			prob_sum   = 0;
+		}
+		mass_sum += Peaks.mass[state_index]*Peaks.prob[state_index];
+		prob_sum += Peaks.prob[state_index];
+	}
+	Peaks.mass[c]    = mass_sum/prob_sum;
+	Peaks.prob[c]    = prob_sum;
+	Peaks.StateTotal = c+1;
+	if( 0 != isoDalton_score_spectrum_init(&Spectrum, &Peaks, SCORE_DEFAULT_PPM) ){
+		return 1;
+	}
+
+	//--------------------------------------------------------------------------
+	// Candidates
+	//--------------------------------------------------------------------------
+	Ncandidates = BENCH_SCORE_C*BENCH_SCORE_H*BENCH_SCORE_O;
+	Candidates  = (struct istates_info *)malloc(Ncandidates*sizeof(struct istates_info));
+	Scores      = (struct spectrum_score *)malloc(Ncandidates*sizeof(struct spectrum_score));
+	if( (NULL == Candidates) || (NULL == Scores) ){
+		printf("Error : could not allocate %d candidates\n",Ncandidates);
+		return 1;
+	}
+	candidate = 0;
+	for(c=0; c<BENCH_SCORE_C; c++){
+		for(h=0; h<BENCH_SCORE_H; h++){
+			for(o=0; o<BENCH_SCORE_O; o++){
+				AtomCount[0] = 252 + c;
+				AtomCount[1] = 374 + h;
+				AtomCount[3] = 74 + o;
+				sprintf(formula, "C%dH%dN65O%dS6", AtomCount[0], AtomCount[1], AtomCount[3]);
+				Candidates[candidate].mass = (double *)malloc(Mstates*sizeof(double));
+				Candidates[candidate].prob = (double *)malloc(Mstates*sizeof(double));
+				if( (NULL == Candidates[candidate].mass) || (NULL == Candidates[candidate].prob) ){
+					printf("Error : could not allocate %d states\n",Mstates);
+					return 1;
+				}
+				isoDalton_exact_mass(&Molecule, &Elements, Mstates, &Candidates[candidate], 0);
+				candidate++;
+			}
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// Throughput
+	//--------------------------------------------------------------------------
+	printf("-----------------------------------------------------------\n");
+	if( 0 != isoDalton_score_batch(&Spectrum, Candidates, Ncandidates, 0, Scores, Nthreads) ){
+		return 1;
+	}
+	best = 0;
+	for(candidate=1; candidate<Ncandidates; candidate++){
+		if( Scores[best].SpectralAngle < Scores[candidate].SpectralAngle ){
+			best = candidate;
+		}
+	}
+	printf("%d candidates of %d states against %d centroids\n",Ncandidates,Mstates,Spectrum.PeakTotal);
+	printf("best: C%dH%dN65O%dS6 spectral angle %.4f ratio error %.4f\n",252+best/(BENCH_SCORE_H*BENCH_SCORE_O),374+(best/BENCH_SCORE_O)%BENCH_SCORE_H,74+best%BENCH_SCORE_O,Scores[best].SpectralAngle,Scores[best].RatioError);
+	seconds = bench_score_time(&Spectrum, Candidates, Ncandidates, Scores, 1);
+	printf("isoDalton_score_batch  1 thread  : %12.0f candidates/second\n",(double)Ncandidates/seconds);
+	if( 1 < Nthreads ){
+		seconds = bench_score_time(&Spectrum, Candidates, Ncandidates, Scores, Nthreads);
+		printf("isoDalton_score_batch %2d threads : %12.0f candidates/second\n",Nthreads,(double)Ncandidates/seconds);
+	}
+	printf("-----------------------------------------------------------\n");
+
+	for(candidate=0; candidate<Ncandidates; candidate++){
+		free(Candidates[candidate].mass);
+		free(Candidates[candidate].prob);
+	}
+	free(Candidates);
+	free(Scores);
+	free(Peaks.mass);
+	free(Peaks.prob);
+	isoDalton_score_spectrum_free(&Spectrum);
+	return 0;
+}
@@ -0,0 +1,282 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  bench_store.cpp                                         */
+/*               Driver of the element store.  Compute threads acquire   */
+/*               the published table, compute a formula and release it  */
+/*               while the main thread reloads the user isotope file,    */
+/*               alternately well formed and truncated.  Every good      */
+/*               reload must be published, every truncated one rejected, */
+/*               and every computation must match the first.             */
+/*               Usage: bench_store [DataPath] [DataPathUser] [Nreloads] */
+/*                                  [Nthreads] [ScratchDirectory]        */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_store.h"
+#include "thread.h"
+
+#define BENCH_STORE_STATES     200
+#define BENCH_STORE_MAX_THREADS 64
+#define BENCH_STORE_FILENAME   "bench_store_user.xml"
+
+struct bench_store_worker {
+	struct element_store *pStore;
+	struct istates_info  *pReference;
+	volatile long        *pStop;
+	long                  Computations;
+	long                  Mismatches;
+	long                  Generations;   // distinct generations seen
+};
+
+//--------------------------------------------------------
+// Acquire, compute, compare and release until stopped
+//--------------------------------------------------------
+static void bench_store_compute(void *argument){
+	struct bench_store_worker *pWorker;
+	struct element_list *pElements;
+	struct molecule_info Molecule;
+	struct istates_info States;
+	int  AtomicNumber[5] = {6, 1, 7, 8, 16};   // C H N O S
+	int  AtomCount[5]    = {254, 378, 65, 75, 6};
+	int  token;
+	int  state_index;
+	long generation;
+	long last_generation;
+
+	pWorker = (struct bench_store_worker *)argument;
+	Molecule.Formula      = (char *)"C254H378N65O75S6";
+	Molecule.ElementTotal = 5;
+	Molecule.AtomCount    = AtomCount;
+	Molecule.AtomicNumber = AtomicNumber;
+	Molecule.MassNumber   = NULL;
+	States.mass = (double *)malloc(BENCH_STORE_STATES*sizeof(double));
+	States.prob = (double *)malloc(BENCH_STORE_STATES*sizeof(double));
+	last_generation = 0;
+	while( 0 == thread_atomic_load(pWorker->pStop) ){
+		pElements  = isoDalton_store_acquire(pWorker->pStore, &token);
+		generation = isoDalton_store_generation(pWorker->pStore);
+		isoDalton_exact_mass(&Molecule, pElements, BENCH_STORE_STATES, &States, 0);
+		isoDalton_store_release(pWorker->pStore, token);
+		if( generation != last_generation ){
+			pWorker->Generations++;
+			last_generation = generation;
+		}
+		if( States.StateTotal != pWorker->pReference->StateTotal ){
+			pWorker->Mismatches++;
+		}else{
+			for(state_index=0; state_index<States.StateTotal; state_index++){
+				if( (States.mass[state_index] != pWorker->pReference->mass[state_index]) || (States.prob[state_index] != pWorker->pReference->prob[state_index]) ){
+					pWorker->Mismatches++;
+					break;
+				}
+			}
+		}
+		pWorker->Computations++;
+	}
+	free(States.mass);
+	free(States.prob);
+}
+
+//--------------------------------------------------------
+// Write Nbytes of the user isotope file into the scratch
+// directory.  Returns 0 on success.
+//--------------------------------------------------------
+static int bench_store_write(const char *pathfilename, const char *text, size_t Nbytes){
+	FILE *pFile;
+
+	pFile = fopen(pathfilename,"wb");
+	if( NULL == pFile ){
+		printf("Error : could not write %s\n",pathfilename);
+		return -1;
+	}
+	fwrite(text, 1, Nbytes, pFile);
+	fclose(pFile);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	char *DataPath;
+	char *DataPathUser;
+	char *UserCompFilename;
+	char *ScratchDirectory;
+	char *UserText;
+	char  pathfilename[1024];
+	struct element_store *pStore;
+	struct element_list *pElements;
+	struct molecule_info Molecule;
+	struct istates_info Reference;
+	struct bench_store_worker Workers[BENCH_STORE_MAX_THREADS];
+	struct thread_handle Threads[BENCH_STORE_MAX_THREADS];
+	volatile long Stop;
+	FILE *pFile;
+	long UserBytes;
+	long Computations;
+	long Mismatches;
+	long Generations;
+	int  AtomicNumber[5] = {6, 1, 7, 8, 16};
+	int  AtomCount[5]    = {254, 378, 65, 75, 6};
+	int  Nreloads;
+	int  Nthreads;
+	int  Npublished;
+	int  Nrejected;
+	int  Nunexpected;
+	int  reload_index;
+	int  thread_index;
+	int  token;
+	int  status;
+	double seconds;
+	double seconds_reload;
+
+	//--------------------------------------------------------------------------
+	// Paths to the data directories (relative to the C directory, where the
+	// programs are run)
+	//--------------------------------------------------------------------------
+	DataPath         = (char *)"DataFiles";
+	DataPathUser     = (char *)"DataFileUser";
+	UserCompFilename = (char *)"UserIsotopesNIST_HCNOS.xml";
+	ScratchDirectory = (char *)".";
+	Nreloads         = 20;
+	Nthreads         = thread_processor_count();
+	if( 2 < argc ){
+		DataPath     = argv[1];
+		DataPathUser = argv[2];
+	}
+	if( 3 < argc ){
+		Nreloads = atoi(argv[3]);
+	}
+	if( 4 < argc ){
+		Nthreads = atoi(argv[4]);
+	}
+	if( 5 < argc ){
+		ScratchDirectory = argv[5];
+	}
+	if( Nthreads < 1 ){
+		Nthreads = 1;
+	}
+	if( Nthreads > BENCH_STORE_MAX_THREADS ){
+		Nthreads = BENCH_STORE_MAX_THREADS;
+	}
+	data_set_verbose(0);
+
+	//--------------------------------------------------------------------------
+	// The user isotope file, copied into the scratch directory
+	//--------------------------------------------------------------------------
+	sprintf(pathfilename, "%.900s/%.100s", DataPathUser, UserCompFilename);
+	pFile = fopen(pathfilename,"rb");
+	if( NULL == pFile ){
+		printf("Error : could not open %s\n",pathfilename);
+		return 1;
+	}
+	fseek(pFile, 0, SEEK_END);
+	UserBytes = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+	UserText = (char *)malloc(UserBytes);
+	if( (NULL == UserText) || ((size_t)UserBytes != fread(UserText, 1, UserBytes, pFile)) ){
+		printf("Error : could not read %s\n",pathfilename);
+		return 1;
+	}
+	fclose(pFile);
+	sprintf(pathfilename, "%.900s/%s", ScratchDirectory, BENCH_STORE_FILENAME);
+	if( 0 != bench_store_write(pathfilename, UserText, UserBytes) ){
+		return 1;
+	}
+	pStore = isoDalton_store_create(DataPath, ScratchDirectory, (char *)BENCH_STORE_FILENAME);
+	if( NULL == pStore ){
+		return 1;
+	}
+
+	//--------------------------------------------------------------------------
+	// Reference result of the first table
+	//--------------------------------------------------------------------------
+	Molecule.Formula      = (char *)"C254H378N65O75S6";
+	Molecule.ElementTotal = 5;
+	Molecule.AtomCount    = AtomCount;
+	Molecule.AtomicNumber = AtomicNumber;
+	Molecule.MassNumber   = NULL;
+	Reference.mass = (double *)malloc(BENCH_STORE_STATES*sizeof(double));
+	Reference.prob = (double *)malloc(BENCH_STORE_STATES*sizeof(double));
+	pElements = isoDalton_store_acquire(pStore, &token);
+	isoDalton_exact_mass(&Molecule, pElements, BENCH_STORE_STATES, &Reference, 0);
+	isoDalton_store_release(pStore, token);
+
+	//--------------------------------------------------------------------------
+	// Reload while the compute threads run: odd reloads see a file cut
+	// in half, which must be rejected with the old table left in place
+	//--------------------------------------------------------------------------
+	Stop = 0;
+	for(thread_index=0; thread_index<Nthreads; thread_index++){
+		Workers[thread_index].pStore       = pStore;
+		Workers[thread_index].pReference   = &Reference;
+		Workers[thread_index].pStop        = &Stop;
+		Workers[thread_index].Computations = 0;
+		Workers[thread_index].Mismatches   = 0;
+		Workers[thread_index].Generations  = 0;
+		if( 0 != thread_start(&Threads[thread_index], bench_store_compute, &Workers[thread_index]) ){
+			printf("Error : could not start compute thread %d\n",thread_index);
+			return 1;
+		}
+	}
+	Npublished     = 0;
+	Nrejected      = 0;
+	Nunexpected    = 0;
+	seconds_reload = 0;
+	seconds        = thread_wall_seconds();
+	for(reload_index=0; reload_index<Nreloads; reload_index++){
+		if( 0 != bench_store_write(pathfilename, UserText, (1 == reload_index%2) ? UserBytes/2 : UserBytes) ){
+			return 1;
+		}
+		seconds_reload -= thread_wall_seconds();
+		isoDalton_store_reload(pStore);
+		status = isoDalton_store_wait(pStore);
+		seconds_reload += thread_wall_seconds();
+		if( 0 == status ){
+			Npublished++;
+		}else{
+			Nrejected++;
+		}
+		if( (0 == status) != (0 == reload_index%2) ){
+			Nunexpected++;
+		}
+	}
+	thread_atomic_add(&Stop, 1);
+	for(thread_index=0; thread_index<Nthreads; thread_index++){
+		thread_join(&Threads[thread_index]);
+	}
+	seconds = thread_wall_seconds() - seconds;
+
+	Computations = 0;
+	Mismatches   = 0;
+	Generations  = 0;
+	for(thread_index=0; thread_index<Nthreads; thread_index++){
+		Computations += Workers[thread_index].Computations;
+		Mismatches   += Workers[thread_index].Mismatches;
+		if( Generations < Workers[thread_index].Generations ){
+			Generations = Workers[thread_index].Generations;
+		}
+	}
+	printf("-----------------------------------------------------------\n");
+	printf("%d reloads with %d compute threads in %.3f seconds\n",Nreloads,Nthreads,seconds);
+	printf("published %d, rejected %d (malformed file), unexpected %d\n",Npublished,Nrejected,Nunexpected);
+	printf("mean reload time   : %12.3f ms\n",(0 < Nreloads) ? 1000.0*seconds_reload/Nreloads : 0.0);
+	printf("computations       : %12ld (%ld differ from the first table)\n",Computations,Mismatches);
+	printf("table generations  : %12ld seen by a compute thread, %ld published\n",Generations,isoDalton_store_generation(pStore));
+	printf("-----------------------------------------------------------\n");
+
+	isoDalton_store_free(pStore);
+	remove(pathfilename);
+	free(UserText);
+	free(Reference.mass);
+	free(Reference.prob);
+	return ((0 == Nunexpected) && (0 == Mismatches)) ? 0 : 1;
+}
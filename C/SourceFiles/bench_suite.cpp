@@ -0,0 +1,378 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  bench_suite.cpp                                         */
+/*               Benchmark suite for tracking performance.  Times table  */
+/*               loading, formula parsing and isoDalton_exact_mass for a */
+/*               fixed corpus, sweeping Mstates by decades in linear and */
+/*               log10 mode.  Each case is run after warm-up runs and    */
+/*               repeated; the median, 10th and 90th percentiles, mean,  */
+/*               minimum and maximum wall times are printed and can be   */
+/*               written as JSON.  Run bench_suite -h for the options.   */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_formula.h"
+#include "thread.h"
+#include "format.h"
+#include "sort.h"
+
+#define BENCH_SUITE_VERSION     1
+#define BENCH_SUITE_MAX_REPS    1000
+#define BENCH_SUITE_CORPUS      18
+
+struct bench_options {
+	char  *DataPath;
+	char  *UserDataPath;
+	char  *UserCompFilename;
+	char  *JsonFilename;    // NULL = no JSON
+	int    Nwarmup;
+	int    Nreps;
+	double MinStates;
+	double MaxStates;
+	double Budget;          // seconds; a run longer than this ends the Mstates sweep
+	int    Nparse;          // parses per parse sample
+	int    LinearMode;      // 1 = time linear probabilities
+	int    LogMode;         // 1 = time log10 probabilities
+};
+
+struct bench_stats {
+	int    Nsamples;
+	double Median;
+	double P10;
+	double P90;
+	double Mean;
+	double Min;
+	double Max;
+};
+
+struct bench_molecule {
+	const char *Name;
+	const char *Group;
+	const char *Formula;
+};
+
+static const struct bench_molecule BenchCorpus[BENCH_SUITE_CORPUS] = {
+	{"glycine",            "amino acid", "C2H5NO2"},
+	{"glucose",            "metabolite", "C6H12O6"},
+	{"ATP",                "metabolite", "C10H16N5O13P3"},
+	{"cholesterol",        "metabolite", "C27H46O"},
+	{"YLYEIAR",            "peptide",    "C44H66N10O12"},
+	{"LVNELTEFAK",         "peptide",    "C53H86N12O17"},
+	{"HLVDEPQNLIK",        "peptide",    "C58H96N16O18"},
+	{"DAFLGSFLYEYSR",      "peptide",    "C74H102N16O22"},
+	{"bovine insulin",     "protein",    "C254H378N65O75S6"},
+	{"myoglobin",          "protein",    "C738H1166FeN203O208S2"},
+	{"bovine serum albumin","protein",   "C2932H4614N780O898S39"},
+	{"cyclooctasulfur",    "sulfur",     "S8"},
+	{"lipoic acid",        "sulfur",     "C8H14O2S2"},
+	{"glutathione disulfide","sulfur",   "C20H32N6O12S2"},
+	{"hexachlorobiphenyl", "halogen",    "C12H4Cl6"},
+	{"hexabromobenzene",   "halogen",    "C6Br6"},
+	{"tetrabromobisphenol A","halogen",  "C15H12Br4O2"},
+	{"PFOS",               "halogen",    "C8HF17O3S"}
+};
+
+static void bench_usage(void){
+	fprintf(stderr,"Usage: bench_suite [options]\n");
+	fprintf(stderr,"  -data path        directory of NIST_isotopes.txt and AtomTabl.XML (DataFiles)\n");
+	fprintf(stderr,"  -user path        directory of the user isotope file (DataFileUser)\n");
+	fprintf(stderr,"  -comp file        user isotope file (UserIsotopesNIST_HCNOS.xml)\n");
+	fprintf(stderr,"  -json file        write the results as JSON (- for stdout)\n");
+	fprintf(stderr,"  -warmup N         untimed runs before each case (1)\n");
+	fprintf(stderr,"  -reps N           timed runs of each case (5)\n");
+	fprintf(stderr,"  -min_states N     smallest Mstates of the sweep (100)\n");
+	fprintf(stderr,"  -max_states N     largest Mstates of the sweep (10000000)\n");
+	fprintf(stderr,"  -budget seconds   stop the Mstates sweep of a formula after a slower run (5)\n");
+	fprintf(stderr,"  -parse N          parses per parsing sample (10000)\n");
+	fprintf(stderr,"  -linear | -log10  only one probability mode (both)\n");
+}
+
+static int bench_parse_options(int argc, char **argv, struct bench_options *pOptions){
+	int arg_index;
+
+	pOptions->DataPath         = (char *)"DataFiles";
+	pOptions->UserDataPath     = (char *)"DataFileUser";
+	pOptions->UserCompFilename = (char *)"UserIsotopesNIST_HCNOS.xml";
+	pOptions->JsonFilename     = NULL;
+	pOptions->Nwarmup          = 1;
+	pOptions->Nreps            = 5;
+	pOptions->MinStates        = 100;
+	pOptions->MaxStates        = 1e7;
+	pOptions->Budget           = 5.0;
+	pOptions->Nparse           = 10000;
+	pOptions->LinearMode       = 1;
+	pOptions->LogMode          = 1;
+
+	for(arg_index=1; arg_index<argc; arg_index++){
+		if( 0 == strcmp(argv[arg_index],"-linear") ){
+			pOptions->LogMode = 0;
+		}else if( 0 == strcmp(argv[arg_index],"-log10") ){
+			pOptions->LinearMode = 0;
+		}else if( (0 == strcmp(argv[arg_index],"-h")) || (arg_index+1 >= argc) ){
+			return -1;
+		}else{
+			if( 0 == strcmp(argv[arg_index],"-data") ){
+				pOptions->DataPath = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-user") ){
+				pOptions->UserDataPath = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-comp") ){
+				pOptions->UserCompFilename = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-json") ){
+				pOptions->JsonFilename = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-warmup") ){
+				pOptions->Nwarmup = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-reps") ){
+				pOptions->Nreps = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-min_states") ){
+				pOptions->MinStates = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-max_states") ){
+				pOptions->MaxStates = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-budget") ){
+				pOptions->Budget = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-parse") ){
+				pOptions->Nparse = atoi(argv[arg_index+1]);
+			}else{
+				fprintf(stderr,"Error : unknown option %s\n",argv[arg_index]);
+				return -1;
+			}
+			arg_index++;
+		}
+	}
+	if( (pOptions->Nreps < 1) || (pOptions->Nreps > BENCH_SUITE_MAX_REPS) || (pOptions->Nwarmup < 0) || (pOptions->Nparse < 1) || (pOptions->MinStates < 1) ){
+		fprintf(stderr,"Error : -reps must be 1 to %d, -warmup 0 or more, -parse and -min_states 1 or more\n",BENCH_SUITE_MAX_REPS);
+		return -1;
+	}
+	return 0;
+}
+
+//--------------------------------------------------------
+// Percentile of sorted samples, linear interpolation
+// between the closest ranks
+//--------------------------------------------------------
+static double bench_percentile(double *sorted, int Nsamples, double fraction){
+	double position;
+	int lower;
+
+	position = fraction*(double)(Nsamples-1);
+	lower    = (int)position;
+	if( lower >= Nsamples-1 ){
+		return sorted[Nsamples-1];
+	}
+	return sorted[lower] + (position - (double)lower)*(sorted[lower+1] - sorted[lower]);
+}
+
+static void bench_statistics(double *samples, int Nsamples, struct bench_stats *pStats){
+	int sample_index;
+
+	heapsort_dbl_up(Nsamples, samples);
+	pStats->Nsamples = Nsamples;
+	pStats->Median   = bench_percentile(samples, Nsamples, 0.5);
+	pStats->P10      = bench_percentile(samples, Nsamples, 0.1);
+	pStats->P90      = bench_percentile(samples, Nsamples, 0.9);
+	pStats->Min      = samples[0];
+	pStats->Max      = samples[Nsamples-1];
+	pStats->Mean     = 0.0;
+	for(sample_index=0; sample_index<Nsamples; sample_index++){
+		pStats->Mean += samples[sample_index];
+	}
+	pStats->Mean /= (double)Nsamples;
+}
+
+//--------------------------------------------------------
+// JSON helpers
+//--------------------------------------------------------
+static void bench_json_number(FILE *pFile, const char *name, double value){
+	char number[FORMAT_DOUBLE_MAX];
+
+	format_double(value, number);
+	fprintf(pFile,"\"%s\":%s",name,number);
+}
+
+static void bench_json_stats(FILE *pFile, struct bench_stats *pStats){
+	fprintf(pFile,"\"repetitions\":%d,",pStats->Nsamples);
+	bench_json_number(pFile, "median_s", pStats->Median); fputc(',', pFile);
+	bench_json_number(pFile, "p10_s",    pStats->P10);    fputc(',', pFile);
+	bench_json_number(pFile, "p90_s",    pStats->P90);    fputc(',', pFile);
+	bench_json_number(pFile, "mean_s",   pStats->Mean);   fputc(',', pFile);
+	bench_json_number(pFile, "min_s",    pStats->Min);    fputc(',', pFile);
+	bench_json_number(pFile, "max_s",    pStats->Max);
+}
+
+static void bench_print_stats(const char *label, struct bench_stats *pStats, double scale, const char *unit){
+	printf("%-46s %12.4f %12.4f %12.4f %s\n",label,scale*pStats->Median,scale*pStats->P10,scale*pStats->P90,unit);
+}
+
+int main(int argc, char **argv)
+{
+	struct bench_options Options;
+	struct bench_stats Stats;
+	struct element_list Elements;
+	struct formula_symbol_table *pTable;
+	struct formula_info Formula;
+	struct molecule_info Molecule;
+	struct istates_info States;
+	FILE  *pJson;
+	char   label[128];
+	double samples[BENCH_SUITE_MAX_REPS];
+	double Mstates;
+	double time0;
+	double seconds;
+	int    Nsamples;
+	int    run_index;
+	int    loop_index;
+	int    molecule_index;
+	int    log10flag;
+	int    Nresults;
+	int    stop_reason;     // 0 = none, 1 = over budget, 2 = all states kept
+	const char *StopName[3] = {"", "budget", "complete"};
+
+	if( 0 != bench_parse_options(argc, argv, &Options) ){
+		bench_usage();
+		return 1;
+	}
+	data_set_verbose(0);
+	pJson = NULL;
+	if( NULL != Options.JsonFilename ){
+		pJson = (0 == strcmp(Options.JsonFilename,"-")) ? stdout : fopen(Options.JsonFilename,"w");
+		if( NULL == pJson ){
+			fprintf(stderr,"Error : could not open %s\n",Options.JsonFilename);
+			return 1;
+		}
+		fprintf(pJson,"{\"benchmark\":\"isoDalton\",\"version\":%d,\"processors\":%d,",BENCH_SUITE_VERSION,thread_processor_count());
+		fprintf(pJson,"\"warmup\":%d,\"repetitions\":%d,",Options.Nwarmup,Options.Nreps);
+		bench_json_number(pJson, "budget_s", Options.Budget);
+		fprintf(pJson,",\n\"results\":[\n");
+	}
+	Nresults = 0;
+	printf("%-46s %12s %12s %12s\n","case","median","p10","p90");
+
+	//--------------------------------------------------------------------------
+	// Table loading (element tables and the formula symbol table)
+	//--------------------------------------------------------------------------
+	pTable = (struct formula_symbol_table *)malloc(sizeof(struct formula_symbol_table));
+	for(run_index=-Options.Nwarmup; run_index<Options.Nreps; run_index++){
+		time0 = thread_wall_seconds();
+		isoDalton_get_isotopes(Options.DataPath, Options.UserDataPath, Options.UserCompFilename, &Elements);
+		isoDalton_formula_build_table(&Elements, pTable);
+		if( 0 <= run_index ){
+			samples[run_index] = thread_wall_seconds() - time0;
+		}
+		data_free_elements(&Elements);
+	}
+	bench_statistics(samples, Options.Nreps, &Stats);
+	bench_print_stats("load tables", &Stats, 1e3, "ms");
+	if( NULL != pJson ){
+		fprintf(pJson,"{\"stage\":\"load\",");
+		bench_json_stats(pJson, &Stats);
+		fprintf(pJson,"}");
+		Nresults++;
+	}
+	isoDalton_get_isotopes(Options.DataPath, Options.UserDataPath, Options.UserCompFilename, &Elements);
+	if( 0 != isoDalton_formula_build_table(&Elements, pTable) ){
+		fprintf(stderr,"Error : could not build the formula symbol table\n");
+		return 1;
+	}
+
+	//--------------------------------------------------------------------------
+	// Parsing (time per formula)
+	//--------------------------------------------------------------------------
+	for(molecule_index=0; molecule_index<BENCH_SUITE_CORPUS; molecule_index++){
+		for(run_index=-Options.Nwarmup; run_index<Options.Nreps; run_index++){
+			time0 = thread_wall_seconds();
+			for(loop_index=0; loop_index<Options.Nparse; loop_index++){
+				isoDalton_formula_parse(BenchCorpus[molecule_index].Formula, pTable, &Formula);
+			}
+			if( 0 <= run_index ){
+				samples[run_index] = (thread_wall_seconds() - time0)/(double)Options.Nparse;
+			}
+		}
+		bench_statistics(samples, Options.Nreps, &Stats);
+		sprintf(label,"parse %s",BenchCorpus[molecule_index].Name);
+		bench_print_stats(label, &Stats, 1e9, "ns");
+		if( NULL != pJson ){
+			fprintf(pJson,",\n{\"stage\":\"parse\",\"name\":\"%s\",\"group\":\"%s\",\"formula\":\"%s\",",
+				BenchCorpus[molecule_index].Name,BenchCorpus[molecule_index].Group,BenchCorpus[molecule_index].Formula);
+			bench_json_stats(pJson, &Stats);
+			fprintf(pJson,"}");
+			Nresults++;
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// Trellis: Mstates by decades, linear then log10 probabilities.  The sweep
+	// of a formula ends after a run over the budget, or when every state was
+	// kept (a larger Mstates would give the same result).
+	//--------------------------------------------------------------------------
+	for(molecule_index=0; molecule_index<BENCH_SUITE_CORPUS; molecule_index++){
+		isoDalton_formula_parse(BenchCorpus[molecule_index].Formula, pTable, &Formula);
+		isoDalton_formula_molecule(&Formula, (char *)BenchCorpus[molecule_index].Formula, &Molecule);
+		for(log10flag=0; log10flag<=1; log10flag++){
+			if( ((0 == log10flag) && (0 == Options.LinearMode)) || ((1 == log10flag) && (0 == Options.LogMode)) ){
+				continue;
+			}
+			stop_reason = 0;
+			for(Mstates=Options.MinStates; (Mstates<=Options.MaxStates) && (0 == stop_reason); Mstates*=10){
+				States.mass = (double *)malloc((size_t)Mstates*sizeof(double));
+				States.prob = (double *)malloc((size_t)Mstates*sizeof(double));
+				if( (NULL == States.mass) || (NULL == States.prob) ){
+					fprintf(stderr,"Error : could not allocate %.0f states\n",Mstates);
+					free(States.mass);
+					free(States.prob);
+					break;
+				}
+				Nsamples = 0;
+				for(run_index=-Options.Nwarmup; run_index<Options.Nreps; run_index++){
+					time0 = thread_wall_seconds();
+					isoDalton_exact_mass(&Molecule, &Elements, (int)Mstates, &States, log10flag);
+					seconds = thread_wall_seconds() - time0;
+					if( (0 <= run_index) || (seconds > Options.Budget) ){
+						samples[Nsamples++] = seconds;   // a warm-up run over the budget is kept as the only sample
+					}
+					if( seconds > Options.Budget ){
+						stop_reason = 1;
+						break;
+					}
+				}
+				if( (0 == stop_reason) && (States.StateTotal < (int)Mstates) ){
+					stop_reason = 2;
+				}
+				bench_statistics(samples, Nsamples, &Stats);
+				sprintf(label,"exact_mass %s %s Mstates=%.0f",BenchCorpus[molecule_index].Name,log10flag ? "log10" : "linear",Mstates);
+				bench_print_stats(label, &Stats, 1e3, "ms");
+				if( NULL != pJson ){
+					fprintf(pJson,",\n{\"stage\":\"exact_mass\",\"name\":\"%s\",\"group\":\"%s\",\"formula\":\"%s\",",
+						BenchCorpus[molecule_index].Name,BenchCorpus[molecule_index].Group,BenchCorpus[molecule_index].Formula);
+					fprintf(pJson,"\"Mstates\":%.0f,\"log10\":%d,\"states\":%d,",Mstates,log10flag,States.StateTotal);
+					bench_json_stats(pJson, &Stats);
+					if( 0 != stop_reason ){
+						fprintf(pJson,",\"sweep_end\":\"%s\"",StopName[stop_reason]);
+					}
+					fprintf(pJson,"}");
+					Nresults++;
+				}
+				free(States.mass);
+				free(States.prob);
+			}
+		}
+	}
+
+	if( NULL != pJson ){
+		fprintf(pJson,"\n],\"result_total\":%d}\n",Nresults);
+		if( stdout != pJson ){
+			fclose(pJson);
+		}
+	}
+	free(pTable);
+	data_free_elements(&Elements);
+	return 0;
+}
@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  bench_sweep.cpp                                         */
+/*               Benchmark of the enrichment sweep.  Computes bovine     */
+/*               insulin over Nlevels 13C enrichment levels with         */
+/*               isoDalton_enrichment_sweep and with one profile run per */
+/*               level, and reports the times and the largest difference */
+/*               of the ten most probable states.                        */
+/*               Usage: bench_sweep [DataPath] [DataPathUser] [Nlevels]  */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_sweep.h"
+#include <math.h>
+
+#define BENCH_SWEEP_STATES  1000
+#define BENCH_SWEEP_COMPARE 10
+
+int main(int argc, char **argv)
+{
+	char *DataPath;
+	char *DataPathUser;
+	char *UserCompFilename;
+	char  formula[256];
+	struct element_list   Elements;
+	struct element_list *pElements;
+	struct molecule_info Molecule;
+	struct isotope_profile *pProfile;
+	struct istates_info *pSweep;
+	struct istates_info Single;
+	double *fraction;
+	int Nlevels;
+	int level_index;
+	int state_index;
+	double difference;
+	double max_mass_difference;
+	double max_prob_difference;
+	double seconds_sweep;
+	double seconds_single;
+	clock_t time0,time1;
+
+	//--------------------------------------------------------------------------
+	// Paths to the data directories (relative to the C directory, where the
+	// programs are run)
+	//--------------------------------------------------------------------------
+	DataPath         = (char *)"DataFiles";
+	DataPathUser     = (char *)"DataFileUser";
+	UserCompFilename = (char *)"UserIsotopesNIST_HCNOS.xml";
+	Nlevels          = 50;
+	if( 2 < argc ){
+		DataPath     = argv[1];
+		DataPathUser = argv[2];
+	}
+	if( 3 < argc ){
+		Nlevels = atoi(argv[3]);
+	}
+
+	pElements = &Elements;
+	isoDalton_get_isotopes(DataPath, DataPathUser, UserCompFilename, pElements);
+	strcpy(formula,"C 254 H 378 N 65 O 75 S 6");  // bovine insulin
+	isoDalton_parse_molecular_formula(formula, &Molecule, pElements);
+
+	//--------------------------------------------------------------------------
+	// 13C from natural abundance to 99%
+	//--------------------------------------------------------------------------
+	fraction = (double *)malloc(Nlevels*sizeof(double));
+	pSweep   = (struct istates_info *)malloc(Nlevels*sizeof(struct istates_info));
+	for(level_index=0; level_index<Nlevels; level_index++){
+		fraction[level_index] = 0.0107 + (0.99-0.0107)*(double)level_index/(double)((Nlevels > 1) ? Nlevels-1 : 1);
+		pSweep[level_index].StateTotal = BENCH_SWEEP_STATES;
+		pSweep[level_index].mass = (double *)malloc(BENCH_SWEEP_STATES*sizeof(double));
+		pSweep[level_index].prob = (double *)malloc(BENCH_SWEEP_STATES*sizeof(double));
+	}
+	Single.StateTotal = BENCH_SWEEP_STATES;
+	Single.mass = (double *)malloc(BENCH_SWEEP_STATES*sizeof(double));
+	Single.prob = (double *)malloc(BENCH_SWEEP_STATES*sizeof(double));
+
+	time0 = clock();
+	isoDalton_enrichment_sweep(&Molecule, pElements, 6, 13, Nlevels, fraction, BENCH_SWEEP_STATES, pSweep, 1);
+	time1 = clock();
+	seconds_sweep = (double)(time1-time0)/(double)(CLOCKS_PER_SEC);
+
+	//--------------------------------------------------------------------------
+	// One run per level
+	//--------------------------------------------------------------------------
+	max_mass_difference = 0;
+	max_prob_difference = 0;
+	seconds_single      = 0;
+	for(level_index=0; level_index<Nlevels; level_index++){
+		time0 = clock();
+		pProfile = profile_create("sweep", pElements);
+		profile_set_fraction(pProfile, 6, 13, fraction[level_index]);
+		profile_finalize(pProfile);
+		isoDalton_exact_mass_profile(&Molecule, pProfile, BENCH_SWEEP_STATES, &Single, 1);
+		profile_free(pProfile);
+		time1 = clock();
+		seconds_single += (double)(time1-time0)/(double)(CLOCKS_PER_SEC);
+		for(state_index=0; state_index<BENCH_SWEEP_COMPARE; state_index++){
+			difference = fabs(pSweep[level_index].mass[state_index] - Single.mass[state_index]);
+			if( max_mass_difference < difference ){
+				max_mass_difference = difference;
+			}
+			difference = fabs(pSweep[level_index].prob[state_index] - Single.prob[state_index]);
+			if( max_prob_difference < difference ){
+				max_prob_difference = difference;
+			}
+		}
+	}
+	printf("-----------------------------------------------------------\n");
+	printf("%d levels of 13C in [%s], %d states\n",Nlevels,Molecule.Formula,BENCH_SWEEP_STATES);
+	printf("isoDalton_enrichment_sweep   : %8.4f seconds\n",seconds_sweep);
+	printf("isoDalton_exact_mass_profile : %8.4f seconds\n",seconds_single);
+	printf("Top %d states: max mass difference %g daltons, max log10 prob difference %g\n",BENCH_SWEEP_COMPARE,max_mass_difference,max_prob_difference);
+	printf("-----------------------------------------------------------\n");
+
+	for(level_index=0; level_index<Nlevels; level_index++){
+		free(pSweep[level_index].mass);
+		free(pSweep[level_index].prob);
+	}
+	free(pSweep);
+	free(fraction);
+	free(Single.mass);
+	free(Single.prob);
+	return 0;
+}
@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  bench_text.cpp                                          */
+/*               Benchmark of the text writers.  Writes the states of    */
+/*               bovine insulin Nloop times with the fprintf loop of     */
+/*               test_isoDalton.cpp and with the TSV, CSV and NDJSON     */
+/*               writers, checks that the TSV file reads back exactly,   */
+/*               and checks the round trip of random doubles.            */
+/*               Usage: bench_text [DataPath] [DataPathUser] [Nloop]     */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_text.h"
+#include "format.h"
+
+#define BENCH_TEXT_STATES  1000
+#define BENCH_TEXT_RANDOM  1000000
+
+//--------------------------------------------------------
+// Seconds to write the states Nloop times in one format
+// (-1 is the fprintf loop).  The file is rewound first.
+//--------------------------------------------------------
+static double bench_text_write(FILE *pFile, int Format, const char *formula, struct istates_info *pStates, int Nloop, long *pBytes){
+	struct text_writer Writer;
+	int loop_index;
+	int state_index;
+	clock_t time0,time1;
+
+	rewind(pFile);
+	time0 = clock();
+	if( Format < 0 ){
+		for(loop_index=0; loop_index<Nloop; loop_index++){
+			for(state_index=0; state_index<pStates->StateTotal; state_index++){
+				fprintf(pFile,"%20.15f %20.15f\n",pStates->mass[state_index],pStates->prob[state_index]);
+			}
+		}
+		fflush(pFile);
+	}else{
+		isoDalton_text_writer_open(&Writer, pFile, Format, 0);
+		for(loop_index=0; loop_index<Nloop; loop_index++){
+			isoDalton_text_write(&Writer, formula, pStates);
+		}
+		isoDalton_text_writer_close(&Writer);
+	}
+	time1 = clock();
+	*pBytes = ftell(pFile);
+	return (double)(time1-time0)/(double)(CLOCKS_PER_SEC);
+}
+
+int main(int argc, char **argv)
+{
+	char *DataPath;
+	char *DataPathUser;
+	char *UserCompFilename;
+	char  formula[256];
+	char  line[256];
+	char  number[FORMAT_DOUBLE_MAX];
+	char *pField;
+	struct element_list   Elements;
+	struct molecule_info Molecule;
+	struct istates_info States;
+	FILE *pFile;
+	int Nloop;
+	int state_index;
+	int Nmismatch;
+	long random_index;
+	long Nbytes;
+	double value;
+	double readback;
+	double seconds_fprintf;
+	double seconds;
+	unsigned int bits[2];
+	const char *FormatName[3] = {"TSV","CSV","NDJSON"};
+	int Format;
+
+	//--------------------------------------------------------------------------
+	// Paths to the data directories (relative to the C directory, where the
+	// programs are run)
+	//--------------------------------------------------------------------------
+	DataPath         = (char *)"DataFiles";
+	DataPathUser     = (char *)"DataFileUser";
+	UserCompFilename = (char *)"UserIsotopesNIST_HCNOS.xml";
+	Nloop            = 200;
+	if( 2 < argc ){
+		DataPath     = argv[1];
+		DataPathUser = argv[2];
+	}
+	if( 3 < argc ){
+		Nloop = atoi(argv[3]);
+	}
+
+	isoDalton_get_isotopes(DataPath, DataPathUser, UserCompFilename, &Elements);
+	strcpy(formula,"C 254 H 378 N 65 O 75 S 6");  // bovine insulin
+	isoDalton_parse_molecular_formula(formula, &Molecule, &Elements);
+	States.StateTotal = BENCH_TEXT_STATES;
+	States.mass = (double *)malloc(BENCH_TEXT_STATES*sizeof(double));
+	States.prob = (double *)malloc(BENCH_TEXT_STATES*sizeof(double));
+	isoDalton_exact_mass(&Molecule, &Elements, BENCH_TEXT_STATES, &States, 0);
+
+	pFile = tmpfile();
+	if( NULL == pFile ){
+		printf("Error : could not open a temporary file\n");
+		return 1;
+	}
+
+	//--------------------------------------------------------------------------
+	// Write speed
+	//--------------------------------------------------------------------------
+	printf("-----------------------------------------------------------\n");
+	printf("%d states written %d times\n",States.StateTotal,Nloop);
+	seconds_fprintf = bench_text_write(pFile, -1, formula, &States, Nloop, &Nbytes);
+	printf("fprintf %%20.15f : %8.4f seconds %10ld bytes\n",seconds_fprintf,Nbytes);
+	for(Format=TEXT_FORMAT_TSV; Format<=TEXT_FORMAT_NDJSON; Format++){
+		seconds = bench_text_write(pFile, Format, formula, &States, Nloop, &Nbytes);
+		printf("%-16s: %8.4f seconds %10ld bytes  %5.1fx\n",FormatName[Format],seconds,Nbytes,seconds_fprintf/seconds);
+	}
+
+	//--------------------------------------------------------------------------
+	// The TSV file reads back exactly (one copy of the states)
+	//--------------------------------------------------------------------------
+	bench_text_write(pFile, TEXT_FORMAT_TSV, formula, &States, 1, &Nbytes);
+	rewind(pFile);
+	Nmismatch = 0;
+	fgets(line, 256, pFile);
+	for(state_index=0; state_index<States.StateTotal; state_index++){
+		if( NULL == fgets(line, 256, pFile) ){
+			Nmismatch++;
+			break;
+		}
+		pField   = strchr(line, '\t');
+		value    = strtod(pField+1, &pField);
+		readback = strtod(pField+1, NULL);
+		Nmismatch += (value != States.mass[state_index]) || (readback != States.prob[state_index]);
+	}
+	printf("TSV read back     : %d of %d states differ\n",Nmismatch,States.StateTotal);
+
+	//--------------------------------------------------------------------------
+	// Random bit patterns (finite doubles of every exponent)
+	//--------------------------------------------------------------------------
+	srand(1);
+	Nmismatch = 0;
+	for(random_index=0; random_index<BENCH_TEXT_RANDOM; random_index++){
+		bits[0] = ((unsigned int)rand() << 20) ^ ((unsigned int)rand() << 10) ^ (unsigned int)rand();
+		bits[1] = ((unsigned int)rand() << 20) ^ ((unsigned int)rand() << 10) ^ (unsigned int)rand();
+		memcpy(&value, bits, sizeof(value));
+		if( (value != value) || (value - value != 0.0) ){
+			continue;
+		}
+		format_double(value, number);
+		readback = strtod(number, NULL);
+		if( 0 != memcmp(&value, &readback, sizeof(value)) ){
+			if( Nmismatch < 10 ){
+				printf("Error : %.17g written as %s\n",value,number);
+			}
+			Nmismatch++;
+		}
+	}
+	printf("random doubles    : %d of %d differ after the round trip\n",Nmismatch,BENCH_TEXT_RANDOM);
+	printf("-----------------------------------------------------------\n");
+
+	fclose(pFile);
+	free(States.mass);
+	free(States.prob);
+	return 0;
+}
@@ -19,19 +19,34 @@
 
 #include "isoDalton.h"
 #include "sort.h"
+#include "thread.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include <conio.h>  // for testing
+#ifdef WIN32
+	#include <conio.h>  // for testing
+#endif
 #include <math.h>
 #include <float.h>
-#include <time.h>
+#include <limits.h>
 
 //--------------------------------------------------------
-// Create the isotope information
+// Create the isotope information.  The program stops if
+// an XML data file is missing or malformed.
 //--------------------------------------------------------
 void isoDalton_get_isotopes(char *datapath, char *userdatapath, char *usercompfilename, struct element_list *pElements){
+	if( 0 != isoDalton_load_isotopes(datapath, userdatapath, usercompfilename, pElements) ){
+		exit(255);
+	}
+}
+
+//--------------------------------------------------------
+// Create the isotope information.  Returns 0, or -1 if an
+// XML data file is missing or malformed (pElements must
+// then be freed with data_free_elements).
+//--------------------------------------------------------
+int isoDalton_load_isotopes(char *datapath, char *userdatapath, char *usercompfilename, struct element_list *pElements){
 
 	//-----------------------------------------------------------------------
 	// Read in element data from NIST
@@ -45,7 +60,9 @@ void isoDalton_get_isotopes(char *datapath, char *userdatapath, char *usercompfi
 	//         noted and will default to AtomTabl.xml
 	//-----------------------------------------------------------------------
 	data_read_NIST(datapath, pElements);
-	data_read_AtomTabl(datapath, pElements);
+	if( 0 != data_read_AtomTabl(datapath, pElements) ){
+		return -1;
+	}
 
 	//-----------------------------------------------------------------------
 	// Create a default User Isotopic Compostion Fraction file
@@ -56,17 +73,15 @@ void isoDalton_get_isotopes(char *datapath, char *userdatapath, char *usercompfi
 	//-----------------------------------------------------------------------
 	// Read a User Isotopic Composition Fraction file
 	//-----------------------------------------------------------------------
-    data_read_UserIsotopes(userdatapath, usercompfilename, pElements);
+	if( 0 != data_read_UserIsotopes(userdatapath, usercompfilename, pElements) ){
+		return -1;
+	}
 	
 	//-----------------------------------------------------------------------
 	//Make sure the Isotopic Composition Fractions sum to 1.0
 	//-----------------------------------------------------------------------
 	data_normalize_fractions(pElements);
-
-
-
-
-
+	return 0;
 }
 
 void isoDalton_parse_molecular_formula(char *molecular_formula, struct molecule_info *pMolecule, struct element_list *pElements){
@@ -85,6 +100,7 @@ void isoDalton_parse_molecular_formula(char *molecular_formula, struct molecule_
 	pMolecule->ElementTotal = 0;
 	pMolecule->AtomicNumber = NULL;
 	pMolecule->AtomCount    = NULL;
+	pMolecule->MassNumber   = NULL;
 	//printf("%s\n",pMolecule->Formula);
 
 	pch = molecular_formula;
@@ -164,6 +180,21 @@ void isoDalton_parse_molecular_formula(char *molecular_formula, struct molecule_
 	}
 }
 
+//--------------------------------------------------------
+// Find the isotope of an element by its mass number.
+// Returns the index into Element[].Isotope or -1.
+//--------------------------------------------------------
+int isoDalton_get_isotope_index(struct element_info *pElement, int MassNumber){
+	int iso_index;
+
+	for(iso_index=0; iso_index<pElement->IsotopeTotal; iso_index++){
+		if( pElement->Isotope[iso_index]->MassNumber == MassNumber ){
+			return iso_index;
+		}
+	}
+	return -1;
+}
+
 void isoDalton_combine_masses(int *Nelements, double *mass, double *prob, int log10flag) {
 	// Note: this function assumes the mass values have been sorted in ascending order
 	int mindex;
@@ -228,9 +259,7 @@ void isoDalton_combine_masses(int *Nelements, double *mass, double *prob, int lo
 		insert_index++;
 		start_index = stop_index;
 		stop_index  = start_index+1;
-		if( stop_index > *Nelements ){
-			mass[insert_index] = mass[start_index];
-			prob[insert_index] = prob[start_index];
+		if( stop_index > *Nelements ){  // start_index is one past the last state
 			break;
 		}
 	}
@@ -239,13 +268,280 @@ void isoDalton_combine_masses(int *Nelements, double *mass, double *prob, int lo
 }
 
 
-void isoDalton_exact_mass(struct molecule_info *pMolecule, struct element_list *pElements, int Mstates, struct istates_info *pisostates, int log10flag){
+//--------------------------------------------------------
+// One step of the trellis: expand the Nstate1 states by
+// one atom with Nisotopes isotopes, combine equal masses
+// and sort by decreasing probability.  state2 must hold
+// Nstate1*Nisotopes states and may be state1, in which
+// case the expansion is done in place.  Returns the number
+// of states in state2 (the caller caps it).
+//--------------------------------------------------------
+int isoDalton_trellis_step(int Nstate1, double *state1_mass, double *state1_prob, int Nisotopes, double *isotope_mass, double *isotope_fraction, double *state2_mass, double *state2_prob, int log10flag){
+	return isoDalton_trellis_step_timed(Nstate1, state1_mass, state1_prob, Nisotopes, isotope_mass, isotope_fraction, state2_mass, state2_prob, log10flag, NULL);
+}
+
+//--------------------------------------------------------
+// isoDalton_trellis_step that, if stage_seconds is not
+// NULL, adds the wall time of the expand, mass sort,
+// combine and probability sort stages to stage_seconds
+// (indexed by TRACE_STAGE_*).  With NULL the clock is
+// not read.
+//--------------------------------------------------------
+int isoDalton_trellis_step_timed(int Nstate1, double *state1_mass, double *state1_prob, int Nisotopes, double *isotope_mass, double *isotope_fraction, double *state2_mass, double *state2_prob, int log10flag, double *stage_seconds){
+	int state1_index;
+	int state2_index;
+	int isotope_index;
+	int Nstate2;
+	double mass1,prob1;
+	double time0,time1;
+
+	//---------------------------------------------------------
+	// Expand state1 by Nisotopes.  State i goes to states
+	// i*Nisotopes to i*Nisotopes+Nisotopes-1, which are at or
+	// above i, so going from the last state down never writes
+	// over a state that has not been expanded yet.
+	//---------------------------------------------------------
+	time0 = (NULL == stage_seconds) ? 0 : thread_wall_seconds();
+	Nstate2 = Nstate1*Nisotopes;
+	state2_index = Nstate2-1;
+	for(state1_index=Nstate1-1; state1_index>=0; state1_index--){
+		mass1 = state1_mass[state1_index];
+		prob1 = state1_prob[state1_index];
+		for(isotope_index=Nisotopes-1; isotope_index>=0; isotope_index--){
+			state2_mass[state2_index] = mass1 + isotope_mass[isotope_index];
+			if(1 == log10flag ){
+				state2_prob[state2_index] = log10(  pow(10,prob1) * isotope_fraction[isotope_index]  );
+			}else{
+				state2_prob[state2_index] = prob1 * isotope_fraction[isotope_index];
+			}
+			state2_index--;
+		}
+	}
+
+	//printf("Nstates2 = %d\n",Nstate2);
+	//for(state2_index=0; state2_index<Nstate2; state2_index++){
+	//	printf("%3d %17.15f %17.15f\n",state2_index,state2_mass[state2_index],state2_prob[state2_index]);
+	//}
+
+	//---------------------------------------------------------
+	// sort state2 by ascending masses
+	//---------------------------------------------------------
+	if( NULL != stage_seconds ){
+		time1 = thread_wall_seconds();
+		stage_seconds[TRACE_STAGE_EXPAND] += time1 - time0;
+		time0 = time1;
+	}
+	heapsort_2dbl_up(Nstate2, state2_mass, state2_prob);
+	if( NULL != stage_seconds ){
+		time1 = thread_wall_seconds();
+		stage_seconds[TRACE_STAGE_MASS_SORT] += time1 - time0;
+		time0 = time1;
+	}
+
+	//------------------------------------------------------------
+	// combine mass states that are closer than a mass threshold
+	//------------------------------------------------------------
+	isoDalton_combine_masses(&Nstate2, state2_mass, state2_prob, log10flag);
+	if( NULL != stage_seconds ){
+		time1 = thread_wall_seconds();
+		stage_seconds[TRACE_STAGE_COMBINE] += time1 - time0;
+		time0 = time1;
+	}
+
+	//---------------------------------------------------------
+	// sort state2 by decending probability
+	//---------------------------------------------------------
+	heapsort_2dbl_down(Nstate2, state2_prob, state2_mass);
+	if( NULL != stage_seconds ){
+		stage_seconds[TRACE_STAGE_PROB_SORT] += thread_wall_seconds() - time0;
+	}
+
+	return Nstate2;
+}
+
+
+//--------------------------------------------------------
+// Largest number of nonzero isotopes of the elements that
+// go through the trellis (1 if there are none)
+//--------------------------------------------------------
+static int isoDalton_max_isotopes(struct molecule_info *pMolecule, struct element_list *pElements, struct isotope_profile *pProfile){
+	struct element_info *pElement;
+	int maxNisotopes;
+	int index1;
+
+	maxNisotopes = 1;
+	for(index1=0; index1<pMolecule->ElementTotal; index1++){
+		if( (NULL != pMolecule->MassNumber) && (0 < pMolecule->MassNumber[index1]) ){
+			continue;  // fixed isotope
+		}
+		pElement = (NULL == pProfile) ? &pElements->Element[pMolecule->AtomicNumber[index1]] : profile_element(pProfile, pMolecule->AtomicNumber[index1]);
+		if( maxNisotopes < pElement->NonzeroIsotopeTotal ){
+			maxNisotopes = pElement->NonzeroIsotopeTotal;
+		}
+	}
+	return maxNisotopes;
+}
+
+//--------------------------------------------------------
+// Bytes allocated by the trellis: copies of
+// Mstates*maxNisotopes states at a precision (one copy,
+// the expansion is done in place, or two for the
+// clustered trellis) and the isotopes of the current
+// element.  The result arrays belong to the caller and
+// are not counted.
+//--------------------------------------------------------
+static double isoDalton_trellis_bytes(int Mstates, int maxNisotopes, int precision, int copies){
+	return copies*(double)Mstates*(double)maxNisotopes*isoDalton_state_bytes(precision) + 2.0*maxNisotopes*sizeof(double);
+}
+
+//--------------------------------------------------------
+// Peak bytes isoDalton_exact_mass would allocate for the
+// molecule, without computing anything
+//--------------------------------------------------------
+double isoDalton_exact_mass_peak_bytes(struct molecule_info *pMolecule, struct element_list *pElements, struct isotope_profile *pProfile, int Mstates){
+	return isoDalton_trellis_bytes(Mstates, isoDalton_max_isotopes(pMolecule, pElements, pProfile), STATE_PRECISION_FULL, 1);
+}
+
+//--------------------------------------------------------
+// Largest Mstates that fits in bytes at a precision
+//--------------------------------------------------------
+static int isoDalton_trellis_fit(double bytes, int maxNisotopes, int precision, int copies){
+	double Mstates;
+
+	Mstates = (bytes - isoDalton_trellis_bytes(0, maxNisotopes, precision, copies))/(copies*(double)maxNisotopes*isoDalton_state_bytes(precision));
+	if( Mstates < 0 ){
+		return 0;
+	}
+	return (Mstates > (double)INT_MAX) ? INT_MAX : (int)Mstates;
+}
+
+//--------------------------------------------------------
+// Drop the states that can no longer reach the mass
+// window: rest_min and rest_max are the lightest and
+// heaviest masses that the atoms still to add and the
+// fixed terms can give.  The order of the states is kept
+// and the number left is returned.
+//--------------------------------------------------------
+static int isoDalton_window_prune(struct exact_mass_window *pWindow, int Nstates, double *mass, double *prob, double rest_min, double rest_max, int log10flag){
+	int state_index;
+	int Nkept;
+
+	Nkept = 0;
+	for(state_index=0; state_index<Nstates; state_index++){
+		if( (mass[state_index] + rest_max < pWindow->MassLow) || (mass[state_index] + rest_min > pWindow->MassHigh) ){
+			pWindow->Outside += (1 == log10flag) ? pow(10,prob[state_index]) : prob[state_index];
+			pWindow->DroppedTotal++;
+		}else{
+			mass[Nkept] = mass[state_index];
+			prob[Nkept] = prob[state_index];
+			Nkept++;
+		}
+	}
+	return Nkept;
+}
+
+//--------------------------------------------------------
+// log10 probability of the most probable isotope
+// composition of Natoms atoms of an element (the mode of
+// the multinomial distribution): the atoms are added one
+// at a time to the isotope of largest fraction/(count+1)
+// and then moved between isotopes while that raises the
+// probability.
+//--------------------------------------------------------
+static double isoDalton_composition_mode(struct element_info *pElement, int Natoms){
+	int *count;
+	double *fraction;
+	double prob;
+	int Nisotopes;
+	int isotope_index,isotope_best;
+	int atom_index;
+	int moved;
+
+	Nisotopes = pElement->NonzeroIsotopeTotal;
+	count     = (int *)malloc(Nisotopes*sizeof(int));
+	fraction  = (double *)malloc(Nisotopes*sizeof(double));
+	for(isotope_index=0; isotope_index<Nisotopes; isotope_index++){
+		count[isotope_index]    = 0;
+		fraction[isotope_index] = pElement->Isotope[pElement->NonzeroIsotopeIndex[isotope_index]]->CompositionFraction;
+	}
+	for(atom_index=0; atom_index<Natoms; atom_index++){
+		isotope_best = 0;
+		for(isotope_index=1; isotope_index<Nisotopes; isotope_index++){
+			if( fraction[isotope_index]*(count[isotope_best]+1) > fraction[isotope_best]*(count[isotope_index]+1) ){
+				isotope_best = isotope_index;
+			}
+		}
+		count[isotope_best]++;
+	}
+	do{
+		moved = 0;
+		for(isotope_index=0; isotope_index<Nisotopes; isotope_index++){
+			for(isotope_best=0; isotope_best<Nisotopes; isotope_best++){
+				if( (0 < count[isotope_index]) && (fraction[isotope_best]*count[isotope_index] > (1.0+1e-12)*fraction[isotope_index]*(count[isotope_best]+1)) ){
+					count[isotope_index]--;
+					count[isotope_best]++;
+					moved = 1;
+				}
+			}
+		}
+	}while( moved );
+
+	// log10 of Natoms!/(count[0]!...) * fraction[0]^count[0]...
+	prob = 0;
+	for(atom_index=2; atom_index<=Natoms; atom_index++){
+		prob += log10((double)atom_index);
+	}
+	for(isotope_index=0; isotope_index<Nisotopes; isotope_index++){
+		for(atom_index=2; atom_index<=count[isotope_index]; atom_index++){
+			prob -= log10((double)atom_index);
+		}
+		if( 0 < count[isotope_index] ){
+			prob += count[isotope_index]*log10(fraction[isotope_index]);
+		}
+	}
+	free(count);
+	free(fraction);
+	return prob;
+}
+
+//--------------------------------------------------------
+// Drop the states (sorted by decreasing probability) whose
+// best completion, the log10 probability plus rest_best,
+// is below the cutoff of the probability bound.  The
+// number left is returned.
+//--------------------------------------------------------
+static int isoDalton_bound_prune(struct exact_mass_bound *pBound, int Nstates, double *prob, double rest_best, int log10flag){
+	int state_index;
+	int Nkept;
+
+	Nkept = Nstates;
+	for(state_index=0; state_index<Nstates; state_index++){
+		if( ((1 == log10flag) ? prob[state_index] : log10(prob[state_index])) + rest_best < pBound->Cutoff - BOUND_SLACK ){
+			Nkept = state_index;
+			break;
+		}
+	}
+	for(state_index=Nkept; state_index<Nstates; state_index++){
+		pBound->Pruned += (1 == log10flag) ? pow(10,prob[state_index]) : prob[state_index];
+	}
+	pBound->PrunedTotal += Nstates - Nkept;
+	return Nkept;
+}
+
+//--------------------------------------------------------
+// Order the elements of a molecule for the trellis: the
+// single isotope elements are summed into fixed terms and
+// the others are sorted by increasing number of isotopes
+// and then by increasing mass.  The elements are read
+// from pElements or, if pProfile is not NULL, through the
+// profile overlay.
+//--------------------------------------------------------
+void isoDalton_trellis_plan(struct molecule_info *pMolecule, struct element_list *pElements, struct isotope_profile *pProfile, struct trellis_plan *pPlan){
 
 	int Nelements;
 	int Natoms;
 	int Nisotopes,maxNisotopes;
-	int isotope_index;
-	int index,index1,index2,index3;
+	int index1,index2,index3;
 	int *NonzeroIsotopeTotal;
 	int *Eindex,*Mindex;
 	double mass_min;
@@ -259,13 +555,11 @@ void isoDalton_exact_mass(struct molecule_info *pMolecule, struct element_list *
 	double term_most_probable;
 	double term_least_probable;
 	double distribution_span;
-	double *state1_mass,*state2_mass,*state3_mass;
-	double *state1_prob,*state2_prob,*state3_prob;
+	double fixed_mass;
+	double fixed_prob;
+	int MassNumber;
 	double *average_mass1,*average_mass2;
-	int state1_index,state2_index;
-	int Nstate1,Nstate2;
-	int state_index;
-	clock_t time0,time1;
+	struct element_info *Etable[ELEMENT_TOTAL];  // elements of the molecule (base list or profile)
 
 	Nelements=pMolecule->ElementTotal;
 	NonzeroIsotopeTotal = (int *)malloc(Nelements*sizeof(int));
@@ -274,10 +568,43 @@ void isoDalton_exact_mass(struct molecule_info *pMolecule, struct element_list *
 	average_mass1       = (double *)malloc(Nelements*sizeof(double));
 	average_mass2       = (double *)malloc(Nelements*sizeof(double));
 	for(index1=0; index1<Nelements; index1++){
-		NonzeroIsotopeTotal[index1] = pElements->Element[pMolecule->AtomicNumber[index1]].NonzeroIsotopeTotal;
-		Eindex[index1]              = pMolecule->AtomicNumber[index1];
-		Mindex[index1]              = index1;
-		average_mass1[index1]       = pElements->Element[pMolecule->AtomicNumber[index1]].AverageMass;
+		if( NULL == pProfile ){
+			Etable[pMolecule->AtomicNumber[index1]] = &pElements->Element[pMolecule->AtomicNumber[index1]];
+		}else{
+			Etable[pMolecule->AtomicNumber[index1]] = profile_element(pProfile, pMolecule->AtomicNumber[index1]);
+		}
+	}
+
+	//--------------------------------------------------------------
+	// Elements with a single isotope, i.e. fixed isotopes such as
+	// [13C] and monoisotopic elements, only shift every state by
+	// the same mass so they are summed here and kept out of the
+	// trellis.  Nelements becomes the number of trellis elements.
+	//--------------------------------------------------------------
+	fixed_mass = 0;
+	fixed_prob = 0;  // log10
+	Nelements  = 0;
+	for(index1=0; index1<pMolecule->ElementTotal; index1++){
+		Natoms     = pMolecule->AtomCount[index1];
+		MassNumber = (NULL == pMolecule->MassNumber) ? 0 : pMolecule->MassNumber[index1];
+		average_mass1[index1] = Etable[pMolecule->AtomicNumber[index1]]->AverageMass;
+		if( 0 < MassNumber ){
+			index3 = isoDalton_get_isotope_index(Etable[pMolecule->AtomicNumber[index1]], MassNumber);
+			if( index3 < 0 ){
+				data_error("Error : isotope %d of %s is not in the element list\n",MassNumber,Etable[pMolecule->AtomicNumber[index1]]->Name);
+				continue;
+			}
+			fixed_mass += (double)Natoms*Etable[pMolecule->AtomicNumber[index1]]->Isotope[index3]->AtomicMass;
+		}else if( 1 == Etable[pMolecule->AtomicNumber[index1]]->NonzeroIsotopeTotal ){
+			index3 = Etable[pMolecule->AtomicNumber[index1]]->NonzeroIsotopeIndex[0];
+			fixed_mass += (double)Natoms*Etable[pMolecule->AtomicNumber[index1]]->Isotope[index3]->AtomicMass;
+			fixed_prob += (double)Natoms*log10(Etable[pMolecule->AtomicNumber[index1]]->Isotope[index3]->CompositionFraction);
+		}else{
+			NonzeroIsotopeTotal[Nelements] = Etable[pMolecule->AtomicNumber[index1]]->NonzeroIsotopeTotal;
+			Eindex[Nelements]              = pMolecule->AtomicNumber[index1];
+			Mindex[Nelements]              = index1;
+			Nelements++;
+		}
 	}
 
 	//--------------------------------------------------------------
@@ -290,31 +617,32 @@ void isoDalton_exact_mass(struct molecule_info *pMolecule, struct element_list *
 	}
 	heapsort_1dbl_2int_up(Nelements, average_mass2, Eindex, Mindex);  // do a secondary sort on increasing mass
 
-	printf("The molecular elements sorted by increasing isotope numbers (and then by mass)\n");
+	data_message("The molecular elements sorted by increasing isotope numbers (and then by mass)\n");
 	for(index1=0; index1<Nelements; index1++){
-		printf("Element %10s has %2d nonzero isotopes.\n",pElements->Element[Eindex[index1]].Name, pElements->Element[Eindex[index1]].NonzeroIsotopeTotal);
+		data_message("Element %10s has %2d nonzero isotopes.\n",Etable[Eindex[index1]]->Name, Etable[Eindex[index1]]->NonzeroIsotopeTotal);
 	}
-	printf("-----------------------------------------------------------\n");
+	data_message("Fixed (single isotope) mass    = %17.15f\n",fixed_mass);
+	data_message("-----------------------------------------------------------\n");
 
 	//-----------------------------------------
 	// Get mass and probability spanning info
 	//-----------------------------------------
-	term_lightest       = 0;
-	term_heaviest       = 0;
-	term_most_probable  = 0;
-	term_least_probable = 0;
+	term_lightest       = fixed_mass;
+	term_heaviest       = fixed_mass;
+	term_most_probable  = fixed_prob;
+	term_least_probable = fixed_prob;
 	for(index1=0; index1<Nelements; index1++){
 		Natoms      = pMolecule->AtomCount[Mindex[index1]];
-		Nisotopes   = pElements->Element[Eindex[index1]].NonzeroIsotopeTotal;
+		Nisotopes   = Etable[Eindex[index1]]->NonzeroIsotopeTotal;
 		mass_min =  DBL_MAX;
 		mass_max = -DBL_MAX;
 		prob_min =  DBL_MAX;
 		prob_max = -DBL_MAX;
 		for(index2=0; index2<Nisotopes; index2++){
-			index3       = pElements->Element[Eindex[index1]].NonzeroIsotopeIndex[index2];
-			mass_isotope = pElements->Element[Eindex[index1]].Isotope[index3]->AtomicMass;
-			prob_isotope = pElements->Element[Eindex[index1]].Isotope[index3]->CompositionFraction;
-			printf("%10s(%2d) isotope(%2d) mass %17.15f fraction %17.10f \n",pElements->Element[Eindex[index1]].Name,pElements->Element[Eindex[index1]].AtomicNumber,pElements->Element[Eindex[index1]].Isotope[index3]->MassNumber,pElements->Element[Eindex[index1]].Isotope[index3]->AtomicMass,pElements->Element[Eindex[index1]].Isotope[index3]->CompositionFraction);
+			index3       = Etable[Eindex[index1]]->NonzeroIsotopeIndex[index2];
+			mass_isotope = Etable[Eindex[index1]]->Isotope[index3]->AtomicMass;
+			prob_isotope = Etable[Eindex[index1]]->Isotope[index3]->CompositionFraction;
+			data_message("%10s(%2d) isotope(%2d) mass %17.15f fraction %17.10f \n",Etable[Eindex[index1]]->Name,Etable[Eindex[index1]]->AtomicNumber,Etable[Eindex[index1]]->Isotope[index3]->MassNumber,Etable[Eindex[index1]]->Isotope[index3]->AtomicMass,Etable[Eindex[index1]]->Isotope[index3]->CompositionFraction);
 			if( mass_min > mass_isotope ){
 				mass_min = mass_isotope;
 			}
@@ -342,15 +670,15 @@ void isoDalton_exact_mass(struct molecule_info *pMolecule, struct element_list *
 		//printf("      term_most_probable  = %f\n",term_most_probable);
 		//printf("      term_least_probable= %f\n",term_least_probable);
 	}
-	printf("-----------------------------------------------------------\n");
-	printf("Information regarding molecule [%s]\n",pMolecule->Formula);
-	printf("The lightest mass term = %f daltons\n",term_lightest);
-	printf("The heaviest mass term = %f daltons\n",term_heaviest);
+	data_message("-----------------------------------------------------------\n");
+	data_message("Information regarding molecule [%s]\n",pMolecule->Formula);
+	data_message("The lightest mass term = %f daltons\n",term_lightest);
+	data_message("The heaviest mass term = %f daltons\n",term_heaviest);
 	distribution_span = term_heaviest - term_lightest;
-	printf("The isotopic distribution spans = %f daltons\n",distribution_span);
-	printf("The most  probable term (log10) = %f\n",term_most_probable);
-	printf("The least probable term (log10) = %f\n",term_least_probable);
-	printf("-----------------------------------------------------------\n");
+	data_message("The isotopic distribution spans = %f daltons\n",distribution_span);
+	data_message("The most  probable term (log10) = %f\n",term_most_probable);
+	data_message("The least probable term (log10) = %f\n",term_least_probable);
+	data_message("-----------------------------------------------------------\n");
 
 
 	//---------------------------------------------------------
@@ -359,149 +687,542 @@ void isoDalton_exact_mass(struct molecule_info *pMolecule, struct element_list *
 	// Mstates*maxNisotopes where maxNisotopes is maximum 
 	// number of isotopes over all elements in the molecule.
 	//---------------------------------------------------------
-	maxNisotopes = 0;
+	maxNisotopes = 1;
 	for(index1=0; index1<Nelements; index1++){
-		Nisotopes = pElements->Element[Eindex[index1]].NonzeroIsotopeTotal;
+		Nisotopes = Etable[Eindex[index1]]->NonzeroIsotopeTotal;
 		if( Nisotopes > maxNisotopes){
 			 maxNisotopes = Nisotopes;
 		}
 	}
-	printf("maxNisotope = %d\n",maxNisotopes);
-	state1_mass = (double *)malloc(Mstates*maxNisotopes*sizeof(double));
-	state1_prob = (double *)malloc(Mstates*maxNisotopes*sizeof(double));
-	state2_mass = (double *)malloc(Mstates*maxNisotopes*sizeof(double));  //****findme**** free memory
-	state2_prob = (double *)malloc(Mstates*maxNisotopes*sizeof(double));
+	data_message("maxNisotope = %d\n",maxNisotopes);
+
+	pPlan->ElementTotal = Nelements;
+	pPlan->MaxIsotopes  = maxNisotopes;
+	pPlan->FixedMass    = fixed_mass;
+	pPlan->FixedProb    = fixed_prob;
+	pPlan->Span         = distribution_span;
+	for(index1=0; index1<Nelements; index1++){
+		pPlan->Element[index1]   = Etable[Eindex[index1]];
+		pPlan->AtomCount[index1] = pMolecule->AtomCount[Mindex[index1]];
+	}
+
+	free(NonzeroIsotopeTotal);
+	free(Eindex);
+	free(Mindex);
+	free(average_mass1);
+	free(average_mass2);
+}
+
+//--------------------------------------------------------
+// Compute the isotope distribution of a molecule.  The
+// elements are read from pElements or, if pProfile is
+// not NULL, through the profile overlay.  pReports (may
+// be NULL) selects the trace, the loss accounting and
+// the memory budget (see isoDalton_trace.h).  With
+// stop_over_budget the trellis stops as soon as the loss
+// is over its budget.  Returns 0, or -1 if the trellis
+// was stopped or not run (the result then has no states).
+//--------------------------------------------------------
+static int isoDalton_exact_mass_core(struct molecule_info *pMolecule, struct element_list *pElements, struct isotope_profile *pProfile, int Mstates, struct istates_info *pisostates, int log10flag, struct exact_mass_reports *pReports, int stop_over_budget){
+
+	int Nelements;
+	int Natoms;
+	int Nisotopes,maxNisotopes;
+	int isotope_index;
+	int index1,index2,index3;
+	double fixed_mass;
+	double fixed_prob;
+	int Nvalid;
+	double *state1_mass;
+	double *state1_prob;
+	double *isotope_mass,*isotope_fraction;
+	int Nstate1,Nstate2;
+	int state_index;
+	struct trellis_plan Plan;
+	int Ngenerated;
+	int trace_element;
+	double stage_seconds[TRACE_STAGE_TOTAL];
+	double time_start,time0,time1;
+	double discarded;
+	double prob_state;
+	int aborted;
+	int Mcapacity;
+	int max_states;
+	int precision;
+	int copies;
+	int status;
+	double bytes_limit;
+	struct loss_element *pLossElement;
+	struct exact_mass_trace *pTrace;
+	struct exact_mass_loss *pLoss;
+	struct exact_mass_memory *pMemory;
+	struct exact_mass_window *pWindow;
+	double element_min[ELEMENT_TOTAL];
+	double element_max[ELEMENT_TOTAL];
+	double rest_min[ELEMENT_TOTAL+1];
+	double rest_max[ELEMENT_TOTAL+1];
+	struct exact_mass_bound *pBound;
+	double rest_best[ELEMENT_TOTAL+1];
+	int plain;
+	int result_states;
+
+	time_start    = thread_wall_seconds();
+	time1         = time_start;
+	trace_element = 0;
+	Ngenerated    = 0;
+	aborted       = 0;
+	Mcapacity     = Mstates;
+	pLossElement  = NULL;
+	pTrace        = (NULL == pReports) ? NULL : pReports->pTrace;
+	pLoss         = (NULL == pReports) ? NULL : pReports->pLoss;
+	pMemory       = (NULL == pReports) ? NULL : pReports->pMemory;
+	pWindow       = (NULL == pReports) ? NULL : pReports->pWindow;
+	pBound        = ((NULL == pReports) || (NULL != pWindow)) ? NULL : pReports->pBound;
+	plain         = (NULL != pWindow) || (NULL != pBound);
+	result_states = Mstates;
+	if( NULL != pTrace ){
+		isoDalton_trace_reset(pTrace, Mstates, log10flag);
+	}
+	if( NULL != pLoss ){
+		pLoss->Mstates         = Mstates;
+		pLoss->OverBudget      = 0;
+		pLoss->Aborted         = 0;
+		pLoss->TruncationTotal = 0;
+		pLoss->Discarded       = 0;
+		pLoss->MaxDiscarded    = 0;
+		pLoss->Retained        = 0;
+		pLoss->ElementTotal    = 0;
+	}
+	isoDalton_trellis_plan(pMolecule, pElements, pProfile, &Plan);
+	if( (NULL != pReports) && (NULL != pReports->pSchedule) ){
+		isoDalton_schedule_plan(&Plan, Mstates, pReports->pSchedule);
+	}
+	Nelements    = Plan.ElementTotal;
+	maxNisotopes = Plan.MaxIsotopes;
+	fixed_mass   = Plan.FixedMass;
+	fixed_prob   = Plan.FixedProb;
+
+	//---------------------------------------------------------
+	// Lightest and heaviest masses of each element and of the
+	// elements after it, for the mass window, and the most
+	// probable composition of the elements after it, for the
+	// probability bound
+	//---------------------------------------------------------
+	if( plain ){
+		rest_min[Nelements]  = fixed_mass;
+		rest_max[Nelements]  = fixed_mass;
+		rest_best[Nelements] = 0;
+		for(index1=Nelements-1; index1>=0; index1--){
+			element_min[index1]  =  DBL_MAX;
+			element_max[index1]  = -DBL_MAX;
+			for(isotope_index=0; isotope_index<Plan.Element[index1]->NonzeroIsotopeTotal; isotope_index++){
+				index3 = Plan.Element[index1]->NonzeroIsotopeIndex[isotope_index];
+				if( element_min[index1] > Plan.Element[index1]->Isotope[index3]->AtomicMass ){
+					element_min[index1] = Plan.Element[index1]->Isotope[index3]->AtomicMass;
+				}
+				if( element_max[index1] < Plan.Element[index1]->Isotope[index3]->AtomicMass ){
+					element_max[index1] = Plan.Element[index1]->Isotope[index3]->AtomicMass;
+				}
+			}
+			rest_min[index1]  = rest_min[index1+1]  + Plan.AtomCount[index1]*element_min[index1];
+			rest_max[index1]  = rest_max[index1+1]  + Plan.AtomCount[index1]*element_max[index1];
+			if( NULL != pBound ){
+				rest_best[index1] = rest_best[index1+1] + isoDalton_composition_mode(Plan.Element[index1], Plan.AtomCount[index1]);
+			}
+		}
+	}
+	if( NULL != pBound ){
+		result_states = ((0 < pBound->ResultStates) && (pBound->ResultStates < Mstates)) ? pBound->ResultStates : Mstates;
+		pBound->Cutoff      = -DBL_MAX;
+		pBound->Pruned      = 0;
+		pBound->PrunedTotal = 0;
+		pBound->LargestStep = 0;
+	}
+	if( NULL != pWindow ){
+		if( 0 <= pWindow->NominalOffset ){
+			pWindow->MassLow  = rest_min[0] + pWindow->NominalOffset - WINDOW_NOMINAL_HALF_WIDTH;
+			pWindow->MassHigh = rest_min[0] + pWindow->NominalOffset + WINDOW_NOMINAL_HALF_WIDTH;
+		}
+		pWindow->Outside      = 0;
+		pWindow->DroppedTotal = 0;
+		data_message("Mass window %f to %f daltons\n",pWindow->MassLow,pWindow->MassHigh);
+	}
+
+	//---------------------------------------------------------
+	// Out of core, the states are in spill files and only
+	// the run buffer is limited by the memory budget
+	//---------------------------------------------------------
+	if( (NULL != pReports) && (NULL != pReports->pExternal) && (0 == plain) ){
+		status = isoDalton_external_trellis(&Plan, Mstates, Mcapacity, pisostates, log10flag, pReports, stop_over_budget, time_start);
+		if( NULL != pTrace ){
+			pTrace->TotalSeconds = thread_wall_seconds() - time_start;
+		}
+		return status;
+	}
 
-	time0 = clock();
 	//---------------------------------------------------------
-	// Load initial states
+	// Mstates*maxNisotopes states must be countable in an int
+	// and, with a memory budget, the states must fit in it:
+	// the precision is lowered (MEMORY_ACTION_FIT_PRECISION),
+	// then Mstates, or nothing is computed.
 	//---------------------------------------------------------
-	Nisotopes   = pElements->Element[Eindex[0]].NonzeroIsotopeTotal;
-	for(index=0; index<Nisotopes; index++){
-		index2            = pElements->Element[Eindex[0]].NonzeroIsotopeIndex[index];
-		state1_mass[index] = pElements->Element[Eindex[0]].Isotope[index2]->AtomicMass;
-		if(1 == log10flag ){
-		    state1_prob[index] = log10(pElements->Element[Eindex[0]].Isotope[index2]->CompositionFraction);
+	precision   = ((NULL == pMemory) || plain) ? STATE_PRECISION_FULL : pMemory->Precision;
+	copies      = ((NULL != pReports) && (NULL != pReports->pClusters) && (0 == plain) && (STATE_PRECISION_FULL == precision)) ? 2 : 1;
+	max_states  = INT_MAX/maxNisotopes;
+	bytes_limit = ((NULL != pMemory) && (0 < pMemory->Budget)) ? pMemory->Budget : DBL_MAX;
+	if( NULL != pMemory ){
+		pMemory->RequestedBytes = isoDalton_trellis_bytes(Mstates, maxNisotopes, precision, copies);
+		pMemory->Fitted         = 0;
+		pMemory->Refused        = 0;
+	}
+	if( (Mstates > max_states) || (isoDalton_trellis_bytes(Mstates, maxNisotopes, precision, copies) > bytes_limit) ){
+		if( (NULL != pMemory) && (MEMORY_ACTION_FIT_PRECISION == pMemory->Action) && (STATE_PRECISION_FULL == precision) && (0 == plain) ){
+			precision = STATE_PRECISION_COMPACT;
+			copies    = 1;
+			data_message("Compact states to fit the memory budget\n");
+		}
+		if( (NULL != pMemory) && (MEMORY_ACTION_REFUSE != pMemory->Action) ){
+			if( Mstates > isoDalton_trellis_fit(bytes_limit, maxNisotopes, precision, copies) ){
+				Mstates = isoDalton_trellis_fit(bytes_limit, maxNisotopes, precision, copies);
+				pMemory->Fitted = 1;
+			}
+			if( Mstates > max_states ){
+				Mstates = max_states;
+				pMemory->Fitted = 1;
+			}
+			if( pMemory->Fitted ){
+				data_message("Mstates lowered to %d to fit the memory budget\n",Mstates);
+			}
 		}else{
-			state1_prob[index] = pElements->Element[Eindex[0]].Isotope[index2]->CompositionFraction;
+			Mstates = 0;
 		}
 	}
-	printf("Initialized lattice with Element %s\n",pElements->Element[Eindex[0]].Name);
-	Nstate1=Nisotopes;
-	Nstate2=0;
-	for(index=0; index<Nisotopes; index++){
-		if(1 == log10flag ){
-		    printf("state %d mass=%f log10(prob)=%f\n",index,state1_mass[index],state1_prob[index]);
+	if( NULL != pMemory ){
+		pMemory->Precision = precision;
+		pMemory->Mstates   = Mstates;
+		pMemory->PeakBytes = isoDalton_trellis_bytes(Mstates, maxNisotopes, precision, copies);
+	}
+	if( NULL != pLoss ){
+		pLoss->Mstates = Mstates;
+	}
+	if( (STATE_PRECISION_FULL != precision) && (0 < Mstates) ){
+		status = isoDalton_compact_trellis(&Plan, precision, Mstates, Mcapacity, pisostates, log10flag, pReports, stop_over_budget, time_start);
+		if( (0 != status) && (NULL != pMemory) && ((NULL == pLoss) || (0 == pLoss->Aborted)) ){
+			pMemory->Refused   = 1;
+			pMemory->PeakBytes = 0;
+		}
+		if( NULL != pTrace ){
+			pTrace->TotalSeconds = thread_wall_seconds() - time_start;
+		}
+		return status;
+	}
+	if( (2 == copies) && (0 < Mstates) ){
+		status = isoDalton_cluster_trellis(&Plan, Mstates, Mcapacity, pisostates, log10flag, pReports, stop_over_budget, time_start);
+		if( (0 != status) && (NULL != pMemory) && ((NULL == pLoss) || (0 == pLoss->Aborted)) ){
+			pMemory->Refused   = 1;
+			pMemory->PeakBytes = 0;
+		}
+		if( NULL != pTrace ){
+			pTrace->TotalSeconds = thread_wall_seconds() - time_start;
+		}
+		return status;
+	}
+
+	state1_mass      = NULL;
+	state1_prob      = NULL;
+	isotope_mass     = NULL;
+	isotope_fraction = NULL;
+	if( 0 < Mstates ){
+		state1_mass      = (double *)malloc((size_t)Mstates*maxNisotopes*sizeof(double));
+		state1_prob      = (double *)malloc((size_t)Mstates*maxNisotopes*sizeof(double));
+		isotope_mass     = (double *)malloc(maxNisotopes*sizeof(double));
+		isotope_fraction = (double *)malloc(maxNisotopes*sizeof(double));
+	}
+	if( (NULL == state1_mass) || (NULL == state1_prob) || (NULL == isotope_mass) || (NULL == isotope_fraction) ){
+		if( 0 < Mstates ){
+			data_error("Error : could not allocate %d states of %d isotopes for %s\n",Mstates,maxNisotopes,pMolecule->Formula);
 		}else{
-		    printf("state %d mass=%f prob=%f\n",index,state1_mass[index],state1_prob[index]);
+			data_message("%d states of %d isotopes for %s do not fit in the memory budget\n",Mcapacity,maxNisotopes,pMolecule->Formula);
 		}
+		if( NULL != pMemory ){
+			pMemory->Refused   = 1;
+			pMemory->Mstates   = 0;
+			pMemory->PeakBytes = 0;
+		}
+		Mstates = 0;
+		aborted = 1;
 	}
 
+	time0 = thread_wall_seconds();
+	if( NULL != pTrace ){
+		pTrace->SetupSeconds = time0 - time_start;
+	}
+	//---------------------------------------------------------
+	// Load the initial state, the empty molecule, which the
+	// first trellis step expands by the isotopes of the first
+	// element (a molecule of fixed isotopes keeps this state)
+	//---------------------------------------------------------
+	if( 0 == aborted ){
+		state1_mass[0] = 0;
+		state1_prob[0] = (1 == log10flag) ? 0 : 1;
+	}
+	Nstate1=1;
+	Nstate2=0;
+
 	//---------------------------------------------------------
 	// Trellis
 	//---------------------------------------------------------
-	for(index1=0; index1<Nelements; index1++){
-		Natoms      = pMolecule->AtomCount[Mindex[index1]];
-		Nisotopes   = pElements->Element[Eindex[index1]].NonzeroIsotopeTotal;
-		for(index2=0; index2<Natoms; index2++){
-			if( !(index1==0 && index2==0) ){ // skip the first entry since this was preloaded in the trellis
-				//printf("Nstate1=%d  Nisotopes=%d\n",Nstate1,Nisotopes);
-				//---------------------------------------------------------
-				// Expand state1 by Nisotopes
-				//---------------------------------------------------------
-				state2_index=0;
-				for(state1_index=0; state1_index<Nstate1; state1_index++){
-					for(isotope_index=0; isotope_index<Nisotopes; isotope_index++){
-						index3                    = pElements->Element[Eindex[index1]].NonzeroIsotopeIndex[isotope_index];
-						state2_mass[state2_index] = state1_mass[state1_index] + pElements->Element[Eindex[index1]].Isotope[index3]->AtomicMass;
-						if(1 == log10flag ){
-							state2_prob[state2_index] = log10(  pow(10,state1_prob[state1_index]) * pElements->Element[Eindex[index1]].Isotope[index3]->CompositionFraction  );
-						}else{
-							state2_prob[state2_index] = state1_prob[state1_index] * pElements->Element[Eindex[index1]].Isotope[index3]->CompositionFraction;
-						}
-						state2_index++;
+	for(index1=0; (index1<Nelements) && (0 == aborted); index1++){
+		Natoms      = Plan.AtomCount[index1];
+		Nisotopes   = Plan.Element[index1]->NonzeroIsotopeTotal;
+		for(isotope_index=0; isotope_index<Nisotopes; isotope_index++){
+			index3                        = Plan.Element[index1]->NonzeroIsotopeIndex[isotope_index];
+			isotope_mass[isotope_index]     = Plan.Element[index1]->Isotope[index3]->AtomicMass;
+			isotope_fraction[isotope_index] = Plan.Element[index1]->Isotope[index3]->CompositionFraction;
+		}
+		if( NULL != pTrace ){
+			trace_element = isoDalton_trace_add_element(pTrace, Plan.Element[index1]->AtomicNumber, Natoms, Nisotopes);
+		}
+		if( NULL != pLoss ){
+			pLossElement = &pLoss->Element[pLoss->ElementTotal++];
+			pLossElement->AtomicNumber = Plan.Element[index1]->AtomicNumber;
+			pLossElement->Discarded    = 0;
+			pLossElement->MaxDiscarded = 0;
+		}
+		for(index2=0; (index2<Natoms) && (0 == aborted); index2++){
+			if( NULL == pTrace ){
+				Nstate2 = isoDalton_trellis_step(Nstate1, state1_mass, state1_prob, Nisotopes, isotope_mass, isotope_fraction, state1_mass, state1_prob, log10flag);
+			}else{
+				for(index3=0; index3<TRACE_STAGE_TOTAL; index3++){
+					stage_seconds[index3] = 0;
+				}
+				Ngenerated = Nstate1*Nisotopes;
+				Nstate2 = isoDalton_trellis_step_timed(Nstate1, state1_mass, state1_prob, Nisotopes, isotope_mass, isotope_fraction, state1_mass, state1_prob, log10flag, stage_seconds);
+				time1 = thread_wall_seconds();
+			}
+
+			//printf("Element %10s Atom Count %d\n",Plan.Element[index1]->Name, index2);
+
+			//----------------------------------------------
+			// Drop the states out of reach of the window
+			//----------------------------------------------
+			if( NULL != pWindow ){
+				Nstate2 = isoDalton_window_prune(pWindow, Nstate2, state1_mass, state1_prob, rest_min[index1+1] + (Natoms-index2-1)*element_min[index1], rest_max[index1+1] + (Natoms-index2-1)*element_max[index1], log10flag);
+			}
+
+			//----------------------------------------------
+			// Once an element is complete the states are
+			// compositions: drop those whose best completion
+			// is below the cutoff, and raise the cutoff to
+			// the result_states-th best completion
+			//----------------------------------------------
+			if( (NULL != pBound) && (index2 == Natoms-1) ){
+				Nstate2 = isoDalton_bound_prune(pBound, Nstate2, state1_prob, rest_best[index1+1], log10flag);
+				if( result_states <= Nstate2 ){
+					prob_state = (1 == log10flag) ? state1_prob[result_states-1] : log10(state1_prob[result_states-1]);
+					if( pBound->Cutoff < prob_state + rest_best[index1+1] ){
+						pBound->Cutoff = prob_state + rest_best[index1+1];
 					}
 				}
-				Nstate2 = state2_index;
-
-				//printf("Nstates2 = %d\n",Nstate2);
-				//for(state2_index=0; state2_index<Nstate2; state2_index++){
-				//	printf("%3d %17.15f %17.15f\n",state2_index,state2_mass[state2_index],state2_prob[state2_index]);
-				//}
-
-				//---------------------------------------------------------
-				// sort state2 by ascending masses
-				//---------------------------------------------------------
-				heapsort_2dbl_up(Nstate2, state2_mass, state2_prob);
-
-				//printf("Nstates2 = %d   sorted by mass\n",Nstate2);
-				//for(state2_index=0; state2_index<Nstate2; state2_index++){
-				//	printf("%3d %f %f\n",state2_index,state2_mass[state2_index],state2_prob[state2_index]);
-				//}
-
-				//------------------------------------------------------------
-				// combine mass states that are closer than a mass threshold
-				//------------------------------------------------------------
-				isoDalton_combine_masses(&Nstate2, state2_mass, state2_prob, log10flag);
-
-				//printf("Nstates2 = %d   mass combined\n",Nstate2);
-				//for(state2_index=0; state2_index<Nstate2; state2_index++){
-				//	printf("%3d %f %f\n",state2_index,state2_mass[state2_index],state2_prob[state2_index]);
-				//}
-
-				//---------------------------------------------------------
-				// sort state2 by decending probability
-				//---------------------------------------------------------
-				heapsort_2dbl_down(Nstate2, state2_prob, state2_mass);
-
-				//printf("sorted by probability\n");
-				//for(state2_index=0; state2_index<Nstate2; state2_index++){
-				//	printf("%3d %17.15f %17.15f\n",state2_index,state2_mass[state2_index],state2_prob[state2_index]);
-				//}
-
-
-				//printf("Element %10s Atom Count %d\n",pElements->Element[Eindex[index1]].Name, index2);
-
-
-			//printf("\n\n\n press the key c to continue \n");
-			//while(1){
-			//	ch = _getch();
-			//	if( 'c' == ch ){
-			//		break;
-			//	}
-			//}
-
-			    //----------------------------------------------
-			    // Swap pointers so state2 becomes state1
-				// and vice versa and cap number of states
-			    //----------------------------------------------
-			    state3_mass = state1_mass;
-			    state3_prob = state1_prob;
-			    state1_mass = state2_mass;
-			    state1_prob = state2_prob;
-			    state2_mass = state3_mass;
-			    state2_prob = state3_prob;
-				if( Nstate2 > Mstates ){
-                    Nstate1 = Mstates;
-				}else{
-					Nstate1 = Nstate2;
+			}
+
+			//----------------------------------------------
+			// Cap the number of states (the step works in
+			// place so the states are already in state1)
+			//----------------------------------------------
+			if( Nstate2 > Mstates ){
+				Nstate1 = Mstates;
+			}else{
+				Nstate1 = Nstate2;
+			}
+
+			//----------------------------------------------
+			// The dropped states are the tail of the states
+			// sorted by decreasing probability
+			//----------------------------------------------
+			if( (NULL != pLoss) && (Nstate2 > Mstates) ){
+				discarded = 0;
+				for(state_index=Mstates; state_index<Nstate2; state_index++){
+					discarded += (1 == log10flag) ? pow(10,state1_prob[state_index]) : state1_prob[state_index];
+				}
+				prob_state = (1 == log10flag) ? pow(10,state1_prob[Mstates]) : state1_prob[Mstates];
+				pLossElement->Discarded += discarded;
+				if( pLossElement->MaxDiscarded < prob_state ){
+					pLossElement->MaxDiscarded = prob_state;
 				}
+				pLoss->Discarded += discarded;
+				if( pLoss->MaxDiscarded < prob_state ){
+					pLoss->MaxDiscarded = prob_state;
+				}
+				pLoss->TruncationTotal++;
+				if( (0 < pLoss->Budget) && (pLoss->Discarded > pLoss->Budget) ){
+					pLoss->OverBudget = 1;
+					aborted = stop_over_budget;
+				}
+			}
+			if( (NULL != pBound) && (pBound->LargestStep < Nstate1) ){
+				pBound->LargestStep = Nstate1;
+			}
+			if( NULL != pTrace ){
+				stage_seconds[TRACE_STAGE_TRUNCATE] = thread_wall_seconds() - time1;
+				isoDalton_trace_add_step(pTrace, trace_element, index2, Ngenerated, Nstate2, Nstate1, stage_seconds);
 			}
 		}
 	}
-	time1 = clock();
-	printf("clock rate of timer = %d\n",CLOCKS_PER_SEC);
-	printf("It took %8.4f seconds to compute isotope spectra\n",(double)(time1-time0)/(double)(CLOCKS_PER_SEC));
-	printf("Number of States = %d\n",Mstates);
+	if( (NULL != pWindow) && (0 == aborted) ){
+		Nstate1 = isoDalton_window_prune(pWindow, Nstate1, state1_mass, state1_prob, fixed_mass, fixed_mass, log10flag);  // a molecule of fixed isotopes
+	}
+	time1 = thread_wall_seconds();
+	data_message("It took %8.4f seconds (wall time) to compute isotope spectra\n",time1-time0);
+	data_message("Number of States = %d\n",Mstates);
 
 
-	for(state_index=0; state_index<Mstates; state_index++){
-		pisostates->mass[state_index] = state1_mass[state_index];
-		pisostates->prob[state_index] = state1_prob[state_index];
+	//---------------------------------------------------------
+	// Copy out the states shifted by the fixed isotope terms.
+	// StateTotal is set to the number of valid states and any
+	// remaining entries are zeroed.
+	//---------------------------------------------------------
+	Nvalid = (Nstate1 < result_states) ? Nstate1 : result_states;
+	if( NULL != pBound ){
+		pBound->Cutoff += fixed_prob;
+	}
+	if( aborted ){
+		Nvalid = 0;
+		if( NULL != pLoss ){
+			pLoss->Aborted = 1;
+		}
+	}
+	if( NULL != pLoss ){
+		for(state_index=0; state_index<Nvalid; state_index++){
+			pLoss->Retained += (1 == log10flag) ? pow(10,state1_prob[state_index]) : state1_prob[state_index];
+		}
+	}
+	for(state_index=0; state_index<Mcapacity; state_index++){
+		if( state_index < Nvalid ){
+			pisostates->mass[state_index] = state1_mass[state_index] + fixed_mass;
+			if(1 == log10flag ){
+				pisostates->prob[state_index] = state1_prob[state_index] + fixed_prob;
+			}else{
+				pisostates->prob[state_index] = state1_prob[state_index] * pow(10.0,fixed_prob);
+			}
+		}else{
+			pisostates->mass[state_index] = 0;
+			pisostates->prob[state_index] = (1 == log10flag) ? -DBL_MAX : 0;
+		}
 	}
+	pisostates->StateTotal = Nvalid;
 
+	free(isotope_mass);
+	free(isotope_fraction);
+	free(state1_mass);
+	free(state1_prob);
+
+	if( NULL != pTrace ){
+		pTrace->TotalSeconds = thread_wall_seconds() - time_start;
+	}
+	return aborted ? -1 : 0;
 }			   
 			   
 
+void isoDalton_exact_mass(struct molecule_info *pMolecule, struct element_list *pElements, int Mstates, struct istates_info *pisostates, int log10flag){
+	isoDalton_exact_mass_core(pMolecule, pElements, NULL, Mstates, pisostates, log10flag, NULL, 0);
+}
+
+//--------------------------------------------------------
+// Same as isoDalton_exact_mass but with the isotope
+// fractions and masses of a (finalized) abundance profile
+//--------------------------------------------------------
+void isoDalton_exact_mass_profile(struct molecule_info *pMolecule, struct isotope_profile *pProfile, int Mstates, struct istates_info *pisostates, int log10flag){
+	isoDalton_exact_mass_core(pMolecule, pProfile->pBase, pProfile, Mstates, pisostates, log10flag, NULL, 0);
+}
 
+//--------------------------------------------------------
+// Same as isoDalton_exact_mass (or, if pProfile is not
+// NULL, isoDalton_exact_mass_profile) with the reports
+// and budgets of pReports (see isoDalton_trace.h):
+//   pTrace   wall time of every stage and state counts
+//   pLoss    probability discarded by the cap at Mstates
+//            and what to do when it is over budget:
+//            LOSS_ACTION_REPORT  compute with Mstates
+//            LOSS_ACTION_ABORT   stop once over budget
+//            LOSS_ACTION_GROW    double Mstates up to
+//                                MaxStates until within
+//                                budget; pisostates must
+//                                hold MaxStates
+//   pMemory  peak bytes of the trellis and a limit on
+//            them: MEMORY_ACTION_REFUSE computes nothing
+//            if Mstates does not fit, MEMORY_ACTION_FIT
+//            lowers Mstates until it does
+// Returns 0, or -1 if the loss is over budget or the
+// memory budget (or malloc) refused the computation.
+//--------------------------------------------------------
+int isoDalton_exact_mass_report(struct molecule_info *pMolecule, struct element_list *pElements, struct isotope_profile *pProfile, int Mstates, struct istates_info *pisostates, int log10flag, struct exact_mass_reports *pReports){
+	struct exact_mass_loss *pLoss;
+	int stop_over_budget;
+	int status;
 
+	if( NULL != pProfile ){
+		pElements = pProfile->pBase;
+	}
+	pLoss = pReports->pLoss;
+	if( NULL == pLoss ){
+		return isoDalton_exact_mass_core(pMolecule, pElements, pProfile, Mstates, pisostates, log10flag, pReports, 0);
+	}
+	if( (LOSS_ACTION_GROW == pLoss->Action) && (pLoss->MaxStates < Mstates) ){
+		pLoss->MaxStates = Mstates;
+	}
+	pLoss->Attempts = 0;
+	for(;;){
+		//----------------------------------------------------
+		// Each attempt but the last one may stop early
+		//----------------------------------------------------
+		stop_over_budget = (LOSS_ACTION_ABORT == pLoss->Action) || ((LOSS_ACTION_GROW == pLoss->Action) && (Mstates < pLoss->MaxStates));
+		pLoss->Attempts++;
+		status = isoDalton_exact_mass_core(pMolecule, pElements, pProfile, Mstates, pisostates, log10flag, pReports, stop_over_budget);
+		if( (0 == pLoss->OverBudget) || (LOSS_ACTION_GROW != pLoss->Action) || (Mstates >= pLoss->MaxStates) ){
+			break;
+		}
+		//----------------------------------------------------
+		// No point growing past what the memory budget fits
+		//----------------------------------------------------
+		if( (NULL != pReports->pMemory) && (pReports->pMemory->Fitted || pReports->pMemory->Refused) ){
+			break;
+		}
+		Mstates = (Mstates > pLoss->MaxStates/2) ? pLoss->MaxStates : 2*Mstates;
+	}
+	return (pLoss->OverBudget || (0 != status)) ? -1 : 0;
+}
+
+//--------------------------------------------------------
+// isoDalton_exact_mass_report with only the trace
+//--------------------------------------------------------
+void isoDalton_exact_mass_traced(struct molecule_info *pMolecule, struct element_list *pElements, struct isotope_profile *pProfile, int Mstates, struct istates_info *pisostates, int log10flag, struct exact_mass_trace *pTrace){
+	struct exact_mass_reports Reports;
+
+	Reports.pTrace    = pTrace;
+	Reports.pLoss     = NULL;
+	Reports.pMemory   = NULL;
+	Reports.pExternal = NULL;
+	Reports.pClusters = NULL;
+	Reports.pWindow   = NULL;
+	Reports.pBound    = NULL;
+	Reports.pSchedule = NULL;
+	isoDalton_exact_mass_report(pMolecule, pElements, pProfile, Mstates, pisostates, log10flag, &Reports);
+}
+
+//--------------------------------------------------------
+// isoDalton_exact_mass_report with only the loss report
+//--------------------------------------------------------
+int isoDalton_exact_mass_loss(struct molecule_info *pMolecule, struct element_list *pElements, struct isotope_profile *pProfile, int Mstates, struct istates_info *pisostates, int log10flag, struct exact_mass_loss *pLoss){
+	struct exact_mass_reports Reports;
+
+	Reports.pTrace    = NULL;
+	Reports.pLoss     = pLoss;
+	Reports.pMemory   = NULL;
+	Reports.pExternal = NULL;
+	Reports.pClusters = NULL;
+	Reports.pWindow   = NULL;
+	Reports.pBound    = NULL;
+	Reports.pSchedule = NULL;
+	return isoDalton_exact_mass_report(pMolecule, pElements, pProfile, Mstates, pisostates, log10flag, &Reports);
+}
@@ -17,6 +17,13 @@
 /*-----------------------------------------------------------------------*/ 
 
 #include "data.h" 
+#include "profile.h"
+#include "isoDalton_trace.h"
+#include "isoDalton_compact.h"
+#include "isoDalton_external.h"
+#include "isoDalton_cluster.h"
+#include "isoDalton_schedule.h"
+#include "isoDalton_moments.h"
 
 struct istates_info {
 	int StateTotal;
@@ -24,10 +31,34 @@ struct istates_info {
 	double *prob;
 };
 
+//--------------------------------------------------------
+// Elements of a molecule in trellis order
+// (isoDalton_trellis_plan)
+//--------------------------------------------------------
+struct trellis_plan {
+	int    ElementTotal;                          // elements with two or more isotopes
+	struct element_info *Element[ELEMENT_TOTAL];
+	int    AtomCount[ELEMENT_TOTAL];
+	int    MaxIsotopes;                           // largest isotope count, at least 1
+	double FixedMass;                             // mass of the single isotope elements
+	double FixedProb;                             // their probability (log10)
+	double Span;                                  // heaviest minus lightest mass
+};
+
 
 void isoDalton_get_isotopes(char *, char *, char *, struct element_list *);
+int  isoDalton_load_isotopes(char *, char *, char *, struct element_list *);
 void isoDalton_parse_molecular_formula(char *, struct molecule_info *, struct element_list *);
+int  isoDalton_get_isotope_index(struct element_info *, int);
 void isoDalton_combine_masses(int* , double *, double *, int);
+int  isoDalton_trellis_step(int, double *, double *, int, double *, double *, double *, double *, int);
+int  isoDalton_trellis_step_timed(int, double *, double *, int, double *, double *, double *, double *, int, double *);
+void isoDalton_trellis_plan(struct molecule_info *, struct element_list *, struct isotope_profile *, struct trellis_plan *);
 void isoDalton_exact_mass(struct molecule_info *, struct element_list *, int, struct istates_info *, int);
+void isoDalton_exact_mass_profile(struct molecule_info *, struct isotope_profile *, int, struct istates_info *, int);
+void isoDalton_exact_mass_traced(struct molecule_info *, struct element_list *, struct isotope_profile *, int, struct istates_info *, int, struct exact_mass_trace *);
+int  isoDalton_exact_mass_loss(struct molecule_info *, struct element_list *, struct isotope_profile *, int, struct istates_info *, int, struct exact_mass_loss *);
+int  isoDalton_exact_mass_report(struct molecule_info *, struct element_list *, struct isotope_profile *, int, struct istates_info *, int, struct exact_mass_reports *);
+double isoDalton_exact_mass_peak_bytes(struct molecule_info *, struct element_list *, struct isotope_profile *, int);
 
 
@@ -0,0 +1,221 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_batch.cpp                                     */
+/*               Monoisotopic, lightest, average and nominal masses and  */
+/*               mass defects of a matrix of formulas (element counts    */
+/*               by column), in blocks of rows with SSE2 and threads     */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_batch.h"
+#include "thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define BATCH_SSE2
+	#include <emmintrin.h>
+#endif
+
+//--------------------------------------------------------
+// Per column masses (the vectors of the dot products)
+//--------------------------------------------------------
+struct batch_columns {
+	double *Monoisotopic;
+	double *Lightest;
+	double *Average;
+	double *Nominal;
+};
+
+//--------------------------------------------------------
+// Rows First to Last-1 of a batch, for one thread
+//--------------------------------------------------------
+struct batch_slice {
+	struct mass_batch    *pBatch;
+	struct batch_columns *pColumns;
+	int                   First;
+	int                   Last;
+};
+
+//--------------------------------------------------------
+// Masses of the Nrows rows from First
+//--------------------------------------------------------
+static void batch_block(struct mass_batch *pBatch, struct batch_columns *pColumns, int First, int Nrows){
+	double mono[BATCH_BLOCK_ROWS];
+	double light[BATCH_BLOCK_ROWS];
+	double average[BATCH_BLOCK_ROWS];
+	double nominal[BATCH_BLOCK_ROWS];
+	double count_row;
+	int *count;
+	int column;
+	int row;
+#ifdef BATCH_SSE2
+	__m128d mono_mass,light_mass,average_mass,nominal_mass;
+	__m128d counts;
+#endif
+
+	for(row=0; row<Nrows; row++){
+		mono[row]    = 0;
+		light[row]   = 0;
+		average[row] = 0;
+		nominal[row] = 0;
+	}
+	for(column=0; column<pBatch->ElementTotal; column++){
+		count = pBatch->Count[column] + First;
+		row   = 0;
+#ifdef BATCH_SSE2
+		mono_mass    = _mm_set1_pd(pColumns->Monoisotopic[column]);
+		light_mass   = _mm_set1_pd(pColumns->Lightest[column]);
+		average_mass = _mm_set1_pd(pColumns->Average[column]);
+		nominal_mass = _mm_set1_pd(pColumns->Nominal[column]);
+		for(; row+1<Nrows; row+=2){
+			counts = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *)(count+row)));
+			_mm_storeu_pd(mono+row,    _mm_add_pd(_mm_loadu_pd(mono+row),    _mm_mul_pd(counts, mono_mass)));
+			_mm_storeu_pd(light+row,   _mm_add_pd(_mm_loadu_pd(light+row),   _mm_mul_pd(counts, light_mass)));
+			_mm_storeu_pd(average+row, _mm_add_pd(_mm_loadu_pd(average+row), _mm_mul_pd(counts, average_mass)));
+			_mm_storeu_pd(nominal+row, _mm_add_pd(_mm_loadu_pd(nominal+row), _mm_mul_pd(counts, nominal_mass)));
+		}
+#endif
+		for(; row<Nrows; row++){
+			count_row     = (double)count[row];
+			mono[row]    += count_row*pColumns->Monoisotopic[column];
+			light[row]   += count_row*pColumns->Lightest[column];
+			average[row] += count_row*pColumns->Average[column];
+			nominal[row] += count_row*pColumns->Nominal[column];
+		}
+	}
+
+	//---------------------------------------------------------
+	// Outputs
+	//---------------------------------------------------------
+	for(row=0; row<Nrows; row++){
+		if( NULL != pBatch->Monoisotopic ){
+			pBatch->Monoisotopic[First+row] = mono[row];
+		}
+		if( NULL != pBatch->Lightest ){
+			pBatch->Lightest[First+row] = light[row];
+		}
+		if( NULL != pBatch->Average ){
+			pBatch->Average[First+row] = average[row];
+		}
+		if( NULL != pBatch->Nominal ){
+			pBatch->Nominal[First+row] = (int)nominal[row];
+		}
+		if( NULL != pBatch->Defect ){
+			pBatch->Defect[First+row] = mono[row] - nominal[row];
+		}
+	}
+}
+
+static void batch_slice_work(void *argument){
+	struct batch_slice *pSlice;
+	int row;
+	int Nrows;
+
+	pSlice = (struct batch_slice *)argument;
+	for(row=pSlice->First; row<pSlice->Last; row+=BATCH_BLOCK_ROWS){
+		Nrows = pSlice->Last - row;
+		if( Nrows > BATCH_BLOCK_ROWS ){
+			Nrows = BATCH_BLOCK_ROWS;
+		}
+		batch_block(pSlice->pBatch, pSlice->pColumns, row, Nrows);
+	}
+}
+
+//--------------------------------------------------------
+// Masses of every formula of a batch with ThreadTotal
+// threads (the calling thread included).  Returns 0, or
+// -1 for an element that is not in the element list or
+// has no isotopes, or if out of memory.
+//--------------------------------------------------------
+int isoDalton_batch_masses(struct element_list *pElements, struct mass_batch *pBatch, int ThreadTotal){
+	struct batch_columns Columns;
+	struct batch_slice Slice[BATCH_MAX_THREADS];
+	struct element_info *pElement;
+	struct isotope_info *pIsotope;
+	int column;
+	int index;
+	int isotope_index;
+	int thread_index;
+	int rows_per_thread;
+	int Nslices;
+
+	Columns.Monoisotopic = (double *)malloc(pBatch->ElementTotal*sizeof(double));
+	Columns.Lightest     = (double *)malloc(pBatch->ElementTotal*sizeof(double));
+	Columns.Average      = (double *)malloc(pBatch->ElementTotal*sizeof(double));
+	Columns.Nominal      = (double *)malloc(pBatch->ElementTotal*sizeof(double));
+	if( (NULL == Columns.Monoisotopic) || (NULL == Columns.Lightest) || (NULL == Columns.Average) || (NULL == Columns.Nominal) ){
+		data_error("Error : could not allocate the masses of %d elements\n",pBatch->ElementTotal);
+		free(Columns.Monoisotopic);
+		free(Columns.Lightest);
+		free(Columns.Average);
+		free(Columns.Nominal);
+		return -1;
+	}
+
+	//---------------------------------------------------------
+	// Masses of one atom of each column
+	//---------------------------------------------------------
+	for(column=0; column<pBatch->ElementTotal; column++){
+		if( (pBatch->AtomicNumber[column] < 1) || (pBatch->AtomicNumber[column] >= ELEMENT_TOTAL) || (pElements->Element[pBatch->AtomicNumber[column]].IsotopeTotal < 1) ){
+			data_error("Error : element %d of column %d is not in the element list\n",pBatch->AtomicNumber[column],column);
+			free(Columns.Monoisotopic);
+			free(Columns.Lightest);
+			free(Columns.Average);
+			free(Columns.Nominal);
+			return -1;
+		}
+		pElement = &pElements->Element[pBatch->AtomicNumber[column]];
+		pIsotope = pElement->Isotope[pElement->MostCommonIsotopeIndex];
+		Columns.Monoisotopic[column] = pIsotope->AtomicMass;
+		Columns.Nominal[column]      = (double)pIsotope->MassNumber;
+		Columns.Average[column]      = pElement->AverageMass;
+		Columns.Lightest[column]     = pIsotope->AtomicMass;
+		for(index=0; index<pElement->NonzeroIsotopeTotal; index++){
+			isotope_index = pElement->NonzeroIsotopeIndex[index];
+			if( Columns.Lightest[column] > pElement->Isotope[isotope_index]->AtomicMass ){
+				Columns.Lightest[column] = pElement->Isotope[isotope_index]->AtomicMass;
+			}
+		}
+	}
+
+	//---------------------------------------------------------
+	// Contiguous slices of whole blocks, one per thread (none
+	// of them empty)
+	//---------------------------------------------------------
+	if( ThreadTotal > BATCH_MAX_THREADS ){
+		ThreadTotal = BATCH_MAX_THREADS;
+	}
+	if( ThreadTotal < 1 ){
+		ThreadTotal = 1;
+	}
+	rows_per_thread = (pBatch->FormulaTotal + ThreadTotal - 1)/ThreadTotal;
+	rows_per_thread = ((rows_per_thread + BATCH_BLOCK_ROWS - 1)/BATCH_BLOCK_ROWS)*BATCH_BLOCK_ROWS;
+	Nslices = (0 < rows_per_thread) ? (pBatch->FormulaTotal + rows_per_thread - 1)/rows_per_thread : 0;
+	for(thread_index=0; thread_index<Nslices; thread_index++){
+		Slice[thread_index].pBatch   = pBatch;
+		Slice[thread_index].pColumns = &Columns;
+		Slice[thread_index].First    = thread_index*rows_per_thread;
+		Slice[thread_index].Last     = Slice[thread_index].First + rows_per_thread;
+		if( Slice[thread_index].Last > pBatch->FormulaTotal ){
+			Slice[thread_index].Last = pBatch->FormulaTotal;
+		}
+	}
+	thread_run_slices(Nslices, batch_slice_work, Slice, sizeof(Slice[0]));
+
+	free(Columns.Monoisotopic);
+	free(Columns.Lightest);
+	free(Columns.Average);
+	free(Columns.Nominal);
+	return 0;
+}
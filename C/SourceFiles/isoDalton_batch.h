@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_batch.h                                       */
+/*               Header file for isoDalton_batch.cpp, the monoisotopic,  */
+/*               average and nominal masses of many formulas given as    */
+/*               columns of element counts                               */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_BATCH
+#define ISODALTON_BATCH
+
+//---------------------------------------------------------------------------------------------
+// Batch masses.  The formulas are the rows of a matrix of atom counts stored by column: one
+// array of FormulaTotal counts per element.  Every mass is a dot product of a row with a
+// vector of per element masses, so a block of BATCH_BLOCK_ROWS rows is accumulated one column
+// at a time (the block stays in cache, the columns are read once, in order) with SSE2 when the
+// compiler targets it, and ThreadTotal threads take contiguous ranges of rows.
+//
+//   Monoisotopic  the most common isotope of every element (MostCommonIsotopeIndex)
+//   Lightest      the lightest isotope with a nonzero fraction, the M+0 peak
+//   Average       AverageMass of every element
+//   Nominal       the mass numbers of the most common isotopes
+//   Defect        Monoisotopic - Nominal
+//
+// An output array left NULL is not written.
+//---------------------------------------------------------------------------------------------
+#define BATCH_BLOCK_ROWS   512
+#define BATCH_MAX_THREADS  64
+
+struct mass_batch {
+	int     FormulaTotal;     // rows
+	int     ElementTotal;     // columns
+	int    *AtomicNumber;     // element of each column
+	int   **Count;            // Count[column][row], atoms of the element in the formula
+	double *Monoisotopic;     // outputs, FormulaTotal each (NULL = not computed)
+	double *Lightest;
+	double *Average;
+	int    *Nominal;
+	double *Defect;
+};
+
+int isoDalton_batch_masses(struct element_list *, struct mass_batch *, int);
+
+#endif
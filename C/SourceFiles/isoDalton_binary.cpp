@@ -0,0 +1,387 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_binary.cpp                                    */
+/*               Source code for writing and reading the binary result   */
+/*               file (see isoDalton_binary.h for the layout)            */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_binary.h"
+#include "sort.h"
+#include <math.h>
+#ifdef WIN32
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#define BINARY_VERSION  1
+#define BINARY_PAD8(n)  (((n)+7) & ~((binary_uint64)7))
+
+//--------------------------------------------------------
+// Writer
+//--------------------------------------------------------
+int isoDalton_binary_writer_open(struct binary_writer *pWriter, FILE *pFile, double quantum, int prob_bytes){
+	struct binary_file_header Header;
+
+	if( (quantum <= 0) || ((4 != prob_bytes) && (8 != prob_bytes)) ){
+		data_error("Error : binary writer : the quantum must be positive and the probability size 4 or 8\n");
+		return -1;
+	}
+	memset(&Header, 0, sizeof(Header));
+	memcpy(Header.Magic, BINARY_MAGIC, 8);
+	Header.ByteOrder = BINARY_BYTE_ORDER;
+	Header.Version   = BINARY_VERSION;
+	Header.Quantum   = quantum;
+	if( 1 != fwrite(&Header, sizeof(Header), 1, pFile) ){
+		data_error("Error : binary writer : could not write the file header\n");
+		return -1;
+	}
+	pWriter->pFile         = pFile;
+	pWriter->Quantum       = quantum;
+	pWriter->ProbBytes     = prob_bytes;
+	pWriter->Offset        = sizeof(Header);
+	pWriter->MoleculeTotal = 0;
+	pWriter->IndexCapacity = 1024;
+	pWriter->Index         = (binary_uint64 *)malloc((size_t)pWriter->IndexCapacity*sizeof(binary_uint64));
+	pWriter->StateCapacity = 0;
+	pWriter->SortMass      = NULL;
+	pWriter->SortProb      = NULL;
+	pWriter->Buffer        = NULL;
+	return 0;
+}
+
+//--------------------------------------------------------
+// Append the first StateTotal states of pStates.
+// Returns 0 on success and -1 on a write error.
+//--------------------------------------------------------
+int isoDalton_binary_write(struct binary_writer *pWriter, const char *formula, struct istates_info *pStates, int log10flag){
+	struct binary_record_header Header;
+	unsigned char *pByte;
+	char   *pFormula;
+	float  *pFloat;
+	double *pDouble;
+	binary_uint64 formula_bytes;
+	binary_uint64 column_bytes;
+	binary_uint64 prob_bytes;
+	binary_uint64 record_bytes;
+	binary_uint64 delta;
+	binary_int64  quantized;
+	binary_int64  previous;
+	binary_int64  first;
+	int Nstates;
+	int state_index;
+	int status;
+
+	Nstates = pStates->StateTotal;
+	if( Nstates > pWriter->StateCapacity ){
+		pWriter->StateCapacity = Nstates;
+		pWriter->SortMass = (double *)realloc(pWriter->SortMass, Nstates*sizeof(double));
+		pWriter->SortProb = (double *)realloc(pWriter->SortProb, Nstates*sizeof(double));
+		pWriter->Buffer   = (unsigned char *)realloc(pWriter->Buffer, (size_t)Nstates*18+16);  // 8 + 10 bytes per state and padding
+	}
+	if( pWriter->MoleculeTotal == pWriter->IndexCapacity ){
+		pWriter->IndexCapacity *= 2;
+		pWriter->Index = (binary_uint64 *)realloc(pWriter->Index, (size_t)pWriter->IndexCapacity*sizeof(binary_uint64));
+	}
+
+	//---------------------------------------------------
+	// States in increasing mass order
+	//---------------------------------------------------
+	memcpy(pWriter->SortMass, pStates->mass, Nstates*sizeof(double));
+	memcpy(pWriter->SortProb, pStates->prob, Nstates*sizeof(double));
+	heapsort_2dbl_up(Nstates, pWriter->SortMass, pWriter->SortProb);
+
+	//---------------------------------------------------
+	// Probability column then the varint mass deltas
+	//---------------------------------------------------
+	pByte = pWriter->Buffer;
+	if( 4 == pWriter->ProbBytes ){
+		pFloat = (float *)pByte;
+		for(state_index=0; state_index<Nstates; state_index++){
+			pFloat[state_index] = (float)pWriter->SortProb[state_index];
+		}
+	}else{
+		pDouble = (double *)pByte;
+		for(state_index=0; state_index<Nstates; state_index++){
+			pDouble[state_index] = pWriter->SortProb[state_index];
+		}
+	}
+	prob_bytes = BINARY_PAD8((binary_uint64)Nstates*pWriter->ProbBytes);
+	memset(pByte + (binary_uint64)Nstates*pWriter->ProbBytes, 0, (size_t)(prob_bytes - (binary_uint64)Nstates*pWriter->ProbBytes));
+	pByte += prob_bytes;
+	first    = 0;
+	previous = 0;
+	for(state_index=0; state_index<Nstates; state_index++){
+		quantized = (binary_int64)floor(pWriter->SortMass[state_index]/pWriter->Quantum + 0.5);
+		if( 0 == state_index ){
+			first = quantized;
+		}else{
+			delta = (binary_uint64)(quantized - previous);
+			while( delta >= 0x80 ){
+				*pByte++ = (unsigned char)(delta | 0x80);
+				delta >>= 7;
+			}
+			*pByte++ = (unsigned char)delta;
+		}
+		previous = quantized;
+	}
+	column_bytes = (binary_uint64)(pByte - pWriter->Buffer);
+	memset(pByte, 0, (size_t)(BINARY_PAD8(column_bytes) - column_bytes));
+
+	//---------------------------------------------------
+	// Record header, formula and columns
+	//---------------------------------------------------
+	formula_bytes = BINARY_PAD8(strlen(formula)+1);
+	record_bytes  = sizeof(Header) + formula_bytes + BINARY_PAD8(column_bytes);
+	memset(&Header, 0, sizeof(Header));
+	Header.StateTotal    = (binary_uint32)Nstates;
+	Header.FormulaLength = (binary_uint32)strlen(formula);
+	Header.MassBytes     = (binary_uint32)(column_bytes - prob_bytes);
+	Header.ProbBytes     = (binary_uint16)pWriter->ProbBytes;
+	Header.Flags         = (binary_uint16)((1 == log10flag) ? BINARY_FLAG_LOG10 : 0);
+	Header.FirstMass     = first;
+	pFormula = (char *)calloc((size_t)formula_bytes, 1);
+	strcpy(pFormula, formula);
+	status = 0;
+	if( (1 != fwrite(&Header, sizeof(Header), 1, pWriter->pFile)) ||
+		(1 != fwrite(pFormula, (size_t)formula_bytes, 1, pWriter->pFile)) ||
+		((0 < column_bytes) && (1 != fwrite(pWriter->Buffer, (size_t)BINARY_PAD8(column_bytes), 1, pWriter->pFile))) ){
+		data_error("Error : binary writer : write failed\n");
+		status = -1;
+	}
+	free(pFormula);
+	if( 0 != status ){
+		return -1;
+	}
+	pWriter->Index[pWriter->MoleculeTotal] = pWriter->Offset;
+	pWriter->MoleculeTotal++;
+	pWriter->Offset += record_bytes;
+	return 0;
+}
+
+//--------------------------------------------------------
+// Write the index and footer and free the writer (the
+// FILE is not closed).  Returns 0 on success, -1 on error.
+//--------------------------------------------------------
+int isoDalton_binary_writer_close(struct binary_writer *pWriter){
+	struct binary_file_footer Footer;
+	int status;
+
+	memset(&Footer, 0, sizeof(Footer));
+	Footer.IndexOffset   = pWriter->Offset;
+	Footer.MoleculeTotal = pWriter->MoleculeTotal;
+	memcpy(Footer.Magic, BINARY_INDEX_MAGIC, 8);
+	status = 0;
+	if( ((0 < pWriter->MoleculeTotal) && (pWriter->MoleculeTotal != fwrite(pWriter->Index, sizeof(binary_uint64), (size_t)pWriter->MoleculeTotal, pWriter->pFile))) ||
+		(1 != fwrite(&Footer, sizeof(Footer), 1, pWriter->pFile)) ){
+		data_error("Error : binary writer : could not write the index\n");
+		status = -1;
+	}
+	free(pWriter->Index);
+	free(pWriter->SortMass);
+	free(pWriter->SortProb);
+	free(pWriter->Buffer);
+	return status;
+}
+
+
+//--------------------------------------------------------
+// Reader.  Returns 0 on success and -1 if the file can
+// not be mapped or is not a complete binary result file.
+//--------------------------------------------------------
+int isoDalton_binary_open(struct binary_reader *pReader, const char *filename){
+	const struct binary_file_header *pHeader;
+	const struct binary_file_footer *pFooter;
+
+	pReader->pData = NULL;
+#ifdef WIN32
+	{
+		LARGE_INTEGER size;
+
+		pReader->FileHandle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if( INVALID_HANDLE_VALUE == pReader->FileHandle ){
+			data_error("Error : could not open %s\n",filename);
+			return -1;
+		}
+		GetFileSizeEx(pReader->FileHandle, &size);
+		pReader->Size      = (binary_uint64)size.QuadPart;
+		pReader->MapHandle = CreateFileMapping(pReader->FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if( NULL != pReader->MapHandle ){
+			pReader->pData = (const unsigned char *)MapViewOfFile(pReader->MapHandle, FILE_MAP_READ, 0, 0, 0);
+		}
+		if( NULL == pReader->pData ){
+			data_error("Error : could not map %s\n",filename);
+			if( NULL != pReader->MapHandle ){
+				CloseHandle(pReader->MapHandle);
+			}
+			CloseHandle(pReader->FileHandle);
+			return -1;
+		}
+	}
+#else
+	{
+		struct stat status;
+		void *pMap;
+		int fd;
+
+		fd = open(filename, O_RDONLY);
+		if( fd < 0 ){
+			data_error("Error : could not open %s\n",filename);
+			return -1;
+		}
+		if( (0 != fstat(fd, &status)) || (0 == status.st_size) ){
+			data_error("Error : %s is empty\n",filename);
+			close(fd);
+			return -1;
+		}
+		pReader->Size = (binary_uint64)status.st_size;
+		pMap = mmap(NULL, (size_t)pReader->Size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if( MAP_FAILED == pMap ){
+			data_error("Error : could not map %s\n",filename);
+			return -1;
+		}
+		pReader->pData = (const unsigned char *)pMap;
+	}
+#endif
+	//---------------------------------------------------
+	// Check the header, footer and index (the index is
+	// 8 byte aligned and fills the space up to the footer)
+	//---------------------------------------------------
+	pHeader = (const struct binary_file_header *)pReader->pData;
+	pFooter = (const struct binary_file_footer *)(pReader->pData + pReader->Size - sizeof(struct binary_file_footer));
+	if( (pReader->Size < sizeof(struct binary_file_header) + sizeof(struct binary_file_footer)) ||
+		(0 != memcmp(pHeader->Magic, BINARY_MAGIC, 8)) ||
+		(BINARY_BYTE_ORDER != pHeader->ByteOrder) ||
+		(0 != memcmp(pFooter->Magic, BINARY_INDEX_MAGIC, 8)) ||
+		(pFooter->IndexOffset < sizeof(struct binary_file_header)) ||
+		(pFooter->IndexOffset > pReader->Size - sizeof(struct binary_file_footer)) ||
+		(0 != (pFooter->IndexOffset & 7)) ||
+		(pFooter->MoleculeTotal != (pReader->Size - sizeof(struct binary_file_footer) - pFooter->IndexOffset)/sizeof(binary_uint64)) ||
+		(pFooter->IndexOffset + pFooter->MoleculeTotal*sizeof(binary_uint64) + sizeof(struct binary_file_footer) != pReader->Size) ){
+		data_error("Error : %s is not a complete isoDalton binary file (or was written with the other byte order)\n",filename);
+		isoDalton_binary_close(pReader);
+		return -1;
+	}
+	pReader->Quantum       = pHeader->Quantum;
+	pReader->MoleculeTotal = pFooter->MoleculeTotal;
+	pReader->IndexOffset   = pFooter->IndexOffset;
+	pReader->Index         = (const binary_uint64 *)(pReader->pData + pFooter->IndexOffset);
+	return 0;
+}
+
+//--------------------------------------------------------
+// Locate molecule i.  Returns 0 on success, -1 if i is
+// out of range or the record is damaged (it must lie
+// between the file header and the index, start on an 8
+// byte boundary and hold a NUL terminated formula and 4
+// or 8 byte probabilities).
+//--------------------------------------------------------
+int isoDalton_binary_record(struct binary_reader *pReader, binary_uint64 i, struct binary_record *pRecord){
+	const struct binary_record_header *pHeader;
+	const unsigned char *pByte;
+	binary_uint64 offset;
+	binary_uint64 end;
+
+	if( i >= pReader->MoleculeTotal ){
+		return -1;
+	}
+	offset = pReader->Index[i];
+	if( (offset < sizeof(struct binary_file_header)) || (0 != (offset & 7)) ||
+		(offset > pReader->IndexOffset - sizeof(struct binary_record_header)) ){
+		return -1;
+	}
+	pHeader = (const struct binary_record_header *)(pReader->pData + offset);
+	if( ((4 != pHeader->ProbBytes) && (8 != pHeader->ProbBytes)) ||
+		(pHeader->StateTotal > 0x7fffffff) || (pHeader->MassBytes > 0x7fffffff) ){
+		return -1;
+	}
+
+	//---------------------------------------------------
+	// Each term is below 2^36, so the sum can not wrap
+	//---------------------------------------------------
+	end = offset + sizeof(struct binary_record_header) + BINARY_PAD8((binary_uint64)pHeader->FormulaLength+1)
+		+ BINARY_PAD8((binary_uint64)pHeader->StateTotal*pHeader->ProbBytes) + pHeader->MassBytes;
+	if( end > pReader->IndexOffset ){
+		return -1;
+	}
+	if( 0 != ((const char *)(pHeader+1))[pHeader->FormulaLength] ){
+		return -1;
+	}
+	pByte = (const unsigned char *)(pHeader+1);
+	pRecord->Formula    = (const char *)pByte;
+	pRecord->StateTotal = (int)pHeader->StateTotal;
+	pRecord->ProbBytes  = (int)pHeader->ProbBytes;
+	pRecord->log10flag  = (0 != (pHeader->Flags & BINARY_FLAG_LOG10));
+	pRecord->FirstMass  = pHeader->FirstMass;
+	pRecord->MassBytes  = (int)pHeader->MassBytes;
+	pByte += BINARY_PAD8((binary_uint64)pHeader->FormulaLength+1);
+	pRecord->ProbFloat  = (4 == pHeader->ProbBytes) ? (const float *)pByte : NULL;
+	pRecord->ProbDouble = (8 == pHeader->ProbBytes) ? (const double *)pByte : NULL;
+	pByte += BINARY_PAD8((binary_uint64)pHeader->StateTotal*pHeader->ProbBytes);
+	pRecord->MassDelta  = pByte;
+	return 0;
+}
+
+//--------------------------------------------------------
+// Decode a record into StateTotal masses and probabilities
+// (increasing mass).  Returns 0 on success, -1 if the
+// mass column is damaged.
+//--------------------------------------------------------
+int isoDalton_binary_decode(struct binary_reader *pReader, struct binary_record *pRecord, double *mass, double *prob){
+	const unsigned char *pByte;
+	const unsigned char *pEnd;
+	binary_int64  quantized;
+	binary_uint64 delta;
+	int shift;
+	int state_index;
+
+	pByte = pRecord->MassDelta;
+	pEnd  = pRecord->MassDelta + pRecord->MassBytes;
+	quantized = pRecord->FirstMass;
+	for(state_index=0; state_index<pRecord->StateTotal; state_index++){
+		if( state_index > 0 ){
+			delta = 0;
+			shift = 0;
+			do{
+				if( (pByte >= pEnd) || (shift > 63) ){
+					return -1;
+				}
+				delta |= (binary_uint64)(*pByte & 0x7F) << shift;
+				shift += 7;
+			}while( *pByte++ & 0x80 );
+			quantized += (binary_int64)delta;
+		}
+		mass[state_index] = (double)quantized*pReader->Quantum;
+		prob[state_index] = (NULL != pRecord->ProbFloat) ? (double)pRecord->ProbFloat[state_index] : pRecord->ProbDouble[state_index];
+	}
+	return 0;
+}
+
+void isoDalton_binary_close(struct binary_reader *pReader){
+	if( NULL == pReader->pData ){
+		return;
+	}
+#ifdef WIN32
+	UnmapViewOfFile(pReader->pData);
+	CloseHandle(pReader->MapHandle);
+	CloseHandle(pReader->FileHandle);
+#else
+	munmap((void *)pReader->pData, (size_t)pReader->Size);
+#endif
+	pReader->pData = NULL;
+}
@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_binary.h                                      */
+/*               Header file for isoDalton_binary.cpp, a binary result   */
+/*               file for many molecules that can be memory mapped and   */
+/*               read at any molecule without parsing the file           */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_BINARY
+#define ISODALTON_BINARY
+
+#include "data.h"
+
+#ifdef _MSC_VER
+	typedef unsigned __int64 binary_uint64;
+	typedef __int64          binary_int64;
+	typedef unsigned int     binary_uint32;
+	typedef unsigned short   binary_uint16;
+#else
+	#include <stdint.h>
+	typedef uint64_t         binary_uint64;
+	typedef int64_t          binary_int64;
+	typedef uint32_t         binary_uint32;
+	typedef uint16_t         binary_uint16;
+#endif
+
+//---------------------------------------------------------------------------------------------
+// File layout (native byte order, every block starts on an 8 byte boundary)
+//
+//   file header    struct binary_file_header
+//   record 0       struct binary_record_header
+//                  formula, NUL terminated
+//                  probability column, StateTotal floats or doubles
+//                  mass column, StateTotal quantized masses: the first is in the record
+//                  header and the rest are unsigned LEB128 varint deltas (MassBytes bytes)
+//   record 1 ...
+//   index          MoleculeTotal 64 bit file offsets of the records
+//   file footer    struct binary_file_footer (the last 24 bytes of the file)
+//
+// The states of a record are in increasing mass order so the deltas are small.  A mass is
+// Quantum*(quantized mass) daltons; the default quantum of 1e-9 daltons keeps 12 or more
+// significant digits for masses below 1e5 daltons.
+//---------------------------------------------------------------------------------------------
+#define BINARY_MAGIC           "isoDbin1"
+#define BINARY_INDEX_MAGIC     "isoDidx1"
+#define BINARY_BYTE_ORDER      0x01020304
+#define BINARY_DEFAULT_QUANTUM 1e-9
+#define BINARY_FLAG_LOG10      1          // probabilities are log10 values
+
+struct binary_file_header {
+	char          Magic[8];
+	binary_uint32 ByteOrder;   // BINARY_BYTE_ORDER as written by the writer
+	binary_uint32 Version;
+	double        Quantum;     // daltons per quantized mass unit
+};
+
+struct binary_record_header {
+	binary_uint32 StateTotal;
+	binary_uint32 FormulaLength;  // without the NUL
+	binary_uint32 MassBytes;      // bytes of the varint mass deltas
+	binary_uint16 ProbBytes;      // 4 (float) or 8 (double)
+	binary_uint16 Flags;          // BINARY_FLAG_LOG10
+	binary_int64  FirstMass;      // quantized mass of the first (lightest) state
+};
+
+struct binary_file_footer {
+	binary_uint64 IndexOffset;
+	binary_uint64 MoleculeTotal;
+	char          Magic[8];
+};
+
+//---------------------------------------------------------------------------------------------
+// Writer.  Records are appended as they come; only the index (8 bytes per molecule) is kept
+// in memory until the file is closed.
+//---------------------------------------------------------------------------------------------
+struct binary_writer {
+	FILE          *pFile;
+	double         Quantum;
+	int            ProbBytes;
+	binary_uint64  Offset;
+	binary_uint64 *Index;
+	binary_uint64  MoleculeTotal;
+	binary_uint64  IndexCapacity;
+	int            StateCapacity;
+	double        *SortMass;      // scratch of StateCapacity states
+	double        *SortProb;
+	unsigned char *Buffer;        // scratch for the encoded columns
+};
+
+//---------------------------------------------------------------------------------------------
+// Reader.  The whole file is mapped; a molecule is found through the index.
+//---------------------------------------------------------------------------------------------
+struct binary_reader {
+	const unsigned char *pData;
+	binary_uint64        Size;
+	binary_uint64        MoleculeTotal;
+	binary_uint64        IndexOffset;  // the records lie below it
+	const binary_uint64 *Index;
+	double               Quantum;
+#ifdef WIN32
+	void                *FileHandle;
+	void                *MapHandle;
+#endif
+};
+
+//---------------------------------------------------------------------------------------------
+// One record as it lies in the mapped file (no copies)
+//---------------------------------------------------------------------------------------------
+struct binary_record {
+	const char          *Formula;
+	int                  StateTotal;
+	int                  ProbBytes;
+	int                  log10flag;
+	const float         *ProbFloat;   // set if ProbBytes is 4
+	const double        *ProbDouble;  // set if ProbBytes is 8
+	binary_int64         FirstMass;
+	const unsigned char *MassDelta;
+	int                  MassBytes;
+};
+
+int  isoDalton_binary_writer_open(struct binary_writer *, FILE *, double, int);
+int  isoDalton_binary_write(struct binary_writer *, const char *, struct istates_info *, int);
+int  isoDalton_binary_writer_close(struct binary_writer *);
+
+int  isoDalton_binary_open(struct binary_reader *, const char *);
+int  isoDalton_binary_record(struct binary_reader *, binary_uint64, struct binary_record *);
+int  isoDalton_binary_decode(struct binary_reader *, struct binary_record *, double *, double *);
+void isoDalton_binary_close(struct binary_reader *);
+
+#endif
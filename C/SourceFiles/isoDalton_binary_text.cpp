@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_binary_text.cpp                               */
+/*               Converts a binary result file back to the text format   */
+/*               of isoDalton_cli (states in increasing mass order).     */
+/*               Usage: isoDalton_binary_text file [first [count]]       */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_binary.h"
+
+int main(int argc, char **argv)
+{
+	struct binary_reader Reader;
+	struct binary_record Record;
+	binary_uint64 first;
+	binary_uint64 count;
+	binary_uint64 molecule_index;
+	double *mass;
+	double *prob;
+	int state_capacity;
+	int state_index;
+
+	if( argc < 2 ){
+		fprintf(stderr,"Usage: isoDalton_binary_text file [first [count]]\n");
+		fprintf(stderr,"Writes molecules first .. first+count-1 (all by default) as text to stdout.\n");
+		return 1;
+	}
+	if( 0 != isoDalton_binary_open(&Reader, argv[1]) ){
+		return 1;
+	}
+	first = 0;
+	count = Reader.MoleculeTotal;
+	if( 2 < argc ){
+		first = (binary_uint64)atol(argv[2]);
+		count = (first < Reader.MoleculeTotal) ? Reader.MoleculeTotal-first : 0;
+	}
+	if( 3 < argc ){
+		if( (binary_uint64)atol(argv[3]) < count ){
+			count = (binary_uint64)atol(argv[3]);
+		}
+	}
+
+	state_capacity = 0;
+	mass = NULL;
+	prob = NULL;
+	for(molecule_index=first; molecule_index<first+count; molecule_index++){
+		if( (0 != isoDalton_binary_record(&Reader, molecule_index, &Record)) ){
+			fprintf(stderr,"Error : molecule %lu is damaged\n",(unsigned long)molecule_index);
+			return 1;
+		}
+		if( Record.StateTotal > state_capacity ){
+			state_capacity = Record.StateTotal;
+			mass = (double *)realloc(mass, state_capacity*sizeof(double));
+			prob = (double *)realloc(prob, state_capacity*sizeof(double));
+		}
+		if( 0 != isoDalton_binary_decode(&Reader, &Record, mass, prob) ){
+			fprintf(stderr,"Error : molecule %lu is damaged\n",(unsigned long)molecule_index);
+			return 1;
+		}
+		printf("# %s\t%d\n",Record.Formula,Record.StateTotal);
+		for(state_index=0; state_index<Record.StateTotal; state_index++){
+			printf("%20.15f %20.15f\n",mass[state_index],prob[state_index]);
+		}
+	}
+	free(mass);
+	free(prob);
+	isoDalton_binary_close(&Reader);
+	return 0;
+}
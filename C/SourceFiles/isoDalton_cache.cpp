@@ -0,0 +1,466 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_cache.cpp                                    */
+/*               File backed cache of computed isotope distributions,    */
+/*               keyed on the canonical formula, the computation         */
+/*               parameters and a fingerprint of the element list, with  */
+/*               least recently used eviction.                           */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_cache.h"
+#include "sort.h"
+
+#ifdef WIN32
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <sys/file.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#define CACHE_PAD8(n)        (((n) + 7) & ~(cache_uint64)7)
+#define CACHE_SLOT_FRACTION  32   // the slot table takes about 1/32 of the file
+
+//--------------------------------------------------------
+// 64 bit FNV-1a hash
+//--------------------------------------------------------
+static cache_uint64 cache_hash_start(void){
+	cache_uint64 hash;
+
+	hash  = 0xCBF29CE4;
+	hash  = (hash << 32) | 0x84222325;
+	return hash;
+}
+
+static cache_uint64 cache_hash_bytes(cache_uint64 hash, const void *data, size_t Nbytes){
+	const unsigned char *pByte;
+	cache_uint64 prime;
+	size_t byte_index;
+
+	prime = 0x100;
+	prime = (prime << 32) | 0x000001B3;
+	pByte = (const unsigned char *)data;
+	for(byte_index=0; byte_index<Nbytes; byte_index++){
+		hash ^= pByte[byte_index];
+		hash *= prime;
+	}
+	return hash;
+}
+
+static cache_uint64 cache_key_hash(struct cache_key *pKey){
+	cache_uint64 hash;
+
+	hash = cache_hash_start();
+	hash = cache_hash_bytes(hash, pKey->Formula, strlen(pKey->Formula));
+	hash = cache_hash_bytes(hash, &pKey->Mstates, sizeof(pKey->Mstates));
+	hash = cache_hash_bytes(hash, &pKey->log10flag, sizeof(pKey->log10flag));
+	hash = cache_hash_bytes(hash, &pKey->Fingerprint, sizeof(pKey->Fingerprint));
+	hash = cache_hash_bytes(hash, &pKey->Parameters, sizeof(pKey->Parameters));
+	return (0 == hash) ? 1 : hash;
+}
+
+//--------------------------------------------------------
+// Fingerprint of the isotope masses and fractions of every
+// element.  Any change to the element list (a different
+// user isotope file, an edited NIST table) changes it.
+//--------------------------------------------------------
+cache_uint64 isoDalton_cache_fingerprint(struct element_list *pElements){
+	struct element_info *pElement;
+	cache_uint64 hash;
+	int element_index;
+	int isotope_index;
+
+	hash = cache_hash_start();
+	for(element_index=0; element_index<ELEMENT_TOTAL; element_index++){
+		pElement = &pElements->Element[element_index];
+		hash = cache_hash_bytes(hash, &pElement->IsotopeTotal, sizeof(int));
+		for(isotope_index=0; isotope_index<pElement->IsotopeTotal; isotope_index++){
+			hash = cache_hash_bytes(hash, &pElement->Isotope[isotope_index]->MassNumber, sizeof(int));
+			hash = cache_hash_bytes(hash, &pElement->Isotope[isotope_index]->AtomicMass, sizeof(double));
+			hash = cache_hash_bytes(hash, &pElement->Isotope[isotope_index]->CompositionFraction, sizeof(double));
+		}
+	}
+	return hash;
+}
+
+//--------------------------------------------------------
+// Parameters of a cache key: the hash of a record holding
+// every setting that changes a result.  The record must
+// be the same bytes for the same settings (zero it before
+// filling it in, padding included).
+//--------------------------------------------------------
+cache_uint64 isoDalton_cache_parameters(const void *record, size_t Nbytes){
+	return cache_hash_bytes(cache_hash_start(), record, Nbytes);
+}
+
+//--------------------------------------------------------
+// Bytes of an entry
+//--------------------------------------------------------
+static cache_uint64 cache_entry_bytes(cache_uint64 KeyLength, cache_uint64 StateTotal){
+	return sizeof(struct cache_entry_header) + CACHE_PAD8(KeyLength+1) + 2*StateTotal*sizeof(double);
+}
+
+//--------------------------------------------------------
+// Slot of the key, or NULL
+//--------------------------------------------------------
+static struct cache_slot *cache_find(struct result_cache *pCache, struct cache_key *pKey, cache_uint64 hash){
+	struct cache_entry_header *pEntry;
+	struct cache_slot *pSlot;
+	cache_uint64 mask;
+	cache_uint64 slot_index;
+
+	mask = pCache->pHeader->SlotTotal - 1;
+	for(slot_index=hash&mask; 0 != pCache->Slot[slot_index].Offset; slot_index=(slot_index+1)&mask){
+		pSlot = &pCache->Slot[slot_index];
+		if( pSlot->Hash != hash ){
+			continue;
+		}
+		pEntry = (struct cache_entry_header *)(pCache->pData + pSlot->Offset);
+		if( (pEntry->Fingerprint == pKey->Fingerprint) && (pEntry->Parameters == pKey->Parameters) &&
+			((int)pEntry->Mstates == pKey->Mstates) && ((int)pEntry->log10flag == pKey->log10flag) &&
+			(0 == strcmp((const char *)(pEntry+1), pKey->Formula)) ){
+			return pSlot;
+		}
+	}
+	return NULL;
+}
+
+static void cache_place(struct result_cache *pCache, cache_uint64 hash, cache_uint64 offset, cache_uint64 last_use){
+	cache_uint64 mask;
+	cache_uint64 slot_index;
+
+	mask = pCache->pHeader->SlotTotal - 1;
+	for(slot_index=hash&mask; 0 != pCache->Slot[slot_index].Offset; slot_index=(slot_index+1)&mask){
+	}
+	pCache->Slot[slot_index].Hash    = hash;
+	pCache->Slot[slot_index].Offset  = offset;
+	pCache->Slot[slot_index].LastUse = last_use;
+}
+
+//--------------------------------------------------------
+// Evict the least recently used entries until at most
+// half of the data region and slot table is in use, then
+// slide the survivors down and rebuild the slot table
+//--------------------------------------------------------
+static void cache_evict(struct result_cache *pCache){
+	struct cache_file_header  *pHeader;
+	struct cache_entry_header *pEntry;
+	double *last_use;
+	double *offset;
+	double *kept_last_use;
+	double *order;
+	cache_uint64 kept_bytes;
+	cache_uint64 entry_bytes;
+	cache_uint64 next_offset;
+	cache_uint64 slot_index;
+	long Nentries;
+	long Nkept;
+	long entry_index;
+
+	pHeader  = pCache->pHeader;
+	Nentries = (long)pHeader->EntryTotal;
+	last_use = (double *)malloc((Nentries+1)*sizeof(double));
+	offset   = (double *)malloc((Nentries+1)*sizeof(double));
+	order    = (double *)malloc((Nentries+1)*sizeof(double));
+	entry_index = 0;
+	for(slot_index=0; slot_index<pHeader->SlotTotal; slot_index++){
+		if( 0 != pCache->Slot[slot_index].Offset ){
+			last_use[entry_index] = (double)pCache->Slot[slot_index].LastUse;
+			offset[entry_index]   = (double)pCache->Slot[slot_index].Offset;
+			entry_index++;
+		}
+	}
+
+	//---------------------------------------------------
+	// Most recently used first, keep what fits in half
+	//---------------------------------------------------
+	heapsort_2dbl_up(Nentries, last_use, offset);
+	kept_bytes = 0;
+	Nkept      = 0;
+	for(entry_index=Nentries-1; entry_index>=0; entry_index--){
+		pEntry      = (struct cache_entry_header *)(pCache->pData + (cache_uint64)offset[entry_index]);
+		entry_bytes = cache_entry_bytes(pEntry->KeyLength, pEntry->StateTotal);
+		if( (kept_bytes + entry_bytes > pCache->DataCapacity/2) || ((cache_uint64)Nkept+1 > pHeader->SlotTotal/2) ){
+			break;
+		}
+		kept_bytes += entry_bytes;
+		Nkept++;
+	}
+	kept_last_use = &last_use[Nentries-Nkept];   // sorted along with the offsets
+	for(entry_index=0; entry_index<Nkept; entry_index++){
+		order[entry_index] = offset[Nentries-Nkept+entry_index];
+	}
+	heapsort_2dbl_up(Nkept, order, kept_last_use);
+
+	//---------------------------------------------------
+	// Slide down in file order (each entry moves to a
+	// lower or equal offset, so memmove is safe)
+	//---------------------------------------------------
+	memset(pCache->Slot, 0, (size_t)pHeader->SlotTotal*sizeof(struct cache_slot));
+	next_offset = pHeader->DataOffset;
+	for(entry_index=0; entry_index<Nkept; entry_index++){
+		pEntry      = (struct cache_entry_header *)(pCache->pData + (cache_uint64)order[entry_index]);
+		entry_bytes = cache_entry_bytes(pEntry->KeyLength, pEntry->StateTotal);
+		memmove(pCache->pData + next_offset, pEntry, (size_t)entry_bytes);
+		pEntry = (struct cache_entry_header *)(pCache->pData + next_offset);
+		cache_place(pCache, pEntry->Hash, next_offset, (cache_uint64)kept_last_use[entry_index]);
+		next_offset += entry_bytes;
+	}
+	pCache->Evictions   += Nentries - Nkept;
+	pHeader->Evictions  += Nentries - Nkept;
+	pHeader->EntryTotal  = Nkept;
+	pHeader->DataUsed    = next_offset - pHeader->DataOffset;
+	free(last_use);
+	free(offset);
+	free(order);
+}
+
+//--------------------------------------------------------
+// Clear the file (new, damaged, dirty or resized)
+//--------------------------------------------------------
+static void cache_initialize(struct result_cache *pCache, cache_uint64 size){
+	struct cache_file_header *pHeader;
+	cache_uint64 SlotTotal;
+
+	SlotTotal = 256;
+	while( SlotTotal*sizeof(struct cache_slot)*2 <= size/CACHE_SLOT_FRACTION ){
+		SlotTotal *= 2;
+	}
+	pHeader = pCache->pHeader;
+	memset(pHeader, 0, sizeof(struct cache_file_header));
+	memcpy(pHeader->Magic, CACHE_MAGIC, 8);
+	pHeader->ByteOrder  = CACHE_BYTE_ORDER;
+	pHeader->Version    = CACHE_VERSION;
+	pHeader->FileSize   = size;
+	pHeader->SlotTotal  = SlotTotal;
+	pHeader->DataOffset = CACHE_PAD8(sizeof(struct cache_file_header)) + SlotTotal*sizeof(struct cache_slot);
+	memset(pCache->pData + sizeof(struct cache_file_header), 0, (size_t)(pHeader->DataOffset - sizeof(struct cache_file_header)));
+}
+
+//--------------------------------------------------------
+// Open (or create) a cache file of size bytes.  A file of
+// another size, version or byte order, or one not closed
+// cleanly, is cleared.  Returns 0 on success and -1 if
+// the file can not be opened, locked or mapped.
+//--------------------------------------------------------
+int isoDalton_cache_open(struct result_cache *pCache, const char *filename, cache_uint64 size){
+	struct cache_file_header *pHeader;
+	cache_uint64 file_size;
+
+	if( size < CACHE_MIN_SIZE ){
+		size = CACHE_MIN_SIZE;
+	}
+	size = CACHE_PAD8(size);
+	pCache->pData = NULL;
+#ifdef WIN32
+	{
+		LARGE_INTEGER existing;
+
+		//---------------------------------------------------
+		// No sharing: the open handle is the lock
+		//---------------------------------------------------
+		pCache->FileHandle = CreateFileA(filename, GENERIC_READ|GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if( INVALID_HANDLE_VALUE == pCache->FileHandle ){
+			data_error("Error : could not open or lock the cache %s\n",filename);
+			return -1;
+		}
+		GetFileSizeEx(pCache->FileHandle, &existing);
+		file_size = (cache_uint64)existing.QuadPart;
+		pCache->MapHandle = CreateFileMapping(pCache->FileHandle, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+		if( NULL != pCache->MapHandle ){
+			pCache->pData = (unsigned char *)MapViewOfFile(pCache->MapHandle, FILE_MAP_WRITE, 0, 0, 0);
+		}
+		if( NULL == pCache->pData ){
+			data_error("Error : could not map the cache %s\n",filename);
+			if( NULL != pCache->MapHandle ){
+				CloseHandle(pCache->MapHandle);
+			}
+			CloseHandle(pCache->FileHandle);
+			return -1;
+		}
+	}
+#else
+	{
+		struct stat status;
+		void *pMap;
+
+		pCache->FileDescriptor = open(filename, O_RDWR|O_CREAT, 0644);
+		if( pCache->FileDescriptor < 0 ){
+			data_error("Error : could not open the cache %s\n",filename);
+			return -1;
+		}
+		if( 0 != flock(pCache->FileDescriptor, LOCK_EX|LOCK_NB) ){
+			data_error("Error : the cache %s is in use by another process\n",filename);
+			close(pCache->FileDescriptor);
+			return -1;
+		}
+		fstat(pCache->FileDescriptor, &status);
+		file_size = (cache_uint64)status.st_size;
+		if( (file_size != size) && (0 != ftruncate(pCache->FileDescriptor, (off_t)size)) ){
+			data_error("Error : could not resize the cache %s\n",filename);
+			close(pCache->FileDescriptor);
+			return -1;
+		}
+		pMap = mmap(NULL, (size_t)size, PROT_READ|PROT_WRITE, MAP_SHARED, pCache->FileDescriptor, 0);
+		if( MAP_FAILED == pMap ){
+			data_error("Error : could not map the cache %s\n",filename);
+			close(pCache->FileDescriptor);
+			return -1;
+		}
+		pCache->pData = (unsigned char *)pMap;
+	}
+#endif
+	pCache->pHeader = pHeader = (struct cache_file_header *)pCache->pData;
+	if( (file_size != size) || (0 != memcmp(pHeader->Magic, CACHE_MAGIC, 8)) ||
+		(CACHE_BYTE_ORDER != pHeader->ByteOrder) || (CACHE_VERSION != pHeader->Version) ||
+		(size != pHeader->FileSize) || (0 != pHeader->Dirty) ){
+		cache_initialize(pCache, size);
+	}
+	pHeader->Dirty       = 1;
+	pCache->Slot         = (struct cache_slot *)(pCache->pData + CACHE_PAD8(sizeof(struct cache_file_header)));
+	pCache->DataCapacity = size - pHeader->DataOffset;
+	pCache->Lookups      = 0;
+	pCache->Hits         = 0;
+	pCache->Inserts      = 0;
+	pCache->Evictions    = 0;
+	thread_mutex_init(&pCache->Mutex);
+	return 0;
+}
+
+//--------------------------------------------------------
+// Copy the cached states of the key into pStates, whose
+// arrays must hold Mstates states.  Returns 1 on a hit
+// and 0 on a miss.
+//--------------------------------------------------------
+int isoDalton_cache_lookup(struct result_cache *pCache, struct cache_key *pKey, struct istates_info *pStates){
+	struct cache_entry_header *pEntry;
+	struct cache_slot *pSlot;
+	const double *pMass;
+	cache_uint64 hash;
+
+	hash = cache_key_hash(pKey);
+	thread_mutex_lock(&pCache->Mutex);
+	pCache->Lookups++;
+	pCache->pHeader->Lookups++;
+	pSlot = cache_find(pCache, pKey, hash);
+	if( NULL == pSlot ){
+		thread_mutex_unlock(&pCache->Mutex);
+		return 0;
+	}
+	pCache->Hits++;
+	pCache->pHeader->Hits++;
+	pSlot->LastUse = ++pCache->pHeader->Clock;
+	pEntry = (struct cache_entry_header *)(pCache->pData + pSlot->Offset);
+	pMass  = (const double *)((const unsigned char *)(pEntry+1) + CACHE_PAD8(pEntry->KeyLength+1));
+	pStates->StateTotal = (int)pEntry->StateTotal;
+	memcpy(pStates->mass, pMass, pEntry->StateTotal*sizeof(double));
+	memcpy(pStates->prob, pMass + pEntry->StateTotal, pEntry->StateTotal*sizeof(double));
+	thread_mutex_unlock(&pCache->Mutex);
+	return 1;
+}
+
+//--------------------------------------------------------
+// Store the states of the key (if the key is already
+// cached, nothing changes).  Returns 0 on success and -1
+// if the entry is larger than half the cache.
+//--------------------------------------------------------
+int isoDalton_cache_insert(struct result_cache *pCache, struct cache_key *pKey, struct istates_info *pStates){
+	struct cache_file_header  *pHeader;
+	struct cache_entry_header *pEntry;
+	unsigned char *pByte;
+	cache_uint64 hash;
+	cache_uint64 entry_bytes;
+	cache_uint64 offset;
+	size_t key_length;
+
+	hash        = cache_key_hash(pKey);
+	key_length  = strlen(pKey->Formula);
+	entry_bytes = cache_entry_bytes(key_length, pStates->StateTotal);
+	if( entry_bytes > pCache->DataCapacity/2 ){
+		return -1;
+	}
+	thread_mutex_lock(&pCache->Mutex);
+	pHeader = pCache->pHeader;
+	if( NULL != cache_find(pCache, pKey, hash) ){
+		thread_mutex_unlock(&pCache->Mutex);
+		return 0;
+	}
+	if( (pHeader->DataUsed + entry_bytes > pCache->DataCapacity) || ((pHeader->EntryTotal+1)*4 > pHeader->SlotTotal*3) ){
+		cache_evict(pCache);
+	}
+	offset = pHeader->DataOffset + pHeader->DataUsed;
+	pEntry = (struct cache_entry_header *)(pCache->pData + offset);
+	pEntry->Hash        = hash;
+	pEntry->Fingerprint = pKey->Fingerprint;
+	pEntry->Parameters  = pKey->Parameters;
+	pEntry->Mstates     = (cache_uint32)pKey->Mstates;
+	pEntry->log10flag   = (cache_uint32)pKey->log10flag;
+	pEntry->KeyLength   = (cache_uint32)key_length;
+	pEntry->StateTotal  = (cache_uint32)pStates->StateTotal;
+	pByte = (unsigned char *)(pEntry+1);
+	memset(pByte, 0, (size_t)CACHE_PAD8(key_length+1));
+	memcpy(pByte, pKey->Formula, key_length);
+	pByte += CACHE_PAD8(key_length+1);
+	memcpy(pByte, pStates->mass, pStates->StateTotal*sizeof(double));
+	memcpy(pByte + pStates->StateTotal*sizeof(double), pStates->prob, pStates->StateTotal*sizeof(double));
+	cache_place(pCache, hash, offset, ++pHeader->Clock);
+	pHeader->DataUsed += entry_bytes;
+	pHeader->EntryTotal++;
+	pHeader->Inserts++;
+	pCache->Inserts++;
+	thread_mutex_unlock(&pCache->Mutex);
+	return 0;
+}
+
+void isoDalton_cache_stats(struct result_cache *pCache, struct cache_stats *pStats){
+	thread_mutex_lock(&pCache->Mutex);
+	pStats->Lookups      = pCache->Lookups;
+	pStats->Hits         = pCache->Hits;
+	pStats->Inserts      = pCache->Inserts;
+	pStats->Evictions    = pCache->Evictions;
+	pStats->TotalLookups = pCache->pHeader->Lookups;
+	pStats->TotalHits    = pCache->pHeader->Hits;
+	pStats->EntryTotal   = pCache->pHeader->EntryTotal;
+	pStats->DataUsed     = pCache->pHeader->DataUsed;
+	pStats->DataCapacity = pCache->DataCapacity;
+	thread_mutex_unlock(&pCache->Mutex);
+}
+
+//--------------------------------------------------------
+// Mark the file clean, write it back and unlock it
+//--------------------------------------------------------
+void isoDalton_cache_close(struct result_cache *pCache){
+	if( NULL == pCache->pData ){
+		return;
+	}
+#ifdef WIN32
+	FlushViewOfFile(pCache->pData, 0);
+	pCache->pHeader->Dirty = 0;
+	FlushViewOfFile(pCache->pData, sizeof(struct cache_file_header));
+	UnmapViewOfFile(pCache->pData);
+	CloseHandle(pCache->MapHandle);
+	CloseHandle(pCache->FileHandle);
+#else
+	msync(pCache->pData, (size_t)pCache->pHeader->FileSize, MS_SYNC);
+	pCache->pHeader->Dirty = 0;
+	msync(pCache->pData, sizeof(struct cache_file_header), MS_SYNC);
+	munmap(pCache->pData, (size_t)pCache->pHeader->FileSize);
+	flock(pCache->FileDescriptor, LOCK_UN);
+	close(pCache->FileDescriptor);
+#endif
+	pCache->pData = NULL;
+	thread_mutex_destroy(&pCache->Mutex);
+}
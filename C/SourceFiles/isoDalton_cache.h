@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_cache.h                                       */
+/*               Header file for isoDalton_cache.cpp, a file backed      */
+/*               cache of computed isotope distributions                 */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_CACHE
+#define ISODALTON_CACHE
+
+#include "data.h"
+#include "thread.h"
+
+#ifdef _MSC_VER
+	typedef unsigned __int64 cache_uint64;
+	typedef unsigned int     cache_uint32;
+#else
+	#include <stdint.h>
+	typedef uint64_t         cache_uint64;
+	typedef uint32_t         cache_uint32;
+#endif
+
+//---------------------------------------------------------------------------------------------
+// The cache is one file of a fixed size (the size limit), mapped into memory:
+//
+//   header       struct cache_file_header
+//   slot table   SlotTotal struct cache_slot, open addressing on the key hash
+//   data         entries appended one after the other:
+//                  struct cache_entry_header
+//                  canonical formula, NUL terminated, padded to 8 bytes
+//                  StateTotal masses then StateTotal probabilities (doubles, exactly as computed)
+//
+// A lookup hashes the key, probes the slot table and compares the stored key, then copies the
+// states out of the mapping.  Every hit or insert stamps the slot with the cache clock.  When
+// the data region or slot table fills, the least recently used entries are evicted until half
+// of the space is free and the survivors are slid down to close the gaps.
+//
+// The file belongs to one process at a time (it is locked while open).  It is marked dirty
+// while open, so a file left by a crashed run is cleared rather than trusted.
+//---------------------------------------------------------------------------------------------
+#define CACHE_MAGIC        "isoDcch1"
+#define CACHE_BYTE_ORDER   0x01020304
+#define CACHE_VERSION      1
+#define CACHE_DEFAULT_SIZE (256<<20)   // bytes
+#define CACHE_MIN_SIZE     (1<<20)
+
+struct cache_file_header {
+	char         Magic[8];
+	cache_uint32 ByteOrder;
+	cache_uint32 Version;
+	cache_uint64 FileSize;
+	cache_uint64 SlotTotal;     // power of two
+	cache_uint64 DataOffset;    // file offset of the data region
+	cache_uint64 DataUsed;      // bytes of the data region in use
+	cache_uint64 EntryTotal;
+	cache_uint64 Clock;         // incremented on every hit and insert
+	cache_uint64 Dirty;         // 1 while a process has the file open
+	cache_uint64 Lookups;       // totals over every run that used the file
+	cache_uint64 Hits;
+	cache_uint64 Inserts;
+	cache_uint64 Evictions;
+};
+
+struct cache_slot {
+	cache_uint64 Hash;
+	cache_uint64 Offset;        // file offset of the entry, 0 = empty slot
+	cache_uint64 LastUse;       // cache clock of the last hit or insert
+};
+
+struct cache_entry_header {
+	cache_uint64 Hash;
+	cache_uint64 Fingerprint;
+	cache_uint64 Parameters;
+	cache_uint32 Mstates;
+	cache_uint32 log10flag;
+	cache_uint32 KeyLength;     // canonical formula length without the NUL
+	cache_uint32 StateTotal;
+};
+
+//---------------------------------------------------------------------------------------------
+// What a result depends on.  Formula is the canonical formula (isoDalton_formula_canonical),
+// Fingerprint identifies the element list (isoDalton_cache_fingerprint) and Parameters is the
+// 64 bit FNV-1a hash (isoDalton_cache_parameters) of a record of every other setting that
+// changes the result (0 if there is none).  Entries are matched on the hash, so two records
+// are only told apart if their hashes differ.
+//---------------------------------------------------------------------------------------------
+struct cache_key {
+	const char  *Formula;
+	int          Mstates;
+	int          log10flag;
+	cache_uint64 Fingerprint;
+	cache_uint64 Parameters;
+};
+
+struct cache_stats {
+	cache_uint64 Lookups;       // this session
+	cache_uint64 Hits;
+	cache_uint64 Inserts;
+	cache_uint64 Evictions;
+	cache_uint64 TotalLookups;  // every run that used the file
+	cache_uint64 TotalHits;
+	cache_uint64 EntryTotal;
+	cache_uint64 DataUsed;
+	cache_uint64 DataCapacity;
+};
+
+struct result_cache {
+	unsigned char            *pData;      // the mapped file
+	struct cache_file_header *pHeader;
+	struct cache_slot        *Slot;
+	cache_uint64              DataCapacity;
+	thread_mutex              Mutex;      // lookups and inserts may come from any thread
+	cache_uint64              Lookups;
+	cache_uint64              Hits;
+	cache_uint64              Inserts;
+	cache_uint64              Evictions;
+#ifdef WIN32
+	void                     *FileHandle;
+	void                     *MapHandle;
+#else
+	int                       FileDescriptor;
+#endif
+};
+
+int  isoDalton_cache_open(struct result_cache *, const char *, cache_uint64);
+int  isoDalton_cache_lookup(struct result_cache *, struct cache_key *, struct istates_info *);
+int  isoDalton_cache_insert(struct result_cache *, struct cache_key *, struct istates_info *);
+void isoDalton_cache_stats(struct result_cache *, struct cache_stats *);
+void isoDalton_cache_close(struct result_cache *);
+cache_uint64 isoDalton_cache_fingerprint(struct element_list *);
+cache_uint64 isoDalton_cache_parameters(const void *, size_t);
+
+#endif
@@ -0,0 +1,1152 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_cli.cpp                                       */
+/*               Command line driver.  Reads one molecular formula per   */
+/*               line from a file or stdin and writes the isotope        */
+/*               distribution of each formula.                           */
+/*                                                                       */
+/*               The formulas pass through three stages connected by     */
+/*               bounded queues: a reader (main thread), a pool of       */
+/*               compute threads and a writer thread.  A fixed number of */
+/*               job slots, each holding the states of one formula,      */
+/*               circulates through the stages, so memory does not grow  */
+/*               with the size of the input.  Results are written as     */
+/*               they finish, or in input order with -ordered.           */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_formula.h"
+#include "isoDalton_binary.h"
+#include "isoDalton_text.h"
+#include "isoDalton_mzml.h"
+#include "isoDalton_cache.h"
+#include "isoDalton_score.h"
+#include "thread.h"
+#include <limits.h>
+
+#define CLI_LINE_MAX        1024
+#define CLI_OUTPUT_BUFFER   (1<<20)
+#define CLI_STATUS_TOO_LONG -1   // job status of a line longer than CLI_LINE_MAX
+#define CLI_STATUS_LOSS     -2   // job status of a computation stopped by -loss_action abort
+#define CLI_STATUS_MEMORY   -3   // job status of a computation refused by -max_memory
+#define CLI_STATUS_SPILL    -4   // job status of a computation whose spill files failed
+#define CLI_STATUS_ENVELOPE -5   // job status of an envelope that could not be allocated
+#define CLI_FORMAT_TEXT     0
+#define CLI_FORMAT_BINARY   1    // isoDalton_binary.h
+#define CLI_FORMAT_TABLE    2    // isoDalton_text.h: tsv, csv or ndjson
+#define CLI_FORMAT_MZML     3    // isoDalton_mzml.h
+#define CLI_ENVELOPE_MAX_ERROR 0.01   // default -envelope_max_error
+
+static char OutputBuffer[CLI_OUTPUT_BUFFER];
+
+//---------------------------------------------------------------------------------------------
+// Command line options
+//---------------------------------------------------------------------------------------------
+struct cli_options {
+	char *DataPath;
+	char *UserDataPath;
+	char *UserCompFilename;
+	char *InputFilename;    // NULL = stdin
+	char *OutputFilename;   // NULL = stdout
+	int   Mstates;
+	int   log10flag;
+	int   Nthreads;
+	int   Nslots;           // number of formulas in flight
+	int   Ordered;          // 1 = write the results in input order
+	int   Verbose;
+	int   Format;           // CLI_FORMAT_TEXT, _BINARY, _TABLE or _MZML
+	int   TextFormat;       // table: TEXT_FORMAT_TSV, TEXT_FORMAT_CSV or TEXT_FORMAT_NDJSON
+	double Quantum;         // binary: daltons per quantized mass unit
+	int   ProbBytes;        // binary: 4 (float) or 8 (double) byte probabilities
+	char *CacheFilename;    // NULL = no result cache
+	double CacheMegabytes;
+	char *TraceFilename;    // NULL = no instrumentation
+	int   TraceCsv;         // 1 = CSV trace, 0 = one JSON object per formula
+	double LossBudget;      // largest discarded probability, 0 = no budget
+	int   LossAction;       // LOSS_ACTION_REPORT, _ABORT or _GROW
+	int   MaxStates;        // largest number of states of LOSS_ACTION_GROW
+	char *LossFilename;     // NULL = no loss report
+	double MemoryMegabytes; // peak memory of one trellis, 0 = no budget
+	int   MemoryAction;     // MEMORY_ACTION_FIT, _FIT_PRECISION or _REFUSE
+	int   Precision;        // STATE_PRECISION_FULL, _COMPACT or _WIDE
+	char *SpillDirectory;   // NULL = the states are kept in memory
+	double RunMegabytes;    // spill: memory of one sorted run, 0 = -max_memory or the default
+	int   Checkpoint;       // spill: 1 = checkpoint every formula in the spill directory
+	int   KeepStates;       // spill: most probable states written per formula, 0 = -states
+	int   Clustered;        // 1 = keep the states by nominal mass cluster
+	int   ClusterThreads;   // clusters: threads of one formula
+	int   ClusterBudget;    // clusters: CLUSTER_BUDGET_GLOBAL or _PROPORTIONAL
+	int   ClusterMinimum;   // clusters: proportional: states kept per cluster
+	int   Windowed;         // 1 = only the states of a mass window
+	double WindowLow;       // window: daltons
+	double WindowHigh;
+	int   WindowOffset;     // window: k of the M+k cluster, -1 = WindowLow to WindowHigh
+	int   BoundStates;      // most probable states written with bound pruning, 0 = no bound
+	int   Scheduled;        // 1 = element order by cost model
+	int   Envelope;         // ENVELOPE_GAUSSIAN or _EDGEWORTH clusters instead of the trellis, -1 = trellis
+	double EnvelopeMaxError; // envelope: largest estimated error, the trellis above it
+	char *ObservedFilename; // NULL = no scoring
+	double Ppm;             // scoring: match tolerance
+	char *ScoreFilename;    // scoring: JSON lines of the scores
+};
+
+//---------------------------------------------------------------------------------------------
+// Every option that changes a result, in a fixed record (0 when the option is not used) whose
+// FNV-1a hash is the Parameters of the cache keys
+//---------------------------------------------------------------------------------------------
+struct cli_cache_parameters {
+	double LossBudget;
+	double MemoryMegabytes;
+	double WindowLow;
+	double WindowHigh;
+	int    StateCapacity;
+	int    LossAction;          // +1, 0 = no budget
+	int    MemoryAction;        // +1, 0 = no budget
+	int    Precision;
+	int    ClusterProportional;
+	int    ClusterMinimum;
+	int    Windowed;
+	int    WindowOffset;
+	int    BoundStates;
+	int    Scheduled;
+	int    Spilled;
+	int    KeepStates;
+};
+
+//---------------------------------------------------------------------------------------------
+// One formula and its result
+//---------------------------------------------------------------------------------------------
+struct cli_job {
+	long   Sequence;                 // line number among the formulas read, from 0
+	char   Formula[CLI_LINE_MAX];
+	int    Status;                   // FORMULA_OK, a FORMULA_ERROR code or CLI_STATUS_*
+	struct formula_info Parsed;
+	struct istates_info States;
+	int    Traced;                   // 1 = Trace holds the computation of this formula
+	struct exact_mass_trace Trace;
+	int    LossReported;             // 1 = Loss holds the computation of this formula
+	struct exact_mass_loss Loss;
+	struct exact_mass_memory Memory;
+	double PeakBytes;                // peak trellis bytes with -max_memory, else 0
+	struct exact_mass_external External;
+	char   CheckpointPath[EXTERNAL_PATH_MAX];
+	double SpillBytes;               // bytes written to spill files with -spill, else 0
+	struct exact_mass_clusters Clusters;
+	struct exact_mass_window Window;
+	struct exact_mass_bound Bound;
+	struct exact_mass_schedule Schedule;
+	int    Scored;                   // 1 = Score holds the score of the states against -observed
+	int    Enveloped;                // 1 = States are the clusters of the -envelope
+	double EnvelopeError;            // -envelope: estimated error of the envelope
+	struct spectrum_score Score;
+};
+
+struct cli_context {
+	struct cli_options          *pOptions;
+	struct element_list         *pElements;
+	struct formula_symbol_table *pTable;
+	struct thread_queue FreeQueue;   // empty job slots
+	struct thread_queue WorkQueue;   // formulas to compute
+	struct thread_queue DoneQueue;   // results to write
+	volatile long WorkersRunning;
+	FILE *pOutput;
+	struct binary_writer Binary;
+	struct text_writer   Table;
+	struct mzml_writer   Mzml;
+	struct result_cache  Cache;
+	FILE *pTrace;
+	FILE *pLoss;
+	FILE *pScore;
+	struct score_spectrum Spectrum;   // -observed
+	double BestAngle;                 // largest spectral angle of a formula
+	char   BestFormula[CLI_LINE_MAX];
+	int   StateCapacity;   // states of a job slot
+	int          CacheOpen;
+	cache_uint64 Fingerprint;   // of the element list, part of every cache key
+	cache_uint64 Parameters;    // of the options changing a result, part of every cache key
+	long  Nwritten;
+	long  Nerrors;
+	double PeakBytes;   // largest peak trellis bytes of a formula
+	double SpillBytes;  // largest spill bytes of a formula
+};
+
+
+static void cli_usage(void){
+	fprintf(stderr,"Usage: isoDalton_cli [options] [formula_file]\n");
+	fprintf(stderr,"Reads one molecular formula per line (stdin if no file is given).\n");
+	fprintf(stderr,"Blank lines and lines starting with # are skipped.\n");
+	fprintf(stderr,"  -data path      directory of NIST_isotopes.txt and AtomTabl.XML (DataFiles)\n");
+	fprintf(stderr,"  -user path      directory of the user isotope file (DataFileUser)\n");
+	fprintf(stderr,"  -comp file      user isotope file (UserIsotopesNIST_HCNOS.xml)\n");
+	fprintf(stderr,"  -states N       number of states per formula (1000)\n");
+	fprintf(stderr,"  -log10          write log10 probabilities\n");
+	fprintf(stderr,"  -threads N      compute threads (number of processors)\n");
+	fprintf(stderr,"  -queue N        formulas in flight (4 per thread)\n");
+	fprintf(stderr,"  -ordered        write the results in input order\n");
+	fprintf(stderr,"  -o file         output file (stdout)\n");
+	fprintf(stderr,"  -format name    text, tsv, csv, ndjson, binary or mzml (text);\n");
+	fprintf(stderr,"                  binary and mzml need -o\n");
+	fprintf(stderr,"  -float          binary: 32 bit probabilities (64 bit)\n");
+	fprintf(stderr,"  -quantum q      binary: mass resolution in daltons (1e-9)\n");
+	fprintf(stderr,"  -cache file     reuse results stored in this cache file (and add new ones)\n");
+	fprintf(stderr,"  -cache_size MB  size limit of the cache file (256)\n");
+	fprintf(stderr,"  -trace file     write the stage times and state counts of every formula\n");
+	fprintf(stderr,"  -trace_format f json (one object per line) or csv (json)\n");
+	fprintf(stderr,"  -max_loss p     largest probability the cap at -states may discard\n");
+	fprintf(stderr,"  -loss_action a  report, abort or grow when -max_loss is exceeded (report)\n");
+	fprintf(stderr,"  -max_states N   grow: largest number of states (64 times -states)\n");
+	fprintf(stderr,"  -loss file      write the discarded probability of every formula (JSON lines);\n");
+	fprintf(stderr,"                  formulas are computed, not read from the -cache\n");
+	fprintf(stderr,"  -max_memory MB  peak memory of one computation (no limit)\n");
+	fprintf(stderr,"  -memory_action a fit (lower -states), fit_precision (compact states first) or refuse\n");
+	fprintf(stderr,"                  when -max_memory is exceeded (fit)\n");
+	fprintf(stderr,"  -precision p    trellis states: full (doubles), compact (32 bit mass offset and\n");
+	fprintf(stderr,"                  float) or wide (64 bit mass offset and double) (full)\n");
+	fprintf(stderr,"  -spill dir      keep the states in spill files in this directory (out of core)\n");
+	fprintf(stderr,"  -run_size MB    spill: memory of one sorted run (-max_memory or 256)\n");
+	fprintf(stderr,"  -checkpoint     spill: checkpoint every formula so a rerun continues it\n");
+	fprintf(stderr,"  -keep N         spill: most probable states written per formula (-states)\n");
+	fprintf(stderr,"  -clusters       sort and combine the states by nominal mass cluster\n");
+	fprintf(stderr,"  -cluster_threads N clusters: threads sharing the clusters of one formula (1)\n");
+	fprintf(stderr,"  -cluster_budget b clusters: global (the most probable states) or proportional\n");
+	fprintf(stderr,"                  (-states shared out by cluster probability) (global)\n");
+	fprintf(stderr,"  -cluster_min N  clusters: proportional: states every cluster keeps (16)\n");
+	fprintf(stderr,"  -window lo,hi   only the states of lo to hi daltons\n");
+	fprintf(stderr,"  -window_nominal k only the states of the M+k cluster\n");
+	fprintf(stderr,"                  (in memory full precision states: not with -spill,\n");
+	fprintf(stderr,"                  -clusters or -precision)\n");
+	fprintf(stderr,"  -schedule       order the elements by the estimated trellis cost\n");
+	fprintf(stderr,"  -envelope e     gaussian or edgeworth: write the nominal mass clusters of the\n");
+	fprintf(stderr,"                  analytic envelope instead of the trellis states\n");
+	fprintf(stderr,"  -envelope_max_error e  envelope: the trellis states of a formula whose envelope\n");
+	fprintf(stderr,"                  has a larger estimated error (0.01)\n");
+	fprintf(stderr,"  -observed file  centroids (mass intensity per line) to score every formula against\n");
+	fprintf(stderr,"  -score file     observed: write the scores of every formula (JSON lines)\n");
+	fprintf(stderr,"  -ppm p          observed: match tolerance in ppm (5)\n");
+	fprintf(stderr,"  -bound K        write the K most probable states, dropping the states that\n");
+	fprintf(stderr,"                  cannot reach them after each element (-states are kept)\n");
+	fprintf(stderr,"                  (in memory full precision states: not with -spill,\n");
+	fprintf(stderr,"                  -clusters or -precision)\n");
+	fprintf(stderr,"  -v              print the data file and computation reports to stderr\n");
+}
+
+//--------------------------------------------------------
+// Returns 0 on success and -1 on a usage error
+//--------------------------------------------------------
+static int cli_parse_options(int argc, char **argv, struct cli_options *pOptions){
+	int arg_index;
+
+	pOptions->DataPath         = (char *)"DataFiles";
+	pOptions->UserDataPath     = (char *)"DataFileUser";
+	pOptions->UserCompFilename = (char *)"UserIsotopesNIST_HCNOS.xml";
+	pOptions->InputFilename    = NULL;
+	pOptions->OutputFilename   = NULL;
+	pOptions->Mstates          = 1000;
+	pOptions->log10flag        = 0;
+	pOptions->Nthreads         = thread_processor_count();
+	pOptions->Nslots           = 0;
+	pOptions->Ordered          = 0;
+	pOptions->Verbose          = 0;
+	pOptions->Format           = CLI_FORMAT_TEXT;
+	pOptions->TextFormat       = TEXT_FORMAT_TSV;
+	pOptions->Quantum          = BINARY_DEFAULT_QUANTUM;
+	pOptions->ProbBytes        = 8;
+	pOptions->CacheFilename    = NULL;
+	pOptions->CacheMegabytes   = CACHE_DEFAULT_SIZE/1048576.0;
+	pOptions->TraceFilename    = NULL;
+	pOptions->TraceCsv         = 0;
+	pOptions->LossBudget       = 0;
+	pOptions->LossAction       = LOSS_ACTION_REPORT;
+	pOptions->MaxStates        = 0;
+	pOptions->LossFilename     = NULL;
+	pOptions->MemoryMegabytes  = 0;
+	pOptions->MemoryAction     = MEMORY_ACTION_FIT;
+	pOptions->Precision        = STATE_PRECISION_FULL;
+	pOptions->SpillDirectory   = NULL;
+	pOptions->RunMegabytes     = 0;
+	pOptions->Checkpoint       = 0;
+	pOptions->KeepStates       = 0;
+	pOptions->Clustered        = 0;
+	pOptions->ClusterThreads   = 1;
+	pOptions->ClusterBudget    = CLUSTER_BUDGET_GLOBAL;
+	pOptions->ClusterMinimum   = CLUSTER_DEFAULT_MIN_STATES;
+	pOptions->Windowed         = 0;
+	pOptions->WindowLow        = 0;
+	pOptions->WindowHigh       = 0;
+	pOptions->WindowOffset     = -1;
+	pOptions->BoundStates      = 0;
+	pOptions->Scheduled        = 0;
+	pOptions->Envelope         = -1;
+	pOptions->EnvelopeMaxError = CLI_ENVELOPE_MAX_ERROR;
+	pOptions->ObservedFilename = NULL;
+	pOptions->Ppm              = SCORE_DEFAULT_PPM;
+	pOptions->ScoreFilename    = NULL;
+
+	for(arg_index=1; arg_index<argc; arg_index++){
+		if( 0 == strcmp(argv[arg_index],"-log10") ){
+			pOptions->log10flag = 1;
+		}else if( 0 == strcmp(argv[arg_index],"-ordered") ){
+			pOptions->Ordered = 1;
+		}else if( 0 == strcmp(argv[arg_index],"-v") ){
+			pOptions->Verbose = 1;
+		}else if( 0 == strcmp(argv[arg_index],"-float") ){
+			pOptions->ProbBytes = 4;
+		}else if( 0 == strcmp(argv[arg_index],"-checkpoint") ){
+			pOptions->Checkpoint = 1;
+		}else if( 0 == strcmp(argv[arg_index],"-schedule") ){
+			pOptions->Scheduled = 1;
+		}else if( 0 == strcmp(argv[arg_index],"-clusters") ){
+			pOptions->Clustered = 1;
+		}else if( 0 == strcmp(argv[arg_index],"-h") ){
+			return -1;
+		}else if( ('-' == argv[arg_index][0]) && (arg_index+1 < argc) ){
+			if( 0 == strcmp(argv[arg_index],"-data") ){
+				pOptions->DataPath = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-user") ){
+				pOptions->UserDataPath = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-comp") ){
+				pOptions->UserCompFilename = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-states") ){
+				pOptions->Mstates = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-threads") ){
+				pOptions->Nthreads = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-queue") ){
+				pOptions->Nslots = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-o") ){
+				pOptions->OutputFilename = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-cache") ){
+				pOptions->CacheFilename = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-cache_size") ){
+				pOptions->CacheMegabytes = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-trace") ){
+				pOptions->TraceFilename = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-trace_format") ){
+				if( (0 != strcmp(argv[arg_index+1],"json")) && (0 != strcmp(argv[arg_index+1],"csv")) ){
+					fprintf(stderr,"Error : unknown trace format %s\n",argv[arg_index+1]);
+					return -1;
+				}
+				pOptions->TraceCsv = (0 == strcmp(argv[arg_index+1],"csv"));
+			}else if( 0 == strcmp(argv[arg_index],"-max_loss") ){
+				pOptions->LossBudget = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-max_states") ){
+				pOptions->MaxStates = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-loss") ){
+				pOptions->LossFilename = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-max_memory") ){
+				pOptions->MemoryMegabytes = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-memory_action") ){
+				if( 0 == strcmp(argv[arg_index+1],"fit") ){
+					pOptions->MemoryAction = MEMORY_ACTION_FIT;
+				}else if( 0 == strcmp(argv[arg_index+1],"fit_precision") ){
+					pOptions->MemoryAction = MEMORY_ACTION_FIT_PRECISION;
+				}else if( 0 == strcmp(argv[arg_index+1],"refuse") ){
+					pOptions->MemoryAction = MEMORY_ACTION_REFUSE;
+				}else{
+					fprintf(stderr,"Error : unknown memory action %s\n",argv[arg_index+1]);
+					return -1;
+				}
+			}else if( 0 == strcmp(argv[arg_index],"-spill") ){
+				pOptions->SpillDirectory = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-run_size") ){
+				pOptions->RunMegabytes = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-keep") ){
+				pOptions->KeepStates = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-cluster_threads") ){
+				pOptions->ClusterThreads = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-window") ){
+				if( (2 != sscanf(argv[arg_index+1],"%lf,%lf",&pOptions->WindowLow,&pOptions->WindowHigh)) || (pOptions->WindowLow > pOptions->WindowHigh) ){
+					fprintf(stderr,"Error : bad mass window %s\n",argv[arg_index+1]);
+					return -1;
+				}
+				pOptions->Windowed     = 1;
+				pOptions->WindowOffset = -1;
+			}else if( 0 == strcmp(argv[arg_index],"-window_nominal") ){
+				pOptions->Windowed     = 1;
+				pOptions->WindowOffset = atoi(argv[arg_index+1]);
+				if( pOptions->WindowOffset < 0 ){
+					fprintf(stderr,"Error : bad nominal offset %s\n",argv[arg_index+1]);
+					return -1;
+				}
+			}else if( 0 == strcmp(argv[arg_index],"-observed") ){
+				pOptions->ObservedFilename = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-ppm") ){
+				pOptions->Ppm = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-score") ){
+				pOptions->ScoreFilename = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-envelope") ){
+				if( 0 == strcmp(argv[arg_index+1],"gaussian") ){
+					pOptions->Envelope = ENVELOPE_GAUSSIAN;
+				}else if( 0 == strcmp(argv[arg_index+1],"edgeworth") ){
+					pOptions->Envelope = ENVELOPE_EDGEWORTH;
+				}else{
+					fprintf(stderr,"Error : unknown envelope %s\n",argv[arg_index+1]);
+					return -1;
+				}
+			}else if( 0 == strcmp(argv[arg_index],"-envelope_max_error") ){
+				pOptions->EnvelopeMaxError = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-bound") ){
+				pOptions->BoundStates = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-cluster_min") ){
+				pOptions->ClusterMinimum = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-cluster_budget") ){
+				if( 0 == strcmp(argv[arg_index+1],"global") ){
+					pOptions->ClusterBudget = CLUSTER_BUDGET_GLOBAL;
+				}else if( 0 == strcmp(argv[arg_index+1],"proportional") ){
+					pOptions->ClusterBudget = CLUSTER_BUDGET_PROPORTIONAL;
+					pOptions->Clustered     = 1;
+				}else{
+					fprintf(stderr,"Error : unknown cluster budget %s\n",argv[arg_index+1]);
+					return -1;
+				}
+			}else if( 0 == strcmp(argv[arg_index],"-precision") ){
+				if( 0 == strcmp(argv[arg_index+1],"full") ){
+					pOptions->Precision = STATE_PRECISION_FULL;
+				}else if( 0 == strcmp(argv[arg_index+1],"compact") ){
+					pOptions->Precision = STATE_PRECISION_COMPACT;
+				}else if( 0 == strcmp(argv[arg_index+1],"wide") ){
+					pOptions->Precision = STATE_PRECISION_WIDE;
+				}else{
+					fprintf(stderr,"Error : unknown precision %s\n",argv[arg_index+1]);
+					return -1;
+				}
+			}else if( 0 == strcmp(argv[arg_index],"-loss_action") ){
+				if( 0 == strcmp(argv[arg_index+1],"report") ){
+					pOptions->LossAction = LOSS_ACTION_REPORT;
+				}else if( 0 == strcmp(argv[arg_index+1],"abort") ){
+					pOptions->LossAction = LOSS_ACTION_ABORT;
+				}else if( 0 == strcmp(argv[arg_index+1],"grow") ){
+					pOptions->LossAction = LOSS_ACTION_GROW;
+				}else{
+					fprintf(stderr,"Error : unknown loss action %s\n",argv[arg_index+1]);
+					return -1;
+				}
+			}else if( 0 == strcmp(argv[arg_index],"-quantum") ){
+				pOptions->Quantum = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-format") ){
+				if( 0 == strcmp(argv[arg_index+1],"text") ){
+					pOptions->Format = CLI_FORMAT_TEXT;
+				}else if( 0 == strcmp(argv[arg_index+1],"binary") ){
+					pOptions->Format = CLI_FORMAT_BINARY;
+				}else if( 0 == strcmp(argv[arg_index+1],"mzml") ){
+					pOptions->Format = CLI_FORMAT_MZML;
+				}else if( 0 <= isoDalton_text_format_code(argv[arg_index+1]) ){
+					pOptions->Format     = CLI_FORMAT_TABLE;
+					pOptions->TextFormat = isoDalton_text_format_code(argv[arg_index+1]);
+				}else{
+					fprintf(stderr,"Error : unknown format %s\n",argv[arg_index+1]);
+					return -1;
+				}
+			}else{
+				fprintf(stderr,"Error : unknown option %s\n",argv[arg_index]);
+				return -1;
+			}
+			arg_index++;
+		}else if( ('-' != argv[arg_index][0]) && (NULL == pOptions->InputFilename) ){
+			pOptions->InputFilename = argv[arg_index];
+		}else{
+			fprintf(stderr,"Error : unknown option %s\n",argv[arg_index]);
+			return -1;
+		}
+	}
+	if( (pOptions->Mstates < 1) || (pOptions->Nthreads < 1) ){
+		fprintf(stderr,"Error : -states and -threads must be at least 1\n");
+		return -1;
+	}
+	if( ((CLI_FORMAT_BINARY == pOptions->Format) || (CLI_FORMAT_MZML == pOptions->Format)) && (NULL == pOptions->OutputFilename) ){
+		fprintf(stderr,"Error : the binary and mzml formats need an output file (-o)\n");
+		return -1;
+	}
+	if( (NULL == pOptions->ObservedFilename) != (NULL == pOptions->ScoreFilename) ){
+		fprintf(stderr,"Error : -observed and -score go together\n");
+		return -1;
+	}
+	if( pOptions->Windowed && (0 < pOptions->BoundStates) ){
+		fprintf(stderr,"Error : -bound cannot be used with a mass window\n");
+		return -1;
+	}
+	if( pOptions->Windowed && ((NULL != pOptions->SpillDirectory) || pOptions->Clustered || (STATE_PRECISION_FULL != pOptions->Precision)) ){
+		fprintf(stderr,"Error : a mass window cannot be used with -spill, -clusters or -precision\n");
+		return -1;
+	}
+	if( (0 < pOptions->BoundStates) && ((NULL != pOptions->SpillDirectory) || pOptions->Clustered || (STATE_PRECISION_FULL != pOptions->Precision)) ){
+		fprintf(stderr,"Error : -bound cannot be used with -spill, -clusters or -precision\n");
+		return -1;
+	}
+	if( pOptions->MaxStates < pOptions->Mstates ){
+		pOptions->MaxStates = (pOptions->Mstates > INT_MAX/64) ? INT_MAX : 64*pOptions->Mstates;
+	}
+	if( pOptions->Nslots < 1 ){
+		pOptions->Nslots = 4*pOptions->Nthreads;
+	}
+	if( pOptions->Nslots < pOptions->Nthreads ){
+		pOptions->Nslots = pOptions->Nthreads;
+	}
+	return 0;
+}
+
+//--------------------------------------------------------
+// The analytic envelope of one parsed formula (-envelope).
+// Enveloped is set if its estimated error is within
+// -envelope_max_error; otherwise the formula is left to
+// the trellis.
+//--------------------------------------------------------
+static void cli_envelope(struct cli_context *pContext, struct cli_job *pJob){
+	struct cli_options *pOptions;
+	struct molecule_info Molecule;
+	struct exact_mass_moments Moments;
+	int Npeaks;
+
+	//---------------------------------------------------------
+	// At most -states clusters, and no more than the job slot
+	// holds (-keep)
+	//---------------------------------------------------------
+	pOptions = pContext->pOptions;
+	Npeaks   = (pOptions->Mstates < pContext->StateCapacity) ? pOptions->Mstates : pContext->StateCapacity;
+	isoDalton_formula_molecule(&pJob->Parsed, pJob->Formula, &Molecule);
+	isoDalton_moments(&Molecule, pContext->pElements, NULL, &Moments);
+	if( 0 != isoDalton_moments_envelope(&Moments, pOptions->Envelope, Npeaks, &pJob->States, pOptions->log10flag, &pJob->EnvelopeError) ){
+		pJob->Status = CLI_STATUS_ENVELOPE;
+		return;
+	}
+	pJob->Enveloped = (pJob->EnvelopeError <= pOptions->EnvelopeMaxError);
+	isoDalton_formula_mz(&pJob->Parsed, &pJob->States);
+}
+
+//--------------------------------------------------------
+// Compute one parsed formula, with the trace if -trace,
+// the loss accounting if -max_loss or -loss and the
+// memory budget and state precision if -max_memory or
+// -precision, the spill files if -spill, the nominal
+// mass clusters if -clusters, the mass window if
+// -window or -window_nominal, the probability bound if
+// -bound and the element order if -schedule.  The
+// masses of an ion are m/z (a window too).
+//--------------------------------------------------------
+static void cli_compute(struct cli_context *pContext, struct cli_job *pJob){
+	struct cli_options *pOptions;
+	struct molecule_info Molecule;
+	struct exact_mass_reports Reports;
+
+	pOptions = pContext->pOptions;
+	isoDalton_formula_molecule(&pJob->Parsed, pJob->Formula, &Molecule);
+	if( (NULL == pContext->pTrace) && (NULL == pContext->pLoss) && (0 >= pOptions->LossBudget) && (0 >= pOptions->MemoryMegabytes) && (STATE_PRECISION_FULL == pOptions->Precision) && (NULL == pOptions->SpillDirectory) && (0 == pOptions->Clustered) && (0 == pOptions->Windowed) && (0 >= pOptions->BoundStates) && (0 == pOptions->Scheduled) ){
+		isoDalton_exact_mass(&Molecule, pContext->pElements, pOptions->Mstates, &pJob->States, pOptions->log10flag);
+		isoDalton_formula_mz(&pJob->Parsed, &pJob->States);
+		return;
+	}
+	Reports.pTrace    = NULL;
+	Reports.pLoss     = NULL;
+	Reports.pMemory   = NULL;
+	Reports.pExternal = NULL;
+	Reports.pClusters = NULL;
+	Reports.pWindow   = NULL;
+	Reports.pBound    = NULL;
+	Reports.pSchedule = NULL;
+	if( NULL != pContext->pTrace ){
+		Reports.pTrace = &pJob->Trace;
+		pJob->Traced   = 1;
+	}
+	if( (0 < pOptions->LossBudget) || (NULL != pContext->pLoss) ){
+		isoDalton_loss_init(&pJob->Loss, pOptions->LossBudget, pOptions->LossAction, pOptions->MaxStates);
+		Reports.pLoss      = &pJob->Loss;
+		pJob->LossReported = 1;
+	}
+	if( (0 < pOptions->MemoryMegabytes) || (STATE_PRECISION_FULL != pOptions->Precision) ){
+		isoDalton_memory_init(&pJob->Memory, pOptions->MemoryMegabytes*1048576.0, pOptions->MemoryAction, pOptions->Precision);
+		Reports.pMemory = &pJob->Memory;
+	}
+	if( NULL != pOptions->SpillDirectory ){
+		isoDalton_external_init(&pJob->External, pOptions->SpillDirectory, pOptions->RunMegabytes*1048576.0, NULL);
+		pJob->External.ResultStates = pOptions->KeepStates;
+		if( pOptions->Checkpoint ){
+			sprintf(pJob->CheckpointPath, "%.900s/isoDalton_%ld.checkpoint", pOptions->SpillDirectory, pJob->Sequence);
+			pJob->External.Checkpoint = pJob->CheckpointPath;
+		}
+		Reports.pExternal = &pJob->External;
+	}
+	if( pOptions->Clustered ){
+		isoDalton_clusters_init(&pJob->Clusters, pOptions->ClusterThreads);
+		pJob->Clusters.Budget    = pOptions->ClusterBudget;
+		pJob->Clusters.MinStates = pOptions->ClusterMinimum;
+		Reports.pClusters = &pJob->Clusters;
+	}
+	if( pOptions->Windowed ){
+		if( 0 <= pOptions->WindowOffset ){
+			isoDalton_window_nominal_init(&pJob->Window, pOptions->WindowOffset);
+		}else{
+			isoDalton_window_init(&pJob->Window, isoDalton_formula_neutral_mass(&pJob->Parsed, pOptions->WindowLow), isoDalton_formula_neutral_mass(&pJob->Parsed, pOptions->WindowHigh));
+		}
+		Reports.pWindow = &pJob->Window;
+	}
+	if( 0 < pOptions->BoundStates ){
+		isoDalton_bound_init(&pJob->Bound, pOptions->BoundStates);
+		Reports.pBound = &pJob->Bound;
+	}
+	if( pOptions->Scheduled ){
+		isoDalton_schedule_init(&pJob->Schedule, 0);
+		Reports.pSchedule = &pJob->Schedule;
+	}
+	if( 0 != isoDalton_exact_mass_report(&Molecule, pContext->pElements, NULL, pOptions->Mstates, &pJob->States, pOptions->log10flag, &Reports) ){
+		if( (NULL != Reports.pExternal) && pJob->External.Failed ){
+			pJob->Status = CLI_STATUS_SPILL;
+			pJob->Traced = 0;
+		}else if( (NULL != Reports.pMemory) && pJob->Memory.Refused ){
+			pJob->Status = CLI_STATUS_MEMORY;
+			pJob->Traced = 0;
+		}else if( (NULL != Reports.pLoss) && pJob->Loss.Aborted ){
+			pJob->Status = CLI_STATUS_LOSS;
+		}
+	}
+	isoDalton_formula_mz(&pJob->Parsed, &pJob->States);
+	if( NULL != Reports.pMemory ){
+		pJob->PeakBytes = pJob->Memory.PeakBytes;
+	}
+	if( NULL != Reports.pExternal ){
+		pJob->SpillBytes = (double)pJob->External.SpillBytes;
+	}
+}
+
+//--------------------------------------------------------
+// Compute stage
+//--------------------------------------------------------
+static void cli_compute_thread(void *argument){
+	struct cli_context *pContext;
+	struct cli_job *pJob;
+	struct cache_key Key;
+	char canonical[CLI_LINE_MAX];
+	int  keyed;
+	int  cached;
+
+	pContext = (struct cli_context *)argument;
+	Key.Formula     = canonical;
+	Key.Mstates     = pContext->pOptions->Mstates;
+	Key.log10flag   = pContext->pOptions->log10flag;
+	Key.Fingerprint = pContext->Fingerprint;
+	Key.Parameters  = pContext->Parameters;
+	while( NULL != (pJob = (struct cli_job *)thread_queue_pop(&pContext->WorkQueue)) ){
+		pJob->Traced       = 0;
+		pJob->LossReported = 0;
+		pJob->Scored       = 0;
+		pJob->Enveloped    = 0;
+		pJob->PeakBytes    = 0;
+		pJob->SpillBytes   = 0;
+		if( CLI_STATUS_TOO_LONG != pJob->Status ){
+			pJob->Status = isoDalton_formula_parse(pJob->Formula, pContext->pTable, &pJob->Parsed);
+		}
+		//------------------------------------------------
+		// An envelope is not cached: it takes less time
+		// than a lookup
+		//------------------------------------------------
+		if( (FORMULA_OK == pJob->Status) && (0 <= pContext->pOptions->Envelope) ){
+			cli_envelope(pContext, pJob);
+		}
+		if( (FORMULA_OK == pJob->Status) && (0 == pJob->Enveloped) ){
+			//------------------------------------------------
+			// A cached result skips the computation.  With
+			// -loss every formula is computed (an entry holds
+			// the states, not the report of the computation)
+			// and the results are still stored.
+			//------------------------------------------------
+			keyed  = pContext->CacheOpen && (0 <= isoDalton_formula_canonical(&pJob->Parsed, pContext->pTable, canonical, CLI_LINE_MAX));
+			cached = 0;
+			if( keyed && (NULL == pContext->pLoss) ){
+				cached = isoDalton_cache_lookup(&pContext->Cache, &Key, &pJob->States);
+			}
+			if( 0 == cached ){
+				cli_compute(pContext, pJob);
+				if( keyed && (FORMULA_OK == pJob->Status) ){
+					isoDalton_cache_insert(&pContext->Cache, &Key, &pJob->States);
+				}
+			}
+		}
+		//------------------------------------------------
+		// Cached results are scored too
+		//------------------------------------------------
+		if( (FORMULA_OK == pJob->Status) && (NULL != pContext->pScore) ){
+			pJob->Scored = (0 == isoDalton_score(&pContext->Spectrum, &pJob->States, pContext->pOptions->log10flag, &pJob->Score));
+		}
+		thread_queue_push(&pContext->DoneQueue, pJob);
+	}
+	//----------------------------------------------------
+	// The last compute thread to finish ends the writer
+	//----------------------------------------------------
+	if( 0 == thread_atomic_add(&pContext->WorkersRunning, -1) ){
+		thread_queue_close(&pContext->DoneQueue);
+	}
+}
+
+//--------------------------------------------------------
+// Write stage
+//--------------------------------------------------------
+static const char *cli_status_string(struct cli_job *pJob){
+	if( CLI_STATUS_TOO_LONG == pJob->Status ){
+		return "line too long";
+	}
+	if( CLI_STATUS_LOSS == pJob->Status ){
+		return "discarded probability over -max_loss";
+	}
+	if( CLI_STATUS_MEMORY == pJob->Status ){
+		return "states do not fit in -max_memory";
+	}
+	if( CLI_STATUS_SPILL == pJob->Status ){
+		return "spill file failed";
+	}
+	if( CLI_STATUS_ENVELOPE == pJob->Status ){
+		return "envelope could not be allocated";
+	}
+	return isoDalton_formula_error_string(pJob->Status);
+}
+
+static void cli_write_job(struct cli_context *pContext, struct cli_job *pJob){
+	struct istates_info NoStates;
+	const char *message;
+	int state_index;
+
+	if( FORMULA_OK != pJob->Status ){
+		pContext->Nerrors++;
+	}
+	if( CLI_FORMAT_BINARY == pContext->pOptions->Format ){
+		//----------------------------------------------------
+		// A formula with an error is stored without states so
+		// that record i is still the i-th formula
+		//----------------------------------------------------
+		if( FORMULA_OK == pJob->Status ){
+			isoDalton_binary_write(&pContext->Binary, pJob->Formula, &pJob->States, pContext->pOptions->log10flag);
+		}else{
+			fprintf(stderr,"%s\terror: %s\n",pJob->Formula,cli_status_string(pJob));
+			NoStates.StateTotal = 0;
+			NoStates.mass       = NULL;
+			NoStates.prob       = NULL;
+			isoDalton_binary_write(&pContext->Binary, pJob->Formula, &NoStates, pContext->pOptions->log10flag);
+		}
+	}else if( CLI_FORMAT_MZML == pContext->pOptions->Format ){
+		if( FORMULA_OK == pJob->Status ){
+			isoDalton_mzml_write(&pContext->Mzml, pJob->Formula, &pJob->States);
+		}else{
+			fprintf(stderr,"%s\terror: %s\n",pJob->Formula,cli_status_string(pJob));
+		}
+	}else if( CLI_FORMAT_TABLE == pContext->pOptions->Format ){
+		//----------------------------------------------------
+		// Errors go into an NDJSON stream and to stderr for
+		// TSV and CSV
+		//----------------------------------------------------
+		if( FORMULA_OK == pJob->Status ){
+			isoDalton_text_write(&pContext->Table, pJob->Formula, &pJob->States);
+		}else{
+			message = cli_status_string(pJob);
+			if( TEXT_FORMAT_NDJSON != pContext->pOptions->TextFormat ){
+				fprintf(stderr,"%s\terror: %s\n",pJob->Formula,message);
+			}
+			isoDalton_text_write_error(&pContext->Table, pJob->Formula, message);
+		}
+	}else if( (FORMULA_OK == pJob->Status) && pJob->Enveloped ){
+		fprintf(pContext->pOutput,"# %s\t%d\tenvelope error %.3g\n",pJob->Formula,pJob->States.StateTotal,pJob->EnvelopeError);
+		for(state_index=0; state_index<pJob->States.StateTotal; state_index++){
+			fprintf(pContext->pOutput,"%20.15f %20.15f\n",pJob->States.mass[state_index],pJob->States.prob[state_index]);
+		}
+	}else if( FORMULA_OK == pJob->Status ){
+		fprintf(pContext->pOutput,"# %s\t%d\n",pJob->Formula,pJob->States.StateTotal);
+		for(state_index=0; state_index<pJob->States.StateTotal; state_index++){
+			fprintf(pContext->pOutput,"%20.15f %20.15f\n",pJob->States.mass[state_index],pJob->States.prob[state_index]);
+		}
+	}else if( CLI_STATUS_TOO_LONG == pJob->Status ){
+		fprintf(pContext->pOutput,"# %s\terror: line longer than %d characters\n",pJob->Formula,CLI_LINE_MAX-1);
+	}else if( (CLI_STATUS_LOSS == pJob->Status) || (CLI_STATUS_MEMORY == pJob->Status) || (CLI_STATUS_SPILL == pJob->Status) || (CLI_STATUS_ENVELOPE == pJob->Status) ){
+		fprintf(pContext->pOutput,"# %s\terror: %s\n",pJob->Formula,cli_status_string(pJob));
+	}else{
+		fprintf(pContext->pOutput,"# %s\terror: %s at position %d\n",pJob->Formula,isoDalton_formula_error_string(pJob->Status),pJob->Parsed.ErrorPosition);
+	}
+	//----------------------------------------------------
+	// Formulas served from the cache have no trace
+	//----------------------------------------------------
+	if( pJob->Traced ){
+		if( pContext->pOptions->TraceCsv ){
+			isoDalton_trace_write_csv(&pJob->Trace, pJob->Formula, pContext->pTrace);
+		}else{
+			isoDalton_trace_write_json(&pJob->Trace, pJob->Formula, pContext->pTrace);
+		}
+	}
+	if( pContext->PeakBytes < pJob->PeakBytes ){
+		pContext->PeakBytes = pJob->PeakBytes;
+	}
+	if( pContext->SpillBytes < pJob->SpillBytes ){
+		pContext->SpillBytes = pJob->SpillBytes;
+	}
+	if( pJob->LossReported && (NULL != pContext->pLoss) ){
+		isoDalton_loss_write_json(&pJob->Loss, pJob->Formula, pContext->pLoss);
+	}
+	if( pJob->Scored ){
+		isoDalton_score_write_json(&pJob->Score, pJob->Formula, pContext->pScore);
+		if( pContext->BestAngle < pJob->Score.SpectralAngle ){
+			pContext->BestAngle = pJob->Score.SpectralAngle;
+			strcpy(pContext->BestFormula, pJob->Formula);
+		}
+	}
+	pContext->Nwritten++;
+	thread_queue_push(&pContext->FreeQueue, pJob);
+}
+
+static void cli_write_thread(void *argument){
+	struct cli_context *pContext;
+	struct cli_job *pJob;
+	struct cli_job **Pending;
+	long next_sequence;
+	int  Nslots;
+
+	pContext = (struct cli_context *)argument;
+	Nslots   = pContext->pOptions->Nslots;
+	if( 0 == pContext->pOptions->Ordered ){
+		while( NULL != (pJob = (struct cli_job *)thread_queue_pop(&pContext->DoneQueue)) ){
+			cli_write_job(pContext, pJob);
+		}
+		return;
+	}
+	//----------------------------------------------------
+	// In order: at most Nslots jobs are in flight, so a
+	// job waits in slot Sequence%Nslots until the jobs
+	// before it have been written
+	//----------------------------------------------------
+	Pending = (struct cli_job **)calloc(Nslots, sizeof(struct cli_job *));
+	next_sequence = 0;
+	while( NULL != (pJob = (struct cli_job *)thread_queue_pop(&pContext->DoneQueue)) ){
+		Pending[pJob->Sequence%Nslots] = pJob;
+		while( (NULL != Pending[next_sequence%Nslots]) && (next_sequence == Pending[next_sequence%Nslots]->Sequence) ){
+			pJob = Pending[next_sequence%Nslots];
+			Pending[next_sequence%Nslots] = NULL;
+			cli_write_job(pContext, pJob);
+			next_sequence++;
+		}
+	}
+	free(Pending);
+}
+
+//--------------------------------------------------------
+// Read stage.  Returns the number of formulas read.
+//--------------------------------------------------------
+static long cli_read_formulas(struct cli_context *pContext, FILE *pInput){
+	struct cli_job *pJob;
+	char line[CLI_LINE_MAX];
+	char *pStart;
+	size_t length;
+	long Nread;
+	int  too_long;
+	int  ch;
+
+	Nread = 0;
+	while( NULL != fgets(line, CLI_LINE_MAX, pInput) ){
+		length   = strlen(line);
+		too_long = 0;
+		if( (length == CLI_LINE_MAX-1) && ('\n' != line[length-1]) ){
+			//------------------------------------------------
+			// Skip the rest of an overlong line
+			//------------------------------------------------
+			ch = fgetc(pInput);
+			if( (EOF != ch) && ('\n' != ch) ){
+				too_long = 1;
+				while( (EOF != (ch = fgetc(pInput))) && ('\n' != ch) ){
+				}
+			}
+		}
+		while( (length > 0) && isspace((unsigned char)line[length-1]) ){
+			line[--length] = '\0';
+		}
+		pStart = line;
+		while( isspace((unsigned char)*pStart) ){
+			pStart++;
+		}
+		if( ('\0' == *pStart) || ('#' == *pStart) ){
+			continue;
+		}
+		pJob = (struct cli_job *)thread_queue_pop(&pContext->FreeQueue);
+		pJob->Sequence = Nread;
+		pJob->Status   = too_long ? CLI_STATUS_TOO_LONG : FORMULA_OK;
+		strcpy(pJob->Formula, pStart);
+		thread_queue_push(&pContext->WorkQueue, pJob);
+		Nread++;
+	}
+	thread_queue_close(&pContext->WorkQueue);
+	return Nread;
+}
+
+
+int main(int argc, char **argv)
+{
+	struct cli_options Options;
+	struct cli_context Context;
+	struct element_list Elements;
+	struct cli_job *Jobs;
+	struct thread_handle *ComputeThreads;
+	struct thread_handle WriteThread;
+	struct cache_stats CacheStats;
+	struct istates_info Peaks;
+	FILE *pInput;
+	long Nread;
+	int slot_index;
+	int thread_index;
+	clock_t time0,time1;
+	struct cli_cache_parameters Parameters;
+
+	if( 0 != cli_parse_options(argc, argv, &Options) ){
+		cli_usage();
+		return 1;
+	}
+	//--------------------------------------------------------------------------
+	// The results may go to stdout: the data file and computation reports
+	// of -v and the errors of the library are written to stderr
+	//--------------------------------------------------------------------------
+	data_set_stream(stderr);
+	data_set_verbose(Options.Verbose);
+
+	pInput = stdin;
+	if( NULL != Options.InputFilename ){
+		pInput = fopen(Options.InputFilename,"r");
+		if( NULL == pInput ){
+			fprintf(stderr,"Error : could not open %s\n",Options.InputFilename);
+			return 1;
+		}
+	}
+	Context.pOutput = stdout;
+	if( NULL != Options.OutputFilename ){
+		Context.pOutput = fopen(Options.OutputFilename,((CLI_FORMAT_BINARY == Options.Format) || (CLI_FORMAT_MZML == Options.Format)) ? "wb" : "w");
+		if( NULL == Context.pOutput ){
+			fprintf(stderr,"Error : could not open %s\n",Options.OutputFilename);
+			return 1;
+		}
+	}
+	setvbuf(Context.pOutput, OutputBuffer, _IOFBF, CLI_OUTPUT_BUFFER);
+	Context.pTrace = NULL;
+	if( NULL != Options.TraceFilename ){
+		Context.pTrace = fopen(Options.TraceFilename,"w");
+		if( NULL == Context.pTrace ){
+			fprintf(stderr,"Error : could not open %s\n",Options.TraceFilename);
+			return 1;
+		}
+		if( Options.TraceCsv ){
+			isoDalton_trace_write_csv_header(Context.pTrace);
+		}
+	}
+	Context.pLoss = NULL;
+	if( NULL != Options.LossFilename ){
+		Context.pLoss = fopen(Options.LossFilename,"w");
+		if( NULL == Context.pLoss ){
+			fprintf(stderr,"Error : could not open %s\n",Options.LossFilename);
+			return 1;
+		}
+	}
+	Context.pScore    = NULL;
+	Context.BestAngle = -1;
+	if( NULL != Options.ObservedFilename ){
+		if( isoDalton_score_read_peaks(Options.ObservedFilename, &Peaks) < 1 ){
+			fprintf(stderr,"Error : no peaks in %s\n",Options.ObservedFilename);
+			return 1;
+		}
+		if( 0 != isoDalton_score_spectrum_init(&Context.Spectrum, &Peaks, Options.Ppm) ){
+			return 1;
+		}
+		free(Peaks.mass);
+		free(Peaks.prob);
+		Context.pScore = fopen(Options.ScoreFilename,"w");
+		if( NULL == Context.pScore ){
+			fprintf(stderr,"Error : could not open %s\n",Options.ScoreFilename);
+			return 1;
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// With -loss_action grow a result can have up to MaxStates states
+	//--------------------------------------------------------------------------
+	Context.StateCapacity = Options.Mstates;
+	memset(&Parameters, 0, sizeof(Parameters));   // the padding is hashed too
+	if( 0 < Options.LossBudget ){
+		if( LOSS_ACTION_GROW == Options.LossAction ){
+			Context.StateCapacity = Options.MaxStates;
+		}
+		Parameters.LossBudget = Options.LossBudget;
+		Parameters.LossAction = Options.LossAction + 1;
+	}
+	if( (0 < Options.MemoryMegabytes) && (MEMORY_ACTION_REFUSE != Options.MemoryAction) ){
+		Parameters.MemoryMegabytes = Options.MemoryMegabytes;   // a fitted result has fewer states
+		Parameters.MemoryAction    = Options.MemoryAction + 1;
+	}
+	Parameters.Precision = Options.Precision;   // compact masses are rounded
+	if( CLUSTER_BUDGET_PROPORTIONAL == Options.ClusterBudget ){
+		Parameters.ClusterProportional = 1;   // other states are kept
+		Parameters.ClusterMinimum      = Options.ClusterMinimum;
+	}
+	if( Options.Windowed ){
+		Parameters.Windowed     = 1;
+		Parameters.WindowLow    = Options.WindowLow;
+		Parameters.WindowHigh   = Options.WindowHigh;
+		Parameters.WindowOffset = Options.WindowOffset;
+	}
+	Parameters.BoundStates = Options.BoundStates;   // states below the bound are dropped
+	Parameters.Scheduled   = Options.Scheduled;     // another order truncates other states
+
+	//--------------------------------------------------------------------------
+	// Out of core, only the -keep most probable states are written
+	//--------------------------------------------------------------------------
+	if( NULL != Options.SpillDirectory ){
+		if( (0 < Options.KeepStates) && (Options.KeepStates < Context.StateCapacity) ){
+			Context.StateCapacity = Options.KeepStates;
+		}
+		Parameters.Spilled    = 1;   // runs are combined as they merge
+		Parameters.KeepStates = Options.KeepStates;
+	}
+	Parameters.StateCapacity = Context.StateCapacity;
+	Context.Parameters = isoDalton_cache_parameters(&Parameters, sizeof(Parameters));
+	if( CLI_FORMAT_BINARY == Options.Format ){
+		if( 0 != isoDalton_binary_writer_open(&Context.Binary, Context.pOutput, Options.Quantum, Options.ProbBytes) ){
+			return 1;
+		}
+	}
+	if( CLI_FORMAT_MZML == Options.Format ){
+		if( 0 != isoDalton_mzml_writer_open(&Context.Mzml, Context.pOutput, Context.StateCapacity, Options.log10flag) ){
+			return 1;
+		}
+	}
+	if( CLI_FORMAT_TABLE == Options.Format ){
+		if( 0 != isoDalton_text_writer_open(&Context.Table, Context.pOutput, Options.TextFormat, Options.log10flag) ){
+			return 1;
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// Element tables and the formula symbol table (read only from here on)
+	//--------------------------------------------------------------------------
+	isoDalton_get_isotopes(Options.DataPath, Options.UserDataPath, Options.UserCompFilename, &Elements);
+	Context.pOptions  = &Options;
+	Context.pElements = &Elements;
+	Context.pTable    = (struct formula_symbol_table *)malloc(sizeof(struct formula_symbol_table));
+	if( 0 != isoDalton_formula_build_table(&Elements, Context.pTable) ){
+		fprintf(stderr,"Error : could not build the formula symbol table\n");
+		return 1;
+	}
+	Context.CacheOpen = 0;
+	if( NULL != Options.CacheFilename ){
+		Context.Fingerprint = isoDalton_cache_fingerprint(&Elements);
+		Context.CacheOpen   = (0 == isoDalton_cache_open(&Context.Cache, Options.CacheFilename, (cache_uint64)(Options.CacheMegabytes*1048576.0)));
+		if( 0 == Context.CacheOpen ){
+			fprintf(stderr,"Error : continuing without the cache\n");
+		}
+	}
+	Context.Nwritten = 0;
+	Context.Nerrors  = 0;
+	Context.PeakBytes = 0;
+	Context.SpillBytes = 0;
+	Context.WorkersRunning = Options.Nthreads;
+
+	//--------------------------------------------------------------------------
+	// Job slots, allocated once
+	//--------------------------------------------------------------------------
+	thread_queue_init(&Context.FreeQueue, Options.Nslots);
+	thread_queue_init(&Context.WorkQueue, Options.Nslots);
+	thread_queue_init(&Context.DoneQueue, Options.Nslots);
+	Jobs = (struct cli_job *)malloc(Options.Nslots*sizeof(struct cli_job));
+	for(slot_index=0; slot_index<Options.Nslots; slot_index++){
+		Jobs[slot_index].States.StateTotal = Context.StateCapacity;
+		Jobs[slot_index].States.mass = (double *)malloc(Context.StateCapacity*sizeof(double));
+		Jobs[slot_index].States.prob = (double *)malloc(Context.StateCapacity*sizeof(double));
+		Jobs[slot_index].Traced      = 0;
+		isoDalton_trace_init(&Jobs[slot_index].Trace);
+		thread_queue_push(&Context.FreeQueue, &Jobs[slot_index]);
+	}
+
+	time0 = clock();
+	ComputeThreads = (struct thread_handle *)malloc(Options.Nthreads*sizeof(struct thread_handle));
+	for(thread_index=0; thread_index<Options.Nthreads; thread_index++){
+		if( 0 != thread_start(&ComputeThreads[thread_index], cli_compute_thread, &Context) ){
+			fprintf(stderr,"Error : could not start compute thread %d\n",thread_index);
+			return 1;
+		}
+	}
+	if( 0 != thread_start(&WriteThread, cli_write_thread, &Context) ){
+		fprintf(stderr,"Error : could not start the writer thread\n");
+		return 1;
+	}
+	Nread = cli_read_formulas(&Context, pInput);
+	for(thread_index=0; thread_index<Options.Nthreads; thread_index++){
+		thread_join(&ComputeThreads[thread_index]);
+	}
+	thread_join(&WriteThread);
+	time1 = clock();
+	if( CLI_FORMAT_BINARY == Options.Format ){
+		isoDalton_binary_writer_close(&Context.Binary);
+	}
+	if( CLI_FORMAT_MZML == Options.Format ){
+		if( 0 != isoDalton_mzml_writer_close(&Context.Mzml) ){
+			fprintf(stderr,"Error : could not write the output\n");
+		}
+	}
+	if( CLI_FORMAT_TABLE == Options.Format ){
+		if( 0 != isoDalton_text_writer_close(&Context.Table) ){
+			fprintf(stderr,"Error : could not write the output\n");
+		}
+	}
+	fflush(Context.pOutput);
+
+	if( Options.Verbose ){
+		fprintf(stderr,"%ld formulas read, %ld written, %ld errors, %8.4f seconds of processor time\n",Nread,Context.Nwritten,Context.Nerrors,(double)(time1-time0)/(double)(CLOCKS_PER_SEC));
+		if( 0 < Options.MemoryMegabytes ){
+			fprintf(stderr,"largest trellis peak memory %.1f MB (limit %.1f MB)\n",Context.PeakBytes/1048576.0,Options.MemoryMegabytes);
+		}
+		if( NULL != Options.SpillDirectory ){
+			fprintf(stderr,"largest spill %.1f MB of one formula\n",Context.SpillBytes/1048576.0);
+		}
+		if( (NULL != Context.pScore) && (0 <= Context.BestAngle) ){
+			fprintf(stderr,"best spectral angle %.4f for %s\n",Context.BestAngle,Context.BestFormula);
+		}
+	}
+	if( Context.CacheOpen ){
+		if( Options.Verbose ){
+			isoDalton_cache_stats(&Context.Cache, &CacheStats);
+			fprintf(stderr,"cache : %.0f lookups, %.0f hits (%.1f%%), %.0f inserts, %.0f evicted\n",(double)CacheStats.Lookups,(double)CacheStats.Hits,
+				100.0*(double)CacheStats.Hits/(double)((0 < CacheStats.Lookups) ? CacheStats.Lookups : 1),(double)CacheStats.Inserts,(double)CacheStats.Evictions);
+			fprintf(stderr,"cache : %.0f entries, %.1f of %.1f MB, %.1f%% hits over all runs\n",(double)CacheStats.EntryTotal,(double)CacheStats.DataUsed/1048576.0,
+				(double)CacheStats.DataCapacity/1048576.0,100.0*(double)CacheStats.TotalHits/(double)((0 < CacheStats.TotalLookups) ? CacheStats.TotalLookups : 1));
+		}
+		isoDalton_cache_close(&Context.Cache);
+	}
+
+	//--------------------------------------------------------------------------
+	// Clean up
+	//--------------------------------------------------------------------------
+	if( stdin != pInput ){
+		fclose(pInput);
+	}
+	if( stdout != Context.pOutput ){
+		fclose(Context.pOutput);
+	}
+	if( NULL != Context.pTrace ){
+		fclose(Context.pTrace);
+	}
+	if( NULL != Context.pLoss ){
+		fclose(Context.pLoss);
+	}
+	if( NULL != Context.pScore ){
+		fclose(Context.pScore);
+		isoDalton_score_spectrum_free(&Context.Spectrum);
+	}
+	for(slot_index=0; slot_index<Options.Nslots; slot_index++){
+		free(Jobs[slot_index].States.mass);
+		free(Jobs[slot_index].States.prob);
+		isoDalton_trace_free(&Jobs[slot_index].Trace);
+	}
+	free(Jobs);
+	free(ComputeThreads);
+	thread_queue_destroy(&Context.FreeQueue);
+	thread_queue_destroy(&Context.WorkQueue);
+	thread_queue_destroy(&Context.DoneQueue);
+	free(Context.pTable);
+	data_free_elements(&Elements);
+	return (0 == Context.Nerrors) ? 0 : 1;
+}
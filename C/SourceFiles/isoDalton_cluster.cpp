@@ -0,0 +1,710 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_cluster.cpp                                   */
+/*               The trellis with its states kept in nominal mass        */
+/*               clusters that are sorted and combined one at a time,    */
+/*               shared out between threads                              */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "sort.h"
+#include "thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+struct cluster_trellis;
+typedef void (*cluster_task)(struct cluster_trellis *, int);
+
+//--------------------------------------------------------
+// Threads that share out the clusters of a pass.  The
+// calling thread works too, so ThreadTotal-1 are started.
+//--------------------------------------------------------
+struct cluster_pool {
+	int                     ThreadTotal;
+	struct thread_handle    Thread[CLUSTER_MAX_THREADS];
+	thread_mutex            Mutex;
+	thread_cond             Start;
+	thread_cond             Done;
+	int                     Generation;    // incremented for every pass
+	int                     Busy;          // started threads still in the pass
+	int                     Stop;
+	volatile long           NextCluster;
+	cluster_task            Task;
+	struct cluster_trellis *pTrellis;
+};
+
+//--------------------------------------------------------
+// The states of a step (array Source) and of the next
+// one (array Source^1), cluster by cluster
+//--------------------------------------------------------
+struct cluster_trellis {
+	int     log10flag;
+	int     ClusterCapacity;     // clusters the molecule can reach
+	int     ClusterTotal;        // clusters of the current states
+	int     NextClusterTotal;    // clusters of the next states
+	int     Source;
+	double *Mass[2];
+	double *Prob[2];
+	int    *Start[2];            // first state of each cluster
+	int    *Count[2];            // states of each cluster
+	int     Nisotopes;
+	double *IsotopeMass;
+	double *IsotopeFraction;
+	int    *IsotopeShift;        // nominal shift of each isotope
+	int     MaxShift;
+	struct cluster_pool Pool;
+};
+
+//--------------------------------------------------------
+// Passes
+//--------------------------------------------------------
+static void cluster_work(struct cluster_pool *pPool){
+	long cluster;
+
+	while( (cluster = thread_atomic_add(&pPool->NextCluster, 1) - 1) < pPool->pTrellis->NextClusterTotal ){
+		pPool->Task(pPool->pTrellis, (int)cluster);
+	}
+}
+
+static void cluster_worker(void *argument){
+	struct cluster_pool *pPool;
+	int generation;
+
+	pPool      = (struct cluster_pool *)argument;
+	generation = 0;
+	for(;;){
+		thread_mutex_lock(&pPool->Mutex);
+		while( (generation == pPool->Generation) && (0 == pPool->Stop) ){
+			thread_cond_wait(&pPool->Start, &pPool->Mutex);
+		}
+		if( pPool->Stop ){
+			thread_mutex_unlock(&pPool->Mutex);
+			return;
+		}
+		generation = pPool->Generation;
+		thread_mutex_unlock(&pPool->Mutex);
+		cluster_work(pPool);
+		thread_mutex_lock(&pPool->Mutex);
+		if( 0 == --pPool->Busy ){
+			thread_cond_signal(&pPool->Done);
+		}
+		thread_mutex_unlock(&pPool->Mutex);
+	}
+}
+
+// Run Task on every next cluster and wait for all of them
+static void cluster_pass(struct cluster_trellis *pTrellis, cluster_task Task){
+	struct cluster_pool *pPool;
+	int cluster;
+
+	pPool = &pTrellis->Pool;
+	if( 1 == pPool->ThreadTotal ){
+		for(cluster=0; cluster<pTrellis->NextClusterTotal; cluster++){
+			Task(pTrellis, cluster);
+		}
+		return;
+	}
+	thread_mutex_lock(&pPool->Mutex);
+	pPool->Task        = Task;
+	pPool->NextCluster = 0;
+	pPool->Busy        = pPool->ThreadTotal-1;
+	pPool->Generation++;
+	thread_cond_broadcast(&pPool->Start);
+	thread_mutex_unlock(&pPool->Mutex);
+	cluster_work(pPool);
+	thread_mutex_lock(&pPool->Mutex);
+	while( 0 < pPool->Busy ){
+		thread_cond_wait(&pPool->Done, &pPool->Mutex);
+	}
+	thread_mutex_unlock(&pPool->Mutex);
+}
+
+static void cluster_pool_start(struct cluster_trellis *pTrellis, int ThreadTotal){
+	struct cluster_pool *pPool;
+	int thread_index;
+
+	pPool = &pTrellis->Pool;
+	if( ThreadTotal > CLUSTER_MAX_THREADS ){
+		ThreadTotal = CLUSTER_MAX_THREADS;
+	}
+	pPool->ThreadTotal = 1;
+	pPool->pTrellis    = pTrellis;
+	pPool->Generation  = 0;
+	pPool->Busy        = 0;
+	pPool->Stop        = 0;
+	pPool->NextCluster = 0;
+	thread_mutex_init(&pPool->Mutex);
+	thread_cond_init(&pPool->Start);
+	thread_cond_init(&pPool->Done);
+	for(thread_index=1; thread_index<ThreadTotal; thread_index++){
+		if( 0 != thread_start(&pPool->Thread[thread_index], cluster_worker, pPool) ){
+			break;
+		}
+		pPool->ThreadTotal++;
+	}
+}
+
+static void cluster_pool_stop(struct cluster_trellis *pTrellis){
+	struct cluster_pool *pPool;
+	int thread_index;
+
+	pPool = &pTrellis->Pool;
+	thread_mutex_lock(&pPool->Mutex);
+	pPool->Stop = 1;
+	thread_cond_broadcast(&pPool->Start);
+	thread_mutex_unlock(&pPool->Mutex);
+	for(thread_index=1; thread_index<pPool->ThreadTotal; thread_index++){
+		thread_join(&pPool->Thread[thread_index]);
+	}
+	thread_cond_destroy(&pPool->Done);
+	thread_cond_destroy(&pPool->Start);
+	thread_mutex_destroy(&pPool->Mutex);
+}
+
+//--------------------------------------------------------
+// Tasks on one next cluster
+//--------------------------------------------------------
+
+// The states of the current clusters that add up to it
+static void cluster_expand(struct cluster_trellis *pTrellis, int cluster){
+	double *state1_mass,*state1_prob;
+	double *state2_mass,*state2_prob;
+	double mass_isotope,fraction_isotope;
+	int source;
+	int state1_index,state1_stop;
+	int state2_index;
+	int isotope_index;
+
+	state1_mass  = pTrellis->Mass[pTrellis->Source];
+	state1_prob  = pTrellis->Prob[pTrellis->Source];
+	state2_mass  = pTrellis->Mass[pTrellis->Source^1];
+	state2_prob  = pTrellis->Prob[pTrellis->Source^1];
+	state2_index = pTrellis->Start[pTrellis->Source^1][cluster];
+	for(isotope_index=0; isotope_index<pTrellis->Nisotopes; isotope_index++){
+		source = cluster - pTrellis->IsotopeShift[isotope_index];
+		if( (source < 0) || (source >= pTrellis->ClusterTotal) ){
+			continue;
+		}
+		mass_isotope     = pTrellis->IsotopeMass[isotope_index];
+		fraction_isotope = pTrellis->IsotopeFraction[isotope_index];
+		state1_stop      = pTrellis->Start[pTrellis->Source][source] + pTrellis->Count[pTrellis->Source][source];
+		for(state1_index=pTrellis->Start[pTrellis->Source][source]; state1_index<state1_stop; state1_index++){
+			state2_mass[state2_index] = state1_mass[state1_index] + mass_isotope;
+			if(1 == pTrellis->log10flag ){
+				state2_prob[state2_index] = log10(  pow(10,state1_prob[state1_index]) * fraction_isotope  );
+			}else{
+				state2_prob[state2_index] = state1_prob[state1_index] * fraction_isotope;
+			}
+			state2_index++;
+		}
+	}
+	pTrellis->Count[pTrellis->Source^1][cluster] = state2_index - pTrellis->Start[pTrellis->Source^1][cluster];
+}
+
+static void cluster_mass_sort(struct cluster_trellis *pTrellis, int cluster){
+	int first;
+
+	first = pTrellis->Start[pTrellis->Source^1][cluster];
+	heapsort_2dbl_up(pTrellis->Count[pTrellis->Source^1][cluster], &pTrellis->Mass[pTrellis->Source^1][first], &pTrellis->Prob[pTrellis->Source^1][first]);
+}
+
+static void cluster_combine(struct cluster_trellis *pTrellis, int cluster){
+	int first;
+
+	first = pTrellis->Start[pTrellis->Source^1][cluster];
+	if( 0 < pTrellis->Count[pTrellis->Source^1][cluster] ){
+		isoDalton_combine_masses(&pTrellis->Count[pTrellis->Source^1][cluster], &pTrellis->Mass[pTrellis->Source^1][first], &pTrellis->Prob[pTrellis->Source^1][first], pTrellis->log10flag);
+	}
+}
+
+static void cluster_prob_sort(struct cluster_trellis *pTrellis, int cluster){
+	int first;
+
+	first = pTrellis->Start[pTrellis->Source^1][cluster];
+	heapsort_2dbl_down(pTrellis->Count[pTrellis->Source^1][cluster], &pTrellis->Prob[pTrellis->Source^1][first], &pTrellis->Mass[pTrellis->Source^1][first]);
+}
+
+// All four while the cluster is in cache
+static void cluster_step(struct cluster_trellis *pTrellis, int cluster){
+	cluster_expand(pTrellis, cluster);
+	cluster_mass_sort(pTrellis, cluster);
+	cluster_combine(pTrellis, cluster);
+	cluster_prob_sort(pTrellis, cluster);
+}
+
+//--------------------------------------------------------
+// Where each next cluster starts: its states come from
+// the current clusters cluster-shift
+//--------------------------------------------------------
+static int cluster_layout(struct cluster_trellis *pTrellis){
+	int cluster;
+	int source;
+	int isotope_index;
+	int offset;
+
+	pTrellis->NextClusterTotal = pTrellis->ClusterTotal + pTrellis->MaxShift;
+	offset = 0;
+	for(cluster=0; cluster<pTrellis->NextClusterTotal; cluster++){
+		pTrellis->Start[pTrellis->Source^1][cluster] = offset;
+		for(isotope_index=0; isotope_index<pTrellis->Nisotopes; isotope_index++){
+			source = cluster - pTrellis->IsotopeShift[isotope_index];
+			if( (0 <= source) && (source < pTrellis->ClusterTotal) ){
+				offset += pTrellis->Count[pTrellis->Source][source];
+			}
+		}
+	}
+	return offset;
+}
+
+//--------------------------------------------------------
+// Max heap of clusters on the probability of the state
+// at Position[cluster] (the clusters are sorted by
+// decreasing probability)
+//--------------------------------------------------------
+static void cluster_heap_down(int *Heap, int Nheap, double *Prob, int *Start, int *Position, int index){
+	int child;
+	int cluster;
+
+	cluster = Heap[index];
+	while( (child = 2*index+1) < Nheap ){
+		if( (child+1 < Nheap) && (Prob[Start[Heap[child+1]]+Position[Heap[child+1]]] > Prob[Start[Heap[child]]+Position[Heap[child]]]) ){
+			child++;
+		}
+		if( Prob[Start[cluster]+Position[cluster]] >= Prob[Start[Heap[child]]+Position[Heap[child]]] ){
+			break;
+		}
+		Heap[index] = Heap[child];
+		index = child;
+	}
+	Heap[index] = cluster;
+}
+
+//--------------------------------------------------------
+// Take the Ntake most probable states of the Nclusters
+// clusters of array after the Position[c] states already
+// taken from each.  Position[c] is advanced and, with
+// Mass and Prob, the states are copied there by
+// decreasing probability.
+//--------------------------------------------------------
+static void cluster_take(struct cluster_trellis *pTrellis, int array, int Nclusters, int Ntake, int *Position, int *Heap, double *Mass, double *Prob){
+	int *Start;
+	int *Count;
+	int Nheap;
+	int cluster;
+	int state_index;
+
+	Start = pTrellis->Start[array];
+	Count = pTrellis->Count[array];
+	Nheap = 0;
+	for(cluster=0; cluster<Nclusters; cluster++){
+		if( Position[cluster] < Count[cluster] ){
+			Heap[Nheap++] = cluster;
+		}
+	}
+	for(cluster=Nheap/2-1; cluster>=0; cluster--){
+		cluster_heap_down(Heap, Nheap, pTrellis->Prob[array], Start, Position, cluster);
+	}
+	for(state_index=0; (state_index<Ntake) && (0 < Nheap); state_index++){
+		cluster = Heap[0];
+		if( NULL != Mass ){
+			Mass[state_index] = pTrellis->Mass[array][Start[cluster]+Position[cluster]];
+			Prob[state_index] = pTrellis->Prob[array][Start[cluster]+Position[cluster]];
+		}
+		Position[cluster]++;
+		if( Position[cluster] == Count[cluster] ){
+			Heap[0] = Heap[--Nheap];
+		}
+		if( 0 < Nheap ){
+			cluster_heap_down(Heap, Nheap, pTrellis->Prob[array], Start, Position, 0);
+		}
+	}
+}
+
+static double cluster_linear(double prob, int log10flag){
+	return (1 == log10flag) ? pow(10,prob) : prob;
+}
+
+//--------------------------------------------------------
+// CLUSTER_BUDGET_PROPORTIONAL: the states each next
+// cluster keeps (Position).  Every cluster keeps up to
+// MinStates, lowered so that the minimums take at most
+// half of Mstates, the rest is shared in proportion to
+// the probability of the clusters and what rounding
+// leaves goes to the most probable states.
+//--------------------------------------------------------
+static void cluster_budget(struct cluster_trellis *pTrellis, int Mstates, int MinStates, int *Position, int *Heap, double *Weight, double *Order){
+	int *Start;
+	int *Count;
+	double weight_total;
+	int Nclusters;
+	int Nordered;
+	int cluster;
+	int state_index;
+	int left,round_left;
+	int extra;
+
+	Start     = pTrellis->Start[pTrellis->Source^1];
+	Count     = pTrellis->Count[pTrellis->Source^1];
+	Nclusters = pTrellis->NextClusterTotal;
+	Nordered  = 0;
+	for(cluster=0; cluster<Nclusters; cluster++){
+		Position[cluster] = 0;
+		Weight[cluster]   = 0;
+		for(state_index=0; state_index<Count[cluster]; state_index++){
+			Weight[cluster] += cluster_linear(pTrellis->Prob[pTrellis->Source^1][Start[cluster]+state_index], pTrellis->log10flag);
+		}
+		if( 0 < Count[cluster] ){
+			Heap[Nordered]  = cluster;
+			Order[Nordered] = Weight[cluster];
+			Nordered++;
+		}
+	}
+
+	// The minimum, most probable clusters first
+	if( (0 < Nordered) && (MinStates > Mstates/2/Nordered) ){
+		MinStates = Mstates/2/Nordered;
+	}
+	for(cluster=0; cluster<Nordered; cluster++){
+		Weight[Nclusters+cluster] = (double)Heap[cluster];
+	}
+	heapsort_2dbl_down(Nordered, Order, &Weight[Nclusters]);
+	left = Mstates;
+	for(cluster=0; (cluster<Nordered) && (0 < left); cluster++){
+		extra = Count[(int)Weight[Nclusters+cluster]];
+		if( extra > MinStates ){
+			extra = MinStates;
+		}
+		if( extra > left ){
+			extra = left;
+		}
+		Position[(int)Weight[Nclusters+cluster]] = extra;
+		left -= extra;
+	}
+
+	// The rest by probability, until the clusters are full
+	while( 0 < left ){
+		weight_total = 0;
+		for(cluster=0; cluster<Nclusters; cluster++){
+			if( Position[cluster] < Count[cluster] ){
+				weight_total += Weight[cluster];
+			}
+		}
+		if( weight_total <= 0 ){
+			break;
+		}
+		round_left = left;
+		for(cluster=0; cluster<Nclusters; cluster++){
+			if( Position[cluster] < Count[cluster] ){
+				extra = (int)floor(round_left*(Weight[cluster]/weight_total));
+				if( extra > Count[cluster] - Position[cluster] ){
+					extra = Count[cluster] - Position[cluster];
+				}
+				Position[cluster] += extra;
+				left -= extra;
+			}
+		}
+		if( left == round_left ){
+			break;
+		}
+	}
+	cluster_take(pTrellis, pTrellis->Source^1, Nclusters, left, Position, Heap, NULL, NULL);
+}
+
+//--------------------------------------------------------
+// Clustered trellis options (isoDalton_cluster.h)
+//--------------------------------------------------------
+void isoDalton_clusters_init(struct exact_mass_clusters *pClusters, int ThreadTotal){
+	pClusters->ThreadTotal    = (ThreadTotal < 1) ? 1 : ThreadTotal;
+	pClusters->Budget         = CLUSTER_BUDGET_GLOBAL;
+	pClusters->MinStates      = CLUSTER_DEFAULT_MIN_STATES;
+	pClusters->ClusterTotal   = 0;
+	pClusters->LargestCluster = 0;
+}
+
+//--------------------------------------------------------
+// The trellis of a planned molecule by nominal mass
+// cluster (pReports->pClusters).  Mstates states are kept
+// and Mcapacity result entries are written.  Returns 0,
+// or -1 if the trellis was stopped by the loss budget or
+// could not be allocated.
+//--------------------------------------------------------
+int isoDalton_cluster_trellis(struct trellis_plan *pPlan, int Mstates, int Mcapacity, struct istates_info *pisostates, int log10flag, struct exact_mass_reports *pReports, int stop_over_budget, double time_start){
+	struct exact_mass_clusters *pClusters;
+	struct exact_mass_trace *pTrace;
+	struct exact_mass_loss *pLoss;
+	struct loss_element *pLossElement;
+	struct cluster_trellis Trellis;
+	int *Position;
+	int *Heap;
+	double *Weight;
+	double *Order;
+	double mass_min;
+	double discarded;
+	double prob_state;
+	double stage_seconds[TRACE_STAGE_TOTAL];
+	double time0,time1;
+	int Natoms;
+	int Nstate1,Nstate2;
+	int Ngenerated;
+	int Nvalid;
+	int cluster;
+	int shift;
+	int state_index;
+	int index1,index2,index3;
+	int trace_element;
+	int aborted;
+	int array_index;
+
+	pClusters     = pReports->pClusters;
+	pTrace        = pReports->pTrace;
+	pLoss         = pReports->pLoss;
+	pLossElement  = NULL;
+	trace_element = 0;
+	aborted       = 0;
+
+	//---------------------------------------------------------
+	// The heaviest cluster the molecule can reach
+	//---------------------------------------------------------
+	Trellis.ClusterCapacity = 1;
+	for(index1=0; index1<pPlan->ElementTotal; index1++){
+		mass_min = DBL_MAX;
+		shift    = 0;
+		for(index2=0; index2<pPlan->Element[index1]->NonzeroIsotopeTotal; index2++){
+			index3 = pPlan->Element[index1]->NonzeroIsotopeIndex[index2];
+			if( mass_min > pPlan->Element[index1]->Isotope[index3]->AtomicMass ){
+				mass_min = pPlan->Element[index1]->Isotope[index3]->AtomicMass;
+			}
+		}
+		for(index2=0; index2<pPlan->Element[index1]->NonzeroIsotopeTotal; index2++){
+			index3 = pPlan->Element[index1]->NonzeroIsotopeIndex[index2];
+			if( shift < (int)floor(pPlan->Element[index1]->Isotope[index3]->AtomicMass - mass_min + 0.5) ){
+				shift = (int)floor(pPlan->Element[index1]->Isotope[index3]->AtomicMass - mass_min + 0.5);
+			}
+		}
+		Trellis.ClusterCapacity += shift*pPlan->AtomCount[index1];
+	}
+	Trellis.log10flag       = log10flag;
+	Trellis.IsotopeMass     = (double *)malloc(pPlan->MaxIsotopes*sizeof(double));
+	Trellis.IsotopeFraction = (double *)malloc(pPlan->MaxIsotopes*sizeof(double));
+	Trellis.IsotopeShift    = (int *)malloc(pPlan->MaxIsotopes*sizeof(int));
+	Position                = (int *)malloc(Trellis.ClusterCapacity*sizeof(int));
+	Heap                    = (int *)malloc(Trellis.ClusterCapacity*sizeof(int));
+	Weight                  = (double *)malloc(2*Trellis.ClusterCapacity*sizeof(double));
+	Order                   = (double *)malloc(Trellis.ClusterCapacity*sizeof(double));
+	for(array_index=0; array_index<2; array_index++){
+		Trellis.Mass[array_index]  = (double *)malloc((size_t)Mstates*pPlan->MaxIsotopes*sizeof(double));
+		Trellis.Prob[array_index]  = (double *)malloc((size_t)Mstates*pPlan->MaxIsotopes*sizeof(double));
+		Trellis.Start[array_index] = (int *)malloc(Trellis.ClusterCapacity*sizeof(int));
+		Trellis.Count[array_index] = (int *)malloc(Trellis.ClusterCapacity*sizeof(int));
+	}
+	if( (NULL == Trellis.IsotopeMass) || (NULL == Trellis.IsotopeFraction) || (NULL == Trellis.IsotopeShift) || (NULL == Position) || (NULL == Heap) || (NULL == Weight) || (NULL == Order) ||
+		(NULL == Trellis.Mass[0]) || (NULL == Trellis.Prob[0]) || (NULL == Trellis.Start[0]) || (NULL == Trellis.Count[0]) ||
+		(NULL == Trellis.Mass[1]) || (NULL == Trellis.Prob[1]) || (NULL == Trellis.Start[1]) || (NULL == Trellis.Count[1]) ){
+		data_error("Error : could not allocate %d clustered states of %d isotopes\n",Mstates,pPlan->MaxIsotopes);
+		aborted = -1;
+	}
+
+	if( 0 == aborted ){
+		cluster_pool_start(&Trellis, pClusters->ThreadTotal);
+		time0 = thread_wall_seconds();
+		if( NULL != pTrace ){
+			pTrace->SetupSeconds = time0 - time_start;
+		}
+		Trellis.Source          = 0;
+		Trellis.ClusterTotal    = 1;
+		Trellis.Start[0][0]     = 0;
+		Trellis.Count[0][0]     = 1;
+		Trellis.Mass[0][0]      = 0;
+		Trellis.Prob[0][0]      = (1 == log10flag) ? 0 : 1;
+		pClusters->LargestCluster = 1;
+		Nstate1 = 1;
+
+		for(index1=0; (index1<pPlan->ElementTotal) && (0 == aborted); index1++){
+			Natoms            = pPlan->AtomCount[index1];
+			Trellis.Nisotopes = pPlan->Element[index1]->NonzeroIsotopeTotal;
+			Trellis.MaxShift  = 0;
+			mass_min          = DBL_MAX;
+			for(index2=0; index2<Trellis.Nisotopes; index2++){
+				index3 = pPlan->Element[index1]->NonzeroIsotopeIndex[index2];
+				Trellis.IsotopeMass[index2]     = pPlan->Element[index1]->Isotope[index3]->AtomicMass;
+				Trellis.IsotopeFraction[index2] = pPlan->Element[index1]->Isotope[index3]->CompositionFraction;
+				if( mass_min > Trellis.IsotopeMass[index2] ){
+					mass_min = Trellis.IsotopeMass[index2];
+				}
+			}
+			for(index2=0; index2<Trellis.Nisotopes; index2++){
+				Trellis.IsotopeShift[index2] = (int)floor(Trellis.IsotopeMass[index2] - mass_min + 0.5);
+				if( Trellis.MaxShift < Trellis.IsotopeShift[index2] ){
+					Trellis.MaxShift = Trellis.IsotopeShift[index2];
+				}
+			}
+			if( NULL != pTrace ){
+				trace_element = isoDalton_trace_add_element(pTrace, pPlan->Element[index1]->AtomicNumber, Natoms, Trellis.Nisotopes);
+			}
+			if( NULL != pLoss ){
+				pLossElement = &pLoss->Element[pLoss->ElementTotal++];
+				pLossElement->AtomicNumber = pPlan->Element[index1]->AtomicNumber;
+				pLossElement->Discarded    = 0;
+				pLossElement->MaxDiscarded = 0;
+			}
+			for(index2=0; (index2<Natoms) && (0 == aborted); index2++){
+				for(index3=0; index3<TRACE_STAGE_TOTAL; index3++){
+					stage_seconds[index3] = 0;
+				}
+				//---------------------------------------------
+				// Expand, sort, combine and sort each cluster
+				// (as separate timed passes when tracing)
+				//---------------------------------------------
+				time0 = thread_wall_seconds();
+				Ngenerated = cluster_layout(&Trellis);
+				if( NULL == pTrace ){
+					cluster_pass(&Trellis, cluster_step);
+				}else{
+					cluster_pass(&Trellis, cluster_expand);
+					time1 = thread_wall_seconds();
+					stage_seconds[TRACE_STAGE_EXPAND] = time1 - time0;
+					time0 = time1;
+					cluster_pass(&Trellis, cluster_mass_sort);
+					time1 = thread_wall_seconds();
+					stage_seconds[TRACE_STAGE_MASS_SORT] = time1 - time0;
+					time0 = time1;
+					cluster_pass(&Trellis, cluster_combine);
+					time1 = thread_wall_seconds();
+					stage_seconds[TRACE_STAGE_COMBINE] = time1 - time0;
+					time0 = time1;
+					cluster_pass(&Trellis, cluster_prob_sort);
+					time1 = thread_wall_seconds();
+					stage_seconds[TRACE_STAGE_PROB_SORT] = time1 - time0;
+					time0 = time1;
+				}
+				Nstate2 = 0;
+				for(cluster=0; cluster<Trellis.NextClusterTotal; cluster++){
+					Nstate2 += Trellis.Count[Trellis.Source^1][cluster];
+					if( pClusters->LargestCluster < Trellis.Count[Trellis.Source^1][cluster] ){
+						pClusters->LargestCluster = Trellis.Count[Trellis.Source^1][cluster];
+					}
+				}
+
+				//---------------------------------------------
+				// Cap the number of states: the clusters keep
+				// the states taken from their heads
+				//---------------------------------------------
+				Nstate1 = Nstate2;
+				if( Nstate2 > Mstates ){
+					Nstate1 = Mstates;
+					if( CLUSTER_BUDGET_PROPORTIONAL == pClusters->Budget ){
+						cluster_budget(&Trellis, Mstates, pClusters->MinStates, Position, Heap, Weight, Order);
+					}else{
+						for(cluster=0; cluster<Trellis.NextClusterTotal; cluster++){
+							Position[cluster] = 0;
+						}
+						cluster_take(&Trellis, Trellis.Source^1, Trellis.NextClusterTotal, Mstates, Position, Heap, NULL, NULL);
+					}
+					discarded = 0;
+					prob_state = 0;
+					for(cluster=0; cluster<Trellis.NextClusterTotal; cluster++){
+						index3 = Trellis.Start[Trellis.Source^1][cluster];
+						for(state_index=Position[cluster]; state_index<Trellis.Count[Trellis.Source^1][cluster]; state_index++){
+							discarded += cluster_linear(Trellis.Prob[Trellis.Source^1][index3+state_index], log10flag);
+						}
+						if( (Position[cluster] < Trellis.Count[Trellis.Source^1][cluster]) && (prob_state < cluster_linear(Trellis.Prob[Trellis.Source^1][index3+Position[cluster]], log10flag)) ){
+							prob_state = cluster_linear(Trellis.Prob[Trellis.Source^1][index3+Position[cluster]], log10flag);
+						}
+						Trellis.Count[Trellis.Source^1][cluster] = Position[cluster];
+					}
+					if( NULL != pLoss ){
+						pLossElement->Discarded += discarded;
+						if( pLossElement->MaxDiscarded < prob_state ){
+							pLossElement->MaxDiscarded = prob_state;
+						}
+						pLoss->Discarded += discarded;
+						if( pLoss->MaxDiscarded < prob_state ){
+							pLoss->MaxDiscarded = prob_state;
+						}
+						pLoss->TruncationTotal++;
+						if( (0 < pLoss->Budget) && (pLoss->Discarded > pLoss->Budget) ){
+							pLoss->OverBudget = 1;
+							aborted = stop_over_budget;
+						}
+					}
+				}
+				Trellis.Source ^= 1;
+				Trellis.ClusterTotal = Trellis.NextClusterTotal;
+				while( (1 < Trellis.ClusterTotal) && (0 == Trellis.Count[Trellis.Source][Trellis.ClusterTotal-1]) ){
+					Trellis.ClusterTotal--;
+				}
+				if( NULL != pTrace ){
+					stage_seconds[TRACE_STAGE_TRUNCATE] = thread_wall_seconds() - time0;
+					isoDalton_trace_add_step(pTrace, trace_element, index2, Ngenerated, Nstate2, Nstate1, stage_seconds);
+				}
+			}
+		}
+		cluster_pool_stop(&Trellis);
+	}
+
+	//---------------------------------------------------------
+	// Copy out by decreasing probability as
+	// isoDalton_exact_mass_core does
+	//---------------------------------------------------------
+	Nvalid = 0;
+	if( 0 == aborted ){
+		pClusters->ClusterTotal = 0;
+		for(cluster=0; cluster<Trellis.ClusterTotal; cluster++){
+			if( 0 < Trellis.Count[Trellis.Source][cluster] ){
+				pClusters->ClusterTotal++;
+			}
+		}
+		Nvalid = (Nstate1 < Mcapacity) ? Nstate1 : Mcapacity;
+		for(cluster=0; cluster<Trellis.ClusterTotal; cluster++){
+			Position[cluster] = 0;
+		}
+		cluster_take(&Trellis, Trellis.Source, Trellis.ClusterTotal, Nvalid, Position, Heap, pisostates->mass, pisostates->prob);
+		data_message("%d nominal mass clusters, at most %d states in one\n",pClusters->ClusterTotal,pClusters->LargestCluster);
+	}else if( (1 == aborted) && (NULL != pLoss) ){
+		pLoss->Aborted = 1;
+	}
+	for(state_index=0; state_index<Mcapacity; state_index++){
+		if( state_index < Nvalid ){
+			if( NULL != pLoss ){
+				pLoss->Retained += cluster_linear(pisostates->prob[state_index], log10flag);
+			}
+			pisostates->mass[state_index] += pPlan->FixedMass;
+			if(1 == log10flag ){
+				pisostates->prob[state_index] += pPlan->FixedProb;
+			}else{
+				pisostates->prob[state_index] *= pow(10.0,pPlan->FixedProb);
+			}
+		}else{
+			pisostates->mass[state_index] = 0;
+			pisostates->prob[state_index] = (1 == log10flag) ? -DBL_MAX : 0;
+		}
+	}
+	pisostates->StateTotal = Nvalid;
+
+	free(Trellis.IsotopeMass);
+	free(Trellis.IsotopeFraction);
+	free(Trellis.IsotopeShift);
+	free(Position);
+	free(Heap);
+	free(Weight);
+	free(Order);
+	for(array_index=0; array_index<2; array_index++){
+		free(Trellis.Mass[array_index]);
+		free(Trellis.Prob[array_index]);
+		free(Trellis.Start[array_index]);
+		free(Trellis.Count[array_index]);
+	}
+	return (0 == aborted) ? 0 : -1;
+}
@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_cluster.h                                     */
+/*               Header file for isoDalton_cluster.cpp, the trellis with */
+/*               its states kept in nominal mass clusters that are       */
+/*               sorted and combined independently                       */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_CLUSTER
+#define ISODALTON_CLUSTER
+
+//---------------------------------------------------------------------------------------------
+// Clustered trellis.  Every isotope of an element is a whole number of daltons (its nominal
+// shift, rounded) above the lightest one, so a state belongs to the cluster of the sum of the
+// shifts of its atoms (M, M+1, M+2 ...).  States of different clusters are about a dalton
+// apart and are never combined, so each step expands cluster c into clusters c+shift, and the
+// mass sort, combine and probability sort run on one cluster at a time: small arrays that
+// stay in cache and that ThreadTotal threads share out.  The Mstates most probable states are
+// then picked from the heads of the clusters (each sorted by decreasing probability).
+//
+// With CLUSTER_BUDGET_PROPORTIONAL the Mstates are shared out between the clusters instead:
+// each keeps up to MinStates states (the minimums take at most half of Mstates) and the rest
+// go to the clusters in proportion to their probability, so the minor clusters (M+4, M+5 ...)
+// keep their fine structure rather than the main peak keeping thousands of states of
+// negligible probability.
+//
+// The states of a step and of the next are in two arrays, so the trellis takes twice the
+// memory of isoDalton_exact_mass.
+//---------------------------------------------------------------------------------------------
+#define CLUSTER_MAX_THREADS         64
+#define CLUSTER_BUDGET_GLOBAL       0    // the Mstates most probable states
+#define CLUSTER_BUDGET_PROPORTIONAL 1    // Mstates shared out by cluster probability
+#define CLUSTER_DEFAULT_MIN_STATES  16
+
+struct exact_mass_clusters {
+	int ThreadTotal;       // set by the caller: threads sorting clusters (1 = the calling thread)
+	int Budget;            // set by the caller: CLUSTER_BUDGET_*
+	int MinStates;         // set by the caller: proportional: states every cluster keeps if it has them
+	int ClusterTotal;      // clusters holding states at the end
+	int LargestCluster;    // most states of one cluster after a combine
+};
+
+void isoDalton_clusters_init(struct exact_mass_clusters *, int);
+int  isoDalton_cluster_trellis(struct trellis_plan *, int, int, struct istates_info *, int, struct exact_mass_reports *, int, double);
+
+#endif
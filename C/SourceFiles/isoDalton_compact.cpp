@@ -0,0 +1,348 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_compact.cpp                                   */
+/*               The trellis of isoDalton_exact_mass on packed state     */
+/*               records.  One template serves every record type; with  */
+/*               8 byte records each step moves half the memory of the  */
+/*               separate double arrays.                                 */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+#define COMPACT_MIN_QUANTUM 1e-12
+
+//--------------------------------------------------------
+// Record orders for compact_heapsort
+//--------------------------------------------------------
+struct compact_mass_up {
+	template <class Record> bool operator()(const Record &a, const Record &b) const { return a.Offset < b.Offset; }
+};
+
+struct compact_prob_down {
+	template <class Record> bool operator()(const Record &a, const Record &b) const { return a.Prob > b.Prob; }
+};
+
+//--------------------------------------------------------
+// Heapsort of records (the same algorithm as sort.cpp)
+// into the order given by before
+//--------------------------------------------------------
+template <class Record, class Order>
+static void compact_heapsort(int Nelements, Record *array, Order before){
+	int i,j,k,m;
+	Record tmp;
+	Record *arrayoffset;
+
+	if (Nelements < 2) {
+		return;
+	}
+	arrayoffset = array-1;  // arrayoffset[1..Nelements]
+	m = Nelements;
+	k = (Nelements >> 1) + 1;
+	while(1) {
+		if (k > 1) {
+			tmp = arrayoffset[--k];
+		}else{
+			tmp = arrayoffset[m];
+			arrayoffset[m] = arrayoffset[1];
+			if (--m == 1) {
+				arrayoffset[1] = tmp;
+				return;
+			}
+		}
+		i = k;
+		j = k << 1;
+		while (j <= m) {
+			if (j < m && before(arrayoffset[j], arrayoffset[j+1])){
+				++j;
+			}
+			if (before(tmp, arrayoffset[j])) {
+				arrayoffset[i] = arrayoffset[j];
+				j += (i = j);
+			}else{
+				j = m + 1;
+			}
+		}
+		arrayoffset[i] = tmp;
+	}
+}
+
+static double compact_linear(double prob, int log10flag){
+	return (1 == log10flag) ? pow(10,prob) : prob;
+}
+
+//--------------------------------------------------------
+// The trellis of isoDalton_exact_mass_core on records.
+// Offset is the integer type of Record::Offset.
+//--------------------------------------------------------
+template <class Record, class Offset>
+static int compact_trellis(struct trellis_plan *pPlan, int Mstates, int Mcapacity, struct istates_info *pisostates, int log10flag, struct exact_mass_reports *pReports, int stop_over_budget, double quantum, double time_start){
+	Record *state;
+	Record *pOut;
+	Offset *isotope_offset;
+	Offset offset1;
+	double *isotope_fraction;
+	double mass_min;
+	double base_mass;
+	double psum;
+	double discarded;
+	double prob_state;
+	double stage_seconds[TRACE_STAGE_TOTAL];
+	double time0,time1;
+	int Nisotopes;
+	int Natoms;
+	int Nstate1,Nstate2;
+	int Ngenerated;
+	int Nvalid;
+	int state1_index,state2_index,isotope_index;
+	int start_index,stop_index;
+	int index1,index2,index3;
+	int trace_element;
+	int aborted;
+	struct exact_mass_trace *pTrace;
+	struct exact_mass_loss *pLoss;
+	struct loss_element *pLossElement;
+
+	pTrace        = (NULL == pReports) ? NULL : pReports->pTrace;
+	pLoss         = (NULL == pReports) ? NULL : pReports->pLoss;
+	pLossElement  = NULL;
+	trace_element = 0;
+	Ngenerated    = 0;
+	aborted       = 0;
+	state            = (Record *)malloc((size_t)Mstates*pPlan->MaxIsotopes*sizeof(Record));
+	isotope_offset   = (Offset *)malloc(pPlan->MaxIsotopes*sizeof(Offset));
+	isotope_fraction = (double *)malloc(pPlan->MaxIsotopes*sizeof(double));
+	if( (NULL == state) || (NULL == isotope_offset) || (NULL == isotope_fraction) ){
+		data_error("Error : could not allocate %d compact states of %d isotopes\n",Mstates,pPlan->MaxIsotopes);
+		free(state);
+		free(isotope_offset);
+		free(isotope_fraction);
+		pisostates->StateTotal = 0;
+		return -1;
+	}
+
+	time0 = thread_wall_seconds();
+	time1 = time0;
+	if( NULL != pTrace ){
+		pTrace->SetupSeconds = time0 - time_start;
+	}
+	base_mass       = 0;
+	state[0].Offset = 0;
+	state[0].Prob   = (1 == log10flag) ? 0 : 1;
+	Nstate1 = 1;
+
+	for(index1=0; (index1<pPlan->ElementTotal) && (0 == aborted); index1++){
+		Natoms    = pPlan->AtomCount[index1];
+		Nisotopes = pPlan->Element[index1]->NonzeroIsotopeTotal;
+		mass_min  = DBL_MAX;
+		for(isotope_index=0; isotope_index<Nisotopes; isotope_index++){
+			index3 = pPlan->Element[index1]->NonzeroIsotopeIndex[isotope_index];
+			if( mass_min > pPlan->Element[index1]->Isotope[index3]->AtomicMass ){
+				mass_min = pPlan->Element[index1]->Isotope[index3]->AtomicMass;
+			}
+		}
+		for(isotope_index=0; isotope_index<Nisotopes; isotope_index++){
+			index3 = pPlan->Element[index1]->NonzeroIsotopeIndex[isotope_index];
+			isotope_offset[isotope_index]   = (Offset)floor((pPlan->Element[index1]->Isotope[index3]->AtomicMass - mass_min)/quantum + 0.5);
+			isotope_fraction[isotope_index] = pPlan->Element[index1]->Isotope[index3]->CompositionFraction;
+		}
+		if( NULL != pTrace ){
+			trace_element = isoDalton_trace_add_element(pTrace, pPlan->Element[index1]->AtomicNumber, Natoms, Nisotopes);
+		}
+		if( NULL != pLoss ){
+			pLossElement = &pLoss->Element[pLoss->ElementTotal++];
+			pLossElement->AtomicNumber = pPlan->Element[index1]->AtomicNumber;
+			pLossElement->Discarded    = 0;
+			pLossElement->MaxDiscarded = 0;
+		}
+		for(index2=0; (index2<Natoms) && (0 == aborted); index2++){
+			if( NULL != pTrace ){
+				for(index3=0; index3<TRACE_STAGE_TOTAL; index3++){
+					stage_seconds[index3] = 0;
+				}
+				time0 = thread_wall_seconds();
+			}
+			//---------------------------------------------
+			// Expand in place from the last state down
+			//---------------------------------------------
+			base_mass += mass_min;
+			Ngenerated = Nstate1*Nisotopes;
+			state2_index = Ngenerated-1;
+			for(state1_index=Nstate1-1; state1_index>=0; state1_index--){
+				offset1 = state[state1_index].Offset;
+				psum    = state[state1_index].Prob;
+				for(isotope_index=Nisotopes-1; isotope_index>=0; isotope_index--){
+					state[state2_index].Offset = offset1 + isotope_offset[isotope_index];
+					if(1 == log10flag ){
+						state[state2_index].Prob = log10(  pow(10,psum) * isotope_fraction[isotope_index]  );
+					}else{
+						state[state2_index].Prob = psum * isotope_fraction[isotope_index];
+					}
+					state2_index--;
+				}
+			}
+			if( NULL != pTrace ){
+				time1 = thread_wall_seconds();
+				stage_seconds[TRACE_STAGE_EXPAND] = time1 - time0;
+				time0 = time1;
+			}
+
+			//---------------------------------------------
+			// Sort by mass and combine equal offsets
+			//---------------------------------------------
+			compact_heapsort(Ngenerated, state, compact_mass_up());
+			if( NULL != pTrace ){
+				time1 = thread_wall_seconds();
+				stage_seconds[TRACE_STAGE_MASS_SORT] = time1 - time0;
+				time0 = time1;
+			}
+			Nstate2     = 0;
+			start_index = 0;
+			while( start_index < Ngenerated ){
+				stop_index = start_index+1;
+				while( (stop_index < Ngenerated) && (state[stop_index].Offset == state[start_index].Offset) ){
+					stop_index++;
+				}
+				pOut = &state[Nstate2];
+				pOut->Offset = state[start_index].Offset;
+				if( 1 == stop_index-start_index ){
+					pOut->Prob = state[start_index].Prob;
+				}else{
+					psum = 0;
+					for(state1_index=start_index; state1_index<stop_index; state1_index++){
+						psum += compact_linear(state[state1_index].Prob, log10flag);
+					}
+					pOut->Prob = (1 == log10flag) ? log10(psum) : psum;
+				}
+				Nstate2++;
+				start_index = stop_index;
+			}
+			if( NULL != pTrace ){
+				time1 = thread_wall_seconds();
+				stage_seconds[TRACE_STAGE_COMBINE] = time1 - time0;
+				time0 = time1;
+			}
+
+			compact_heapsort(Nstate2, state, compact_prob_down());
+			if( NULL != pTrace ){
+				time1 = thread_wall_seconds();
+				stage_seconds[TRACE_STAGE_PROB_SORT] = time1 - time0;
+				time0 = time1;
+			}
+
+			//---------------------------------------------
+			// Cap the number of states
+			//---------------------------------------------
+			Nstate1 = (Nstate2 > Mstates) ? Mstates : Nstate2;
+			if( (NULL != pLoss) && (Nstate2 > Mstates) ){
+				discarded = 0;
+				for(state1_index=Mstates; state1_index<Nstate2; state1_index++){
+					discarded += compact_linear(state[state1_index].Prob, log10flag);
+				}
+				prob_state = compact_linear(state[Mstates].Prob, log10flag);
+				pLossElement->Discarded += discarded;
+				if( pLossElement->MaxDiscarded < prob_state ){
+					pLossElement->MaxDiscarded = prob_state;
+				}
+				pLoss->Discarded += discarded;
+				if( pLoss->MaxDiscarded < prob_state ){
+					pLoss->MaxDiscarded = prob_state;
+				}
+				pLoss->TruncationTotal++;
+				if( (0 < pLoss->Budget) && (pLoss->Discarded > pLoss->Budget) ){
+					pLoss->OverBudget = 1;
+					aborted = stop_over_budget;
+				}
+			}
+			if( NULL != pTrace ){
+				stage_seconds[TRACE_STAGE_TRUNCATE] = thread_wall_seconds() - time0;
+				isoDalton_trace_add_step(pTrace, trace_element, index2, Ngenerated, Nstate2, Nstate1, stage_seconds);
+			}
+		}
+	}
+
+	//---------------------------------------------------------
+	// Copy out as isoDalton_exact_mass_core does
+	//---------------------------------------------------------
+	Nvalid = aborted ? 0 : Nstate1;
+	if( aborted && (NULL != pLoss) ){
+		pLoss->Aborted = 1;
+	}
+	for(state1_index=0; state1_index<Mcapacity; state1_index++){
+		if( state1_index < Nvalid ){
+			pisostates->mass[state1_index] = base_mass + quantum*(double)state[state1_index].Offset + pPlan->FixedMass;
+			if(1 == log10flag ){
+				pisostates->prob[state1_index] = (double)state[state1_index].Prob + pPlan->FixedProb;
+			}else{
+				pisostates->prob[state1_index] = (double)state[state1_index].Prob * pow(10.0,pPlan->FixedProb);
+			}
+			if( NULL != pLoss ){
+				pLoss->Retained += compact_linear(state[state1_index].Prob, log10flag);
+			}
+		}else{
+			pisostates->mass[state1_index] = 0;
+			pisostates->prob[state1_index] = (1 == log10flag) ? -DBL_MAX : 0;
+		}
+	}
+	pisostates->StateTotal = Nvalid;
+
+	free(state);
+	free(isotope_offset);
+	free(isotope_fraction);
+	return aborted ? -1 : 0;
+}
+
+//--------------------------------------------------------
+// Bytes of one state at a precision
+//--------------------------------------------------------
+int isoDalton_state_bytes(int precision){
+	if( STATE_PRECISION_COMPACT == precision ){
+		return sizeof(struct compact_state32);
+	}
+	if( STATE_PRECISION_WIDE == precision ){
+		return sizeof(struct compact_state64);
+	}
+	return 2*sizeof(double);
+}
+
+//--------------------------------------------------------
+// Mass quantum for a molecule whose masses span span
+// daltons (isoDalton_compact.h)
+//--------------------------------------------------------
+double isoDalton_compact_quantum(int precision, double span){
+	double quantum;
+
+	quantum = span/((STATE_PRECISION_COMPACT == precision) ? 2147483648.0 : 9223372036854775808.0);
+	return (quantum < COMPACT_MIN_QUANTUM) ? COMPACT_MIN_QUANTUM : quantum;
+}
+
+//--------------------------------------------------------
+// The trellis of a planned molecule on packed records.
+// Mstates states are kept and Mcapacity result entries
+// are written.  Returns 0, or -1 if the trellis was
+// stopped by the loss budget or could not be allocated.
+//--------------------------------------------------------
+int isoDalton_compact_trellis(struct trellis_plan *pPlan, int precision, int Mstates, int Mcapacity, struct istates_info *pisostates, int log10flag, struct exact_mass_reports *pReports, int stop_over_budget, double time_start){
+	double quantum;
+
+	quantum = isoDalton_compact_quantum(precision, pPlan->Span);
+	data_message("Compact states of %d bytes, mass quantum %g daltons\n",isoDalton_state_bytes(precision),quantum);
+	if( STATE_PRECISION_WIDE == precision ){
+		return compact_trellis<struct compact_state64, compact_uint64>(pPlan, Mstates, Mcapacity, pisostates, log10flag, pReports, stop_over_budget, quantum, time_start);
+	}
+	return compact_trellis<struct compact_state32, compact_uint32>(pPlan, Mstates, Mcapacity, pisostates, log10flag, pReports, stop_over_budget, quantum, time_start);
+}
@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_compact.h                                     */
+/*               Header file for isoDalton_compact.cpp, the trellis on   */
+/*               packed state records of reduced precision               */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_COMPACT
+#define ISODALTON_COMPACT
+
+#ifdef _MSC_VER
+	typedef unsigned __int64 compact_uint64;
+	typedef unsigned int     compact_uint32;
+#else
+	#include <stdint.h>
+	typedef uint64_t         compact_uint64;
+	typedef uint32_t         compact_uint32;
+#endif
+
+//---------------------------------------------------------------------------------------------
+// State precision.  A packed state stores its mass as an integer number of quanta above the
+// lightest mass the atoms added so far can have, so equal masses are equal integers whatever
+// order the atoms were added in, and the probability as it is computed (log10 with log10flag).
+// The quantum is the largest of 1e-12 daltons and the mass span of the molecule over 2^31
+// (32 bit offsets) or 2^63 (64 bit offsets); every isotope mass is rounded to it, so a mass is
+// off by at most half a quantum per atom.
+//---------------------------------------------------------------------------------------------
+#define STATE_PRECISION_FULL     0   // double mass and probability arrays (16 bytes a state)
+#define STATE_PRECISION_COMPACT  1   // struct compact_state32 (8 bytes a state)
+#define STATE_PRECISION_WIDE     2   // struct compact_state64 (16 bytes a state)
+
+struct compact_state32 {
+	compact_uint32 Offset;   // mass in quanta
+	float          Prob;
+};
+
+struct compact_state64 {
+	compact_uint64 Offset;
+	double         Prob;
+};
+
+int    isoDalton_state_bytes(int);
+double isoDalton_compact_quantum(int, double);
+int    isoDalton_compact_trellis(struct trellis_plan *, int, int, int, struct istates_info *, int, struct exact_mass_reports *, int, double);
+
+#endif
@@ -0,0 +1,700 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_decompose.cpp                                 */
+/*               Candidate formulas of a monoisotopic mass: extended     */
+/*               residue table decomposition of the integer scaled       */
+/*               masses, valence and RDBE filters, and the scoring of    */
+/*               the isotope patterns of the candidates                  */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_decompose.h"
+#include "thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//--------------------------------------------------------
+// State of the depth first search of one query
+//--------------------------------------------------------
+struct decompose_search {
+	struct decompose_alphabet *pAlphabet;
+	struct decompose_query    *pQuery;
+	struct decompose_result   *pResult;
+	int    Count[DECOMPOSE_MAX_ELEMENTS];   // above the minimum counts
+	int    Span[DECOMPOSE_MAX_ELEMENTS];    // Maximum - Minimum
+	int    Period;                          // a0/gcd(a0,a1)
+	double MinimumMass;                     // mass of the minimum counts
+	double MassLow;                         // target window
+	double MassHigh;
+	int    Failed;
+};
+
+//--------------------------------------------------------
+// Candidates First to Last-1 of a result, for one thread
+//--------------------------------------------------------
+struct decompose_slice {
+	struct decompose_alphabet *pAlphabet;
+	struct element_list       *pElements;
+	struct decompose_result   *pResult;
+	struct score_spectrum     *pSpectrum;
+	int                        Mstates;
+	int                        Pattern;
+	int                        First;
+	int                        Last;
+	int                        Failed;
+};
+
+//--------------------------------------------------------
+// Valence of the common organic elements, 0 if not known
+//--------------------------------------------------------
+static int decompose_valence(int AtomicNumber){
+	switch( AtomicNumber ){
+		case  1: return 1;   // H
+		case  5: return 3;   // B
+		case  6: return 4;   // C
+		case  7: return 3;   // N
+		case  8: return 2;   // O
+		case  9: return 1;   // F
+		case 11: return 1;   // Na
+		case 14: return 4;   // Si
+		case 15: return 3;   // P
+		case 16: return 2;   // S
+		case 17: return 1;   // Cl
+		case 19: return 1;   // K
+		case 34: return 2;   // Se
+		case 35: return 1;   // Br
+		case 53: return 1;   // I
+	}
+	return 0;
+}
+
+static int decompose_gcd(int a, int b){
+	int r;
+
+	while( 0 != b ){
+		r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
+//--------------------------------------------------------
+// 1 if element a of the alphabet comes before element b
+// in a Hill formula
+//--------------------------------------------------------
+static int decompose_hill_before(struct decompose_alphabet *pAlphabet, int carbon, int a, int b){
+	if( carbon ){
+		if( 6 == pAlphabet->AtomicNumber[b] ){
+			return 0;
+		}
+		if( 6 == pAlphabet->AtomicNumber[a] ){
+			return 1;
+		}
+		if( 1 == pAlphabet->AtomicNumber[b] ){
+			return 0;
+		}
+		if( 1 == pAlphabet->AtomicNumber[a] ){
+			return 1;
+		}
+	}
+	return (strcmp(pAlphabet->Symbol[a], pAlphabet->Symbol[b]) < 0);
+}
+
+//--------------------------------------------------------
+// One atom of an element: probability of each nominal
+// shift above the lightest isotope, and probability times
+// mass
+//--------------------------------------------------------
+static void decompose_shifts(struct element_info *pElement, double *ShiftProb, double *ShiftMass){
+	struct isotope_info *pIsotope;
+	double lightest;
+	double fraction_total;
+	int index;
+	int shift;
+
+	lightest       = 0;
+	fraction_total = 0;
+	for(index=0; index<pElement->NonzeroIsotopeTotal; index++){
+		pIsotope = pElement->Isotope[pElement->NonzeroIsotopeIndex[index]];
+		if( (0 == index) || (pIsotope->AtomicMass < lightest) ){
+			lightest = pIsotope->AtomicMass;
+		}
+		fraction_total += pIsotope->CompositionFraction;
+	}
+	for(shift=0; shift<DECOMPOSE_CLUSTERS; shift++){
+		ShiftProb[shift] = 0;
+		ShiftMass[shift] = 0;
+	}
+	for(index=0; index<pElement->NonzeroIsotopeTotal; index++){
+		pIsotope = pElement->Isotope[pElement->NonzeroIsotopeIndex[index]];
+		shift    = (int)floor(pIsotope->AtomicMass - lightest + 0.5);
+		if( shift < DECOMPOSE_CLUSTERS ){
+			ShiftProb[shift] += pIsotope->CompositionFraction/fraction_total;
+			ShiftMass[shift] += pIsotope->CompositionFraction/fraction_total*pIsotope->AtomicMass;
+		}
+	}
+}
+
+//--------------------------------------------------------
+// Alphabet of ElementTotal elements with atom counts from
+// Minimum to Maximum (NULL = 0 and no limit).  Builds the
+// extended residue table.  Returns 0, or -1 for an element
+// that is not in the element list, twice in the alphabet,
+// or if out of memory.
+//--------------------------------------------------------
+int isoDalton_decompose_alphabet(struct element_list *pElements, int ElementTotal, int *AtomicNumber, int *Minimum, int *Maximum, struct decompose_alphabet *pAlphabet){
+	struct element_info *pElement;
+	double mass[DECOMPOSE_MAX_ELEMENTS];
+	double error;
+	int order[DECOMPOSE_MAX_ELEMENTS];
+	int *Previous;
+	int *Current;
+	int element_index;
+	int index;
+	int carbon;
+	int a0;
+	int ai;
+	int step;
+	int divisor;
+	int residue;
+	int residue_class;
+	int rep;
+	int n;
+
+	pAlphabet->Residue = NULL;
+	if( (ElementTotal < 1) || (ElementTotal > DECOMPOSE_MAX_ELEMENTS) ){
+		data_error("Error : the alphabet must have 1 to %d elements\n",DECOMPOSE_MAX_ELEMENTS);
+		return -1;
+	}
+
+	//---------------------------------------------------------
+	// Monoisotopic and integer masses, sorted by integer mass
+	//---------------------------------------------------------
+	pAlphabet->ElementTotal = ElementTotal;
+	pAlphabet->Blowup       = DECOMPOSE_BLOWUP;
+	for(element_index=0; element_index<ElementTotal; element_index++){
+		if( (AtomicNumber[element_index] < 1) || (AtomicNumber[element_index] >= ELEMENT_TOTAL) || (pElements->Element[AtomicNumber[element_index]].IsotopeTotal < 1) ){
+			data_error("Error : element %d is not in the element list\n",AtomicNumber[element_index]);
+			return -1;
+		}
+		pElement = &pElements->Element[AtomicNumber[element_index]];
+		mass[element_index]  = pElement->Isotope[pElement->MostCommonIsotopeIndex]->AtomicMass;
+		order[element_index] = element_index;
+		for(index=element_index; (0 < index) && (mass[order[index-1]] > mass[element_index]); index--){
+			order[index]   = order[index-1];
+			order[index-1] = element_index;
+		}
+	}
+	for(element_index=0; element_index<ElementTotal; element_index++){
+		index    = order[element_index];
+		pElement = &pElements->Element[AtomicNumber[index]];
+		pAlphabet->AtomicNumber[element_index] = AtomicNumber[index];
+		pAlphabet->Minimum[element_index]      = (NULL == Minimum) ? 0 : Minimum[index];
+		pAlphabet->Maximum[element_index]      = (NULL == Maximum) ? DECOMPOSE_INFINITY : Maximum[index];
+		pAlphabet->Valence[element_index]      = decompose_valence(AtomicNumber[index]);
+		pAlphabet->Mass[element_index]         = mass[index];
+		pAlphabet->IntegerMass[element_index]  = (int)floor(mass[index]*pAlphabet->Blowup + 0.5);
+		pAlphabet->Symbol[element_index]       = pElement->Symbol;
+		if( (0 < element_index) && (pAlphabet->AtomicNumber[element_index-1] == AtomicNumber[index]) ){
+			data_error("Error : element %s is twice in the alphabet\n",pElement->Symbol);
+			return -1;
+		}
+		decompose_shifts(pElement, pAlphabet->ShiftProb[element_index], pAlphabet->ShiftMass[element_index]);
+		error = pAlphabet->IntegerMass[element_index]/(mass[index]*pAlphabet->Blowup) - 1.0;
+		if( (0 == element_index) || (error < pAlphabet->ErrorLow) ){
+			pAlphabet->ErrorLow = error;
+		}
+		if( (0 == element_index) || (error > pAlphabet->ErrorHigh) ){
+			pAlphabet->ErrorHigh = error;
+		}
+	}
+
+	//---------------------------------------------------------
+	// Hill order: C then H if there is carbon, then by symbol
+	//---------------------------------------------------------
+	carbon = 0;
+	for(element_index=0; element_index<ElementTotal; element_index++){
+		carbon |= (6 == pAlphabet->AtomicNumber[element_index]);
+	}
+	for(element_index=0; element_index<ElementTotal; element_index++){
+		pAlphabet->HillOrder[element_index] = element_index;
+		for(index=element_index; (0 < index) && decompose_hill_before(pAlphabet, carbon, element_index, pAlphabet->HillOrder[index-1]); index--){
+			pAlphabet->HillOrder[index]   = pAlphabet->HillOrder[index-1];
+			pAlphabet->HillOrder[index-1] = element_index;
+		}
+	}
+
+	//---------------------------------------------------------
+	// Extended residue table, round robin: Residue[i][r] is
+	// the smallest integer mass with residue r modulo a0 of
+	// elements 0..i (values past DECOMPOSE_INFINITY are kept
+	// at DECOMPOSE_INFINITY, with the residue followed apart)
+	//---------------------------------------------------------
+	a0 = pAlphabet->IntegerMass[0];
+	pAlphabet->Residue = (int *)malloc(ElementTotal*a0*sizeof(int));
+	if( NULL == pAlphabet->Residue ){
+		data_error("Error : could not allocate a residue table of %d x %d\n",ElementTotal,a0);
+		return -1;
+	}
+	for(residue=0; residue<a0; residue++){
+		pAlphabet->Residue[residue] = DECOMPOSE_INFINITY;
+	}
+	pAlphabet->Residue[0] = 0;
+	for(element_index=1; element_index<ElementTotal; element_index++){
+		Previous = pAlphabet->Residue + (element_index-1)*a0;
+		Current  = pAlphabet->Residue + element_index*a0;
+		memcpy(Current, Previous, a0*sizeof(int));
+		ai      = pAlphabet->IntegerMass[element_index];
+		step    = ai % a0;
+		divisor = decompose_gcd(a0, ai);
+		for(residue_class=0; residue_class<divisor; residue_class++){
+			n       = DECOMPOSE_INFINITY;
+			residue = residue_class;
+			for(index=residue_class; index<a0; index+=divisor){
+				if( Current[index] < n ){
+					n       = Current[index];
+					residue = index;
+				}
+			}
+			if( DECOMPOSE_INFINITY == n ){
+				continue;
+			}
+			for(rep=1; rep<a0/divisor; rep++){
+				n       = (n >= DECOMPOSE_INFINITY - ai) ? DECOMPOSE_INFINITY : n + ai;
+				residue = (residue + step) % a0;
+				if( Current[residue] < n ){
+					n = Current[residue];
+				}
+				Current[residue] = n;
+			}
+		}
+	}
+	return 0;
+}
+
+void isoDalton_decompose_alphabet_free(struct decompose_alphabet *pAlphabet){
+	free(pAlphabet->Residue);
+	pAlphabet->Residue = NULL;
+}
+
+//--------------------------------------------------------
+// A decomposition of an integer mass: real mass and filters
+//--------------------------------------------------------
+static void decompose_accept(struct decompose_search *pSearch){
+	struct decompose_alphabet *pAlphabet;
+	struct decompose_query    *pQuery;
+	struct decompose_result   *pResult;
+	struct decompose_candidate *pCandidate;
+	struct decompose_candidate *grown;
+	double mass;
+	double rdbe;
+	int count;
+	int valence_sum;
+	int valence_max;
+	int atoms;
+	int element_index;
+
+	pAlphabet = pSearch->pAlphabet;
+	pQuery    = pSearch->pQuery;
+	pResult   = pSearch->pResult;
+	pResult->VisitTotal += 1;
+	mass = pSearch->MinimumMass;
+	for(element_index=0; element_index<pAlphabet->ElementTotal; element_index++){
+		mass += pSearch->Count[element_index]*pAlphabet->Mass[element_index];
+	}
+	if( (mass < pSearch->MassLow) || (mass > pSearch->MassHigh) ){
+		return;
+	}
+
+	//---------------------------------------------------------
+	// RDBE and Senior's rules over the atoms of known valence
+	//---------------------------------------------------------
+	rdbe        = 1.0;
+	valence_sum = 0;
+	valence_max = 0;
+	atoms       = 0;
+	for(element_index=0; element_index<pAlphabet->ElementTotal; element_index++){
+		count = pSearch->Count[element_index] + pAlphabet->Minimum[element_index];
+		if( (0 == count) || (0 == pAlphabet->Valence[element_index]) ){
+			continue;
+		}
+		rdbe        += 0.5*count*(pAlphabet->Valence[element_index] - 2);
+		valence_sum += count*pAlphabet->Valence[element_index];
+		atoms       += count;
+		if( valence_max < pAlphabet->Valence[element_index] ){
+			valence_max = pAlphabet->Valence[element_index];
+		}
+	}
+	if( (rdbe < pQuery->RdbeMin) || (rdbe > pQuery->RdbeMax) ){
+		return;
+	}
+	if( pQuery->EvenElectron && (0 != (valence_sum & 1)) ){
+		return;
+	}
+	if( pQuery->Senior && ((valence_sum < 2*valence_max) || (valence_sum < 2*(atoms-1))) ){
+		return;
+	}
+
+	//---------------------------------------------------------
+	// Keep it
+	//---------------------------------------------------------
+	if( pResult->CandidateTotal == pResult->CandidateCapacity ){
+		grown = (struct decompose_candidate *)realloc(pResult->Candidate, 2*(pResult->CandidateCapacity+32)*sizeof(struct decompose_candidate));
+		if( NULL == grown ){
+			data_error("Error : could not allocate %d candidates\n",2*(pResult->CandidateCapacity+32));
+			pSearch->Failed = 1;
+			return;
+		}
+		pResult->Candidate         = grown;
+		pResult->CandidateCapacity = 2*(pResult->CandidateCapacity+32);
+	}
+	pCandidate = &pResult->Candidate[pResult->CandidateTotal];
+	for(element_index=0; element_index<pAlphabet->ElementTotal; element_index++){
+		pCandidate->Count[element_index] = pSearch->Count[element_index] + pAlphabet->Minimum[element_index];
+	}
+	pCandidate->Mass   = mass;
+	pCandidate->Ppm    = 1e6*(mass - pQuery->Mass)/pQuery->Mass;
+	pCandidate->Rdbe   = rdbe;
+	pCandidate->Scored = 0;
+	pResult->CandidateTotal++;
+}
+
+//--------------------------------------------------------
+// Decompositions of the integer mass m with elements
+// 0..element_index, the counts of the heavier elements
+// being set.  A count is tried only if the rest of m can
+// be made of the lighter elements (residue table).
+//--------------------------------------------------------
+static void decompose_level(struct decompose_search *pSearch, int element_index, int m){
+	int *Lighter;
+	int a0;
+	int ai;
+	int count;
+
+	a0 = pSearch->pAlphabet->IntegerMass[0];
+	if( 0 == element_index ){
+		if( (0 == m % a0) && (m/a0 <= pSearch->Span[0]) ){
+			pSearch->Count[0] = m/a0;
+			decompose_accept(pSearch);
+		}
+		return;
+	}
+
+	//---------------------------------------------------------
+	// Last two elements: the smallest mass of the residue is
+	// count*a1 alone, and the other counts follow every
+	// a0/gcd(a0,a1) atoms
+	//---------------------------------------------------------
+	if( 1 == element_index ){
+		ai = pSearch->pAlphabet->IntegerMass[1];
+		if( pSearch->pAlphabet->Residue[a0 + m % a0] > m ){
+			return;
+		}
+		for(count=pSearch->pAlphabet->Residue[a0 + m % a0]/ai; (count <= pSearch->Span[1]) && (count*ai <= m) && !pSearch->Failed; count+=pSearch->Period){
+			if( (m - count*ai)/a0 <= pSearch->Span[0] ){
+				pSearch->Count[1] = count;
+				pSearch->Count[0] = (m - count*ai)/a0;
+				decompose_accept(pSearch);
+			}
+		}
+		pSearch->Count[1] = 0;
+		return;
+	}
+	Lighter = pSearch->pAlphabet->Residue + (element_index-1)*a0;
+	ai      = pSearch->pAlphabet->IntegerMass[element_index];
+	for(count=0; (count <= pSearch->Span[element_index]) && (0 <= m) && !pSearch->Failed; count++){
+		if( Lighter[m % a0] <= m ){
+			pSearch->Count[element_index] = count;
+			decompose_level(pSearch, element_index-1, m);
+		}
+		m -= ai;
+	}
+	pSearch->Count[element_index] = 0;
+}
+
+//--------------------------------------------------------
+// Candidates of a query (appended to the result, which
+// starts empty: CandidateCapacity 0, Candidate NULL).
+// Returns 0, or -1 for a target too heavy for the integer
+// masses or if out of memory.
+//--------------------------------------------------------
+int isoDalton_decompose(struct decompose_alphabet *pAlphabet, struct decompose_query *pQuery, struct decompose_result *pResult){
+	struct decompose_search Search;
+	double low,high;
+	double integer_low,integer_high;
+	int element_index;
+	int m;
+
+	Search.pAlphabet   = pAlphabet;
+	Search.pQuery      = pQuery;
+	Search.pResult     = pResult;
+	Search.MassLow     = pQuery->Mass*(1.0 - 1e-6*pQuery->Ppm);
+	Search.MassHigh    = pQuery->Mass*(1.0 + 1e-6*pQuery->Ppm);
+	Search.MinimumMass = 0;
+	Search.Failed      = 0;
+	Search.Period      = 1;
+	if( 1 < pAlphabet->ElementTotal ){
+		Search.Period = pAlphabet->IntegerMass[0]/decompose_gcd(pAlphabet->IntegerMass[0], pAlphabet->IntegerMass[1]);
+	}
+	for(element_index=0; element_index<pAlphabet->ElementTotal; element_index++){
+		Search.Count[element_index] = 0;
+		Search.Span[element_index]  = pAlphabet->Maximum[element_index] - pAlphabet->Minimum[element_index];
+		Search.MinimumMass         += pAlphabet->Minimum[element_index]*pAlphabet->Mass[element_index];
+	}
+
+	//---------------------------------------------------------
+	// Integer masses of the real masses of the window above
+	// the minimum counts: the integer mass of a decomposition
+	// of real mass M is within M*Blowup*(1+ErrorLow) and
+	// M*Blowup*(1+ErrorHigh)
+	//---------------------------------------------------------
+	low  = Search.MassLow  - Search.MinimumMass;
+	high = Search.MassHigh - Search.MinimumMass;
+	if( high < 0 ){
+		return 0;
+	}
+	if( low < 0 ){
+		low = 0;
+	}
+	integer_low  = ceil(low*pAlphabet->Blowup*(1.0 + pAlphabet->ErrorLow));
+	integer_high = floor(high*pAlphabet->Blowup*(1.0 + pAlphabet->ErrorHigh));
+	if( integer_high >= (double)DECOMPOSE_INFINITY ){
+		data_error("Error : the mass %f is too large to decompose\n",pQuery->Mass);
+		return -1;
+	}
+	for(m=(int)integer_low; (m <= (int)integer_high) && !Search.Failed; m++){
+		pResult->IntegerTotal += 1;
+		decompose_level(&Search, pAlphabet->ElementTotal-1, m);
+	}
+	return Search.Failed ? -1 : 0;
+}
+
+void isoDalton_decompose_result_free(struct decompose_result *pResult){
+	free(pResult->Candidate);
+	pResult->Candidate         = NULL;
+	pResult->CandidateTotal    = 0;
+	pResult->CandidateCapacity = 0;
+}
+
+//--------------------------------------------------------
+// Hill formula of a candidate, e.g. C6H12O6.  Returns 0,
+// or -1 if it does not fit in length characters.
+//--------------------------------------------------------
+int isoDalton_decompose_formula(struct decompose_alphabet *pAlphabet, struct decompose_candidate *pCandidate, char *formula, int length){
+	char term[32];
+	int element_index;
+	int hill_index;
+	int used;
+
+	used = 0;
+	formula[0] = '\0';
+	for(hill_index=0; hill_index<pAlphabet->ElementTotal; hill_index++){
+		element_index = pAlphabet->HillOrder[hill_index];
+		if( 0 == pCandidate->Count[element_index] ){
+			continue;
+		}
+		if( 1 == pCandidate->Count[element_index] ){
+			sprintf(term, "%s", pAlphabet->Symbol[element_index]);
+		}else{
+			sprintf(term, "%s%d", pAlphabet->Symbol[element_index], pCandidate->Count[element_index]);
+		}
+		if( used + (int)strlen(term) >= length ){
+			return -1;
+		}
+		strcpy(formula+used, term);
+		used += (int)strlen(term);
+	}
+	return 0;
+}
+
+//--------------------------------------------------------
+// Prob,Mass = Prob1,Mass1 convolved with Prob2,Mass2 over
+// the nominal shifts, Mass holding probability times mass
+//--------------------------------------------------------
+static void decompose_convolve(double *Prob1, double *Mass1, double *Prob2, double *Mass2, double *Prob, double *Mass){
+	int shift1;
+	int shift2;
+
+	for(shift1=0; shift1<DECOMPOSE_CLUSTERS; shift1++){
+		Prob[shift1] = 0;
+		Mass[shift1] = 0;
+	}
+	for(shift1=0; shift1<DECOMPOSE_CLUSTERS; shift1++){
+		if( 0 == Prob1[shift1] ){
+			continue;
+		}
+		for(shift2=0; shift1+shift2<DECOMPOSE_CLUSTERS; shift2++){
+			Prob[shift1+shift2] += Prob1[shift1]*Prob2[shift2];
+			Mass[shift1+shift2] += Mass1[shift1]*Prob2[shift2] + Prob1[shift1]*Mass2[shift2];
+		}
+	}
+}
+
+//--------------------------------------------------------
+// Probability and mean mass of the M+k clusters of a
+// candidate: the distribution of each element raised to
+// its atom count by squaring
+//--------------------------------------------------------
+static void decompose_clusters(struct decompose_alphabet *pAlphabet, struct decompose_candidate *pCandidate, struct istates_info *pClusters){
+	double prob[DECOMPOSE_CLUSTERS];
+	double mass[DECOMPOSE_CLUSTERS];
+	double power_prob[DECOMPOSE_CLUSTERS];
+	double power_mass[DECOMPOSE_CLUSTERS];
+	double next_prob[DECOMPOSE_CLUSTERS];
+	double next_mass[DECOMPOSE_CLUSTERS];
+	int element_index;
+	int shift;
+	int n;
+
+	for(shift=0; shift<DECOMPOSE_CLUSTERS; shift++){
+		prob[shift] = 0;
+		mass[shift] = 0;
+	}
+	prob[0] = 1;
+	for(element_index=0; element_index<pAlphabet->ElementTotal; element_index++){
+		memcpy(power_prob, pAlphabet->ShiftProb[element_index], DECOMPOSE_CLUSTERS*sizeof(double));
+		memcpy(power_mass, pAlphabet->ShiftMass[element_index], DECOMPOSE_CLUSTERS*sizeof(double));
+		for(n=pCandidate->Count[element_index]; 0 < n; n>>=1){
+			if( n & 1 ){
+				decompose_convolve(prob, mass, power_prob, power_mass, next_prob, next_mass);
+				memcpy(prob, next_prob, DECOMPOSE_CLUSTERS*sizeof(double));
+				memcpy(mass, next_mass, DECOMPOSE_CLUSTERS*sizeof(double));
+			}
+			if( 1 < n ){
+				decompose_convolve(power_prob, power_mass, power_prob, power_mass, next_prob, next_mass);
+				memcpy(power_prob, next_prob, DECOMPOSE_CLUSTERS*sizeof(double));
+				memcpy(power_mass, next_mass, DECOMPOSE_CLUSTERS*sizeof(double));
+			}
+		}
+	}
+	pClusters->StateTotal = 0;
+	for(shift=0; shift<DECOMPOSE_CLUSTERS; shift++){
+		if( prob[shift] >= DECOMPOSE_CLUSTER_MIN ){
+			pClusters->mass[pClusters->StateTotal] = mass[shift]/prob[shift];
+			pClusters->prob[pClusters->StateTotal] = prob[shift];
+			pClusters->StateTotal++;
+		}
+	}
+}
+
+//--------------------------------------------------------
+// Isotope pattern and score of each candidate of a slice,
+// one at a time
+//--------------------------------------------------------
+static void decompose_slice_work(void *argument){
+	struct decompose_slice *pSlice;
+	struct decompose_alphabet *pAlphabet;
+	struct decompose_candidate *pCandidate;
+	struct molecule_info Molecule;
+	struct istates_info States;
+	char formula[DECOMPOSE_MAX_ELEMENTS*16];
+	int AtomCount[DECOMPOSE_MAX_ELEMENTS];
+	int AtomicNumber[DECOMPOSE_MAX_ELEMENTS];
+	int capacity;
+	int candidate;
+	int element_index;
+
+	pSlice    = (struct decompose_slice *)argument;
+	pAlphabet = pSlice->pAlphabet;
+	capacity  = (DECOMPOSE_PATTERN_TRELLIS == pSlice->Pattern) ? pSlice->Mstates : DECOMPOSE_CLUSTERS;
+	States.mass = (double *)malloc(capacity*sizeof(double));
+	States.prob = (double *)malloc(capacity*sizeof(double));
+	if( (NULL == States.mass) || (NULL == States.prob) ){
+		data_error("Error : could not allocate %d states\n",capacity);
+		free(States.mass);
+		free(States.prob);
+		pSlice->Failed = 1;
+		return;
+	}
+	Molecule.Formula      = formula;
+	Molecule.AtomCount    = AtomCount;
+	Molecule.AtomicNumber = AtomicNumber;
+	Molecule.MassNumber   = NULL;
+	for(candidate=pSlice->First; candidate<pSlice->Last; candidate++){
+		pCandidate = &pSlice->pResult->Candidate[candidate];
+		if( DECOMPOSE_PATTERN_TRELLIS == pSlice->Pattern ){
+			isoDalton_decompose_formula(pAlphabet, pCandidate, formula, DECOMPOSE_MAX_ELEMENTS*16);
+			Molecule.ElementTotal = 0;
+			for(element_index=0; element_index<pAlphabet->ElementTotal; element_index++){
+				if( 0 < pCandidate->Count[element_index] ){
+					AtomCount[Molecule.ElementTotal]    = pCandidate->Count[element_index];
+					AtomicNumber[Molecule.ElementTotal] = pAlphabet->AtomicNumber[element_index];
+					Molecule.ElementTotal++;
+				}
+			}
+			isoDalton_exact_mass(&Molecule, pSlice->pElements, pSlice->Mstates, &States, 0);
+		}else{
+			decompose_clusters(pAlphabet, pCandidate, &States);
+		}
+		if( 0 != isoDalton_score(pSlice->pSpectrum, &States, 0, &pCandidate->Score) ){
+			pSlice->Failed = 1;
+			break;
+		}
+		pCandidate->Scored = 1;
+	}
+	free(States.mass);
+	free(States.prob);
+}
+
+//--------------------------------------------------------
+// Scores of the candidates of a result against a spectrum
+// with ThreadTotal threads (the calling thread included):
+// the clusters of each candidate, or with Pattern
+// DECOMPOSE_PATTERN_TRELLIS Mstates states.  Returns 0, or
+// -1 if out of memory.
+//--------------------------------------------------------
+int isoDalton_decompose_score(struct decompose_alphabet *pAlphabet, struct element_list *pElements, struct decompose_result *pResult, struct score_spectrum *pSpectrum, int Pattern, int Mstates, int ThreadTotal){
+	struct decompose_slice Slice[DECOMPOSE_MAX_THREADS];
+	int thread_index;
+	int per_thread;
+	int status;
+
+	if( ThreadTotal > DECOMPOSE_MAX_THREADS ){
+		ThreadTotal = DECOMPOSE_MAX_THREADS;
+	}
+	if( ThreadTotal > pResult->CandidateTotal ){
+		ThreadTotal = pResult->CandidateTotal;
+	}
+	if( ThreadTotal < 1 ){
+		ThreadTotal = 1;
+	}
+	per_thread = (pResult->CandidateTotal + ThreadTotal - 1)/ThreadTotal;
+	for(thread_index=0; thread_index<ThreadTotal; thread_index++){
+		Slice[thread_index].pAlphabet = pAlphabet;
+		Slice[thread_index].pElements = pElements;
+		Slice[thread_index].pResult   = pResult;
+		Slice[thread_index].pSpectrum = pSpectrum;
+		Slice[thread_index].Mstates   = Mstates;
+		Slice[thread_index].Pattern   = Pattern;
+		Slice[thread_index].First     = thread_index*per_thread;
+		Slice[thread_index].Last      = Slice[thread_index].First + per_thread;
+		Slice[thread_index].Failed    = 0;
+		if( Slice[thread_index].First > pResult->CandidateTotal ){
+			Slice[thread_index].First = pResult->CandidateTotal;
+		}
+		if( Slice[thread_index].Last > pResult->CandidateTotal ){
+			Slice[thread_index].Last = pResult->CandidateTotal;
+		}
+	}
+	thread_run_slices(ThreadTotal, decompose_slice_work, Slice, sizeof(Slice[0]));
+	status = 0;
+	for(thread_index=0; thread_index<ThreadTotal; thread_index++){
+		if( Slice[thread_index].Failed ){
+			status = -1;
+		}
+	}
+	return status;
+}
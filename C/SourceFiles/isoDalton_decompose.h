@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_decompose.h                                   */
+/*               Header file for isoDalton_decompose.cpp, the candidate  */
+/*               formulas of an observed monoisotopic mass               */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_DECOMPOSE
+#define ISODALTON_DECOMPOSE
+
+#include "isoDalton_score.h"
+
+//---------------------------------------------------------------------------------------------
+// Mass decomposition.  The monoisotopic masses of the elements of the alphabet (the most
+// common isotopes, as isoDalton_batch_masses) are scaled by DECOMPOSE_BLOWUP and rounded to
+// integers a[0] < a[1] < ...  The extended residue table (Bocker and Liptak's round robin
+// algorithm) holds, for each element i and residue r modulo a[0], the smallest integer mass
+// with that residue made of elements 0..i, so whether a remainder m can still be completed
+// with the lighter elements is one lookup: Residue[i][m mod a[0]] <= m.  Every integer mass
+// whose rounding error allows a real mass within Ppm of the target is decomposed by a depth
+// first search over the counts of the heavier elements with that lookup pruning every branch
+// that has no completion; the count of the lightest element follows from the remainder.
+//
+// The minimum counts are taken off the target first and the maximum counts bound the loops.
+// A decomposition is kept if its real mass is within Ppm of the target and it passes the
+// filters of the query:
+//
+//   RDBE            ring and double bond equivalents 1 + sum n*(v-2)/2 in [RdbeMin,RdbeMax]
+//   EvenElectron    integral RDBE, i.e. an even sum of valences
+//   Senior          Senior's rules: the sum of valences is at least twice the largest valence
+//                   and at least 2*(atoms-1)
+//
+// Valences are those of the common organic elements (H 1, C 4, N 3, O 2, P 3, S 2, halogens
+// 1, ...); an element with valence 0 (not known) is left out of the filters.  The valences
+// of an alphabet can be changed after isoDalton_decompose_alphabet.
+//
+// isoDalton_decompose_score computes the isotope pattern of every candidate, one candidate at
+// a time per thread, and scores it against an observed spectrum.  DECOMPOSE_PATTERN_CLUSTERS
+// gives the exact probability and mean mass of every M+k cluster (what a centroid of a unit
+// resolution envelope measures): the atoms of an element make a distribution over the nominal
+// shift k, of the probability and of the probability times the mass, and the distribution of
+// the molecule is the convolution of the powers of those of its elements (by squaring, the
+// first DECOMPOSE_CLUSTERS shifts kept), tens of microseconds a candidate.  The analytic
+// envelope of isoDalton_moments_envelope is faster, but is off by several percent at 2 kDa.
+// DECOMPOSE_PATTERN_TRELLIS scores the Mstates states of the trellis instead, for observed
+// spectra resolving the fine structure.
+//---------------------------------------------------------------------------------------------
+#define DECOMPOSE_MAX_ELEMENTS      16
+#define DECOMPOSE_BLOWUP            5963.337687   // small rounding errors for the CHNOPS masses
+#define DECOMPOSE_DEFAULT_PPM       5.0
+#define DECOMPOSE_MAX_THREADS       64
+#define DECOMPOSE_INFINITY          0x7fffffff    // no decomposition with that residue
+#define DECOMPOSE_CLUSTERS          32            // M+0 to M+31
+#define DECOMPOSE_CLUSTER_MIN       1e-9          // clusters of smaller probability are not scored
+#define DECOMPOSE_PATTERN_CLUSTERS  0
+#define DECOMPOSE_PATTERN_TRELLIS   1
+
+struct decompose_alphabet {
+	int     ElementTotal;
+	int     AtomicNumber[DECOMPOSE_MAX_ELEMENTS];   // by increasing IntegerMass
+	int     Minimum[DECOMPOSE_MAX_ELEMENTS];
+	int     Maximum[DECOMPOSE_MAX_ELEMENTS];
+	int     Valence[DECOMPOSE_MAX_ELEMENTS];
+	double  Mass[DECOMPOSE_MAX_ELEMENTS];           // monoisotopic
+	int     IntegerMass[DECOMPOSE_MAX_ELEMENTS];    // Mass*Blowup rounded
+	int     HillOrder[DECOMPOSE_MAX_ELEMENTS];      // element indices in Hill order
+	char   *Symbol[DECOMPOSE_MAX_ELEMENTS];
+	double  ShiftProb[DECOMPOSE_MAX_ELEMENTS][DECOMPOSE_CLUSTERS];   // one atom: probability of shift k
+	double  ShiftMass[DECOMPOSE_MAX_ELEMENTS][DECOMPOSE_CLUSTERS];   // and probability times mass
+	double  Blowup;
+	double  ErrorLow;                               // smallest IntegerMass/(Mass*Blowup) - 1
+	double  ErrorHigh;                              // largest
+	int    *Residue;                                // Residue[i*IntegerMass[0] + r]
+};
+
+struct decompose_query {
+	double Mass;            // neutral monoisotopic mass
+	double Ppm;
+	double RdbeMin;
+	double RdbeMax;
+	int    EvenElectron;
+	int    Senior;
+};
+
+struct decompose_candidate {
+	int    Count[DECOMPOSE_MAX_ELEMENTS];           // alphabet order
+	double Mass;
+	double Ppm;             // 1e6*(Mass - target)/target
+	double Rdbe;
+	int    Scored;          // isoDalton_decompose_score: Score is set
+	struct spectrum_score Score;
+};
+
+struct decompose_result {
+	int    CandidateTotal;
+	int    CandidateCapacity;
+	struct decompose_candidate *Candidate;
+	double IntegerTotal;    // integer masses decomposed
+	double VisitTotal;      // integer decompositions found (before the mass and filters)
+};
+
+int  isoDalton_decompose_alphabet(struct element_list *, int, int *, int *, int *, struct decompose_alphabet *);
+void isoDalton_decompose_alphabet_free(struct decompose_alphabet *);
+int  isoDalton_decompose(struct decompose_alphabet *, struct decompose_query *, struct decompose_result *);
+void isoDalton_decompose_result_free(struct decompose_result *);
+int  isoDalton_decompose_score(struct decompose_alphabet *, struct element_list *, struct decompose_result *, struct score_spectrum *, int, int, int);
+int  isoDalton_decompose_formula(struct decompose_alphabet *, struct decompose_candidate *, char *, int);
+
+#endif
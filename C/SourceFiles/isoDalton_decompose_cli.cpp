@@ -0,0 +1,359 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_decompose_cli.cpp                             */
+/*               Command line driver of the mass decomposition.  Writes  */
+/*               the candidate formulas of a neutral monoisotopic mass   */
+/*               within element bounds, a ppm tolerance and the valence  */
+/*               and RDBE filters, scored against an observed isotope    */
+/*               envelope with -observed.                                */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_formula.h"
+#include "isoDalton_decompose.h"
+#include "sort.h"
+#include "thread.h"
+#include <math.h>
+
+#define DECOMPOSE_CLI_DEFAULT_MAX    "C200H400N40O60P5S5"
+#define DECOMPOSE_CLI_DEFAULT_STATES 200
+#define DECOMPOSE_CLI_FORMULA_MAX    256
+
+struct decompose_cli_options {
+	char  *DataPath;
+	char  *UserDataPath;
+	char  *UserCompFilename;
+	char  *MinimumFormula;    // NULL = no minimum counts
+	char  *MaximumFormula;    // the alphabet
+	char  *ObservedFilename;  // NULL = no scoring
+	double Mass;
+	double Ppm;
+	double RdbeMin;
+	double RdbeMax;
+	int    EvenElectron;
+	int    Senior;
+	int    Mstates;
+	int    Pattern;           // DECOMPOSE_PATTERN_*
+	int    Nthreads;
+	int    Top;               // 0 = all candidates
+	int    Verbose;
+};
+
+static void decompose_cli_usage(void){
+	fprintf(stderr,"Usage: isoDalton_decompose_cli -mass M [options]\n");
+	fprintf(stderr,"Writes the candidate formulas of the neutral monoisotopic mass M.\n");
+	fprintf(stderr,"  -data dir       data directory (DataFiles)\n");
+	fprintf(stderr,"  -user dir       user data directory (DataFileUser)\n");
+	fprintf(stderr,"  -comp file      user composition file (UserIsotopesNIST_HCNOS.xml)\n");
+	fprintf(stderr,"  -max formula    elements and their largest counts (%s)\n",DECOMPOSE_CLI_DEFAULT_MAX);
+	fprintf(stderr,"  -min formula    smallest counts (none)\n");
+	fprintf(stderr,"  -ppm p          mass tolerance in ppm (%g)\n",DECOMPOSE_DEFAULT_PPM);
+	fprintf(stderr,"  -rdbe lo,hi     ring and double bond equivalents (0,1000)\n");
+	fprintf(stderr,"  -radicals       allow odd valence sums (half integer RDBE)\n");
+	fprintf(stderr,"  -no_senior      do not apply Senior's valence rules\n");
+	fprintf(stderr,"  -observed file  centroids (mass intensity per line): score the isotope pattern\n");
+	fprintf(stderr,"                  of every candidate and sort by spectral angle\n");
+	fprintf(stderr,"  -pattern p      observed: clusters (M, M+1 ... probabilities and mean masses) or\n");
+	fprintf(stderr,"                  trellis (-states states, for spectra resolving the fine structure)\n");
+	fprintf(stderr,"  -states N       observed, trellis: states of each isotope pattern (%d)\n",DECOMPOSE_CLI_DEFAULT_STATES);
+	fprintf(stderr,"  -threads T      observed: scoring threads (number of processors)\n");
+	fprintf(stderr,"  -top K          write the first K candidates only\n");
+	fprintf(stderr,"  -v              print the search counts and times to stderr\n");
+}
+
+//--------------------------------------------------------
+// Returns 0 on success and -1 on a usage error
+//--------------------------------------------------------
+static int decompose_cli_parse_options(int argc, char **argv, struct decompose_cli_options *pOptions){
+	int arg_index;
+
+	pOptions->DataPath         = (char *)"DataFiles";
+	pOptions->UserDataPath     = (char *)"DataFileUser";
+	pOptions->UserCompFilename = (char *)"UserIsotopesNIST_HCNOS.xml";
+	pOptions->MinimumFormula   = NULL;
+	pOptions->MaximumFormula   = (char *)DECOMPOSE_CLI_DEFAULT_MAX;
+	pOptions->ObservedFilename = NULL;
+	pOptions->Mass             = 0;
+	pOptions->Ppm              = DECOMPOSE_DEFAULT_PPM;
+	pOptions->RdbeMin          = 0;
+	pOptions->RdbeMax          = 1000;
+	pOptions->EvenElectron     = 1;
+	pOptions->Senior           = 1;
+	pOptions->Mstates          = DECOMPOSE_CLI_DEFAULT_STATES;
+	pOptions->Pattern          = DECOMPOSE_PATTERN_CLUSTERS;
+	pOptions->Nthreads         = thread_processor_count();
+	pOptions->Top              = 0;
+	pOptions->Verbose          = 0;
+
+	for(arg_index=1; arg_index<argc; arg_index++){
+		if( 0 == strcmp(argv[arg_index],"-radicals") ){
+			pOptions->EvenElectron = 0;
+		}else if( 0 == strcmp(argv[arg_index],"-no_senior") ){
+			pOptions->Senior = 0;
+		}else if( 0 == strcmp(argv[arg_index],"-v") ){
+			pOptions->Verbose = 1;
+		}else if( 0 == strcmp(argv[arg_index],"-h") ){
+			return -1;
+		}else if( ('-' == argv[arg_index][0]) && (arg_index+1 < argc) ){
+			if( 0 == strcmp(argv[arg_index],"-data") ){
+				pOptions->DataPath = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-user") ){
+				pOptions->UserDataPath = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-comp") ){
+				pOptions->UserCompFilename = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-mass") ){
+				pOptions->Mass = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-max") ){
+				pOptions->MaximumFormula = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-min") ){
+				pOptions->MinimumFormula = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-ppm") ){
+				pOptions->Ppm = atof(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-rdbe") ){
+				if( (2 != sscanf(argv[arg_index+1],"%lf,%lf",&pOptions->RdbeMin,&pOptions->RdbeMax)) || (pOptions->RdbeMin > pOptions->RdbeMax) ){
+					fprintf(stderr,"Error : bad RDBE range %s\n",argv[arg_index+1]);
+					return -1;
+				}
+			}else if( 0 == strcmp(argv[arg_index],"-observed") ){
+				pOptions->ObservedFilename = argv[arg_index+1];
+			}else if( 0 == strcmp(argv[arg_index],"-pattern") ){
+				if( 0 == strcmp(argv[arg_index+1],"clusters") ){
+					pOptions->Pattern = DECOMPOSE_PATTERN_CLUSTERS;
+				}else if( 0 == strcmp(argv[arg_index+1],"trellis") ){
+					pOptions->Pattern = DECOMPOSE_PATTERN_TRELLIS;
+				}else{
+					fprintf(stderr,"Error : unknown pattern %s\n",argv[arg_index+1]);
+					return -1;
+				}
+			}else if( 0 == strcmp(argv[arg_index],"-states") ){
+				pOptions->Mstates = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-threads") ){
+				pOptions->Nthreads = atoi(argv[arg_index+1]);
+			}else if( 0 == strcmp(argv[arg_index],"-top") ){
+				pOptions->Top = atoi(argv[arg_index+1]);
+			}else{
+				fprintf(stderr,"Error : unknown option %s\n",argv[arg_index]);
+				return -1;
+			}
+			arg_index++;
+		}else{
+			fprintf(stderr,"Error : unknown option %s\n",argv[arg_index]);
+			return -1;
+		}
+	}
+	if( pOptions->Mass <= 0 ){
+		fprintf(stderr,"Error : -mass must be given and positive\n");
+		return -1;
+	}
+	if( (pOptions->Ppm <= 0) || (pOptions->Mstates < 1) ){
+		fprintf(stderr,"Error : -ppm and -states must be positive\n");
+		return -1;
+	}
+	return 0;
+}
+
+//--------------------------------------------------------
+// Element bounds from -max and -min: the elements of the
+// maximum formula make the alphabet.  Returns the number
+// of elements or -1.
+//--------------------------------------------------------
+static int decompose_cli_bounds(struct decompose_cli_options *pOptions, struct formula_symbol_table *pTable, int *AtomicNumber, int *Minimum, int *Maximum){
+	struct formula_info Formula;
+	int status;
+	int element_total;
+	int element_index;
+	int index;
+
+	status = isoDalton_formula_parse(pOptions->MaximumFormula, pTable, &Formula);
+	if( FORMULA_OK != status ){
+		fprintf(stderr,"Error : -max %s: %s\n",pOptions->MaximumFormula,isoDalton_formula_error_string(status));
+		return -1;
+	}
+	if( Formula.ElementTotal > DECOMPOSE_MAX_ELEMENTS ){
+		fprintf(stderr,"Error : -max has more than %d elements\n",DECOMPOSE_MAX_ELEMENTS);
+		return -1;
+	}
+	element_total = Formula.ElementTotal;
+	for(element_index=0; element_index<element_total; element_index++){
+		if( 0 != Formula.MassNumber[element_index] ){
+			fprintf(stderr,"Error : -max must not name isotopes\n");
+			return -1;
+		}
+		AtomicNumber[element_index] = Formula.AtomicNumber[element_index];
+		Maximum[element_index]      = Formula.AtomCount[element_index];
+		Minimum[element_index]      = 0;
+	}
+	if( NULL == pOptions->MinimumFormula ){
+		return element_total;
+	}
+	status = isoDalton_formula_parse(pOptions->MinimumFormula, pTable, &Formula);
+	if( FORMULA_OK != status ){
+		fprintf(stderr,"Error : -min %s: %s\n",pOptions->MinimumFormula,isoDalton_formula_error_string(status));
+		return -1;
+	}
+	for(index=0; index<Formula.ElementTotal; index++){
+		for(element_index=0; element_index<element_total; element_index++){
+			if( (AtomicNumber[element_index] == Formula.AtomicNumber[index]) && (0 == Formula.MassNumber[index]) ){
+				break;
+			}
+		}
+		if( element_index == element_total ){
+			fprintf(stderr,"Error : the elements of -min must be in -max\n");
+			return -1;
+		}
+		Minimum[element_index] = Formula.AtomCount[index];
+	}
+	return element_total;
+}
+
+int main(int argc, char **argv)
+{
+	struct decompose_cli_options Options;
+	struct element_list Elements;
+	struct formula_symbol_table *pTable;
+	struct decompose_alphabet Alphabet;
+	struct decompose_query Query;
+	struct decompose_result Result;
+	struct decompose_candidate *pCandidate;
+	struct istates_info Peaks;
+	struct score_spectrum Spectrum;
+	char   formula[DECOMPOSE_CLI_FORMULA_MAX];
+	int    AtomicNumber[DECOMPOSE_MAX_ELEMENTS];
+	int    Minimum[DECOMPOSE_MAX_ELEMENTS];
+	int    Maximum[DECOMPOSE_MAX_ELEMENTS];
+	double *Key;
+	int    *Order;
+	int    *Unused;
+	int    element_total;
+	int    candidate;
+	int    written;
+	double seconds_table;
+	double seconds_search;
+	double seconds_score;
+
+	if( 0 != decompose_cli_parse_options(argc, argv, &Options) ){
+		decompose_cli_usage();
+		return 1;
+	}
+	data_set_stream(stderr);
+	data_set_verbose(0);
+	isoDalton_get_isotopes(Options.DataPath, Options.UserDataPath, Options.UserCompFilename, &Elements);
+	pTable = (struct formula_symbol_table *)malloc(sizeof(struct formula_symbol_table));
+	if( (NULL == pTable) || (0 != isoDalton_formula_build_table(&Elements, pTable)) ){
+		fprintf(stderr,"Error : could not build the element symbol table\n");
+		return 1;
+	}
+	element_total = decompose_cli_bounds(&Options, pTable, AtomicNumber, Minimum, Maximum);
+	if( element_total < 1 ){
+		return 1;
+	}
+
+	//--------------------------------------------------------------------------
+	// Residue table and candidates
+	//--------------------------------------------------------------------------
+	seconds_table = thread_wall_seconds();
+	if( 0 != isoDalton_decompose_alphabet(&Elements, element_total, AtomicNumber, Minimum, Maximum, &Alphabet) ){
+		return 1;
+	}
+	seconds_table = thread_wall_seconds() - seconds_table;
+	Query.Mass         = Options.Mass;
+	Query.Ppm          = Options.Ppm;
+	Query.RdbeMin      = Options.RdbeMin;
+	Query.RdbeMax      = Options.RdbeMax;
+	Query.EvenElectron = Options.EvenElectron;
+	Query.Senior       = Options.Senior;
+	Result.CandidateTotal    = 0;
+	Result.CandidateCapacity = 0;
+	Result.Candidate         = NULL;
+	Result.IntegerTotal      = 0;
+	Result.VisitTotal        = 0;
+	seconds_search = thread_wall_seconds();
+	if( 0 != isoDalton_decompose(&Alphabet, &Query, &Result) ){
+		return 1;
+	}
+	seconds_search = thread_wall_seconds() - seconds_search;
+
+	//--------------------------------------------------------------------------
+	// Isotope patterns of the candidates against the observed envelope
+	//--------------------------------------------------------------------------
+	seconds_score = 0;
+	if( NULL != Options.ObservedFilename ){
+		if( isoDalton_score_read_peaks(Options.ObservedFilename, &Peaks) < 1 ){
+			fprintf(stderr,"Error : no peaks in %s\n",Options.ObservedFilename);
+			return 1;
+		}
+		if( 0 != isoDalton_score_spectrum_init(&Spectrum, &Peaks, Options.Ppm) ){
+			return 1;
+		}
+		free(Peaks.mass);
+		free(Peaks.prob);
+		seconds_score = thread_wall_seconds();
+		if( 0 != isoDalton_decompose_score(&Alphabet, &Elements, &Result, &Spectrum, Options.Pattern, Options.Mstates, Options.Nthreads) ){
+			return 1;
+		}
+		seconds_score = thread_wall_seconds() - seconds_score;
+		isoDalton_score_spectrum_free(&Spectrum);
+	}
+
+	//--------------------------------------------------------------------------
+	// Best spectral angle first when scored, else smallest mass error
+	//--------------------------------------------------------------------------
+	Key    = (double *)malloc((Result.CandidateTotal+1)*sizeof(double));
+	Order  = (int *)malloc((Result.CandidateTotal+1)*sizeof(int));
+	Unused = (int *)malloc((Result.CandidateTotal+1)*sizeof(int));
+	if( (NULL == Key) || (NULL == Order) || (NULL == Unused) ){
+		fprintf(stderr,"Error : could not allocate %d candidates\n",Result.CandidateTotal);
+		return 1;
+	}
+	for(candidate=0; candidate<Result.CandidateTotal; candidate++){
+		pCandidate        = &Result.Candidate[candidate];
+		Key[candidate]    = pCandidate->Scored ? -pCandidate->Score.SpectralAngle : fabs(pCandidate->Ppm);
+		Order[candidate]  = candidate;
+		Unused[candidate] = 0;
+	}
+	heapsort_1dbl_2int_up(Result.CandidateTotal, Key, Order, Unused);
+	if( NULL == Options.ObservedFilename ){
+		printf("formula\tmass\tppm\trdbe\n");
+	}else{
+		printf("formula\tmass\tppm\trdbe\tspectral_angle\tcosine\tkl_divergence\tratio_error\n");
+	}
+	written = Result.CandidateTotal;
+	if( (0 < Options.Top) && (Options.Top < written) ){
+		written = Options.Top;
+	}
+	for(candidate=0; candidate<written; candidate++){
+		pCandidate = &Result.Candidate[Order[candidate]];
+		isoDalton_decompose_formula(&Alphabet, pCandidate, formula, DECOMPOSE_CLI_FORMULA_MAX);
+		printf("%s\t%.6f\t%.3f\t%.1f",formula,pCandidate->Mass,pCandidate->Ppm,pCandidate->Rdbe);
+		if( pCandidate->Scored ){
+			printf("\t%.4f\t%.4f\t%.4f\t%.4f",pCandidate->Score.SpectralAngle,pCandidate->Score.Cosine,pCandidate->Score.KLDivergence,pCandidate->Score.RatioError);
+		}
+		printf("\n");
+	}
+	if( Options.Verbose ){
+		fprintf(stderr,"%d candidates of %.0f decompositions of %.0f integer masses\n",Result.CandidateTotal,Result.VisitTotal,Result.IntegerTotal);
+		fprintf(stderr,"residue table %.3f ms, decomposition %.3f ms",1e3*seconds_table,1e3*seconds_search);
+		if( NULL != Options.ObservedFilename ){
+			fprintf(stderr,", isotope patterns and scores %.3f ms",1e3*seconds_score);
+		}
+		fprintf(stderr,"\n");
+	}
+
+	free(Key);
+	free(Order);
+	free(Unused);
+	free(pTable);
+	isoDalton_decompose_result_free(&Result);
+	isoDalton_decompose_alphabet_free(&Alphabet);
+	return 0;
+}
@@ -0,0 +1,1278 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_external.cpp                                  */
+/*               The trellis with its states in spill files: runs are    */
+/*               sorted in memory, merged by mass and the most probable  */
+/*               states are selected in sequential passes                */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "sort.h"
+#include "thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <time.h>
+#ifndef _MSC_VER
+	#include <sys/types.h>
+#endif
+
+#ifdef _MSC_VER
+	#define external_seek(pFile,offset) _fseeki64(pFile,(__int64)(offset),SEEK_SET)
+#else
+	#define external_seek(pFile,offset) fseeko(pFile,(off_t)(offset),SEEK_SET)
+#endif
+
+#define EXTERNAL_HISTOGRAM_BINS 4096   // bins between the below and above classes
+#define EXTERNAL_SELECT_PASSES  8      // most histogram passes of one selection
+#define EXTERNAL_MIN_RUN_STATES 4096
+
+//--------------------------------------------------------
+// A sequential stream of states over a spill file.  With
+// Async a thread reads ahead (or writes behind) into the
+// buffer the caller is not using.
+//--------------------------------------------------------
+struct external_stream {
+	FILE                  *pFile;
+	int                    Writing;
+	int                    Async;
+	struct external_state *Buffer[2];
+	int                    Count[2];     // states in the buffer
+	int                    Full[2];      // read: filled by the thread, write: waiting to be written
+	int                    Capacity;     // states of a buffer
+	int                    Front;        // buffer of the caller
+	int                    Position;     // next state of the front buffer
+	int                    Ended;
+	int                    Closing;
+	int                    Error;
+	external_uint64        Remaining;    // states left to read
+	external_uint64        Written;      // states written
+	thread_mutex           Mutex;
+	thread_cond            Changed;
+	struct thread_handle   Thread;
+};
+
+//--------------------------------------------------------
+// States written to a stream: the count, the linear
+// probability sum and the range of log10 probability
+//--------------------------------------------------------
+struct external_stats {
+	external_uint64 Total;
+	double          Sum;
+	double          MinKey;
+	double          MaxKey;
+};
+
+struct external_work {
+	struct exact_mass_external *pExternal;
+	int     log10flag;
+	int     RunStates;       // states of the run buffer
+	double *Mass;            // the run buffer
+	double *Prob;
+};
+
+//--------------------------------------------------------
+// The checkpoint file: where the trellis is and what has
+// been discarded so far
+//--------------------------------------------------------
+struct external_checkpoint {
+	char                  Magic[8];
+	external_uint64       Identity;        // external_identity of the computation
+	int                   Element;         // next atom to add
+	int                   Atom;
+	int                   TruncationTotal;
+	int                   Reserved;
+	struct external_stats States;          // of the states file
+	double                Discarded;
+	double                MaxDiscarded;
+	double                ElementDiscarded[ELEMENT_TOTAL];
+	double                ElementMaxDiscarded[ELEMENT_TOTAL];
+	char                  StatePath[EXTERNAL_PATH_MAX];
+};
+
+//--------------------------------------------------------
+// Stream buffers
+//--------------------------------------------------------
+static void external_fill(struct external_stream *pStream, int buffer){
+	size_t Nstates;
+
+	Nstates = (pStream->Remaining < (external_uint64)pStream->Capacity) ? (size_t)pStream->Remaining : (size_t)pStream->Capacity;
+	pStream->Count[buffer] = (int)fread(pStream->Buffer[buffer], sizeof(struct external_state), Nstates, pStream->pFile);
+	if( pStream->Count[buffer] != (int)Nstates ){
+		pStream->Error = 1;
+	}
+	pStream->Remaining -= Nstates;
+}
+
+static void external_flush(struct external_stream *pStream, int buffer){
+	if( (size_t)pStream->Count[buffer] != fwrite(pStream->Buffer[buffer], sizeof(struct external_state), pStream->Count[buffer], pStream->pFile) ){
+		pStream->Error = 1;
+	}
+}
+
+static void external_reader(void *argument){
+	struct external_stream *pStream;
+	int buffer;
+
+	pStream = (struct external_stream *)argument;
+	buffer  = 0;
+	for(;;){
+		thread_mutex_lock(&pStream->Mutex);
+		while( pStream->Full[buffer] && (0 == pStream->Closing) ){
+			thread_cond_wait(&pStream->Changed, &pStream->Mutex);
+		}
+		if( pStream->Closing ){
+			thread_mutex_unlock(&pStream->Mutex);
+			return;
+		}
+		thread_mutex_unlock(&pStream->Mutex);
+		external_fill(pStream, buffer);
+		thread_mutex_lock(&pStream->Mutex);
+		pStream->Full[buffer] = 1;
+		thread_cond_broadcast(&pStream->Changed);
+		thread_mutex_unlock(&pStream->Mutex);
+		if( 0 == pStream->Count[buffer] ){
+			return;  // an empty buffer ends the stream
+		}
+		buffer ^= 1;
+	}
+}
+
+static void external_writer(void *argument){
+	struct external_stream *pStream;
+	int buffer;
+
+	pStream = (struct external_stream *)argument;
+	buffer  = 0;
+	for(;;){
+		thread_mutex_lock(&pStream->Mutex);
+		while( (0 == pStream->Full[buffer]) && (0 == pStream->Closing) ){
+			thread_cond_wait(&pStream->Changed, &pStream->Mutex);
+		}
+		if( 0 == pStream->Full[buffer] ){
+			thread_mutex_unlock(&pStream->Mutex);
+			return;
+		}
+		thread_mutex_unlock(&pStream->Mutex);
+		external_flush(pStream, buffer);
+		thread_mutex_lock(&pStream->Mutex);
+		pStream->Full[buffer] = 0;
+		thread_cond_broadcast(&pStream->Changed);
+		thread_mutex_unlock(&pStream->Mutex);
+		buffer ^= 1;
+	}
+}
+
+//--------------------------------------------------------
+// Open a stream of Nstates states from offset (reading)
+// or a new file (writing).  Returns 0 or -1.
+//--------------------------------------------------------
+static int external_open(struct external_stream *pStream, const char *path, int writing, external_uint64 offset, external_uint64 Nstates, int capacity, int async){
+	pStream->pFile = fopen(path, writing ? "wb" : "rb");
+	if( NULL == pStream->pFile ){
+		data_error("Error : could not open spill file %s\n",path);
+		return -1;
+	}
+	if( (0 != offset) && (0 != external_seek(pStream->pFile, offset*sizeof(struct external_state))) ){
+		data_error("Error : could not seek in spill file %s\n",path);
+		fclose(pStream->pFile);
+		return -1;
+	}
+	pStream->Buffer[0] = (struct external_state *)malloc(capacity*sizeof(struct external_state));
+	pStream->Buffer[1] = async ? (struct external_state *)malloc(capacity*sizeof(struct external_state)) : NULL;
+	if( (NULL == pStream->Buffer[0]) || (async && (NULL == pStream->Buffer[1])) ){
+		data_error("Error : could not allocate the buffers of spill file %s\n",path);
+		free(pStream->Buffer[0]);
+		free(pStream->Buffer[1]);
+		fclose(pStream->pFile);
+		return -1;
+	}
+	pStream->Writing   = writing;
+	pStream->Async     = async;
+	pStream->Capacity  = capacity;
+	pStream->Count[0]  = 0;
+	pStream->Count[1]  = 0;
+	pStream->Full[0]   = 0;
+	pStream->Full[1]   = 0;
+	pStream->Front     = 0;
+	pStream->Position  = 0;
+	pStream->Ended     = 0;
+	pStream->Closing   = 0;
+	pStream->Error     = 0;
+	pStream->Remaining = Nstates;
+	pStream->Written   = 0;
+	if( async ){
+		thread_mutex_init(&pStream->Mutex);
+		thread_cond_init(&pStream->Changed);
+		if( 0 == writing ){
+			pStream->Front   = 1;  // a reader starts by handing back an empty buffer,
+			pStream->Full[1] = 1;  // which the thread must not fill before then
+		}
+		if( 0 != thread_start(&pStream->Thread, writing ? external_writer : external_reader, pStream) ){
+			thread_cond_destroy(&pStream->Changed);
+			thread_mutex_destroy(&pStream->Mutex);
+			pStream->Async   = 0;
+			pStream->Front   = 0;
+			pStream->Full[1] = 0;
+		}
+	}
+	return 0;
+}
+
+// Returns 1 with the next state or 0 at the end of the stream
+static int external_read(struct external_stream *pStream, struct external_state *pState){
+	if( pStream->Position == pStream->Count[pStream->Front] ){
+		if( pStream->Ended ){
+			return 0;
+		}
+		if( pStream->Async ){
+			thread_mutex_lock(&pStream->Mutex);
+			pStream->Full[pStream->Front] = 0;
+			pStream->Front ^= 1;
+			thread_cond_broadcast(&pStream->Changed);
+			while( 0 == pStream->Full[pStream->Front] ){
+				thread_cond_wait(&pStream->Changed, &pStream->Mutex);
+			}
+			thread_mutex_unlock(&pStream->Mutex);
+		}else{
+			external_fill(pStream, pStream->Front);
+		}
+		pStream->Position = 0;
+		if( 0 == pStream->Count[pStream->Front] ){
+			pStream->Ended = 1;
+			return 0;
+		}
+	}
+	*pState = pStream->Buffer[pStream->Front][pStream->Position++];
+	return 1;
+}
+
+static void external_submit(struct external_stream *pStream){
+	pStream->Count[pStream->Front] = pStream->Position;
+	if( pStream->Async ){
+		thread_mutex_lock(&pStream->Mutex);
+		pStream->Full[pStream->Front] = 1;
+		pStream->Front ^= 1;
+		thread_cond_broadcast(&pStream->Changed);
+		while( pStream->Full[pStream->Front] ){
+			thread_cond_wait(&pStream->Changed, &pStream->Mutex);
+		}
+		thread_mutex_unlock(&pStream->Mutex);
+	}else{
+		external_flush(pStream, pStream->Front);
+	}
+	pStream->Position = 0;
+}
+
+static void external_write(struct external_stream *pStream, const struct external_state *pState){
+	pStream->Buffer[pStream->Front][pStream->Position++] = *pState;
+	pStream->Written++;
+	if( pStream->Position == pStream->Capacity ){
+		external_submit(pStream);
+	}
+}
+
+// Returns 0, or -1 if a read or write failed
+static int external_close(struct external_stream *pStream){
+	if( pStream->Writing && (0 < pStream->Position) ){
+		external_submit(pStream);
+	}
+	if( pStream->Async ){
+		thread_mutex_lock(&pStream->Mutex);
+		pStream->Closing = 1;
+		thread_cond_broadcast(&pStream->Changed);
+		thread_mutex_unlock(&pStream->Mutex);
+		thread_join(&pStream->Thread);
+		thread_cond_destroy(&pStream->Changed);
+		thread_mutex_destroy(&pStream->Mutex);
+	}
+	if( 0 != fclose(pStream->pFile) ){
+		pStream->Error = 1;
+	}
+	free(pStream->Buffer[0]);
+	free(pStream->Buffer[1]);
+	return pStream->Error ? -1 : 0;
+}
+
+//--------------------------------------------------------
+// A new spill file name in the spill directory
+//--------------------------------------------------------
+static void external_spill_path(struct exact_mass_external *pExternal, char *path, const char *tag){
+	static volatile long serial = 0;
+
+	sprintf(path, "%.900s/isoDalton_%lx_%ld.%s", (NULL == pExternal->Directory) ? "." : pExternal->Directory, (unsigned long)time(NULL) ^ (unsigned long)(size_t)pExternal, thread_atomic_add(&serial, 1), tag);
+}
+
+//--------------------------------------------------------
+// Probabilities
+//--------------------------------------------------------
+static double external_linear(double prob, int log10flag){
+	return (1 == log10flag) ? pow(10,prob) : prob;
+}
+
+// log10 probability, -DBL_MAX for a zero probability
+static double external_key(double prob, int log10flag){
+	if( 1 != log10flag ){
+		prob = (prob > 0) ? log10(prob) : -DBL_MAX;
+	}
+	return (prob > -DBL_MAX) ? prob : -DBL_MAX;
+}
+
+static void external_stats_init(struct external_stats *pStats){
+	pStats->Total  = 0;
+	pStats->Sum    = 0;
+	pStats->MinKey = DBL_MAX;
+	pStats->MaxKey = -DBL_MAX;
+}
+
+static void external_emit(struct external_work *pWork, struct external_stream *pStream, struct external_stats *pStats, const struct external_state *pState){
+	double key;
+
+	external_write(pStream, pState);
+	key = external_key(pState->Prob, pWork->log10flag);
+	pStats->Total++;
+	pStats->Sum += external_linear(pState->Prob, pWork->log10flag);
+	if( pStats->MinKey > key ){
+		pStats->MinKey = key;
+	}
+	if( pStats->MaxKey < key ){
+		pStats->MaxKey = key;
+	}
+}
+
+static int external_write_one(struct external_work *pWork, const char *path, const struct external_state *pState, struct external_stats *pStats){
+	struct external_stream Out;
+
+	if( 0 != external_open(&Out, path, 1, 0, 0, 1, 0) ){
+		return -1;
+	}
+	external_stats_init(pStats);
+	external_emit(pWork, &Out, pStats, pState);
+	pWork->pExternal->SpillBytes += sizeof(struct external_state);
+	return external_close(&Out);
+}
+
+//--------------------------------------------------------
+// Runs: the states of state_path, RunStates/Nisotopes at
+// a time, are expanded by the isotopes, sorted by mass
+// and combined, and appended to run_path
+//--------------------------------------------------------
+static int external_runs(struct external_work *pWork, const char *state_path, external_uint64 Nstate1, int Nisotopes, double *isotope_mass, double *isotope_fraction, const char *run_path, external_uint64 *RunStart, external_uint64 *RunCount, int *pNruns, double *stage_seconds){
+	struct external_stream In;
+	struct external_stream Out;
+	struct external_state state;
+	external_uint64 offset;
+	double mass1,prob1;
+	double time0,time1;
+	int chunk;
+	int Nchunk;
+	int Nstate2;
+	int state1_index,state2_index,isotope_index;
+	int status;
+
+	if( 0 != external_open(&In, state_path, 0, 0, Nstate1, EXTERNAL_BUFFER_STATES, 1) ){
+		return -1;
+	}
+	if( 0 != external_open(&Out, run_path, 1, 0, 0, EXTERNAL_BUFFER_STATES, 1) ){
+		external_close(&In);
+		return -1;
+	}
+	chunk   = pWork->RunStates/Nisotopes;
+	offset  = 0;
+	*pNruns = 0;
+	for(;;){
+		time0  = thread_wall_seconds();
+		Nchunk = 0;
+		while( (Nchunk < chunk) && external_read(&In, &state) ){
+			pWork->Mass[Nchunk] = state.Mass;
+			pWork->Prob[Nchunk] = state.Prob;
+			Nchunk++;
+		}
+		if( 0 == Nchunk ){
+			break;
+		}
+		//---------------------------------------------
+		// Expand in place from the last state down as
+		// isoDalton_trellis_step does
+		//---------------------------------------------
+		Nstate2 = Nchunk*Nisotopes;
+		state2_index = Nstate2-1;
+		for(state1_index=Nchunk-1; state1_index>=0; state1_index--){
+			mass1 = pWork->Mass[state1_index];
+			prob1 = pWork->Prob[state1_index];
+			for(isotope_index=Nisotopes-1; isotope_index>=0; isotope_index--){
+				pWork->Mass[state2_index] = mass1 + isotope_mass[isotope_index];
+				if(1 == pWork->log10flag ){
+					pWork->Prob[state2_index] = log10(  pow(10,prob1) * isotope_fraction[isotope_index]  );
+				}else{
+					pWork->Prob[state2_index] = prob1 * isotope_fraction[isotope_index];
+				}
+				state2_index--;
+			}
+		}
+		time1 = thread_wall_seconds();
+		stage_seconds[TRACE_STAGE_EXPAND] += time1 - time0;
+		time0 = time1;
+		heapsort_2dbl_up(Nstate2, pWork->Mass, pWork->Prob);
+		time1 = thread_wall_seconds();
+		stage_seconds[TRACE_STAGE_MASS_SORT] += time1 - time0;
+		time0 = time1;
+		isoDalton_combine_masses(&Nstate2, pWork->Mass, pWork->Prob, pWork->log10flag);
+		for(state2_index=0; state2_index<Nstate2; state2_index++){
+			state.Mass = pWork->Mass[state2_index];
+			state.Prob = pWork->Prob[state2_index];
+			external_write(&Out, &state);
+		}
+		RunStart[*pNruns] = offset;
+		RunCount[*pNruns] = Nstate2;
+		offset += Nstate2;
+		(*pNruns)++;
+		stage_seconds[TRACE_STAGE_COMBINE] += thread_wall_seconds() - time0;
+	}
+	status  = external_close(&In);
+	status |= external_close(&Out);
+	pWork->pExternal->SpillBytes += offset*sizeof(struct external_state);
+	return status;
+}
+
+//--------------------------------------------------------
+// Min heap of merged runs on the mass of their next state
+//--------------------------------------------------------
+static void external_heap_down(int *Heap, int Nheap, struct external_state *Head, int index){
+	int child;
+	int run;
+
+	run = Heap[index];
+	while( (child = 2*index+1) < Nheap ){
+		if( (child+1 < Nheap) && (Head[Heap[child+1]].Mass < Head[Heap[child]].Mass) ){
+			child++;
+		}
+		if( Head[run].Mass <= Head[Heap[child]].Mass ){
+			break;
+		}
+		Heap[index] = Heap[child];
+		index = child;
+	}
+	Heap[index] = run;
+}
+
+//--------------------------------------------------------
+// Merge Nruns runs of run_path by mass into pOut and
+// combine equal masses as isoDalton_combine_masses does
+//--------------------------------------------------------
+static int external_merge(struct external_work *pWork, const char *run_path, external_uint64 *RunStart, external_uint64 *RunCount, int Nruns, struct external_stream *pOut, struct external_stats *pStats){
+	struct external_stream Run[EXTERNAL_MERGE_WAYS];
+	struct external_state Head[EXTERNAL_MERGE_WAYS];
+	struct external_state state;
+	struct external_state group;
+	int Heap[EXTERNAL_MERGE_WAYS];
+	int Nheap;
+	int Ngroup;
+	int run_index;
+	int status;
+	double start_mass;
+	double msum,psum;
+
+	status = 0;
+	Nheap  = 0;
+	for(run_index=0; run_index<Nruns; run_index++){
+		if( 0 != external_open(&Run[run_index], run_path, 0, RunStart[run_index], RunCount[run_index], EXTERNAL_MERGE_STATES, 0) ){
+			while( run_index-- > 0 ){
+				external_close(&Run[run_index]);
+			}
+			return -1;
+		}
+		if( external_read(&Run[run_index], &Head[run_index]) ){
+			Heap[Nheap++] = run_index;
+		}
+	}
+	for(run_index=Nheap/2-1; run_index>=0; run_index--){
+		external_heap_down(Heap, Nheap, Head, run_index);
+	}
+
+	Ngroup     = 0;
+	start_mass = 0;
+	msum       = 0;
+	psum       = 0;
+	while( 0 < Nheap ){
+		run_index = Heap[0];
+		state     = Head[run_index];
+		if( external_read(&Run[run_index], &Head[run_index]) ){
+			external_heap_down(Heap, Nheap, Head, 0);
+		}else{
+			Heap[0] = Heap[--Nheap];
+			if( 0 < Nheap ){
+				external_heap_down(Heap, Nheap, Head, 0);
+			}
+		}
+		if( (0 < Ngroup) && (fabs(state.Mass-start_mass) <= start_mass/pow(10.0,15.0)) ){
+			msum += state.Mass;
+			psum += external_linear(state.Prob, pWork->log10flag);
+			Ngroup++;
+			continue;
+		}
+		if( 1 < Ngroup ){
+			group.Mass = msum/(double)Ngroup;
+			group.Prob = (1 == pWork->log10flag) ? log10(psum) : psum;
+		}
+		if( 0 < Ngroup ){
+			external_emit(pWork, pOut, pStats, &group);
+		}
+		group      = state;
+		start_mass = state.Mass;
+		msum       = state.Mass;
+		psum       = external_linear(state.Prob, pWork->log10flag);
+		Ngroup     = 1;
+	}
+	if( 1 < Ngroup ){
+		group.Mass = msum/(double)Ngroup;
+		group.Prob = (1 == pWork->log10flag) ? log10(psum) : psum;
+	}
+	if( 0 < Ngroup ){
+		external_emit(pWork, pOut, pStats, &group);
+	}
+	for(run_index=0; run_index<Nruns; run_index++){
+		status |= external_close(&Run[run_index]);
+	}
+	return status;
+}
+
+//--------------------------------------------------------
+// Merge the runs into out_path, EXTERNAL_MERGE_WAYS at a
+// time with intermediate run files while there are more
+//--------------------------------------------------------
+static int external_merge_all(struct external_work *pWork, char *run_path, external_uint64 *RunStart, external_uint64 *RunCount, int Nruns, const char *out_path, struct external_stats *pStats){
+	struct external_stream Out;
+	struct external_stats Pass;
+	char pass_path[EXTERNAL_PATH_MAX];
+	external_uint64 offset;
+	int first;
+	int Nmerged;
+	int Nnew;
+	int status;
+
+	while( Nruns > EXTERNAL_MERGE_WAYS ){
+		external_spill_path(pWork->pExternal, pass_path, "run");
+		if( 0 != external_open(&Out, pass_path, 1, 0, 0, EXTERNAL_BUFFER_STATES, 1) ){
+			return -1;
+		}
+		status = 0;
+		offset = 0;
+		Nnew   = 0;
+		for(first=0; first<Nruns; first+=EXTERNAL_MERGE_WAYS){
+			Nmerged = (Nruns-first < EXTERNAL_MERGE_WAYS) ? Nruns-first : EXTERNAL_MERGE_WAYS;
+			external_stats_init(&Pass);
+			status |= external_merge(pWork, run_path, &RunStart[first], &RunCount[first], Nmerged, &Out, &Pass);
+			RunStart[Nnew] = offset;   // Nnew <= first, so no run still to merge is overwritten
+			RunCount[Nnew] = Pass.Total;
+			offset += Pass.Total;
+			Nnew++;
+		}
+		status |= external_close(&Out);
+		remove(run_path);
+		strcpy(run_path, pass_path);
+		pWork->pExternal->SpillBytes += offset*sizeof(struct external_state);
+		pWork->pExternal->MergePasses++;
+		Nruns = Nnew;
+		if( 0 != status ){
+			return -1;
+		}
+	}
+	if( 0 != external_open(&Out, out_path, 1, 0, 0, EXTERNAL_BUFFER_STATES, 1) ){
+		return -1;
+	}
+	external_stats_init(pStats);
+	status  = external_merge(pWork, run_path, RunStart, RunCount, Nruns, &Out, pStats);
+	status |= external_close(&Out);
+	pWork->pExternal->SpillBytes += pStats->Total*sizeof(struct external_state);
+	return status;
+}
+
+//--------------------------------------------------------
+// Class of a log10 probability in a histogram: 0 below
+// Low, 1 to EXTERNAL_HISTOGRAM_BINS the bins and one more
+// above them
+//--------------------------------------------------------
+static int external_class(double key, double Low, double Width){
+	double position;
+
+	if( key < Low ){
+		return 0;
+	}
+	position = (key-Low)/Width;
+	if( !(position < EXTERNAL_HISTOGRAM_BINS) ){
+		return EXTERNAL_HISTOGRAM_BINS+1;
+	}
+	return 1 + (int)position;
+}
+
+static void external_discard(double prob, int log10flag, double *pDiscarded, double *pMaxDiscarded){
+	prob = external_linear(prob, log10flag);
+	*pDiscarded += prob;
+	if( *pMaxDiscarded < prob ){
+		*pMaxDiscarded = prob;
+	}
+}
+
+//--------------------------------------------------------
+// Write the Nkeep most probable of the pIn->Total states
+// of in_path to out_path.  Histogram passes narrow the
+// log10 probability of the Nkeep-th state to one bin; the
+// states above it are kept, and the states of the bin are
+// sorted in memory (or, if there are too many to hold and
+// the bin cannot be narrowed, kept in file order).
+//--------------------------------------------------------
+static int external_select(struct external_work *pWork, const char *in_path, struct external_stats *pIn, external_uint64 Nkeep, const char *out_path, struct external_stats *pOut, double *pDiscarded, double *pMaxDiscarded){
+	external_uint64 Histogram[EXTERNAL_HISTOGRAM_BINS+2];
+	struct external_stream In;
+	struct external_stream Out;
+	struct external_state state;
+	struct external_state buffered;
+	external_uint64 above;
+	external_uint64 taken;
+	double Low,Width;
+	int boundary;
+	int in_memory;
+	int Nboundary;
+	int pass;
+	int state_index;
+	int status;
+	int class_index;
+
+	Low      = pIn->MinKey;
+	Width    = (pIn->MaxKey - pIn->MinKey)/EXTERNAL_HISTOGRAM_BINS;
+	boundary = EXTERNAL_HISTOGRAM_BINS+1;
+	above    = 0;
+	for(pass=0; pass<EXTERNAL_SELECT_PASSES; pass++){
+		memset(Histogram, 0, sizeof(Histogram));
+		if( 0 != external_open(&In, in_path, 0, 0, pIn->Total, EXTERNAL_BUFFER_STATES, 1) ){
+			return -1;
+		}
+		while( external_read(&In, &state) ){
+			Histogram[external_class(external_key(state.Prob, pWork->log10flag), Low, Width)]++;
+		}
+		if( 0 != external_close(&In) ){
+			return -1;
+		}
+		pWork->pExternal->SelectPasses++;
+
+		//-----------------------------------------------
+		// The boundary is the class of the Nkeep-th
+		// state; above counts the states over it
+		//-----------------------------------------------
+		above = 0;
+		for(boundary=EXTERNAL_HISTOGRAM_BINS+1; boundary>0; boundary--){
+			if( above + Histogram[boundary] >= Nkeep ){
+				break;
+			}
+			above += Histogram[boundary];
+		}
+		if( (Histogram[boundary] <= (external_uint64)pWork->RunStates) || (0 == boundary) || (EXTERNAL_HISTOGRAM_BINS+1 == boundary) ){
+			break;
+		}
+		if( (Width/EXTERNAL_HISTOGRAM_BINS <= 0) || (Width/EXTERNAL_HISTOGRAM_BINS <= fabs(Low)*DBL_EPSILON) || (pass+1 == EXTERNAL_SELECT_PASSES) ){
+			break;
+		}
+		Low   += (boundary-1)*Width;
+		Width /= EXTERNAL_HISTOGRAM_BINS;
+	}
+
+	//-----------------------------------------------
+	// Keep the states above the boundary class and
+	// the most probable states of the class
+	//-----------------------------------------------
+	if( 0 != external_open(&In, in_path, 0, 0, pIn->Total, EXTERNAL_BUFFER_STATES, 1) ){
+		return -1;
+	}
+	if( 0 != external_open(&Out, out_path, 1, 0, 0, EXTERNAL_BUFFER_STATES, 1) ){
+		external_close(&In);
+		return -1;
+	}
+	external_stats_init(pOut);
+	in_memory = 1;
+	Nboundary = 0;
+	taken     = 0;
+	while( external_read(&In, &state) ){
+		class_index = external_class(external_key(state.Prob, pWork->log10flag), Low, Width);
+		if( class_index > boundary ){
+			external_emit(pWork, &Out, pOut, &state);
+		}else if( class_index < boundary ){
+			external_discard(state.Prob, pWork->log10flag, pDiscarded, pMaxDiscarded);
+		}else if( in_memory && (Nboundary < pWork->RunStates) ){
+			pWork->Mass[Nboundary] = state.Mass;
+			pWork->Prob[Nboundary] = state.Prob;
+			Nboundary++;
+		}else{
+			//-----------------------------------------
+			// Too many to sort: the buffered states
+			// and the rest are taken in file order
+			//-----------------------------------------
+			if( in_memory ){
+				for(state_index=0; state_index<Nboundary; state_index++){
+					if( taken < Nkeep-above ){
+						buffered.Mass = pWork->Mass[state_index];
+						buffered.Prob = pWork->Prob[state_index];
+						external_emit(pWork, &Out, pOut, &buffered);
+						taken++;
+					}else{
+						external_discard(pWork->Prob[state_index], pWork->log10flag, pDiscarded, pMaxDiscarded);
+					}
+				}
+				in_memory = 0;
+				Nboundary = 0;
+			}
+			if( taken < Nkeep-above ){
+				external_emit(pWork, &Out, pOut, &state);
+				taken++;
+			}else{
+				external_discard(state.Prob, pWork->log10flag, pDiscarded, pMaxDiscarded);
+			}
+		}
+	}
+	if( in_memory ){
+		heapsort_2dbl_down(Nboundary, pWork->Prob, pWork->Mass);
+		for(state_index=0; state_index<Nboundary; state_index++){
+			if( taken < Nkeep-above ){
+				state.Mass = pWork->Mass[state_index];
+				state.Prob = pWork->Prob[state_index];
+				external_emit(pWork, &Out, pOut, &state);
+				taken++;
+			}else{
+				external_discard(pWork->Prob[state_index], pWork->log10flag, pDiscarded, pMaxDiscarded);
+			}
+		}
+	}
+	status  = external_close(&In);
+	status |= external_close(&Out);
+	pWork->pExternal->SpillBytes += pOut->Total*sizeof(struct external_state);
+	return status;
+}
+
+//--------------------------------------------------------
+// Rename a spill file, or copy it if it cannot be renamed
+// (e.g. the checkpoint is on another file system)
+//--------------------------------------------------------
+static int external_move(struct external_work *pWork, const char *from_path, external_uint64 Nstates, const char *to_path){
+	struct external_stream In;
+	struct external_stream Out;
+	struct external_state state;
+	int status;
+
+	remove(to_path);
+	if( 0 == rename(from_path, to_path) ){
+		return 0;
+	}
+	if( 0 != external_open(&In, from_path, 0, 0, Nstates, EXTERNAL_BUFFER_STATES, 1) ){
+		return -1;
+	}
+	if( 0 != external_open(&Out, to_path, 1, 0, 0, EXTERNAL_BUFFER_STATES, 1) ){
+		external_close(&In);
+		return -1;
+	}
+	while( external_read(&In, &state) ){
+		external_write(&Out, &state);
+	}
+	status  = external_close(&In);
+	status |= external_close(&Out);
+	pWork->pExternal->SpillBytes += Nstates*sizeof(struct external_state);
+	remove(from_path);
+	return status;
+}
+
+//--------------------------------------------------------
+// Add one atom: the pStates->Total states of state_path
+// become the pNext->Total states of next_path.  Returns
+// 0 or -1.
+//--------------------------------------------------------
+static int external_step(struct external_work *pWork, const char *state_path, struct external_stats *pStates, int Nisotopes, double *isotope_mass, double *isotope_fraction, int Mstates, const char *next_path, struct external_stats *pNext, external_uint64 *pCombined, double *pDiscarded, double *pMaxDiscarded, double *stage_seconds){
+	struct external_stats Merged;
+	char run_path[EXTERNAL_PATH_MAX];
+	char merged_path[EXTERNAL_PATH_MAX];
+	external_uint64 *RunStart;
+	external_uint64 *RunCount;
+	external_uint64 chunk;
+	double time0;
+	int Nruns;
+	int status;
+
+	chunk    = pWork->RunStates/Nisotopes;
+	Nruns    = (int)((pStates->Total + chunk - 1)/chunk);
+	RunStart = (external_uint64 *)malloc((Nruns+1)*sizeof(external_uint64));
+	RunCount = (external_uint64 *)malloc((Nruns+1)*sizeof(external_uint64));
+	if( (NULL == RunStart) || (NULL == RunCount) ){
+		data_error("Error : could not allocate the index of %d runs\n",Nruns);
+		free(RunStart);
+		free(RunCount);
+		return -1;
+	}
+	external_spill_path(pWork->pExternal, run_path, "run");
+	external_spill_path(pWork->pExternal, merged_path, "merge");
+	status = external_runs(pWork, state_path, pStates->Total, Nisotopes, isotope_mass, isotope_fraction, run_path, RunStart, RunCount, &Nruns, stage_seconds);
+	if( pWork->pExternal->LargestRunTotal < Nruns ){
+		pWork->pExternal->LargestRunTotal = Nruns;
+	}
+	time0 = thread_wall_seconds();
+	if( 0 == status ){
+		status = external_merge_all(pWork, run_path, RunStart, RunCount, Nruns, merged_path, &Merged);
+	}
+	remove(run_path);
+	free(RunStart);
+	free(RunCount);
+	stage_seconds[TRACE_STAGE_COMBINE] += thread_wall_seconds() - time0;
+	if( 0 != status ){
+		remove(merged_path);
+		return -1;
+	}
+
+	//-----------------------------------------------
+	// Keep the Mstates most probable states
+	//-----------------------------------------------
+	time0          = thread_wall_seconds();
+	*pCombined     = Merged.Total;
+	*pDiscarded    = 0;
+	*pMaxDiscarded = 0;
+	if( Merged.Total > (external_uint64)Mstates ){
+		status = external_select(pWork, merged_path, &Merged, Mstates, next_path, pNext, pDiscarded, pMaxDiscarded);
+		remove(merged_path);
+		stage_seconds[TRACE_STAGE_PROB_SORT] += thread_wall_seconds() - time0;
+	}else{
+		*pNext = Merged;
+		status = external_move(pWork, merged_path, Merged.Total, next_path);
+		stage_seconds[TRACE_STAGE_TRUNCATE] += thread_wall_seconds() - time0;
+	}
+	return status;
+}
+
+//--------------------------------------------------------
+// 64 bit FNV-1a hash of what the states depend on: the
+// trellis elements and their isotopes, Mstates and
+// log10flag
+//--------------------------------------------------------
+static external_uint64 external_hash(external_uint64 hash, const void *data, size_t Nbytes){
+	const unsigned char *pByte;
+	external_uint64 prime;
+	size_t byte_index;
+
+	prime = 1;
+	prime = (prime << 40) | 0x1B3;
+	pByte = (const unsigned char *)data;
+	for(byte_index=0; byte_index<Nbytes; byte_index++){
+		hash ^= pByte[byte_index];
+		hash *= prime;
+	}
+	return hash;
+}
+
+static external_uint64 external_identity(struct trellis_plan *pPlan, int Mstates, int log10flag){
+	external_uint64 hash;
+	int index1,index2,index3;
+
+	hash = 0xCBF29CE4;
+	hash = (hash << 32) | 0x84222325;
+	hash = external_hash(hash, &pPlan->ElementTotal, sizeof(int));
+	for(index1=0; index1<pPlan->ElementTotal; index1++){
+		hash = external_hash(hash, &pPlan->Element[index1]->AtomicNumber, sizeof(int));
+		hash = external_hash(hash, &pPlan->AtomCount[index1], sizeof(int));
+		for(index2=0; index2<pPlan->Element[index1]->NonzeroIsotopeTotal; index2++){
+			index3 = pPlan->Element[index1]->NonzeroIsotopeIndex[index2];
+			hash = external_hash(hash, &pPlan->Element[index1]->Isotope[index3]->AtomicMass, sizeof(double));
+			hash = external_hash(hash, &pPlan->Element[index1]->Isotope[index3]->CompositionFraction, sizeof(double));
+		}
+	}
+	hash = external_hash(hash, &Mstates, sizeof(int));
+	hash = external_hash(hash, &log10flag, sizeof(int));
+	return hash;
+}
+
+//--------------------------------------------------------
+// Checkpoint file.  The new file is written next to the
+// old one and renamed over it.
+//--------------------------------------------------------
+static int external_checkpoint_write(struct exact_mass_external *pExternal, struct external_checkpoint *pCheckpoint){
+	char tmp_path[EXTERNAL_PATH_MAX];
+	FILE *pFile;
+	int status;
+
+	sprintf(tmp_path, "%.1000s.tmp", pExternal->Checkpoint);
+	pFile = fopen(tmp_path, "wb");
+	if( NULL == pFile ){
+		data_error("Error : could not write checkpoint %s\n",tmp_path);
+		return -1;
+	}
+	status = (1 == fwrite(pCheckpoint, sizeof(struct external_checkpoint), 1, pFile)) ? 0 : -1;
+	if( 0 != fclose(pFile) ){
+		status = -1;
+	}
+	remove(pExternal->Checkpoint);
+	if( (0 != status) || (0 != rename(tmp_path, pExternal->Checkpoint)) ){
+		data_error("Error : could not write checkpoint %s\n",pExternal->Checkpoint);
+		remove(tmp_path);
+		return -1;
+	}
+	return 0;
+}
+
+// Returns 0 if the checkpoint is of this computation and its states file is there
+static int external_checkpoint_read(struct exact_mass_external *pExternal, external_uint64 identity, struct external_checkpoint *pCheckpoint){
+	FILE *pFile;
+	int status;
+
+	pFile = fopen(pExternal->Checkpoint, "rb");
+	if( NULL == pFile ){
+		return -1;
+	}
+	status = (1 == fread(pCheckpoint, sizeof(struct external_checkpoint), 1, pFile)) ? 0 : -1;
+	fclose(pFile);
+	if( (0 != status) || (0 != memcmp(pCheckpoint->Magic, EXTERNAL_CHECKPOINT_MAGIC, 8)) || (identity != pCheckpoint->Identity) ){
+		return -1;
+	}
+	pCheckpoint->StatePath[EXTERNAL_PATH_MAX-1] = 0;
+	pFile = fopen(pCheckpoint->StatePath, "rb");
+	if( NULL == pFile ){
+		return -1;
+	}
+	fclose(pFile);
+	return 0;
+}
+
+static void external_state_path(struct exact_mass_external *pExternal, char *path, int parity){
+	if( NULL == pExternal->Checkpoint ){
+		external_spill_path(pExternal, path, "states");
+	}else{
+		sprintf(path, "%.1000s.states%d", pExternal->Checkpoint, parity);
+	}
+}
+
+//--------------------------------------------------------
+// Out of core options (isoDalton_external.h).  Directory
+// and Checkpoint are not copied.
+//--------------------------------------------------------
+void isoDalton_external_init(struct exact_mass_external *pExternal, const char *Directory, double RunBytes, const char *Checkpoint){
+	pExternal->Directory       = Directory;
+	pExternal->RunBytes        = RunBytes;
+	pExternal->Checkpoint      = Checkpoint;
+	pExternal->ResultStates    = 0;
+	pExternal->Resumed         = 0;
+	pExternal->Failed          = 0;
+	pExternal->PeakBytes       = 0;
+	pExternal->SpillBytes      = 0;
+	pExternal->LargestStep     = 0;
+	pExternal->LargestRunTotal = 0;
+	pExternal->MergePasses     = 0;
+	pExternal->SelectPasses    = 0;
+}
+
+//--------------------------------------------------------
+// The trellis of a planned molecule with the states in
+// spill files (pReports->pExternal).  Mstates states are
+// kept and the most probable Mcapacity (or ResultStates)
+// are written to the result.  Returns 0, or -1 if the
+// trellis was stopped by the loss budget or a spill file
+// failed.
+//--------------------------------------------------------
+int isoDalton_external_trellis(struct trellis_plan *pPlan, int Mstates, int Mcapacity, struct istates_info *pisostates, int log10flag, struct exact_mass_reports *pReports, int stop_over_budget, double time_start){
+	struct exact_mass_external *pExternal;
+	struct exact_mass_trace *pTrace;
+	struct exact_mass_loss *pLoss;
+	struct exact_mass_memory *pMemory;
+	struct external_work Work;
+	struct external_checkpoint Checkpoint;
+	struct external_stats States;
+	struct external_stats Next;
+	struct external_stats Result;
+	struct external_stream In;
+	struct external_state state;
+	char state_path[EXTERNAL_PATH_MAX];
+	char next_path[EXTERNAL_PATH_MAX];
+	char result_path[EXTERNAL_PATH_MAX];
+	external_uint64 Ncombined;
+	external_uint64 Ngenerated;
+	double *isotope_mass;
+	double *isotope_fraction;
+	double stage_seconds[TRACE_STAGE_TOTAL];
+	double io_bytes;
+	double run_states;
+	double discarded;
+	double prob_state;
+	double unused_discarded;
+	double unused_max;
+	double time0;
+	int Natoms;
+	int Nisotopes;
+	int Nvalid;
+	int index1,index2,index3;
+	int start_element;
+	int start_atom;
+	int trace_element;
+	int parity;
+	int aborted;
+	int failed;
+	int status;
+
+	pExternal = pReports->pExternal;
+	pTrace    = pReports->pTrace;
+	pLoss     = pReports->pLoss;
+	pMemory   = pReports->pMemory;
+	pExternal->Resumed         = 0;
+	pExternal->Failed          = 0;
+	pExternal->SpillBytes      = 0;
+	pExternal->LargestStep     = 0;
+	pExternal->LargestRunTotal = 0;
+	pExternal->MergePasses     = 0;
+	pExternal->SelectPasses    = 0;
+	if( (0 < pExternal->ResultStates) && (pExternal->ResultStates < Mcapacity) ){
+		Mcapacity = pExternal->ResultStates;
+	}
+	trace_element = 0;
+	aborted       = 0;
+	failed        = 0;
+
+	//---------------------------------------------------------
+	// The run buffer takes what memory the I/O buffers leave
+	//---------------------------------------------------------
+	io_bytes   = (double)(EXTERNAL_MERGE_WAYS*EXTERNAL_MERGE_STATES + 2*EXTERNAL_BUFFER_STATES)*sizeof(struct external_state);
+	run_states = pExternal->RunBytes;
+	if( (0 >= run_states) && (NULL != pMemory) && (0 < pMemory->Budget) ){
+		run_states = pMemory->Budget - io_bytes;
+	}
+	if( 0 >= run_states ){
+		run_states = EXTERNAL_DEFAULT_RUN_BYTES;
+	}
+	run_states /= 2*sizeof(double);
+	if( run_states < (double)EXTERNAL_MIN_RUN_STATES*pPlan->MaxIsotopes ){
+		run_states = (double)EXTERNAL_MIN_RUN_STATES*pPlan->MaxIsotopes;
+	}
+	Work.pExternal   = pExternal;
+	Work.log10flag   = log10flag;
+	Work.RunStates   = (run_states > (double)INT_MAX) ? INT_MAX : (int)run_states;
+	Work.Mass        = (double *)malloc((size_t)Work.RunStates*sizeof(double));
+	Work.Prob        = (double *)malloc((size_t)Work.RunStates*sizeof(double));
+	isotope_mass     = (double *)malloc(pPlan->MaxIsotopes*sizeof(double));
+	isotope_fraction = (double *)malloc(pPlan->MaxIsotopes*sizeof(double));
+	pExternal->PeakBytes = 2.0*(double)Work.RunStates*sizeof(double) + io_bytes;
+	if( NULL != pMemory ){
+		pMemory->RequestedBytes = pExternal->PeakBytes;
+		pMemory->PeakBytes      = pExternal->PeakBytes;
+		pMemory->Mstates        = Mstates;
+		pMemory->Fitted         = 0;
+		pMemory->Refused        = 0;
+	}
+	if( (NULL == Work.Mass) || (NULL == Work.Prob) || (NULL == isotope_mass) || (NULL == isotope_fraction) ){
+		data_error("Error : could not allocate a run of %d states\n",Work.RunStates);
+		failed = 1;
+	}
+
+	//---------------------------------------------------------
+	// Start from the checkpoint or from the empty molecule
+	//---------------------------------------------------------
+	start_element = 0;
+	start_atom    = 0;
+	parity        = 0;
+	state_path[0] = 0;
+	if( (0 == failed) && (NULL != pExternal->Checkpoint) && (0 == external_checkpoint_read(pExternal, external_identity(pPlan, Mstates, log10flag), &Checkpoint)) ){
+		strcpy(state_path, Checkpoint.StatePath);
+		States        = Checkpoint.States;
+		start_element = Checkpoint.Element;
+		start_atom    = Checkpoint.Atom;
+		parity        = (state_path[strlen(state_path)-1] == '1') ? 1 : 0;
+		pExternal->Resumed = 1;
+		data_message("Resuming %s at element %d atom %d\n",pExternal->Checkpoint,start_element,start_atom);
+	}else if( 0 == failed ){
+		memset(&Checkpoint, 0, sizeof(Checkpoint));
+		memcpy(Checkpoint.Magic, EXTERNAL_CHECKPOINT_MAGIC, 8);
+		Checkpoint.Identity = external_identity(pPlan, Mstates, log10flag);
+		external_state_path(pExternal, state_path, parity);
+		state.Mass = 0;
+		state.Prob = (1 == log10flag) ? 0 : 1;
+		if( 0 != external_write_one(&Work, state_path, &state, &States) ){
+			failed = 1;
+		}
+	}
+	if( (NULL != pLoss) && (0 == failed) ){
+		for(index1=0; index1<start_element; index1++){
+			pLoss->Element[pLoss->ElementTotal].AtomicNumber = pPlan->Element[index1]->AtomicNumber;
+			pLoss->Element[pLoss->ElementTotal].Discarded    = Checkpoint.ElementDiscarded[index1];
+			pLoss->Element[pLoss->ElementTotal].MaxDiscarded = Checkpoint.ElementMaxDiscarded[index1];
+			pLoss->ElementTotal++;
+		}
+	}
+
+	time0 = thread_wall_seconds();
+	if( NULL != pTrace ){
+		pTrace->SetupSeconds = time0 - time_start;
+	}
+	for(index1=start_element; (index1<pPlan->ElementTotal) && (0 == aborted) && (0 == failed); index1++){
+		Natoms    = pPlan->AtomCount[index1];
+		Nisotopes = pPlan->Element[index1]->NonzeroIsotopeTotal;
+		for(index2=0; index2<Nisotopes; index2++){
+			index3 = pPlan->Element[index1]->NonzeroIsotopeIndex[index2];
+			isotope_mass[index2]     = pPlan->Element[index1]->Isotope[index3]->AtomicMass;
+			isotope_fraction[index2] = pPlan->Element[index1]->Isotope[index3]->CompositionFraction;
+		}
+		if( NULL != pTrace ){
+			trace_element = isoDalton_trace_add_element(pTrace, pPlan->Element[index1]->AtomicNumber, Natoms, Nisotopes);
+		}
+		if( NULL != pLoss ){
+			pLoss->Element[pLoss->ElementTotal].AtomicNumber = pPlan->Element[index1]->AtomicNumber;
+			pLoss->Element[pLoss->ElementTotal].Discarded    = Checkpoint.ElementDiscarded[index1];
+			pLoss->Element[pLoss->ElementTotal].MaxDiscarded = Checkpoint.ElementMaxDiscarded[index1];
+			pLoss->ElementTotal++;
+		}
+		for(index2=(index1 == start_element) ? start_atom : 0; (index2<Natoms) && (0 == aborted); index2++){
+			for(index3=0; index3<TRACE_STAGE_TOTAL; index3++){
+				stage_seconds[index3] = 0;
+			}
+			Ngenerated = States.Total*Nisotopes;
+			if( pExternal->LargestStep < Ngenerated ){
+				pExternal->LargestStep = Ngenerated;
+			}
+			external_state_path(pExternal, next_path, parity^1);
+			status = external_step(&Work, state_path, &States, Nisotopes, isotope_mass, isotope_fraction, Mstates, next_path, &Next, &Ncombined, &discarded, &prob_state, stage_seconds);
+			if( 0 != status ){
+				remove(next_path);
+				failed = 1;
+				break;
+			}
+
+			//---------------------------------------------
+			// The discarded probability, kept with the
+			// checkpoint so a resumed run reports it all
+			//---------------------------------------------
+			if( Ncombined > (external_uint64)Mstates ){
+				Checkpoint.ElementDiscarded[index1] += discarded;
+				if( Checkpoint.ElementMaxDiscarded[index1] < prob_state ){
+					Checkpoint.ElementMaxDiscarded[index1] = prob_state;
+				}
+				Checkpoint.Discarded += discarded;
+				if( Checkpoint.MaxDiscarded < prob_state ){
+					Checkpoint.MaxDiscarded = prob_state;
+				}
+				Checkpoint.TruncationTotal++;
+			}
+			if( NULL != pLoss ){
+				pLoss->Element[pLoss->ElementTotal-1].Discarded    = Checkpoint.ElementDiscarded[index1];
+				pLoss->Element[pLoss->ElementTotal-1].MaxDiscarded = Checkpoint.ElementMaxDiscarded[index1];
+				pLoss->Discarded       = Checkpoint.Discarded;
+				pLoss->MaxDiscarded    = Checkpoint.MaxDiscarded;
+				pLoss->TruncationTotal = Checkpoint.TruncationTotal;
+				if( (0 < pLoss->Budget) && (pLoss->Discarded > pLoss->Budget) ){
+					pLoss->OverBudget = 1;
+					aborted = stop_over_budget;
+				}
+			}
+			if( NULL != pTrace ){
+				isoDalton_trace_add_step(pTrace, trace_element, index2, (Ngenerated > INT_MAX) ? INT_MAX : (int)Ngenerated, (Ncombined > INT_MAX) ? INT_MAX : (int)Ncombined, (int)Next.Total, stage_seconds);
+			}
+
+			//---------------------------------------------
+			// The next states replace the current ones
+			// once the checkpoint points at them
+			//---------------------------------------------
+			if( NULL != pExternal->Checkpoint ){
+				Checkpoint.Element = (index2+1 < Natoms) ? index1 : index1+1;
+				Checkpoint.Atom    = (index2+1 < Natoms) ? index2+1 : 0;
+				Checkpoint.States  = Next;
+				strcpy(Checkpoint.StatePath, next_path);
+				if( 0 != external_checkpoint_write(pExternal, &Checkpoint) ){
+					remove(next_path);
+					failed = 1;
+					break;
+				}
+			}
+			remove(state_path);
+			strcpy(state_path, next_path);
+			States  = Next;
+			parity ^= 1;
+		}
+	}
+	data_message("It took %8.4f seconds (wall time) to compute isotope spectra out of core\n",thread_wall_seconds()-time0);
+	data_message("Number of States = %d, %.1f MB spilled\n",Mstates,(double)pExternal->SpillBytes/1048576.0);
+
+	//---------------------------------------------------------
+	// Copy out the most probable states as
+	// isoDalton_exact_mass_core does
+	//---------------------------------------------------------
+	Nvalid = 0;
+	if( aborted && (NULL != pLoss) ){
+		pLoss->Aborted = 1;
+	}
+	if( (0 == aborted) && (0 == failed) ){
+		strcpy(result_path, state_path);
+		Result = States;
+		if( States.Total > (external_uint64)Mcapacity ){
+			unused_discarded = 0;
+			unused_max       = 0;
+			external_spill_path(pExternal, result_path, "result");
+			if( 0 != external_select(&Work, state_path, &States, Mcapacity, result_path, &Result, &unused_discarded, &unused_max) ){
+				failed = 1;
+			}
+		}
+		if( (0 == failed) && (0 == external_open(&In, result_path, 0, 0, Result.Total, EXTERNAL_BUFFER_STATES, 0)) ){
+			while( (Nvalid < Mcapacity) && external_read(&In, &state) ){
+				pisostates->mass[Nvalid] = state.Mass;
+				pisostates->prob[Nvalid] = state.Prob;
+				Nvalid++;
+			}
+			if( 0 != external_close(&In) ){
+				failed = 1;
+			}
+		}else{
+			failed = 1;
+		}
+		if( 0 != strcmp(result_path, state_path) ){
+			remove(result_path);
+		}
+		if( (NULL != pLoss) && (0 == failed) ){
+			pLoss->Retained = States.Sum;
+		}
+	}
+	if( failed ){
+		pExternal->Failed = 1;
+		Nvalid = 0;
+	}
+	heapsort_2dbl_down(Nvalid, pisostates->prob, pisostates->mass);
+	for(index1=0; index1<Mcapacity; index1++){
+		if( index1 < Nvalid ){
+			pisostates->mass[index1] += pPlan->FixedMass;
+			if(1 == log10flag ){
+				pisostates->prob[index1] += pPlan->FixedProb;
+			}else{
+				pisostates->prob[index1] *= pow(10.0,pPlan->FixedProb);
+			}
+		}else{
+			pisostates->mass[index1] = 0;
+			pisostates->prob[index1] = (1 == log10flag) ? -DBL_MAX : 0;
+		}
+	}
+	pisostates->StateTotal = Nvalid;
+
+	//---------------------------------------------------------
+	// A failed run keeps its checkpoint to be resumed
+	//---------------------------------------------------------
+	if( (0 == failed) || (NULL == pExternal->Checkpoint) ){
+		if( 0 != state_path[0] ){
+			remove(state_path);
+		}
+		if( NULL != pExternal->Checkpoint ){
+			remove(pExternal->Checkpoint);
+		}
+	}
+	free(Work.Mass);
+	free(Work.Prob);
+	free(isotope_mass);
+	free(isotope_fraction);
+	return (aborted || failed) ? -1 : 0;
+}
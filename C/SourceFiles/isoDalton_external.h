@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_external.h                                    */
+/*               Header file for isoDalton_external.cpp, the trellis     */
+/*               with its states in spill files for state sets larger    */
+/*               than memory                                             */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_EXTERNAL
+#define ISODALTON_EXTERNAL
+
+#ifdef _MSC_VER
+	typedef unsigned __int64 external_uint64;
+#else
+	#include <stdint.h>
+	typedef uint64_t         external_uint64;
+#endif
+
+//---------------------------------------------------------------------------------------------
+// Out of core trellis.  The states of a step are kept in a spill file, not in memory.  Each
+// atom is added in three sequential passes:
+//
+//   runs       the states are read a run at a time, expanded by the isotopes, sorted by mass
+//              and combined in memory, and the run is appended to a run file
+//   merge      the runs are merged by mass (EXTERNAL_MERGE_WAYS at a time, with more passes
+//              if there are more runs) and equal masses are combined as they meet
+//   selection  if more than Mstates states are left, histograms of log10 probability over
+//              the merged file find the probability of the Mstates-th state and a last pass
+//              keeps the states above it (the states of the boundary bin are sorted in memory)
+//
+// Only the run buffer (RunBytes) and the I/O buffers are in memory.  The big sequential reads
+// and writes are double buffered: a thread reads ahead or writes behind one buffer while the
+// trellis works on the other.  With a checkpoint file the states file and the position in the
+// trellis are recorded after every atom, and a computation of the same molecule, Mstates and
+// log10flag started with the same checkpoint file continues from there.
+//---------------------------------------------------------------------------------------------
+#define EXTERNAL_DEFAULT_RUN_BYTES (256.0*1048576.0)
+#define EXTERNAL_BUFFER_STATES     65536      // states of a double buffered stream buffer
+#define EXTERNAL_MERGE_STATES      4096       // states of the buffer of one merged run
+#define EXTERNAL_MERGE_WAYS        64         // runs merged at once
+#define EXTERNAL_PATH_MAX          1024
+#define EXTERNAL_CHECKPOINT_MAGIC  "isoDckp1"
+
+struct external_state {
+	double Mass;
+	double Prob;    // log10 with log10flag
+};
+
+struct exact_mass_external {
+	const char     *Directory;      // spill files go here ("." if NULL)
+	double          RunBytes;       // memory for one run, 0 = the memory budget or EXTERNAL_DEFAULT_RUN_BYTES
+	const char     *Checkpoint;     // checkpoint file, NULL = none
+	int             ResultStates;   // most probable states copied to the result, 0 = Mstates
+	int             Resumed;        // 1 = continued from the checkpoint
+	int             Failed;         // 1 = a spill file could not be written or read
+	double          PeakBytes;      // memory of the run buffer and I/O buffers
+	external_uint64 SpillBytes;     // bytes written to spill files
+	external_uint64 LargestStep;    // most states generated by one atom
+	int             LargestRunTotal;
+	int             MergePasses;    // merges of EXTERNAL_MERGE_WAYS runs before the last one
+	int             SelectPasses;   // histogram passes of the selections
+};
+
+void isoDalton_external_init(struct exact_mass_external *, const char *, double, const char *);
+int  isoDalton_external_trellis(struct trellis_plan *, int, int, struct istates_info *, int, struct exact_mass_reports *, int, double);
+
+#endif
@@ -0,0 +1,648 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_formula.cpp                                   */
+/*               Source code for a high rate molecular formula parser.   */
+/*               Element symbols are found with a perfect hash table and */
+/*               no memory is allocated while parsing.                   */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_formula.h"
+#include <limits.h>
+
+#define FORMULA_GROUP_PAREN    0
+#define FORMULA_GROUP_SEGMENT  1
+
+//--------------------------------------------------------
+// Pack a symbol of up to three characters into a key
+//--------------------------------------------------------
+static unsigned int formula_symbol_key(const char *symbol, int Nchar){
+	unsigned int key;
+	int i;
+
+	key = 0;
+	for(i=0; i<Nchar; i++){
+		key |= ((unsigned int)(unsigned char)symbol[i]) << (8*i);
+	}
+	return key;
+}
+
+static unsigned int formula_hash(unsigned int key, unsigned int multiplier){
+	return (key*multiplier) >> (32-FORMULA_HASH_BITS);
+}
+
+//--------------------------------------------------------
+// Build the symbol lookup table from the element list.
+// Returns 0 on success and -1 if no collision free hash
+// multiplier could be found.
+//--------------------------------------------------------
+int isoDalton_formula_build_table(struct element_list *pElements, struct formula_symbol_table *pTable){
+	int element_index;
+	int element_index2;
+	int slot_index;
+	int iso_index;
+	int word_index;
+	int MassNumber;
+	int Nchar;
+	int rank;
+	int collision;
+	int attempt;
+	unsigned int key;
+	unsigned int slot;
+	unsigned int multiplier;
+
+	//---------------------------------------------------
+	// Copy the symbols (the electron and elements with
+	// no symbol, i.e. atomic number 117, are skipped)
+	//---------------------------------------------------
+	for(element_index=0; element_index<ELEMENT_TOTAL; element_index++){
+		pTable->Symbol[element_index][0] = '\0';
+		if( (0 < element_index) && (NULL != pElements->Element[element_index].Symbol) ){
+			Nchar = (int)strlen(pElements->Element[element_index].Symbol);
+			if( (0 < Nchar) && (Nchar < 4) && isupper((unsigned char)pElements->Element[element_index].Symbol[0]) ){
+				strcpy(pTable->Symbol[element_index],pElements->Element[element_index].Symbol);
+			}else{
+				data_error("Warning : Symbol %s (atomic number %d) can not be used in formulas\n",pElements->Element[element_index].Symbol,element_index);
+			}
+		}
+	}
+
+	//---------------------------------------------------
+	// Mass numbers of the known isotopes (for [13C])
+	//---------------------------------------------------
+	for(element_index=0; element_index<ELEMENT_TOTAL; element_index++){
+		for(word_index=0; word_index<FORMULA_MASS_WORDS; word_index++){
+			pTable->MassNumberSet[element_index][word_index] = 0;
+		}
+		for(iso_index=0; iso_index<pElements->Element[element_index].IsotopeTotal; iso_index++){
+			MassNumber = pElements->Element[element_index].Isotope[iso_index]->MassNumber;
+			if( (0 < MassNumber) && (MassNumber < 32*FORMULA_MASS_WORDS) ){
+				pTable->MassNumberSet[element_index][MassNumber>>5] |= 1u << (MassNumber&31);
+			}
+		}
+	}
+
+	//---------------------------------------------------
+	// Alphabetical rank of each symbol (for Hill order)
+	//---------------------------------------------------
+	for(element_index=0; element_index<ELEMENT_TOTAL; element_index++){
+		rank = 0;
+		for(element_index2=0; element_index2<ELEMENT_TOTAL; element_index2++){
+			if( strcmp(pTable->Symbol[element_index2],pTable->Symbol[element_index]) < 0 ){
+				rank++;
+			}
+		}
+		pTable->HillRank[element_index] = rank;
+	}
+
+	//---------------------------------------------------
+	// Search for a multiplier with no slot collisions
+	//---------------------------------------------------
+	multiplier = 0x9E3779B1u;  // golden ratio start point
+	for(attempt=0; attempt<(1<<20); attempt++){
+		for(slot_index=0; slot_index<FORMULA_HASH_SIZE; slot_index++){
+			pTable->Key[slot_index]          = 0;
+			pTable->AtomicNumber[slot_index] = 0;
+		}
+		collision = 0;
+		for(element_index=1; element_index<ELEMENT_TOTAL; element_index++){
+			Nchar = (int)strlen(pTable->Symbol[element_index]);
+			if( 0 < Nchar ){
+				key  = formula_symbol_key(pTable->Symbol[element_index],Nchar);
+				slot = formula_hash(key,multiplier);
+				if( 0 != pTable->Key[slot] ){
+					collision = 1;
+					break;
+				}
+				pTable->Key[slot]          = key;
+				pTable->AtomicNumber[slot] = element_index;
+			}
+		}
+		if( 0 == collision ){
+			pTable->Multiplier = multiplier;
+			return 0;
+		}
+		multiplier = multiplier*1664525u + 1013904223u;
+		multiplier |= 1u;
+	}
+	data_error("Error : no perfect hash multiplier found for the element symbols\n");
+	return -1;
+}
+
+//--------------------------------------------------------
+// Look up a symbol of Nchar characters.
+// Returns the atomic number or 0 if not found.
+//--------------------------------------------------------
+int isoDalton_formula_lookup(struct formula_symbol_table *pTable, const char *symbol, int Nchar){
+	unsigned int key;
+	unsigned int slot;
+
+	if( (Nchar < 1) || (3 < Nchar) ){
+		return 0;
+	}
+	key  = formula_symbol_key(symbol,Nchar);
+	slot = formula_hash(key,pTable->Multiplier);
+	if( pTable->Key[slot] == key ){
+		return pTable->AtomicNumber[slot];
+	}
+	return 0;
+}
+
+//--------------------------------------------------------
+// Read an unsigned integer (after optional spaces).
+// Returns the number of digits read (0 if none).
+//--------------------------------------------------------
+static int formula_read_count(const char *formula, int *pindex, long long *pcount){
+	int index;
+	int Ndigits;
+	long long count;
+
+	index = *pindex;
+	while( (' ' == formula[index]) || ('\t' == formula[index]) ){
+		index++;
+	}
+	count   = 0;
+	Ndigits = 0;
+	while( ('0' <= formula[index]) && (formula[index] <= '9') ){
+		if( count < INT_MAX ){
+			count = count*10 + (formula[index]-'0');
+		}
+		index++;
+		Ndigits++;
+	}
+	if( 0 < Ndigits ){
+		*pindex = index;
+		*pcount = count;
+	}
+	return Ndigits;
+}
+
+//--------------------------------------------------------
+// Read a symbol starting with an upper case letter and
+// return its atomic number (0 if unknown).  D and T are
+// accepted for deuterium and tritium.
+//--------------------------------------------------------
+static int formula_read_symbol(const char *formula, int *pindex, struct formula_symbol_table *pTable, int *pMassNumber){
+	int index;
+	int Nchar;
+	int AtomicNumber;
+
+	index = *pindex;
+	index++;
+	while( islower((unsigned char)formula[index]) ){
+		index++;
+	}
+	Nchar        = index - *pindex;
+	AtomicNumber = isoDalton_formula_lookup(pTable,formula+*pindex,Nchar);
+	*pMassNumber = 0;
+	if( (0 == AtomicNumber) && (1 == Nchar) ){
+		if( 'D' == formula[*pindex] ){
+			AtomicNumber = 1;
+			*pMassNumber = 2;
+		}else if( 'T' == formula[*pindex] ){
+			AtomicNumber = 1;
+			*pMassNumber = 3;
+		}
+	}
+	*pindex = index;
+	return AtomicNumber;
+}
+
+static int formula_sort_key(struct formula_symbol_table *pTable, int AtomicNumber, int MassNumber, int carbon_flag){
+	int rank;
+
+	rank = pTable->HillRank[AtomicNumber];
+	if( 1 == carbon_flag ){
+		if( 6 == AtomicNumber ){
+			rank = -2;
+		}else if( 1 == AtomicNumber ){
+			rank = -1;
+		}
+	}
+	return (rank+2)*1024 + MassNumber;
+}
+
+//--------------------------------------------------------
+// Parse a molecular formula.
+// Accepted grammar (spaces allowed between tokens):
+//   formula  = [multiplier] group* { ('.'|'*'|middle dot) [multiplier] group* } [charge]
+//   group    = Symbol [count] | '[' MassNumber Symbol ']' [count] | '(' group* ')' [count]
+//   charge   = ('+'|'-') [digits] | ('+'|'-')+ | ' ' digits ('+'|'-')
+// e.g. "C 254 H 378 N 65 O 75 S 6", "Ca(OH)2", "(CH3)3C(CH2)2OH",
+//      "CuSO4.5H2O", "C6H13O6+", "Fe+2" and "PO4 3-" are all accepted.
+// Explicit isotopes are written as "[13C]6 C248 H378 [15N]2 N63 O75 S6",
+// with D and T as short forms of [2H] and [3H].  Each explicit isotope
+// is kept as its own entry with a fixed mass (see MassNumber).
+// Note "Fe2+" is read as two iron atoms with a single charge.
+// Repeated elements are merged and the elements are written
+// in Hill order.  Returns FORMULA_OK or an error code.
+//--------------------------------------------------------
+int isoDalton_formula_parse(const char *formula, struct formula_symbol_table *pTable, struct formula_info *pFormula){
+	int TermAtomicNumber[FORMULA_MAX_TERMS];
+	int TermMassNumber[FORMULA_MAX_TERMS];
+	long long TermCount[FORMULA_MAX_TERMS];
+	int GroupStart[FORMULA_MAX_DEPTH];
+	int GroupType[FORMULA_MAX_DEPTH];
+	long long GroupMultiplier[FORMULA_MAX_DEPTH];
+	int Nterms;
+	int depth;
+	int index;
+	int start_index;
+	int AtomicNumber;
+	int MassNumber;
+	int term_index;
+	int element_index;
+	int element_index2;
+	int sign;
+	int Nsigns;
+	int carbon_flag;
+	int tmp_number;
+	int tmp_mass;
+	int tmp_count;
+	long long count;
+	long long sum;
+
+	pFormula->ElementTotal  = 0;
+	pFormula->Charge        = 0;
+	pFormula->ErrorPosition = -1;
+	Nterms = 0;
+	depth  = 0;
+	index  = 0;
+
+	//---------------------------------------------------
+	// Leading multiplier opens the first segment
+	//---------------------------------------------------
+	count = 1;
+	formula_read_count(formula,&index,&count);
+	if( 0 == count ){
+		pFormula->ErrorPosition = index;
+		return FORMULA_ERROR_COUNT;
+	}
+	GroupStart[0]      = 0;
+	GroupType[0]       = FORMULA_GROUP_SEGMENT;
+	GroupMultiplier[0] = count;
+	depth = 1;
+
+	while( '\0' != formula[index] ){
+		if( isupper((unsigned char)formula[index]) || ('[' == formula[index]) ){
+			//---------------------------------------
+			// Element symbol or explicit isotope
+			// with optional count
+			//---------------------------------------
+			start_index = index;
+			if( '[' == formula[index] ){
+				index++;
+				count = 0;
+				formula_read_count(formula,&index,&count);
+				while( (' ' == formula[index]) || ('\t' == formula[index]) ){
+					index++;
+				}
+				if( !isupper((unsigned char)formula[index]) ){
+					pFormula->ErrorPosition = index;
+					return FORMULA_ERROR_SYNTAX;
+				}
+				AtomicNumber = formula_read_symbol(formula,&index,pTable,&MassNumber);
+				if( 0 == AtomicNumber ){
+					pFormula->ErrorPosition = start_index+1;
+					return FORMULA_ERROR_SYMBOL;
+				}
+				while( (' ' == formula[index]) || ('\t' == formula[index]) ){
+					index++;
+				}
+				if( ']' != formula[index] ){
+					pFormula->ErrorPosition = index;
+					return FORMULA_ERROR_SYNTAX;
+				}
+				index++;
+				if( 0 == MassNumber ){
+					MassNumber = (int)count;
+				}
+				if( (MassNumber <= 0) || ((0 < count) && (count != MassNumber)) || (32*FORMULA_MASS_WORDS <= MassNumber) ||
+					(0 == (pTable->MassNumberSet[AtomicNumber][MassNumber>>5] & (1u << (MassNumber&31)))) ){
+					pFormula->ErrorPosition = start_index;
+					return FORMULA_ERROR_ISOTOPE;
+				}
+			}else{
+				AtomicNumber = formula_read_symbol(formula,&index,pTable,&MassNumber);
+				if( 0 == AtomicNumber ){
+					pFormula->ErrorPosition = start_index;
+					return FORMULA_ERROR_SYMBOL;
+				}
+			}
+			count = 1;
+			formula_read_count(formula,&index,&count);
+			if( (0 == count) || (INT_MAX <= count) ){
+				pFormula->ErrorPosition = start_index;
+				return FORMULA_ERROR_COUNT;
+			}
+			if( FORMULA_MAX_TERMS <= Nterms ){
+				pFormula->ErrorPosition = start_index;
+				return FORMULA_ERROR_TOO_LONG;
+			}
+			TermAtomicNumber[Nterms] = AtomicNumber;
+			TermMassNumber[Nterms]   = MassNumber;
+			TermCount[Nterms]        = count;
+			Nterms++;
+		}else if( '(' == formula[index] ){
+			if( FORMULA_MAX_DEPTH <= depth ){
+				pFormula->ErrorPosition = index;
+				return FORMULA_ERROR_PARENTHESIS;
+			}
+			GroupStart[depth]      = Nterms;
+			GroupType[depth]       = FORMULA_GROUP_PAREN;
+			GroupMultiplier[depth] = 1;
+			depth++;
+			index++;
+		}else if( ')' == formula[index] ){
+			if( FORMULA_GROUP_PAREN != GroupType[depth-1] ){
+				pFormula->ErrorPosition = index;
+				return FORMULA_ERROR_PARENTHESIS;
+			}
+			index++;
+			count = 1;
+			formula_read_count(formula,&index,&count);
+			if( (0 == count) || (INT_MAX <= count) ){
+				pFormula->ErrorPosition = index;
+				return FORMULA_ERROR_COUNT;
+			}
+			depth--;
+			for(term_index=GroupStart[depth]; term_index<Nterms; term_index++){
+				TermCount[term_index] *= count;
+				if( INT_MAX < TermCount[term_index] ){
+					pFormula->ErrorPosition = index;
+					return FORMULA_ERROR_COUNT;
+				}
+			}
+		}else if( ('.' == formula[index]) || ('*' == formula[index]) || ( ((char)0xC2 == formula[index]) && ((char)0xB7 == formula[index+1]) ) ){
+			//---------------------------------------
+			// Hydrate (adduct) separator closes the
+			// current segment and opens a new one
+			//---------------------------------------
+			if( FORMULA_GROUP_SEGMENT != GroupType[depth-1] ){
+				pFormula->ErrorPosition = index;
+				return FORMULA_ERROR_PARENTHESIS;
+			}
+			depth--;
+			for(term_index=GroupStart[depth]; term_index<Nterms; term_index++){
+				TermCount[term_index] *= GroupMultiplier[depth];
+				if( INT_MAX < TermCount[term_index] ){
+					pFormula->ErrorPosition = index;
+					return FORMULA_ERROR_COUNT;
+				}
+			}
+			index += ('.' == formula[index] || '*' == formula[index]) ? 1 : 2;
+			count = 1;
+			formula_read_count(formula,&index,&count);
+			if( (0 == count) || (INT_MAX <= count) ){
+				pFormula->ErrorPosition = index;
+				return FORMULA_ERROR_COUNT;
+			}
+			GroupStart[depth]      = Nterms;
+			GroupType[depth]       = FORMULA_GROUP_SEGMENT;
+			GroupMultiplier[depth] = count;
+			depth++;
+		}else if( ('+' == formula[index]) || ('-' == formula[index]) ){
+			//---------------------------------------
+			// Trailing charge, e.g. "+", "+2", "--"
+			//---------------------------------------
+			start_index = index;
+			sign   = ('+' == formula[index]) ? 1 : -1;
+			Nsigns = 0;
+			while( formula[index] == formula[start_index] ){
+				index++;
+				Nsigns++;
+			}
+			count = Nsigns;
+			if( (1 == Nsigns) && formula_read_count(formula,&index,&count) ){
+				if( (0 == count) || (INT_MAX <= count) ){
+					pFormula->ErrorPosition = start_index;
+					return FORMULA_ERROR_CHARGE;
+				}
+			}
+			while( isspace((unsigned char)formula[index]) ){
+				index++;
+			}
+			if( '\0' != formula[index] ){
+				pFormula->ErrorPosition = index;
+				return FORMULA_ERROR_CHARGE;
+			}
+			pFormula->Charge = sign*(int)count;
+		}else if( isspace((unsigned char)formula[index]) ){
+			index++;
+		}else if( ('0' <= formula[index]) && (formula[index] <= '9') ){
+			//---------------------------------------
+			// A number not following a symbol or a
+			// closing parenthesis is only allowed as
+			// a charge magnitude, e.g. "PO4 3-"
+			//---------------------------------------
+			start_index = index;
+			formula_read_count(formula,&index,&count);
+			while( (' ' == formula[index]) || ('\t' == formula[index]) ){
+				index++;
+			}
+			if( (('+' != formula[index]) && ('-' != formula[index])) || (0 == count) || (INT_MAX <= count) ){
+				pFormula->ErrorPosition = start_index;
+				return FORMULA_ERROR_SYNTAX;
+			}
+			sign = ('+' == formula[index]) ? 1 : -1;
+			index++;
+			while( isspace((unsigned char)formula[index]) ){
+				index++;
+			}
+			if( '\0' != formula[index] ){
+				pFormula->ErrorPosition = index;
+				return FORMULA_ERROR_CHARGE;
+			}
+			pFormula->Charge = sign*(int)count;
+		}else{
+			pFormula->ErrorPosition = index;
+			return FORMULA_ERROR_SYNTAX;
+		}
+	}
+
+	//---------------------------------------------------
+	// Close the last segment
+	//---------------------------------------------------
+	if( 1 != depth ){
+		pFormula->ErrorPosition = index;
+		return FORMULA_ERROR_PARENTHESIS;
+	}
+	for(term_index=GroupStart[0]; term_index<Nterms; term_index++){
+		TermCount[term_index] *= GroupMultiplier[0];
+		if( INT_MAX < TermCount[term_index] ){
+			pFormula->ErrorPosition = index;
+			return FORMULA_ERROR_COUNT;
+		}
+	}
+
+	//---------------------------------------------------
+	// Merge repeated elements (and repeated isotopes)
+	//---------------------------------------------------
+	carbon_flag = 0;
+	for(term_index=0; term_index<Nterms; term_index++){
+		AtomicNumber = TermAtomicNumber[term_index];
+		MassNumber   = TermMassNumber[term_index];
+		for(element_index=0; element_index<pFormula->ElementTotal; element_index++){
+			if( (pFormula->AtomicNumber[element_index] == AtomicNumber) && (pFormula->MassNumber[element_index] == MassNumber) ){
+				break;
+			}
+		}
+		if( element_index == pFormula->ElementTotal ){
+			if( FORMULA_MAX_ELEMENTS <= element_index ){
+				pFormula->ErrorPosition = index;
+				return FORMULA_ERROR_TOO_LONG;
+			}
+			pFormula->AtomicNumber[element_index] = AtomicNumber;
+			pFormula->MassNumber[element_index]   = MassNumber;
+			pFormula->AtomCount[element_index]    = 0;
+			pFormula->ElementTotal++;
+			if( 6 == AtomicNumber ){
+				carbon_flag = 1;
+			}
+		}
+		sum = (long long)pFormula->AtomCount[element_index] + TermCount[term_index];
+		if( INT_MAX < sum ){
+			pFormula->ErrorPosition = index;
+			return FORMULA_ERROR_COUNT;
+		}
+		pFormula->AtomCount[element_index] = (int)sum;
+	}
+	if( 0 == pFormula->ElementTotal ){
+		pFormula->ErrorPosition = 0;
+		return FORMULA_ERROR_EMPTY;
+	}
+
+	//---------------------------------------------------
+	// Canonical (Hill) order by insertion sort since
+	// formulas only have a handful of elements
+	//---------------------------------------------------
+	for(element_index=1; element_index<pFormula->ElementTotal; element_index++){
+		tmp_number = pFormula->AtomicNumber[element_index];
+		tmp_mass   = pFormula->MassNumber[element_index];
+		tmp_count  = pFormula->AtomCount[element_index];
+		element_index2 = element_index-1;
+		while( (0 <= element_index2) && (formula_sort_key(pTable,pFormula->AtomicNumber[element_index2],pFormula->MassNumber[element_index2],carbon_flag) > formula_sort_key(pTable,tmp_number,tmp_mass,carbon_flag)) ){
+			pFormula->AtomicNumber[element_index2+1] = pFormula->AtomicNumber[element_index2];
+			pFormula->MassNumber[element_index2+1]   = pFormula->MassNumber[element_index2];
+			pFormula->AtomCount[element_index2+1]    = pFormula->AtomCount[element_index2];
+			element_index2--;
+		}
+		pFormula->AtomicNumber[element_index2+1] = tmp_number;
+		pFormula->MassNumber[element_index2+1]   = tmp_mass;
+		pFormula->AtomCount[element_index2+1]    = tmp_count;
+	}
+
+	return FORMULA_OK;
+}
+
+//--------------------------------------------------------
+// Write the canonical formula string, e.g. "C2H5NO2",
+// "C6H13O6+" or "C4[13C]2H12O6", into buffer (Nbuffer
+// characters long).
+// Returns the string length or -1 if buffer is too small.
+//--------------------------------------------------------
+int isoDalton_formula_canonical(struct formula_info *pFormula, struct formula_symbol_table *pTable, char *buffer, int Nbuffer){
+	int element_index;
+	int Nchar;
+	int Ntotal;
+	char term[32];
+
+	Ntotal = 0;
+	for(element_index=0; element_index<=pFormula->ElementTotal; element_index++){
+		if( element_index < pFormula->ElementTotal ){
+			if( 0 < pFormula->MassNumber[element_index] ){
+				Nchar = sprintf(term,"[%d%s]",pFormula->MassNumber[element_index],pTable->Symbol[pFormula->AtomicNumber[element_index]]);
+			}else{
+				Nchar = sprintf(term,"%s",pTable->Symbol[pFormula->AtomicNumber[element_index]]);
+			}
+			if( 1 != pFormula->AtomCount[element_index] ){
+				Nchar += sprintf(term+Nchar,"%d",pFormula->AtomCount[element_index]);
+			}
+		}else if( 1 == pFormula->Charge ){
+			Nchar = sprintf(term,"+");
+		}else if( -1 == pFormula->Charge ){
+			Nchar = sprintf(term,"-");
+		}else if( 0 < pFormula->Charge ){
+			Nchar = sprintf(term,"+%d",pFormula->Charge);
+		}else if( 0 > pFormula->Charge ){
+			Nchar = sprintf(term,"-%d",-pFormula->Charge);
+		}else{
+			Nchar = 0;
+		}
+		if( Nbuffer <= Ntotal+Nchar ){
+			return -1;
+		}
+		memcpy(buffer+Ntotal,term,Nchar);
+		Ntotal += Nchar;
+	}
+	buffer[Ntotal] = '\0';
+	return Ntotal;
+}
+
+//--------------------------------------------------------
+// Point a molecule_info structure at a parsed formula so
+// it can be passed to isoDalton_exact_mass (no copies).
+//--------------------------------------------------------
+void isoDalton_formula_molecule(struct formula_info *pFormula, char *formula, struct molecule_info *pMolecule){
+	pMolecule->Formula      = formula;
+	pMolecule->ElementTotal = pFormula->ElementTotal;
+	pMolecule->AtomicNumber = pFormula->AtomicNumber;
+	pMolecule->AtomCount    = pFormula->AtomCount;
+	pMolecule->MassNumber   = pFormula->MassNumber;
+}
+
+//--------------------------------------------------------
+// Masses of the states of the atoms of a formula of
+// charge z to m/z, (mass - z*electron)/|z|.  A neutral
+// formula is left as it is.
+//--------------------------------------------------------
+void isoDalton_formula_mz(struct formula_info *pFormula, struct istates_info *pStates){
+	double electrons;
+	double divisor;
+	int state_index;
+
+	if( 0 == pFormula->Charge ){
+		return;
+	}
+	electrons = (double)pFormula->Charge*FORMULA_ELECTRON_MASS;
+	divisor   = (double)abs(pFormula->Charge);
+	for(state_index=0; state_index<pStates->StateTotal; state_index++){
+		pStates->mass[state_index] = (pStates->mass[state_index] - electrons)/divisor;
+	}
+}
+
+//--------------------------------------------------------
+// The mass of the atoms of a formula of charge z whose
+// ion is at m/z mz (the inverse of isoDalton_formula_mz)
+//--------------------------------------------------------
+double isoDalton_formula_neutral_mass(struct formula_info *pFormula, double mz){
+	if( 0 == pFormula->Charge ){
+		return mz;
+	}
+	return mz*(double)abs(pFormula->Charge) + (double)pFormula->Charge*FORMULA_ELECTRON_MASS;
+}
+
+const char *isoDalton_formula_error_string(int error_code){
+	switch(error_code){
+		case FORMULA_OK:                return "ok";
+		case FORMULA_ERROR_SYMBOL:      return "unknown element symbol";
+		case FORMULA_ERROR_PARENTHESIS: return "unbalanced parentheses";
+		case FORMULA_ERROR_COUNT:       return "invalid atom count";
+		case FORMULA_ERROR_CHARGE:      return "invalid charge";
+		case FORMULA_ERROR_SYNTAX:      return "syntax error";
+		case FORMULA_ERROR_TOO_LONG:    return "too many element terms";
+		case FORMULA_ERROR_EMPTY:       return "no atoms";
+		case FORMULA_ERROR_ISOTOPE:     return "unknown isotope";
+	}
+	return "unknown error";
+}
@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_formula.h                                     */
+/*               Header file for isoDalton_formula.cpp, a high rate      */
+/*               molecular formula parser using a perfect hash table     */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_FORMULA
+#define ISODALTON_FORMULA
+
+#include "data.h"
+
+//---------------------------------------------------------------------------------------------
+// Perfect hash table size (must be a power of two).  The element symbols are packed into
+// a 32 bit key and hashed with a multiplicative hash whose multiplier is searched for at
+// build time so that no two symbols share a slot, i.e. a lookup is one multiply, one
+// shift and one compare.
+//---------------------------------------------------------------------------------------------
+#define FORMULA_HASH_BITS      11
+#define FORMULA_HASH_SIZE      (1<<FORMULA_HASH_BITS)
+#define FORMULA_MAX_DEPTH      32    // maximum nesting of parentheses (and hydrate segments)
+#define FORMULA_MAX_TERMS      512   // maximum number of element terms before merging
+#define FORMULA_MAX_ELEMENTS   ELEMENT_TOTAL  // maximum number of distinct elements and isotopes
+#define FORMULA_MASS_WORDS     10    // isotope mass number bit set (mass numbers below 320)
+#define FORMULA_ELECTRON_MASS  5.48579909065e-4   // daltons (CODATA 2018)
+//---------------------------------------------------------------------------------------------
+// Return codes of isoDalton_formula_parse()
+//---------------------------------------------------------------------------------------------
+#define FORMULA_OK                  0
+#define FORMULA_ERROR_SYMBOL        1   // unknown element symbol
+#define FORMULA_ERROR_PARENTHESIS   2   // unbalanced or too deeply nested parentheses
+#define FORMULA_ERROR_COUNT         3   // atom count or multiplier is zero or overflows
+#define FORMULA_ERROR_CHARGE        4   // malformed charge
+#define FORMULA_ERROR_SYNTAX        5   // unexpected character
+#define FORMULA_ERROR_TOO_LONG      6   // more than FORMULA_MAX_TERMS element terms
+#define FORMULA_ERROR_EMPTY         7   // no atoms in the formula
+#define FORMULA_ERROR_ISOTOPE       8   // unknown isotope, e.g. [15C]
+//---------------------------------------------------------------------------------------------
+// Structure to contain the symbol lookup table
+//---------------------------------------------------------------------------------------------
+struct formula_symbol_table {
+	unsigned int Multiplier;                     // multiplicative hash constant (collision free)
+	unsigned int Key[FORMULA_HASH_SIZE];         // packed symbol stored in each slot (0 = empty)
+	int          AtomicNumber[FORMULA_HASH_SIZE];
+	int          HillRank[ELEMENT_TOTAL];        // canonical (Hill system) position of each element
+	char         Symbol[ELEMENT_TOTAL][4];       // symbols copied from the element list
+	unsigned int MassNumberSet[ELEMENT_TOTAL][FORMULA_MASS_WORDS];  // bit set of known isotope mass numbers
+};
+//---------------------------------------------------------------------------------------------
+// Structure to contain a parsed formula.  Elements are merged (each atomic number and
+// mass number pair appears once) and listed in Hill order, C then H then alphabetical,
+// with the natural composition entry of an element before its explicit isotopes.
+// MassNumber is zero for the natural isotopic composition or the mass number of an
+// explicit isotope, e.g. 13 for [13C] and 2 for D.  Charge is z of a trailing +, -, +2 ...;
+// the states of the atoms are computed as for a neutral molecule and isoDalton_formula_mz
+// turns their masses into the m/z of the ion.
+// No memory is allocated; the caller owns the structure.
+//---------------------------------------------------------------------------------------------
+struct formula_info {
+	int ElementTotal;
+	int Charge;
+	int AtomicNumber[FORMULA_MAX_ELEMENTS];
+	int MassNumber[FORMULA_MAX_ELEMENTS];
+	int AtomCount[FORMULA_MAX_ELEMENTS];
+	int ErrorPosition;   // character offset of the first error (-1 if none)
+};
+
+int  isoDalton_formula_build_table(struct element_list *, struct formula_symbol_table *);
+int  isoDalton_formula_lookup(struct formula_symbol_table *, const char *, int);
+int  isoDalton_formula_parse(const char *, struct formula_symbol_table *, struct formula_info *);
+int  isoDalton_formula_canonical(struct formula_info *, struct formula_symbol_table *, char *, int);
+void isoDalton_formula_molecule(struct formula_info *, char *, struct molecule_info *);
+void isoDalton_formula_mz(struct formula_info *, struct istates_info *);
+double isoDalton_formula_neutral_mass(struct formula_info *, double);
+const char *isoDalton_formula_error_string(int);
+
+#endif
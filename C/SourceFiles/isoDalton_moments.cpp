@@ -0,0 +1,377 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_moments.cpp                                   */
+/*               Average, monoisotopic and most abundant mass, the       */
+/*               cumulants of the isotopic distribution and its Gaussian */
+/*               or Edgeworth envelope, computed from the isotopes of    */
+/*               each element without the trellis                        */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "sort.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+#define MOMENTS_PI 3.14159265358979323846
+
+//--------------------------------------------------------
+// Probabilists' Hermite polynomial He_n(z)
+//--------------------------------------------------------
+static double moments_hermite(int n, double z){
+	double h0,h1,h2;
+	int index;
+
+	h0 = 1;
+	h1 = z;
+	if( 0 == n ){
+		return h0;
+	}
+	for(index=1; index<n; index++){
+		h2 = z*h1 - (double)index*h0;
+		h0 = h1;
+		h1 = h2;
+	}
+	return h1;
+}
+
+//--------------------------------------------------------
+// Envelope density of S at z (standardized), without the
+// lattice/sigma factor.  *pNext gets the first terms the
+// expansion leaves out.
+//--------------------------------------------------------
+static double moments_density(struct exact_mass_moments *pMoments, int Order, double z, double *pNext){
+	double sigma;
+	double g1,g2,g3;
+	double phi;
+	double term1,term2,term3;
+
+	sigma = sqrt(pMoments->ShiftCumulant[1]);
+	g1    = pMoments->ShiftCumulant[2]/(sigma*sigma*sigma);
+	g2    = pMoments->ShiftCumulant[3]/(sigma*sigma*sigma*sigma);
+	g3    = pMoments->ShiftCumulant[4]/(sigma*sigma*sigma*sigma*sigma);
+	phi   = exp(-0.5*z*z)/sqrt(2.0*MOMENTS_PI);
+	term1 = g1/6.0*moments_hermite(3,z);                                                    // 1/sqrt(atoms)
+	term2 = g2/24.0*moments_hermite(4,z) + g1*g1/72.0*moments_hermite(6,z);                 // 1/atoms
+	term3 = g3/120.0*moments_hermite(5,z) + g1*g2/144.0*moments_hermite(7,z) + g1*g1*g1/1296.0*moments_hermite(9,z);  // 1/atoms^1.5
+	if( ENVELOPE_GAUSSIAN == Order ){
+		*pNext = phi*(term1 + term2);
+		return phi;
+	}
+	*pNext = phi*term3;
+	return phi*(1.0 + term1 + term2);
+}
+
+//--------------------------------------------------------
+// Clusters klow to khigh (multiples of Lattice) of the
+// envelope
+//--------------------------------------------------------
+static void moments_range(struct exact_mass_moments *pMoments, int *pLow, int *pHigh){
+	double sigma;
+	double low,high;
+
+	sigma = sqrt(pMoments->ShiftCumulant[1]);
+	low   = ceil((pMoments->ShiftCumulant[0] - ENVELOPE_SIGMAS*sigma)/(double)pMoments->Lattice);
+	high  = floor((pMoments->ShiftCumulant[0] + ENVELOPE_SIGMAS*sigma)/(double)pMoments->Lattice);
+	*pLow  = (low < 0) ? 0 : (int)low*pMoments->Lattice;
+	*pHigh = (high*pMoments->Lattice > (double)pMoments->MaxShift) ? pMoments->MaxShift : (int)high*pMoments->Lattice;
+}
+
+//--------------------------------------------------------
+// Mass of cluster k: the regression of the mass on S
+//--------------------------------------------------------
+static double moments_cluster_mass(struct exact_mass_moments *pMoments, int k){
+	return pMoments->AverageMass + ((double)k - pMoments->ShiftCumulant[0])*pMoments->Covariance/pMoments->ShiftCumulant[1];
+}
+
+static int moments_gcd(int a, int b){
+	int swap;
+
+	while( 0 != b ){
+		swap = a % b;
+		a    = b;
+		b    = swap;
+	}
+	return a;
+}
+
+//--------------------------------------------------------
+// Moments of a molecule (isoDalton_moments.h)
+//--------------------------------------------------------
+void isoDalton_moments(struct molecule_info *pMolecule, struct element_list *pElements, struct isotope_profile *pProfile, struct exact_mass_moments *pMoments){
+	struct trellis_plan Plan;
+	struct element_info *pElement;
+	double fraction,fraction_total,fraction_max;
+	double mass,mass_min,mass_mean,mass_top;
+	double shift_mean;
+	double d,e;
+	double c2,c3,c4,c5;
+	double s2,s3,s4,s5;
+	double covariance;
+	double alternation;
+	double Natoms;
+	double density,best,next;
+	int shift,shift_max;
+	int element_index;
+	int isotope_index;
+	int index;
+	int k,klow,khigh;
+
+	isoDalton_trellis_plan(pMolecule, pElements, pProfile, &Plan);
+	pMoments->MonoisotopicMass = Plan.FixedMass;
+	pMoments->LightestMass     = Plan.FixedMass;
+	pMoments->Covariance       = 0;
+	pMoments->Lattice          = 0;
+	pMoments->MaxShift         = 0;
+	pMoments->Probability      = Plan.FixedProb;
+	pMoments->Alternation      = 1;
+	for(index=0; index<MOMENTS_CUMULANTS; index++){
+		pMoments->Cumulant[index]      = 0;
+		pMoments->ShiftCumulant[index] = 0;
+	}
+	pMoments->Cumulant[0] = Plan.FixedMass;
+
+	for(element_index=0; element_index<Plan.ElementTotal; element_index++){
+		pElement = Plan.Element[element_index];
+		Natoms   = (double)Plan.AtomCount[element_index];
+		//---------------------------------------------------
+		// Means of one atom
+		//---------------------------------------------------
+		fraction_total = 0;
+		fraction_max   = -1;
+		mass_min       = DBL_MAX;
+		mass_mean      = 0;
+		mass_top       = 0;
+		for(index=0; index<pElement->NonzeroIsotopeTotal; index++){
+			isotope_index   = pElement->NonzeroIsotopeIndex[index];
+			mass            = pElement->Isotope[isotope_index]->AtomicMass;
+			fraction        = pElement->Isotope[isotope_index]->CompositionFraction;
+			fraction_total += fraction;
+			mass_mean      += fraction*mass;
+			if( mass_min > mass ){
+				mass_min = mass;
+			}
+			if( fraction_max < fraction ){
+				fraction_max = fraction;
+				mass_top     = mass;
+			}
+		}
+		mass_mean /= fraction_total;
+		shift_mean = 0;
+		shift_max  = 0;
+		for(index=0; index<pElement->NonzeroIsotopeTotal; index++){
+			isotope_index = pElement->NonzeroIsotopeIndex[index];
+			shift         = (int)floor(pElement->Isotope[isotope_index]->AtomicMass - mass_min + 0.5);
+			shift_mean   += pElement->Isotope[isotope_index]->CompositionFraction*(double)shift/fraction_total;
+			if( shift_max < shift ){
+				shift_max = shift;
+			}
+			pMoments->Lattice = moments_gcd(shift, pMoments->Lattice);
+		}
+		//---------------------------------------------------
+		// Central moments of one atom
+		//---------------------------------------------------
+		c2 = 0; c3 = 0; c4 = 0; c5 = 0;
+		s2 = 0; s3 = 0; s4 = 0; s5 = 0;
+		covariance = 0;
+		for(index=0; index<pElement->NonzeroIsotopeTotal; index++){
+			isotope_index = pElement->NonzeroIsotopeIndex[index];
+			fraction      = pElement->Isotope[isotope_index]->CompositionFraction/fraction_total;
+			d             = pElement->Isotope[isotope_index]->AtomicMass - mass_mean;
+			e             = floor(pElement->Isotope[isotope_index]->AtomicMass - mass_min + 0.5) - shift_mean;
+			c2 += fraction*d*d;   c3 += fraction*d*d*d;   c4 += fraction*d*d*d*d;   c5 += fraction*d*d*d*d*d;
+			s2 += fraction*e*e;   s3 += fraction*e*e*e;   s4 += fraction*e*e*e*e;   s5 += fraction*e*e*e*e*e;
+			covariance += fraction*d*e;
+		}
+		//---------------------------------------------------
+		// Cumulants add over the atoms
+		//---------------------------------------------------
+		pMoments->Cumulant[0]      += Natoms*mass_mean;
+		pMoments->Cumulant[1]      += Natoms*c2;
+		pMoments->Cumulant[2]      += Natoms*c3;
+		pMoments->Cumulant[3]      += Natoms*(c4 - 3.0*c2*c2);
+		pMoments->Cumulant[4]      += Natoms*(c5 - 10.0*c3*c2);
+		pMoments->ShiftCumulant[0] += Natoms*shift_mean;
+		pMoments->ShiftCumulant[1] += Natoms*s2;
+		pMoments->ShiftCumulant[2] += Natoms*s3;
+		pMoments->ShiftCumulant[3] += Natoms*(s4 - 3.0*s2*s2);
+		pMoments->ShiftCumulant[4] += Natoms*(s5 - 10.0*s3*s2);
+		pMoments->Covariance       += Natoms*covariance;
+		pMoments->MonoisotopicMass += Natoms*mass_top;
+		pMoments->LightestMass     += Natoms*mass_min;
+		pMoments->MaxShift         += Plan.AtomCount[element_index]*shift_max;
+		pMoments->Probability      += Natoms*log10(fraction_total);
+	}
+	pMoments->AverageMass = pMoments->Cumulant[0];
+	if( 0 == pMoments->Lattice ){
+		pMoments->Lattice = 1;
+	}
+
+	//---------------------------------------------------------
+	// Alternation: the product over the atoms of the mean of
+	// (-1)^(shift/Lattice)
+	//---------------------------------------------------------
+	for(element_index=0; element_index<Plan.ElementTotal; element_index++){
+		pElement       = Plan.Element[element_index];
+		alternation    = 0;
+		fraction_total = 0;
+		mass_min       = DBL_MAX;
+		for(index=0; index<pElement->NonzeroIsotopeTotal; index++){
+			isotope_index = pElement->NonzeroIsotopeIndex[index];
+			if( mass_min > pElement->Isotope[isotope_index]->AtomicMass ){
+				mass_min = pElement->Isotope[isotope_index]->AtomicMass;
+			}
+		}
+		for(index=0; index<pElement->NonzeroIsotopeTotal; index++){
+			isotope_index   = pElement->NonzeroIsotopeIndex[index];
+			shift           = (int)floor(pElement->Isotope[isotope_index]->AtomicMass - mass_min + 0.5)/pMoments->Lattice;
+			fraction        = pElement->Isotope[isotope_index]->CompositionFraction;
+			fraction_total += fraction;
+			alternation    += (0 == shift % 2) ? fraction : -fraction;
+		}
+		pMoments->Alternation *= pow(alternation/fraction_total, (double)Plan.AtomCount[element_index]);
+	}
+	if( 0 < pMoments->Cumulant[1] ){
+		pMoments->Skewness = pMoments->Cumulant[2]/pow(pMoments->Cumulant[1],1.5);
+		pMoments->Kurtosis = pMoments->Cumulant[3]/(pMoments->Cumulant[1]*pMoments->Cumulant[1]);
+	}else{
+		pMoments->Skewness = 0;
+		pMoments->Kurtosis = 0;
+	}
+
+	//---------------------------------------------------------
+	// Most abundant cluster: the largest Edgeworth density
+	//---------------------------------------------------------
+	pMoments->MostAbundantCluster = 0;
+	pMoments->MostAbundantMass    = pMoments->AverageMass;
+	if( 0 < pMoments->ShiftCumulant[1] ){
+		moments_range(pMoments, &klow, &khigh);
+		best = -DBL_MAX;
+		for(k=klow; k<=khigh; k+=pMoments->Lattice){
+			density = moments_density(pMoments, ENVELOPE_EDGEWORTH, ((double)k - pMoments->ShiftCumulant[0])/sqrt(pMoments->ShiftCumulant[1]), &next);
+			if( best < density ){
+				best = density;
+				pMoments->MostAbundantCluster = k;
+			}
+		}
+		pMoments->MostAbundantMass = moments_cluster_mass(pMoments, pMoments->MostAbundantCluster);
+	}
+
+	data_message("Average mass          = %17.10f\n",pMoments->AverageMass);
+	data_message("Monoisotopic mass     = %17.10f\n",pMoments->MonoisotopicMass);
+	data_message("Most abundant mass    = %17.10f (M+%d)\n",pMoments->MostAbundantMass,pMoments->MostAbundantCluster);
+	data_message("Cumulants             = %g %g %g %g\n",pMoments->Cumulant[0],pMoments->Cumulant[1],pMoments->Cumulant[2],pMoments->Cumulant[3]);
+	data_message("Skewness, kurtosis    = %g %g\n",pMoments->Skewness,pMoments->Kurtosis);
+}
+
+//--------------------------------------------------------
+// The Mpeaks most probable clusters of the envelope of
+// Order (ENVELOPE_GAUSSIAN or ENVELOPE_EDGEWORTH) into
+// pPeaks, by decreasing probability, and the estimated
+// total variation distance to the exact clusters into
+// *pError.  Returns 0, or -1 if out of memory or Order
+// is unknown.
+//--------------------------------------------------------
+int isoDalton_moments_envelope(struct exact_mass_moments *pMoments, int Order, int Mpeaks, struct istates_info *pPeaks, int log10flag, double *pError){
+	double *mass;
+	double *prob;
+	double sigma;
+	double density,next;
+	double density_total,next_total;
+	double alternation;
+	double probability;
+	int Npeaks;
+	int peak_index;
+	int k,klow,khigh;
+
+	if( (ENVELOPE_GAUSSIAN != Order) && (ENVELOPE_EDGEWORTH != Order) ){
+		data_error("Error : unknown envelope %d\n",Order);
+		return -1;
+	}
+	probability = pow(10.0, pMoments->Probability);
+
+	//---------------------------------------------------------
+	// A molecule of single isotope elements is one peak
+	//---------------------------------------------------------
+	if( (0 >= pMoments->ShiftCumulant[1]) || (Mpeaks < 1) ){
+		pPeaks->StateTotal = (Mpeaks < 1) ? 0 : 1;
+		if( 0 < pPeaks->StateTotal ){
+			pPeaks->mass[0] = pMoments->AverageMass;
+			pPeaks->prob[0] = (1 == log10flag) ? pMoments->Probability : probability;
+		}
+		*pError = 0;
+		return 0;
+	}
+
+	moments_range(pMoments, &klow, &khigh);
+	Npeaks = (khigh - klow)/pMoments->Lattice + 1;
+	mass   = (double *)malloc(Npeaks*sizeof(double));
+	prob   = (double *)malloc(Npeaks*sizeof(double));
+	if( (NULL == mass) || (NULL == prob) ){
+		data_error("Error : could not allocate the envelope of %d clusters\n",Npeaks);
+		free(mass);
+		free(prob);
+		return -1;
+	}
+
+	//---------------------------------------------------------
+	// Density at the lattice points; an Edgeworth density
+	// below zero is clipped and counted in the error
+	//---------------------------------------------------------
+	sigma         = sqrt(pMoments->ShiftCumulant[1]);
+	density_total = 0;
+	next_total    = 0;
+	alternation   = 0;
+	for(peak_index=0, k=klow; peak_index<Npeaks; peak_index++, k+=pMoments->Lattice){
+		density = moments_density(pMoments, Order, ((double)k - pMoments->ShiftCumulant[0])/sigma, &next);
+		if( density < 0 ){
+			next_total += -density;
+			density     = 0;
+		}
+		mass[peak_index] = moments_cluster_mass(pMoments, k);
+		prob[peak_index] = density;
+		density_total   += density;
+		next_total      += fabs(next);
+		alternation     += (0 == (k/pMoments->Lattice) % 2) ? density : -density;
+	}
+	*pError = (0 < density_total) ? 0.5*(next_total + fabs(pMoments->Alternation*density_total - alternation))/density_total : 1;
+	if( *pError > 1 ){
+		*pError = 1;   // a total variation distance is at most 1: the expansion fails (small molecule)
+	}
+	for(peak_index=0; peak_index<Npeaks; peak_index++){
+		prob[peak_index] = (0 < density_total) ? probability*prob[peak_index]/density_total : 0;
+	}
+
+	heapsort_2dbl_down(Npeaks, prob, mass);
+	while( (1 < Npeaks) && (0 >= prob[Npeaks-1]) ){
+		Npeaks--;
+	}
+	if( Npeaks > Mpeaks ){
+		Npeaks = Mpeaks;
+	}
+	for(peak_index=0; peak_index<Npeaks; peak_index++){
+		pPeaks->mass[peak_index] = mass[peak_index];
+		if( 1 == log10flag ){
+			pPeaks->prob[peak_index] = (0 < prob[peak_index]) ? log10(prob[peak_index]) : -DBL_MAX;
+		}else{
+			pPeaks->prob[peak_index] = prob[peak_index];
+		}
+	}
+	pPeaks->StateTotal = Npeaks;
+	data_message("%s envelope of %d clusters, estimated error %g\n",(ENVELOPE_GAUSSIAN == Order) ? "Gaussian" : "Edgeworth",Npeaks,*pError);
+
+	free(mass);
+	free(prob);
+	return 0;
+}
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_moments.h                                     */
+/*               Header file for isoDalton_moments.cpp, the cumulants of */
+/*               the isotopic distribution and its Gaussian or Edgeworth */
+/*               envelope computed without the trellis                   */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_MOMENTS
+#define ISODALTON_MOMENTS
+
+//---------------------------------------------------------------------------------------------
+// Analytic moments.  The mass of a molecule is the sum of the masses of its atoms, which are
+// independent, so its cumulants are the sums over the elements of the atom count times the
+// cumulants of one atom (from the isotope masses and fractions).  The same holds for the
+// nominal shift S of a state (the sum of the rounded isotope shifts above the lightest
+// isotope, i.e. the k of its M+k cluster) and for the covariance of the mass and S.  This
+// takes O(elements) where the trellis takes O(Mstates log Mstates) per atom.
+//
+// The envelope gives the probability of every M+k cluster from the cumulants of S, by the
+// Gaussian or the Edgeworth expansion (skewness and kurtosis terms) at the lattice points k,
+// and the mass of a cluster by the regression of the mass on S.  The error estimate is half
+// the sum over the clusters of the absolute value of the first terms the expansion leaves
+// out, an estimate of the total variation distance to the exact cluster probabilities; it
+// falls as the molecule grows (as 1/sqrt(atoms) for the Gaussian and 1/atoms^1.5 for the
+// Edgeworth expansion).  Neither expansion follows an even/odd alternation of the clusters
+// (C12H4Cl6: the chlorine isotopes are two daltons apart), so half the difference between
+// the exact Alternation and that of the envelope is added to the error estimate.
+//---------------------------------------------------------------------------------------------
+#define MOMENTS_CUMULANTS   5      // the fifth cumulants are kept for the Edgeworth error estimate
+#define ENVELOPE_GAUSSIAN   0
+#define ENVELOPE_EDGEWORTH  1
+#define ENVELOPE_SIGMAS     10.0   // clusters further than this from the mean of S are left out
+
+struct exact_mass_moments {
+	double MonoisotopicMass;             // most abundant isotope of every element
+	double LightestMass;                 // lightest isotope of every element, the mass of M+0
+	double AverageMass;                  // Cumulant[0]
+	double MostAbundantMass;             // estimated mass of the most probable cluster
+	int    MostAbundantCluster;          // its k (Edgeworth envelope)
+	double Cumulant[MOMENTS_CUMULANTS];  // Cumulant[j] is cumulant j+1 of the mass (daltons^(j+1))
+	double Skewness;                     // Cumulant[2]/Cumulant[1]^1.5
+	double Kurtosis;                     // excess kurtosis, Cumulant[3]/Cumulant[1]^2
+	double ShiftCumulant[MOMENTS_CUMULANTS];  // cumulants of the nominal shift S
+	double Covariance;                   // of the mass and S
+	int    Lattice;                      // greatest common divisor of the isotope shifts (S is a multiple)
+	int    MaxShift;                     // largest S, the heaviest cluster
+	double Alternation;                  // P(S/Lattice even) - P(S/Lattice odd)
+	double Probability;                  // log10 of the total probability (0 if the fractions sum to 1)
+};
+
+void isoDalton_moments(struct molecule_info *, struct element_list *, struct isotope_profile *, struct exact_mass_moments *);
+int  isoDalton_moments_envelope(struct exact_mass_moments *, int, int, struct istates_info *, int, double *);
+
+#endif
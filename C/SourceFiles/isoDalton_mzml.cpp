@@ -0,0 +1,248 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_mzml.cpp                                      */
+/*               Streaming mzML writer.  The document is written as text */
+/*               spectrum by spectrum (no XMLNode tree is built) and the */
+/*               peak arrays are base64 encoded with XMLParserBase64Tool.*/
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_mzml.h"
+#include "sort.h"
+#include <math.h>
+
+//--------------------------------------------------------
+// Copy a value into the array in little endian order
+//--------------------------------------------------------
+static void mzml_store_little_endian(const void *value, int Nbytes, unsigned char *pOut){
+	const unsigned char *pIn;
+	unsigned int probe;
+	int byte_index;
+
+	pIn   = (const unsigned char *)value;
+	probe = 1;
+	if( 1 == *(unsigned char *)&probe ){
+		memcpy(pOut, pIn, Nbytes);
+		return;
+	}
+	for(byte_index=0; byte_index<Nbytes; byte_index++){
+		pOut[byte_index] = pIn[Nbytes-1-byte_index];
+	}
+}
+
+//--------------------------------------------------------
+// Formula as an attribute value
+//--------------------------------------------------------
+static void mzml_write_escaped(FILE *pFile, const char *text){
+	const char *pChar;
+
+	for(pChar=text; '\0'!=*pChar; pChar++){
+		switch( *pChar ){
+			case '&':  fputs("&amp;",  pFile); break;
+			case '<':  fputs("&lt;",   pFile); break;
+			case '>':  fputs("&gt;",   pFile); break;
+			case '"':  fputs("&quot;", pFile); break;
+			case '\'': fputs("&apos;", pFile); break;
+			default:   fputc(*pChar, pFile);   break;
+		}
+	}
+}
+
+//--------------------------------------------------------
+// One base64 encoded array
+//--------------------------------------------------------
+static void mzml_write_array(struct mzml_writer *pWriter, int Nbytes, const char *precision, const char *array_cv){
+	char *encoded;
+
+	encoded = pWriter->Base64.encode(pWriter->Bytes, (unsigned int)Nbytes);
+	fprintf(pWriter->pFile,"          <binaryDataArray encodedLength=\"%d\">\n",(int)strlen(encoded));
+	fprintf(pWriter->pFile,"            %s\n",precision);
+	fprintf(pWriter->pFile,"            <cvParam cvRef=\"MS\" accession=\"MS:1000576\" name=\"no compression\" value=\"\"/>\n");
+	fprintf(pWriter->pFile,"            %s\n",array_cv);
+	fprintf(pWriter->pFile,"            <binary>%s</binary>\n",encoded);
+	fprintf(pWriter->pFile,"          </binaryDataArray>\n");
+}
+
+//--------------------------------------------------------
+// Writes the document header up to the spectrumList.
+// Returns 0 on success and -1 on a write error.
+//--------------------------------------------------------
+int isoDalton_mzml_writer_open(struct mzml_writer *pWriter, FILE *pFile, int Mstates, int log10flag){
+	pWriter->pFile         = pFile;
+	pWriter->Mstates       = Mstates;
+	pWriter->log10flag     = log10flag;
+	pWriter->SpectrumTotal = 0;
+	pWriter->StateCapacity = 0;
+	pWriter->SortMass      = NULL;
+	pWriter->SortProb      = NULL;
+	pWriter->Bytes         = NULL;
+	pWriter->WriteError    = 0;
+
+	fprintf(pFile,"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n");
+	fprintf(pFile,"<mzML xmlns=\"http://psi.hupo.org/ms/mzml\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" ");
+	fprintf(pFile,"xsi:schemaLocation=\"http://psi.hupo.org/ms/mzml http://psidev.info/files/ms/mzML/xsd/mzML1.1.0.xsd\" version=\"1.1.0\">\n");
+	fprintf(pFile,"  <cvList count=\"2\">\n");
+	fprintf(pFile,"    <cv id=\"MS\" fullName=\"Proteomics Standards Initiative Mass Spectrometry Ontology\" URI=\"https://raw.githubusercontent.com/HUPO-PSI/psi-ms-CV/master/psi-ms.obo\"/>\n");
+	fprintf(pFile,"    <cv id=\"UO\" fullName=\"Unit Ontology\" URI=\"https://raw.githubusercontent.com/bio-ontology-research-group/unit-ontology/master/unit.obo\"/>\n");
+	fprintf(pFile,"  </cvList>\n");
+	fprintf(pFile,"  <fileDescription>\n");
+	fprintf(pFile,"    <fileContent>\n");
+	fprintf(pFile,"      <cvParam cvRef=\"MS\" accession=\"MS:1000579\" name=\"MS1 spectrum\" value=\"\"/>\n");
+	fprintf(pFile,"      <cvParam cvRef=\"MS\" accession=\"MS:1000127\" name=\"centroid spectrum\" value=\"\"/>\n");
+	fprintf(pFile,"    </fileContent>\n");
+	fprintf(pFile,"  </fileDescription>\n");
+	fprintf(pFile,"  <softwareList count=\"1\">\n");
+	fprintf(pFile,"    <software id=\"isoDalton\" version=\"1.0\">\n");
+	fprintf(pFile,"      <cvParam cvRef=\"MS\" accession=\"MS:1000799\" name=\"custom unreleased software tool\" value=\"isoDalton\"/>\n");
+	fprintf(pFile,"    </software>\n");
+	fprintf(pFile,"  </softwareList>\n");
+	fprintf(pFile,"  <instrumentConfigurationList count=\"1\">\n");
+	fprintf(pFile,"    <instrumentConfiguration id=\"theoretical\">\n");
+	fprintf(pFile,"      <cvParam cvRef=\"MS\" accession=\"MS:1000031\" name=\"instrument model\" value=\"\"/>\n");
+	fprintf(pFile,"      <userParam name=\"isoDalton theoretical spectra\" value=\"exact mass isotopic distribution\"/>\n");
+	fprintf(pFile,"    </instrumentConfiguration>\n");
+	fprintf(pFile,"  </instrumentConfigurationList>\n");
+	fprintf(pFile,"  <dataProcessingList count=\"1\">\n");
+	fprintf(pFile,"    <dataProcessing id=\"isoDalton_processing\">\n");
+	fprintf(pFile,"      <processingMethod order=\"1\" softwareRef=\"isoDalton\">\n");
+	fprintf(pFile,"        <cvParam cvRef=\"MS\" accession=\"MS:1000544\" name=\"Conversion to mzML\" value=\"\"/>\n");
+	fprintf(pFile,"      </processingMethod>\n");
+	fprintf(pFile,"    </dataProcessing>\n");
+	fprintf(pFile,"  </dataProcessingList>\n");
+	fprintf(pFile,"  <run id=\"isoDalton\" defaultInstrumentConfigurationRef=\"theoretical\">\n");
+	fprintf(pFile,"    <spectrumList count=\"");
+	pWriter->CountOffset = ftell(pFile);
+	fprintf(pFile,"%0*d\" defaultDataProcessingRef=\"isoDalton_processing\">\n",MZML_COUNT_DIGITS,0);
+	if( ferror(pFile) ){
+		data_error("Error : mzML writer : could not write the document header\n");
+		return -1;
+	}
+	return 0;
+}
+
+//--------------------------------------------------------
+// Append one spectrum.  Returns 0 on success and -1 on a
+// write error.
+//--------------------------------------------------------
+int isoDalton_mzml_write(struct mzml_writer *pWriter, const char *formula, struct istates_info *pStates){
+	FILE *pFile;
+	float  intensity;
+	double probability;
+	double base_mass;
+	double base_prob;
+	double total;
+	int Nstates;
+	int state_index;
+
+	pFile   = pWriter->pFile;
+	Nstates = pStates->StateTotal;
+	if( Nstates > pWriter->StateCapacity ){
+		pWriter->StateCapacity = Nstates;
+		pWriter->SortMass = (double *)realloc(pWriter->SortMass, Nstates*sizeof(double));
+		pWriter->SortProb = (double *)realloc(pWriter->SortProb, Nstates*sizeof(double));
+		pWriter->Bytes    = (unsigned char *)realloc(pWriter->Bytes, Nstates*sizeof(double));
+	}
+
+	//---------------------------------------------------
+	// Peaks in increasing m/z order, linear probabilities
+	//---------------------------------------------------
+	memcpy(pWriter->SortMass, pStates->mass, Nstates*sizeof(double));
+	for(state_index=0; state_index<Nstates; state_index++){
+		probability = pStates->prob[state_index];
+		pWriter->SortProb[state_index] = pWriter->log10flag ? pow(10.0, probability) : probability;
+	}
+	heapsort_2dbl_up(Nstates, pWriter->SortMass, pWriter->SortProb);
+	base_mass = 0.0;
+	base_prob = 0.0;
+	total     = 0.0;
+	for(state_index=0; state_index<Nstates; state_index++){
+		total += pWriter->SortProb[state_index];
+		if( pWriter->SortProb[state_index] > base_prob ){
+			base_prob = pWriter->SortProb[state_index];
+			base_mass = pWriter->SortMass[state_index];
+		}
+	}
+
+	fprintf(pFile,"      <spectrum index=\"%ld\" id=\"index=%ld\" defaultArrayLength=\"%d\">\n",pWriter->SpectrumTotal,pWriter->SpectrumTotal,Nstates);
+	fprintf(pFile,"        <cvParam cvRef=\"MS\" accession=\"MS:1000579\" name=\"MS1 spectrum\" value=\"\"/>\n");
+	fprintf(pFile,"        <cvParam cvRef=\"MS\" accession=\"MS:1000511\" name=\"ms level\" value=\"1\"/>\n");
+	fprintf(pFile,"        <cvParam cvRef=\"MS\" accession=\"MS:1000127\" name=\"centroid spectrum\" value=\"\"/>\n");
+	fprintf(pFile,"        <cvParam cvRef=\"MS\" accession=\"MS:1000866\" name=\"molecular formula\" value=\"");
+	mzml_write_escaped(pFile, formula);
+	fprintf(pFile,"\"/>\n");
+	if( 0 < Nstates ){
+		fprintf(pFile,"        <cvParam cvRef=\"MS\" accession=\"MS:1000528\" name=\"lowest observed m/z\" value=\"%.17g\" unitCvRef=\"MS\" unitAccession=\"MS:1000040\" unitName=\"m/z\"/>\n",pWriter->SortMass[0]);
+		fprintf(pFile,"        <cvParam cvRef=\"MS\" accession=\"MS:1000527\" name=\"highest observed m/z\" value=\"%.17g\" unitCvRef=\"MS\" unitAccession=\"MS:1000040\" unitName=\"m/z\"/>\n",pWriter->SortMass[Nstates-1]);
+		fprintf(pFile,"        <cvParam cvRef=\"MS\" accession=\"MS:1000504\" name=\"base peak m/z\" value=\"%.17g\" unitCvRef=\"MS\" unitAccession=\"MS:1000040\" unitName=\"m/z\"/>\n",base_mass);
+		fprintf(pFile,"        <cvParam cvRef=\"MS\" accession=\"MS:1000505\" name=\"base peak intensity\" value=\"%.9g\" unitCvRef=\"UO\" unitAccession=\"UO:0000186\" unitName=\"dimensionless unit\"/>\n",base_prob);
+	}
+	fprintf(pFile,"        <cvParam cvRef=\"MS\" accession=\"MS:1000285\" name=\"total ion current\" value=\"%.9g\"/>\n",total);
+	fprintf(pFile,"        <userParam name=\"isoDalton states\" value=\"%d\" type=\"xsd:int\"/>\n",pWriter->Mstates);
+	fprintf(pFile,"        <userParam name=\"isoDalton log10\" value=\"%d\" type=\"xsd:int\"/>\n",pWriter->log10flag);
+	fprintf(pFile,"        <binaryDataArrayList count=\"2\">\n");
+
+	for(state_index=0; state_index<Nstates; state_index++){
+		mzml_store_little_endian(&pWriter->SortMass[state_index], 8, &pWriter->Bytes[8*state_index]);
+	}
+	mzml_write_array(pWriter, 8*Nstates,
+		"<cvParam cvRef=\"MS\" accession=\"MS:1000523\" name=\"64-bit float\" value=\"\"/>",
+		"<cvParam cvRef=\"MS\" accession=\"MS:1000514\" name=\"m/z array\" value=\"\" unitCvRef=\"MS\" unitAccession=\"MS:1000040\" unitName=\"m/z\"/>");
+	for(state_index=0; state_index<Nstates; state_index++){
+		intensity = (float)pWriter->SortProb[state_index];
+		mzml_store_little_endian(&intensity, 4, &pWriter->Bytes[4*state_index]);
+	}
+	mzml_write_array(pWriter, 4*Nstates,
+		"<cvParam cvRef=\"MS\" accession=\"MS:1000521\" name=\"32-bit float\" value=\"\"/>",
+		"<cvParam cvRef=\"MS\" accession=\"MS:1000515\" name=\"intensity array\" value=\"\" unitCvRef=\"UO\" unitAccession=\"UO:0000186\" unitName=\"dimensionless unit\"/>");
+
+	fprintf(pFile,"        </binaryDataArrayList>\n");
+	fprintf(pFile,"      </spectrum>\n");
+	pWriter->SpectrumTotal++;
+	if( ferror(pFile) ){
+		pWriter->WriteError = 1;
+		return -1;
+	}
+	return 0;
+}
+
+//--------------------------------------------------------
+// Close the document and fill in the spectrum count.
+// Returns 0, or -1 if any write failed or the count could
+// not be filled in.  The file stays open.
+//--------------------------------------------------------
+int isoDalton_mzml_writer_close(struct mzml_writer *pWriter){
+	FILE *pFile;
+	long end_offset;
+
+	pFile = pWriter->pFile;
+	fprintf(pFile,"    </spectrumList>\n");
+	fprintf(pFile,"  </run>\n");
+	fprintf(pFile,"</mzML>\n");
+	fflush(pFile);
+	end_offset = ftell(pFile);
+	if( (0 <= pWriter->CountOffset) && (0 <= end_offset) && (0 == fseek(pFile, pWriter->CountOffset, SEEK_SET)) ){
+		fprintf(pFile,"%0*ld",MZML_COUNT_DIGITS,pWriter->SpectrumTotal);
+		fseek(pFile, end_offset, SEEK_SET);
+	}else{
+		data_error("Error : mzML writer : the output is not seekable, the spectrumList count is 0\n");
+		pWriter->WriteError = 1;
+	}
+	if( (0 != fflush(pFile)) || ferror(pFile) ){
+		pWriter->WriteError = 1;
+	}
+	free(pWriter->SortMass);
+	free(pWriter->SortProb);
+	free(pWriter->Bytes);
+	pWriter->Base64.freeBuffer();
+	return pWriter->WriteError ? -1 : 0;
+}
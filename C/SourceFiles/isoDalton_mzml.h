@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_mzml.h                                        */
+/*               Header file for isoDalton_mzml.cpp, a streaming mzML    */
+/*               writer of theoretical spectra                           */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_MZML
+#define ISODALTON_MZML
+
+#include "data.h"
+#include "xmlParser.h"
+
+//---------------------------------------------------------------------------------------------
+// mzML 1.1 output.  Each molecule is one centroid spectrum:
+//
+//   <spectrum index="i" id="index=i" defaultArrayLength="StateTotal">
+//     cvParams: MS1 spectrum, ms level, centroid spectrum, lowest/highest observed m/z,
+//               base peak m/z and intensity, total ion current, molecular formula (MS:1000866)
+//     userParams: isoDalton states, isoDalton log10 (the computation parameters)
+//     <binaryDataArray> m/z        64 bit float, little endian, base64, no compression
+//     <binaryDataArray> intensity  32 bit float, little endian, base64, no compression
+//
+// The m/z array holds the exact masses of the states (charge 1, no proton added) in increasing
+// order and the intensity array their probabilities (converted from log10 if needed).
+//
+// Spectra are written as they come; only one spectrum is held in memory.  The spectrumList
+// count is written as a zero padded placeholder and filled in by the close function, which
+// needs a seekable file.
+//---------------------------------------------------------------------------------------------
+#define MZML_COUNT_DIGITS 10   // width of the spectrumList count placeholder
+
+struct mzml_writer {
+	FILE          *pFile;
+	int            Mstates;        // parameters recorded with every spectrum
+	int            log10flag;
+	long           CountOffset;    // file offset of the spectrumList count, -1 if not seekable
+	long           SpectrumTotal;
+	int            StateCapacity;
+	double        *SortMass;       // scratch of StateCapacity states
+	double        *SortProb;
+	unsigned char *Bytes;          // little endian array before base64 encoding
+	XMLParserBase64Tool Base64;    // keeps its output buffer between spectra
+	int            WriteError;
+};
+
+int isoDalton_mzml_writer_open(struct mzml_writer *, FILE *, int, int);
+int isoDalton_mzml_write(struct mzml_writer *, const char *, struct istates_info *);
+int isoDalton_mzml_writer_close(struct mzml_writer *);
+
+#endif
@@ -0,0 +1,238 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_schedule.cpp                                  */
+/*               Chooses the order of the elements of the trellis with   */
+/*               an estimate of the cost and truncation error of each    */
+/*               order                                                   */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+//--------------------------------------------------------
+// Options of the scheduler (isoDalton_schedule.h)
+//--------------------------------------------------------
+void isoDalton_schedule_init(struct exact_mass_schedule *pSchedule, double MaxError){
+	pSchedule->MaxError    = MaxError;
+	pSchedule->PlanCost    = 0;
+	pSchedule->PlanError   = 0;
+	pSchedule->Cost        = 0;
+	pSchedule->Error       = 0;
+	pSchedule->OrdersTried = 0;
+	pSchedule->Reordered   = 0;
+}
+
+//--------------------------------------------------------
+// Estimated Cost (returned) and Error (*pError) of the
+// trellis with the elements of the plan taken in the
+// order order[0], order[1] ...
+//--------------------------------------------------------
+double isoDalton_schedule_cost(struct trellis_plan *pPlan, int *order, int Mstates, double *pError){
+	double states;
+	double before;
+	double compositions;
+	double generated;
+	double distinct;
+	double cost;
+	double error;
+	int Natoms;
+	int Natoms_total;
+	int Natoms_left;
+	int Nisotopes;
+	int element_index;
+	int atom_index;
+
+	Natoms_total = 0;
+	for(element_index=0; element_index<pPlan->ElementTotal; element_index++){
+		Natoms_total += pPlan->AtomCount[element_index];
+	}
+	Natoms_left = Natoms_total;
+	states      = 1;
+	cost        = 0;
+	error       = 0;
+	for(element_index=0; element_index<pPlan->ElementTotal; element_index++){
+		Nisotopes    = pPlan->Element[order[element_index]]->NonzeroIsotopeTotal;
+		Natoms       = pPlan->AtomCount[order[element_index]];
+		before       = states;
+		compositions = 1;
+		for(atom_index=1; atom_index<=Natoms; atom_index++){
+			generated     = states*Nisotopes;
+			cost         += generated*(1.0 + 2.0*log(generated)/log(2.0));
+			compositions *= (double)(atom_index+Nisotopes-1)/(double)atom_index;  // C(n+k-1,k-1)
+			distinct      = before*compositions;
+			if( distinct > generated ){
+				distinct = generated;
+			}
+			Natoms_left--;
+			if( distinct > (double)Mstates ){
+				error += (1.0 - (double)Mstates/distinct)*(double)(Natoms_left+1)/(double)Natoms_total;
+				states = (double)Mstates;
+			}else{
+				states = distinct;
+			}
+		}
+	}
+	if( NULL != pError ){
+		*pError = error;
+	}
+	return cost;
+}
+
+//--------------------------------------------------------
+// Next order in lexicographic order, 0 after the last
+//--------------------------------------------------------
+static int schedule_next_order(int *order, int Norder){
+	int index1,index2;
+	int swap;
+
+	index1 = Norder-2;
+	while( (0 <= index1) && (order[index1] >= order[index1+1]) ){
+		index1--;
+	}
+	if( index1 < 0 ){
+		return 0;
+	}
+	index2 = Norder-1;
+	while( order[index2] <= order[index1] ){
+		index2--;
+	}
+	swap = order[index1]; order[index1] = order[index2]; order[index2] = swap;
+	for(index1++, index2=Norder-1; index1<index2; index1++, index2--){
+		swap = order[index1]; order[index1] = order[index2]; order[index2] = swap;
+	}
+	return 1;
+}
+
+//--------------------------------------------------------
+// 1 if an order of cost and error is better than the best
+// so far: within max_error and cheaper
+//--------------------------------------------------------
+static int schedule_better(double cost, double error, double best_cost, double max_error){
+	return (error <= max_error*(1.0+1e-9)) && (cost < best_cost*(1.0-1e-9));
+}
+
+//--------------------------------------------------------
+// Reorder the elements of a plan for Mstates states
+//--------------------------------------------------------
+void isoDalton_schedule_plan(struct trellis_plan *pPlan, int Mstates, struct exact_mass_schedule *pSchedule){
+	struct element_info *Element[ELEMENT_TOTAL];
+	int AtomCount[ELEMENT_TOTAL];
+	int order[ELEMENT_TOTAL];
+	int best[ELEMENT_TOTAL];
+	int trial[ELEMENT_TOTAL];
+	int used[ELEMENT_TOTAL];
+	double cost,error;
+	double best_cost,best_error;
+	double max_error;
+	int Nelements;
+	int element_index;
+	int position;
+	int candidate;
+	int index;
+	int pick;
+
+	Nelements = pPlan->ElementTotal;
+	for(element_index=0; element_index<Nelements; element_index++){
+		order[element_index] = element_index;
+		best[element_index]  = element_index;
+		used[element_index]  = 0;
+	}
+	pSchedule->PlanCost    = isoDalton_schedule_cost(pPlan, order, Mstates, &pSchedule->PlanError);
+	pSchedule->OrdersTried = 1;
+	max_error  = (0 < pSchedule->MaxError) ? pSchedule->MaxError : pSchedule->PlanError;
+	best_cost  = pSchedule->PlanCost;
+	best_error = pSchedule->PlanError;
+
+	if( Nelements <= SCHEDULE_MAX_EXHAUSTIVE ){
+		//---------------------------------------------------------
+		// Every order
+		//---------------------------------------------------------
+		while( schedule_next_order(order, Nelements) ){
+			cost = isoDalton_schedule_cost(pPlan, order, Mstates, &error);
+			pSchedule->OrdersTried++;
+			if( schedule_better(cost, error, best_cost, max_error) ){
+				best_cost  = cost;
+				best_error = error;
+				for(element_index=0; element_index<Nelements; element_index++){
+					best[element_index] = order[element_index];
+				}
+			}
+		}
+	}else{
+		//---------------------------------------------------------
+		// Greedy: each position gets the element that gives the
+		// best order with the elements left in plan order after it
+		//---------------------------------------------------------
+		for(position=0; position<Nelements; position++){
+			pick       = -1;
+			best_cost  = 0;
+			best_error = 0;
+			for(candidate=0; candidate<Nelements; candidate++){
+				if( used[candidate] ){
+					continue;
+				}
+				for(element_index=0; element_index<position; element_index++){
+					trial[element_index] = best[element_index];
+				}
+				trial[position] = candidate;
+				index = position+1;
+				for(element_index=0; element_index<Nelements; element_index++){
+					if( (0 == used[element_index]) && (element_index != candidate) ){
+						trial[index++] = element_index;
+					}
+				}
+				cost = isoDalton_schedule_cost(pPlan, trial, Mstates, &error);
+				pSchedule->OrdersTried++;
+				if( (pick < 0) || schedule_better(cost, error, best_cost, max_error) || ((best_error > max_error) && (error < best_error)) ){
+					pick       = candidate;
+					best_cost  = cost;
+					best_error = error;
+				}
+			}
+			best[position] = pick;
+			used[pick]     = 1;
+		}
+		if( !schedule_better(best_cost, best_error, pSchedule->PlanCost, max_error) ){
+			for(element_index=0; element_index<Nelements; element_index++){
+				best[element_index] = element_index;
+			}
+			best_cost  = pSchedule->PlanCost;
+			best_error = pSchedule->PlanError;
+		}
+	}
+
+	//---------------------------------------------------------
+	// Apply the chosen order
+	//---------------------------------------------------------
+	pSchedule->Cost      = best_cost;
+	pSchedule->Error     = best_error;
+	pSchedule->Reordered = 0;
+	for(element_index=0; element_index<Nelements; element_index++){
+		Element[element_index]   = pPlan->Element[element_index];
+		AtomCount[element_index] = pPlan->AtomCount[element_index];
+		if( best[element_index] != element_index ){
+			pSchedule->Reordered = 1;
+		}
+	}
+	for(element_index=0; element_index<Nelements; element_index++){
+		pPlan->Element[element_index]   = Element[best[element_index]];
+		pPlan->AtomCount[element_index] = AtomCount[best[element_index]];
+	}
+	data_message("Scheduled element order (estimated cost %g of %g, error %g of %g):",best_cost,pSchedule->PlanCost,best_error,pSchedule->PlanError);
+	for(element_index=0; element_index<Nelements; element_index++){
+		data_message(" %s",pPlan->Element[element_index]->Name);
+	}
+	data_message("\n");
+}
@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_schedule.h                                    */
+/*               Header file for isoDalton_schedule.cpp, the order of    */
+/*               the elements of the trellis chosen by a cost model      */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_SCHEDULE
+#define ISODALTON_SCHEDULE
+
+//---------------------------------------------------------------------------------------------
+// Element order scheduler.  isoDalton_trellis_plan orders the elements by isotope count and
+// mass.  The scheduler instead estimates, for an order, the states of every step: after n
+// atoms of an element of k isotopes there are C(n+k-1,k-1) compositions of that element, times
+// the states left by the elements before it, up to the states generated and up to Mstates.
+//
+//   Cost   sum over the steps of G*(1 + 2*log2(G)), G the states generated (expand and the two
+//          sorts)
+//   Error  sum over the capped steps of the fraction of the states dropped, times the fraction
+//          of the atoms still to add (an early cap loses the states its drops would have grown)
+//
+// Every order is tried up to SCHEDULE_MAX_EXHAUSTIVE elements, beyond that the elements are
+// picked greedily.  The cheapest order whose Error is at most MaxError is chosen; MaxError 0
+// means the Error of the plan order, so the result is no less accurate than that estimate.
+// The atoms of an element stay together (the probability bound needs whole elements).
+//---------------------------------------------------------------------------------------------
+#define SCHEDULE_MAX_EXHAUSTIVE 7   // 5040 orders
+
+struct exact_mass_schedule {
+	double MaxError;        // set by the caller: largest estimated Error, 0 = that of the plan order
+	double PlanCost;        // estimated Cost of the plan order
+	double PlanError;       // estimated Error of the plan order
+	double Cost;            // estimated Cost of the chosen order
+	double Error;           // estimated Error of the chosen order
+	int    OrdersTried;
+	int    Reordered;       // 1 = the chosen order is not the plan order
+};
+
+void   isoDalton_schedule_init(struct exact_mass_schedule *, double);
+double isoDalton_schedule_cost(struct trellis_plan *, int *, int, double *);
+void   isoDalton_schedule_plan(struct trellis_plan *, int, struct exact_mass_schedule *);
+
+#endif
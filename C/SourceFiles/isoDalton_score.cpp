@@ -0,0 +1,475 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_score.cpp                                     */
+/*               Scores computed isotope states against observed         */
+/*               centroids: ppm alignment by a two pointer sweep,        */
+/*               spectral angle, KL divergence and isotope ratio error,  */
+/*               for one candidate or a batch of candidates in threads   */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_score.h"
+#include "sort.h"
+#include "thread.h"
+#include "format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define SCORE_SSE2
+	#include <emmintrin.h>
+#endif
+
+#define SCORE_PI 3.14159265358979323846
+
+//--------------------------------------------------------
+// Work arrays of one thread: the states of a candidate
+// sorted by mass, and the probability and probability
+// times mass of the states of each centroid
+//--------------------------------------------------------
+struct score_work {
+	int     StateCapacity;
+	double *Mass;
+	double *Prob;
+	double *Theory;
+	double *TheoryMass;
+};
+
+//--------------------------------------------------------
+// Candidates First to Last-1 of a batch, for one thread
+//--------------------------------------------------------
+struct score_slice {
+	struct score_spectrum *pSpectrum;
+	struct istates_info   *Candidates;
+	struct spectrum_score *Scores;
+	int                    log10flag;
+	int                    First;
+	int                    Last;
+	int                    Failed;
+};
+
+//--------------------------------------------------------
+// Read a peak list: one centroid per line, mass and
+// intensity separated by spaces, tabs or a comma.  Lines
+// that do not start with two numbers (headers, comments)
+// and intensities of zero or less are skipped.  Returns
+// the number of peaks or -1.
+//--------------------------------------------------------
+int isoDalton_score_read_peaks(const char *filename, struct istates_info *pPeaks){
+	FILE *pFile;
+	char line[SCORE_LINE_MAX];
+	char *pField;
+	char *pEnd;
+	double mass,intensity;
+	double *grown;
+	int capacity;
+
+	pPeaks->StateTotal = 0;
+	pPeaks->mass       = NULL;
+	pPeaks->prob       = NULL;
+	pFile = fopen(filename,"r");
+	if( NULL == pFile ){
+		data_error("Error : could not open %s\n",filename);
+		return -1;
+	}
+	capacity = 0;
+	while( NULL != fgets(line, SCORE_LINE_MAX, pFile) ){
+		mass = strtod(line, &pField);
+		if( pField == line ){
+			continue;
+		}
+		while( (' ' == *pField) || ('\t' == *pField) || (',' == *pField) ){
+			pField++;
+		}
+		intensity = strtod(pField, &pEnd);
+		if( (pEnd == pField) || (intensity <= 0) ){
+			continue;
+		}
+		if( pPeaks->StateTotal == capacity ){
+			capacity = (0 == capacity) ? 64 : 2*capacity;
+			grown = (double *)realloc(pPeaks->mass, capacity*sizeof(double));
+			if( NULL != grown ){
+				pPeaks->mass = grown;
+				grown = (double *)realloc(pPeaks->prob, capacity*sizeof(double));
+			}
+			if( NULL == grown ){
+				data_error("Error : could not allocate %d peaks\n",capacity);
+				free(pPeaks->mass);
+				free(pPeaks->prob);
+				pPeaks->mass       = NULL;
+				pPeaks->prob       = NULL;
+				pPeaks->StateTotal = 0;
+				fclose(pFile);
+				return -1;
+			}
+			pPeaks->prob = grown;
+		}
+		pPeaks->mass[pPeaks->StateTotal] = mass;
+		pPeaks->prob[pPeaks->StateTotal] = intensity;
+		pPeaks->StateTotal++;
+	}
+	fclose(pFile);
+	return pPeaks->StateTotal;
+}
+
+//--------------------------------------------------------
+// Observed centroids sorted by mass, intensities summing
+// to 1.  Returns 0, or -1 if there are no peaks or out of
+// memory.
+//--------------------------------------------------------
+int isoDalton_score_spectrum_init(struct score_spectrum *pSpectrum, struct istates_info *pPeaks, double Ppm){
+	double total;
+	int peak_index;
+
+	pSpectrum->PeakTotal = 0;
+	pSpectrum->Ppm       = Ppm;
+	pSpectrum->Mass      = (double *)malloc((pPeaks->StateTotal+1)*sizeof(double));
+	pSpectrum->Intensity = (double *)malloc((pPeaks->StateTotal+1)*sizeof(double));
+	if( (NULL == pSpectrum->Mass) || (NULL == pSpectrum->Intensity) ){
+		data_error("Error : could not allocate a spectrum of %d peaks\n",pPeaks->StateTotal);
+		isoDalton_score_spectrum_free(pSpectrum);
+		return -1;
+	}
+	total = 0;
+	for(peak_index=0; peak_index<pPeaks->StateTotal; peak_index++){
+		if( 0 < pPeaks->prob[peak_index] ){
+			pSpectrum->Mass[pSpectrum->PeakTotal]      = pPeaks->mass[peak_index];
+			pSpectrum->Intensity[pSpectrum->PeakTotal] = pPeaks->prob[peak_index];
+			pSpectrum->PeakTotal++;
+			total += pPeaks->prob[peak_index];
+		}
+	}
+	if( 0 == pSpectrum->PeakTotal ){
+		data_error("Error : the spectrum has no peaks\n");
+		isoDalton_score_spectrum_free(pSpectrum);
+		return -1;
+	}
+	heapsort_2dbl_up(pSpectrum->PeakTotal, pSpectrum->Mass, pSpectrum->Intensity);
+	for(peak_index=0; peak_index<pSpectrum->PeakTotal; peak_index++){
+		pSpectrum->Intensity[peak_index] /= total;
+	}
+	return 0;
+}
+
+void isoDalton_score_spectrum_free(struct score_spectrum *pSpectrum){
+	free(pSpectrum->Mass);
+	free(pSpectrum->Intensity);
+	pSpectrum->Mass      = NULL;
+	pSpectrum->Intensity = NULL;
+	pSpectrum->PeakTotal = 0;
+}
+
+static int score_work_init(struct score_work *pWork, int PeakTotal){
+	pWork->StateCapacity = 0;
+	pWork->Mass          = NULL;
+	pWork->Prob          = NULL;
+	pWork->Theory        = (double *)malloc(PeakTotal*sizeof(double));
+	pWork->TheoryMass    = (double *)malloc(PeakTotal*sizeof(double));
+	return ((NULL == pWork->Theory) || (NULL == pWork->TheoryMass)) ? -1 : 0;
+}
+
+static void score_work_free(struct score_work *pWork){
+	free(pWork->Mass);
+	free(pWork->Prob);
+	free(pWork->Theory);
+	free(pWork->TheoryMass);
+}
+
+//--------------------------------------------------------
+// Score of one candidate.  Returns 0, or -1 if out of
+// memory.
+//--------------------------------------------------------
+static int score_candidate(struct score_spectrum *pSpectrum, struct istates_info *pStates, int log10flag, struct score_work *pWork, struct spectrum_score *pScore){
+	double *Observed;
+	double *Theory;
+	double mass,prob,tolerance;
+	double total;
+	double group_mass,group_prob,group_squares;
+	double dot,theory_squares,observed_squares;
+	double distance,distance_next;
+	double smoothed;
+	double base_theory,base_observed;
+	double ratio,ppm,ppm_weight;
+	int Nstates;
+	int Npeaks;
+	int state_index;
+	int peak_index;
+	int best;
+	int base;
+#ifdef SCORE_SSE2
+	__m128d dot2,theory2,observed2;
+	__m128d t,o;
+	double sums[2];
+#endif
+
+	//---------------------------------------------------------
+	// States sorted by mass, linear probabilities
+	//---------------------------------------------------------
+	if( pWork->StateCapacity < pStates->StateTotal ){
+		free(pWork->Mass);
+		free(pWork->Prob);
+		pWork->StateCapacity = pStates->StateTotal;
+		pWork->Mass = (double *)malloc(pWork->StateCapacity*sizeof(double));
+		pWork->Prob = (double *)malloc(pWork->StateCapacity*sizeof(double));
+		if( (NULL == pWork->Mass) || (NULL == pWork->Prob) ){
+			data_error("Error : could not allocate the scoring of %d states\n",pStates->StateTotal);
+			pWork->StateCapacity = 0;
+			return -1;
+		}
+	}
+	Nstates = 0;
+	for(state_index=0; state_index<pStates->StateTotal; state_index++){
+		prob = (1 == log10flag) ? pow(10.0, pStates->prob[state_index]) : pStates->prob[state_index];
+		if( 0 < prob ){
+			pWork->Mass[Nstates] = pStates->mass[state_index];
+			pWork->Prob[Nstates] = prob;
+			Nstates++;
+		}
+	}
+	heapsort_2dbl_up(Nstates, pWork->Mass, pWork->Prob);
+
+	//---------------------------------------------------------
+	// Two pointer sweep: peak_index is the last centroid at
+	// or below the mass of the state (or the first one)
+	//---------------------------------------------------------
+	Npeaks   = pSpectrum->PeakTotal;
+	Observed = pSpectrum->Intensity;
+	Theory   = pWork->Theory;
+	for(peak_index=0; peak_index<Npeaks; peak_index++){
+		Theory[peak_index]           = 0;
+		pWork->TheoryMass[peak_index] = 0;
+	}
+	total         = 0;
+	group_mass    = 0;
+	group_prob    = 0;
+	group_squares = 0;
+	pScore->Unobserved = 0;
+	peak_index = 0;
+	for(state_index=0; state_index<Nstates; state_index++){
+		mass       = pWork->Mass[state_index];
+		prob       = pWork->Prob[state_index];
+		tolerance  = mass*pSpectrum->Ppm*1e-6;
+		total     += prob;
+		while( (peak_index+1 < Npeaks) && (pSpectrum->Mass[peak_index+1] <= mass) ){
+			peak_index++;
+		}
+		best     = -1;
+		distance = fabs(pSpectrum->Mass[peak_index] - mass);
+		if( distance <= tolerance ){
+			best = peak_index;
+		}
+		if( peak_index+1 < Npeaks ){
+			distance_next = fabs(pSpectrum->Mass[peak_index+1] - mass);
+			if( (distance_next <= tolerance) && ((best < 0) || (distance_next < distance)) ){
+				best = peak_index+1;
+			}
+		}
+		if( 0 <= best ){
+			Theory[best]            += prob;
+			pWork->TheoryMass[best] += prob*mass;
+		}else if( (0 < group_prob) && (mass - group_mass <= tolerance) ){
+			group_prob += prob;
+		}else{
+			group_squares += group_prob*group_prob;
+			group_mass     = mass;
+			group_prob     = prob;
+			pScore->Unobserved++;
+		}
+	}
+	group_squares += group_prob*group_prob;
+
+	//---------------------------------------------------------
+	// Vector sums
+	//---------------------------------------------------------
+	dot              = 0;
+	theory_squares   = 0;
+	observed_squares = 0;
+	peak_index       = 0;
+#ifdef SCORE_SSE2
+	dot2      = _mm_setzero_pd();
+	theory2   = _mm_setzero_pd();
+	observed2 = _mm_setzero_pd();
+	for(; peak_index+1<Npeaks; peak_index+=2){
+		t         = _mm_loadu_pd(Theory+peak_index);
+		o         = _mm_loadu_pd(Observed+peak_index);
+		dot2      = _mm_add_pd(dot2,      _mm_mul_pd(t, o));
+		theory2   = _mm_add_pd(theory2,   _mm_mul_pd(t, t));
+		observed2 = _mm_add_pd(observed2, _mm_mul_pd(o, o));
+	}
+	_mm_storeu_pd(sums, dot2);      dot              = sums[0] + sums[1];
+	_mm_storeu_pd(sums, theory2);   theory_squares   = sums[0] + sums[1];
+	_mm_storeu_pd(sums, observed2); observed_squares = sums[0] + sums[1];
+#endif
+	for(; peak_index<Npeaks; peak_index++){
+		dot              += Theory[peak_index]*Observed[peak_index];
+		theory_squares   += Theory[peak_index]*Theory[peak_index];
+		observed_squares += Observed[peak_index]*Observed[peak_index];
+	}
+	theory_squares += group_squares;
+	pScore->Cosine = (0 < theory_squares) ? dot/sqrt(theory_squares*observed_squares) : 0;
+	if( pScore->Cosine > 1 ){
+		pScore->Cosine = 1;
+	}
+	pScore->SpectralAngle = 1.0 - 2.0*acos(pScore->Cosine)/SCORE_PI;
+
+	//---------------------------------------------------------
+	// Per centroid terms
+	//---------------------------------------------------------
+	pScore->Matched      = 0;
+	pScore->KLDivergence = 0;
+	pScore->Explained    = 0;
+	pScore->Coverage     = 0;
+	ppm        = 0;
+	ppm_weight = 0;
+	base       = 0;
+	for(peak_index=0; peak_index<Npeaks; peak_index++){
+		smoothed = ((0 < total) ? Theory[peak_index]/total : 0) + SCORE_KL_EPSILON;
+		smoothed = smoothed/(1.0 + SCORE_KL_EPSILON*(double)(Npeaks + pScore->Unobserved));
+		pScore->KLDivergence += Observed[peak_index]*log(Observed[peak_index]/smoothed);
+		if( Theory[base] < Theory[peak_index] ){
+			base = peak_index;
+		}
+		if( 0 < Theory[peak_index] ){
+			mass = pWork->TheoryMass[peak_index]/Theory[peak_index];
+			pScore->Matched++;
+			pScore->Explained += Observed[peak_index];
+			pScore->Coverage  += Theory[peak_index];
+			ppm        += Observed[peak_index]*(pSpectrum->Mass[peak_index] - mass)/mass*1e6;
+			ppm_weight += Observed[peak_index];
+		}
+	}
+	pScore->Coverage  = (0 < total) ? pScore->Coverage/total : 0;
+	pScore->MassError = (0 < ppm_weight) ? ppm/ppm_weight : 0;
+
+	//---------------------------------------------------------
+	// Isotope ratios relative to the peak of largest t
+	//---------------------------------------------------------
+	base_theory   = Theory[base];
+	base_observed = Observed[base];
+	if( 0 < base_theory ){
+		pScore->RatioError = group_squares/(base_theory*base_theory);
+		for(peak_index=0; peak_index<Npeaks; peak_index++){
+			ratio = Observed[peak_index]/base_observed - Theory[peak_index]/base_theory;
+			pScore->RatioError += ratio*ratio;
+		}
+		pScore->RatioError = sqrt(pScore->RatioError);
+	}else{
+		pScore->RatioError = 1;
+	}
+	return 0;
+}
+
+//--------------------------------------------------------
+// Score of one candidate (isoDalton_score.h).  Returns 0,
+// or -1 if out of memory.
+//--------------------------------------------------------
+int isoDalton_score(struct score_spectrum *pSpectrum, struct istates_info *pStates, int log10flag, struct spectrum_score *pScore){
+	struct score_work Work;
+	int status;
+
+	status = -1;
+	if( 0 == score_work_init(&Work, pSpectrum->PeakTotal) ){
+		status = score_candidate(pSpectrum, pStates, log10flag, &Work, pScore);
+	}
+	score_work_free(&Work);
+	return status;
+}
+
+static void score_slice_work(void *argument){
+	struct score_slice *pSlice;
+	struct score_work Work;
+	int candidate;
+
+	pSlice = (struct score_slice *)argument;
+	if( 0 != score_work_init(&Work, pSlice->pSpectrum->PeakTotal) ){
+		score_work_free(&Work);
+		pSlice->Failed = 1;
+		return;
+	}
+	for(candidate=pSlice->First; candidate<pSlice->Last; candidate++){
+		if( 0 != score_candidate(pSlice->pSpectrum, &pSlice->Candidates[candidate], pSlice->log10flag, &Work, &pSlice->Scores[candidate]) ){
+			pSlice->Failed = 1;
+			break;
+		}
+	}
+	score_work_free(&Work);
+}
+
+//--------------------------------------------------------
+// Scores of Ncandidates candidates against one spectrum
+// with ThreadTotal threads (the calling thread included).
+// Returns 0, or -1 if out of memory.
+//--------------------------------------------------------
+int isoDalton_score_batch(struct score_spectrum *pSpectrum, struct istates_info *Candidates, int Ncandidates, int log10flag, struct spectrum_score *Scores, int ThreadTotal){
+	struct score_slice Slice[SCORE_MAX_THREADS];
+	int thread_index;
+	int per_thread;
+	int status;
+
+	if( ThreadTotal > SCORE_MAX_THREADS ){
+		ThreadTotal = SCORE_MAX_THREADS;
+	}
+	if( ThreadTotal > Ncandidates ){
+		ThreadTotal = Ncandidates;
+	}
+	if( ThreadTotal < 1 ){
+		ThreadTotal = 1;
+	}
+	per_thread = (Ncandidates + ThreadTotal - 1)/ThreadTotal;
+	for(thread_index=0; thread_index<ThreadTotal; thread_index++){
+		Slice[thread_index].pSpectrum  = pSpectrum;
+		Slice[thread_index].Candidates = Candidates;
+		Slice[thread_index].Scores     = Scores;
+		Slice[thread_index].log10flag  = log10flag;
+		Slice[thread_index].First      = thread_index*per_thread;
+		Slice[thread_index].Last       = Slice[thread_index].First + per_thread;
+		Slice[thread_index].Failed     = 0;
+		if( Slice[thread_index].First > Ncandidates ){
+			Slice[thread_index].First = Ncandidates;
+		}
+		if( Slice[thread_index].Last > Ncandidates ){
+			Slice[thread_index].Last = Ncandidates;
+		}
+	}
+	thread_run_slices(ThreadTotal, score_slice_work, Slice, sizeof(Slice[0]));
+	status = 0;
+	for(thread_index=0; thread_index<ThreadTotal; thread_index++){
+		if( Slice[thread_index].Failed ){
+			status = -1;
+		}
+	}
+	return status;
+}
+
+//--------------------------------------------------------
+// One JSON object on one line
+//--------------------------------------------------------
+static void score_write_number(FILE *pFile, const char *name, double value){
+	char number[FORMAT_DOUBLE_MAX];
+
+	format_double(value, number);
+	fprintf(pFile,",\"%s\":%s",name,number);
+}
+
+void isoDalton_score_write_json(struct spectrum_score *pScore, const char *formula, FILE *pFile){
+	fprintf(pFile,"{\"formula\":\"%s\",\"matched\":%d,\"unobserved\":%d",formula,pScore->Matched,pScore->Unobserved);
+	score_write_number(pFile, "cosine", pScore->Cosine);
+	score_write_number(pFile, "spectral_angle", pScore->SpectralAngle);
+	score_write_number(pFile, "kl_divergence", pScore->KLDivergence);
+	score_write_number(pFile, "ratio_error", pScore->RatioError);
+	score_write_number(pFile, "mass_error_ppm", pScore->MassError);
+	score_write_number(pFile, "explained", pScore->Explained);
+	score_write_number(pFile, "coverage", pScore->Coverage);
+	fprintf(pFile,"}\n");
+}
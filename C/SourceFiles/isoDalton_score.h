@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_score.h                                       */
+/*               Header file for isoDalton_score.cpp, the scoring of     */
+/*               computed isotope states against an observed spectrum   */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_SCORE
+#define ISODALTON_SCORE
+
+#include <stdio.h>
+
+//---------------------------------------------------------------------------------------------
+// Spectrum scoring.  The observed centroids are sorted by mass and their intensities
+// normalized once (isoDalton_score_spectrum_init).  For a candidate, its states are sorted by
+// mass and swept together with the centroids (two pointers): a state goes to the nearest
+// centroid within Ppm of its mass, so the fine structure states under one centroid add up.
+// States matching no centroid are grouped (consecutive states within Ppm of the first) into
+// unobserved peaks.  The theoretical vector t (normalized by the total probability of the
+// states) and the observed vector o then give
+//
+//   Cosine          t.o/(|t||o|)
+//   SpectralAngle   1 - 2*acos(Cosine)/pi, 1 for identical patterns, 0 for orthogonal ones
+//   KLDivergence    sum of o*ln(o/t) over the centroids, t smoothed by SCORE_KL_EPSILON
+//   RatioError      root of the sum of the squared differences of the intensities relative
+//                   to the peak of largest t (isotope ratios), unobserved peaks included
+//   MassError       ppm from the probability weighted mass of the states of each centroid,
+//                   averaged with the observed intensities
+//   Explained       observed intensity of the centroids matched by a state
+//   Coverage        probability of the states matched by a centroid
+//
+// isoDalton_score_batch scores many candidates against one spectrum with ThreadTotal
+// threads, each with its own work arrays; the vector sums use SSE2 when the compiler
+// targets it.
+//---------------------------------------------------------------------------------------------
+#define SCORE_DEFAULT_PPM   5.0
+#define SCORE_KL_EPSILON    1e-6
+#define SCORE_MAX_THREADS   64
+#define SCORE_LINE_MAX      256
+
+struct score_spectrum {
+	int     PeakTotal;
+	double *Mass;          // increasing
+	double *Intensity;     // sum 1
+	double  Ppm;           // match tolerance
+};
+
+struct spectrum_score {
+	int    Matched;        // centroids matched by a state
+	int    Unobserved;     // groups of states matching no centroid
+	double Cosine;
+	double SpectralAngle;
+	double KLDivergence;
+	double RatioError;
+	double MassError;      // ppm
+	double Explained;
+	double Coverage;
+};
+
+int  isoDalton_score_read_peaks(const char *, struct istates_info *);
+int  isoDalton_score_spectrum_init(struct score_spectrum *, struct istates_info *, double);
+void isoDalton_score_spectrum_free(struct score_spectrum *);
+int  isoDalton_score(struct score_spectrum *, struct istates_info *, int, struct spectrum_score *);
+int  isoDalton_score_batch(struct score_spectrum *, struct istates_info *, int, int, struct spectrum_score *, int);
+void isoDalton_score_write_json(struct spectrum_score *, const char *, FILE *);
+
+#endif
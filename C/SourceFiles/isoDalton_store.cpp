@@ -0,0 +1,218 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_store.cpp                                     */
+/*               Source code for the published element table and its   */
+/*               background reload (read-copy-update style swap)         */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_store.h"
+
+//--------------------------------------------------------
+// Check that a data file can be opened (the NIST text
+// reader does not report a missing file)
+//--------------------------------------------------------
+static int store_file_exists(char *path, const char *filename){
+	FILE *pFile;
+	char *pathfilename;
+
+	pathfilename = (char *)malloc((strlen(path)+strlen(filename)+2)*sizeof(char));
+	strcpy(pathfilename,path);
+	strcat(pathfilename,DATA_PATH_SEPARATOR);
+	strcat(pathfilename,filename);
+	pFile = fopen(pathfilename,"r");
+	free(pathfilename);
+	if( NULL == pFile ){
+		return 0;
+	}
+	fclose(pFile);
+	return 1;
+}
+
+//--------------------------------------------------------
+// Build a new element table with the same pipeline as
+// isoDalton_get_isotopes.  Returns NULL if a data file is
+// missing or malformed or the table is not usable.
+//--------------------------------------------------------
+static struct element_table *store_load_table(struct element_store *pStore){
+	struct element_table *pTable;
+
+	if( !store_file_exists(pStore->DataPath,"NIST_isotopes.txt") ||
+		!store_file_exists(pStore->DataPath,"AtomTabl.XML") ||
+		!store_file_exists(pStore->UserDataPath,pStore->UserCompFilename) ){
+		data_error("Error : element table not loaded, a data file is missing\n");
+		return NULL;
+	}
+	pTable = (struct element_table *)calloc(1, sizeof(struct element_table));
+	if( 0 != isoDalton_load_isotopes(pStore->DataPath, pStore->UserDataPath, pStore->UserCompFilename, &pTable->Elements) ){
+		data_error("Error : element table not loaded, a data file is malformed\n");
+		data_free_elements(&pTable->Elements);
+		free(pTable);
+		return NULL;
+	}
+	//---------------------------------------------------
+	// Sanity check: hydrogen and carbon must be present
+	//---------------------------------------------------
+	if( (pTable->Elements.Element[1].NonzeroIsotopeTotal < 1) || (pTable->Elements.Element[6].NonzeroIsotopeTotal < 1) ){
+		data_error("Error : element table not loaded, hydrogen or carbon has no isotopes\n");
+		data_free_elements(&pTable->Elements);
+		free(pTable);
+		return NULL;
+	}
+	return pTable;
+}
+
+//--------------------------------------------------------
+// Load the first table synchronously.  Returns NULL if the
+// table could not be loaded.
+//--------------------------------------------------------
+struct element_store *isoDalton_store_create(char *datapath, char *userdatapath, char *usercompfilename){
+	struct element_store *pStore;
+
+	pStore = (struct element_store *)malloc(sizeof(struct element_store));
+	pStore->DataPath         = (char *)malloc((strlen(datapath)+1)*sizeof(char));
+	pStore->UserDataPath     = (char *)malloc((strlen(userdatapath)+1)*sizeof(char));
+	pStore->UserCompFilename = (char *)malloc((strlen(usercompfilename)+1)*sizeof(char));
+	strcpy(pStore->DataPath,datapath);
+	strcpy(pStore->UserDataPath,userdatapath);
+	strcpy(pStore->UserCompFilename,usercompfilename);
+	pStore->Epoch          = 0;
+	pStore->Readers[0]     = 0;
+	pStore->Readers[1]     = 0;
+	pStore->ReloadRunning  = 0;
+	pStore->ReloadStatus   = 0;
+	pStore->ReloadJoinable = 0;
+	pStore->Generation     = 1;
+	pStore->pCurrent       = store_load_table(pStore);
+	if( NULL == pStore->pCurrent ){
+		free(pStore->DataPath);
+		free(pStore->UserDataPath);
+		free(pStore->UserCompFilename);
+		free(pStore);
+		return NULL;
+	}
+	pStore->pCurrent->Generation = 1;
+	return pStore;
+}
+
+//--------------------------------------------------------
+// Get the current element table.  The table stays valid
+// until isoDalton_store_release is called with the token.
+// Lock free: a reader registers in the current epoch and
+// retries if a reload changed the epoch meanwhile.
+//--------------------------------------------------------
+struct element_list *isoDalton_store_acquire(struct element_store *pStore, int *pToken){
+	long epoch;
+	struct element_table *pTable;
+
+	while(1){
+		epoch = thread_atomic_load(&pStore->Epoch);
+		thread_atomic_add(&pStore->Readers[epoch], 1);
+		if( thread_atomic_load(&pStore->Epoch) == epoch ){
+			break;
+		}
+		thread_atomic_add(&pStore->Readers[epoch], -1);
+	}
+	*pToken = (int)epoch;
+	pTable  = (struct element_table *)thread_atomic_load_pointer((void * volatile *)&pStore->pCurrent);
+	return &pTable->Elements;
+}
+
+void isoDalton_store_release(struct element_store *pStore, int token){
+	thread_atomic_add(&pStore->Readers[token], -1);
+}
+
+long isoDalton_store_generation(struct element_store *pStore){
+	return thread_atomic_load(&pStore->Generation);
+}
+
+//--------------------------------------------------------
+// Background reload: build, publish, wait for the readers
+// of the old epoch (the writer waits, readers never do)
+// and free the old table
+//--------------------------------------------------------
+static void store_reload_thread(void *argument){
+	struct element_store *pStore;
+	struct element_table *pTable;
+	struct element_table *pOld;
+	long epoch;
+
+	pStore = (struct element_store *)argument;
+	pTable = store_load_table(pStore);
+	if( NULL == pTable ){
+		pStore->ReloadStatus = -1;
+		thread_atomic_compare_exchange(&pStore->ReloadRunning, 1, 0);
+		return;
+	}
+	pTable->Generation = thread_atomic_load(&pStore->Generation) + 1;
+
+	pOld  = (struct element_table *)thread_atomic_exchange_pointer((void * volatile *)&pStore->pCurrent, pTable);
+	epoch = thread_atomic_load(&pStore->Epoch);
+	thread_atomic_compare_exchange(&pStore->Epoch, epoch, 1-epoch);
+	thread_atomic_add(&pStore->Generation, 1);
+	while( 0 != thread_atomic_load(&pStore->Readers[epoch]) ){
+		thread_sleep_ms(1);
+	}
+	data_free_elements(&pOld->Elements);
+	free(pOld);
+
+	pStore->ReloadStatus = 0;
+	thread_atomic_compare_exchange(&pStore->ReloadRunning, 1, 0);
+}
+
+//--------------------------------------------------------
+// Start a background reload of the data files.  Returns 0
+// if the reload was started and -1 if one is already
+// running.
+//--------------------------------------------------------
+int isoDalton_store_reload(struct element_store *pStore){
+	if( 0 != thread_atomic_compare_exchange(&pStore->ReloadRunning, 0, 1) ){
+		return -1;
+	}
+	if( 1 == pStore->ReloadJoinable ){
+		thread_join(&pStore->ReloadThread);
+		pStore->ReloadJoinable = 0;
+	}
+	if( 0 != thread_start(&pStore->ReloadThread, store_reload_thread, pStore) ){
+		data_error("Error : could not start the reload thread\n");
+		thread_atomic_compare_exchange(&pStore->ReloadRunning, 1, 0);
+		return -1;
+	}
+	pStore->ReloadJoinable = 1;
+	return 0;
+}
+
+//--------------------------------------------------------
+// Wait for a reload to finish.  Returns 0 if the new table
+// was published and -1 if it was rejected.
+//--------------------------------------------------------
+int isoDalton_store_wait(struct element_store *pStore){
+	if( 1 == pStore->ReloadJoinable ){
+		thread_join(&pStore->ReloadThread);
+		pStore->ReloadJoinable = 0;
+	}
+	return (int)pStore->ReloadStatus;
+}
+
+//--------------------------------------------------------
+// Free the store (no readers may be active)
+//--------------------------------------------------------
+void isoDalton_store_free(struct element_store *pStore){
+	isoDalton_store_wait(pStore);
+	data_free_elements(&pStore->pCurrent->Elements);
+	free(pStore->pCurrent);
+	free(pStore->DataPath);
+	free(pStore->UserDataPath);
+	free(pStore->UserCompFilename);
+	free(pStore);
+}
@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_store.h                                       */
+/*               Header file for isoDalton_store.cpp, which keeps the    */
+/*               element tables of a long running process and reloads   */
+/*               them in the background (read-copy-update)               */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_STORE
+#define ISODALTON_STORE
+
+#include "data.h"
+#include "thread.h"
+
+//---------------------------------------------------------------------------------------------
+// An element table that is never changed once it has been published
+//---------------------------------------------------------------------------------------------
+struct element_table {
+	struct element_list Elements;
+	long                Generation;   // 1 for the first load, incremented by each reload
+};
+//---------------------------------------------------------------------------------------------
+// Structure to contain the published element table.
+// Readers call isoDalton_store_acquire/isoDalton_store_release around each computation;
+// this costs two atomic increments and never blocks.  A reload builds a new table on a
+// background thread, swaps the pointer, and frees the old table once every reader that
+// could have seen it has released it (two reader counters alternate between reloads).
+// isoDalton_store_reload and isoDalton_store_wait are called from one control thread.
+//---------------------------------------------------------------------------------------------
+struct element_store {
+	struct element_table * volatile pCurrent;
+	volatile long        Epoch;          // selects the reader counter new readers use
+	volatile long        Readers[2];     // readers that entered in each epoch
+	volatile long        ReloadRunning;  // 1 while the background reload is running
+	volatile long        ReloadStatus;   // 0 if the last reload was published, -1 if rejected
+	int                  ReloadJoinable;
+	volatile long        Generation;     // generation of the published table
+	char                *DataPath;
+	char                *UserDataPath;
+	char                *UserCompFilename;
+	struct thread_handle ReloadThread;
+};
+
+struct element_store *isoDalton_store_create(char *, char *, char *);
+struct element_list  *isoDalton_store_acquire(struct element_store *, int *);
+void isoDalton_store_release(struct element_store *, int);
+long isoDalton_store_generation(struct element_store *);
+int  isoDalton_store_reload(struct element_store *);
+int  isoDalton_store_wait(struct element_store *);
+void isoDalton_store_free(struct element_store *);
+
+#endif
@@ -0,0 +1,351 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_sweep.cpp                                     */
+/*               Source code for the enrichment sweep.                  */
+/*                                                                       */
+/*               The molecule is split into the swept element and the    */
+/*               rest.  The rest does not depend on the enrichment and   */
+/*               is computed once with the trellis.  For the swept       */
+/*               element with n atoms, k of which are the swept isotope, */
+/*               the probability of a state is                           */
+/*                 C(n,k) f^k (1-f)^(n-k) P(other isotopes of n-k atoms) */
+/*               where the last term uses the renormalized fractions of  */
+/*               the other isotopes and does not depend on f.  The       */
+/*               trellis over the other isotopes gives these states for  */
+/*               every n-k as it goes, so they are computed once too.    */
+/*               Each level then only re-weights the states by the       */
+/*               binomial term and merges the two sorted lists, taking   */
+/*               the Mstates most probable pairs with a heap.            */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_sweep.h"
+#include "sort.h"
+#include <math.h>
+#include <float.h>
+
+//--------------------------------------------------------
+// Max heap of (rest index, element index) pairs keyed by
+// the log10 probability of the pair
+//--------------------------------------------------------
+static void sweep_heap_push(int *Nheap, int *heap_i, int *heap_j, double *heap_p, int i, int j, double p){
+	int child;
+	int parent;
+
+	child = *Nheap;
+	*Nheap += 1;
+	while( child > 0 ){
+		parent = (child-1)/2;
+		if( heap_p[parent] >= p ){
+			break;
+		}
+		heap_i[child] = heap_i[parent];
+		heap_j[child] = heap_j[parent];
+		heap_p[child] = heap_p[parent];
+		child = parent;
+	}
+	heap_i[child] = i;
+	heap_j[child] = j;
+	heap_p[child] = p;
+}
+
+static void sweep_heap_pop(int *Nheap, int *heap_i, int *heap_j, double *heap_p){
+	int parent;
+	int child;
+	int i,j;
+	double p;
+
+	*Nheap -= 1;
+	i = heap_i[*Nheap];
+	j = heap_j[*Nheap];
+	p = heap_p[*Nheap];
+	parent = 0;
+	while( (child = 2*parent+1) < *Nheap ){
+		if( (child+1 < *Nheap) && (heap_p[child+1] > heap_p[child]) ){
+			child++;
+		}
+		if( p >= heap_p[child] ){
+			break;
+		}
+		heap_i[parent] = heap_i[child];
+		heap_j[parent] = heap_j[child];
+		heap_p[parent] = heap_p[child];
+		parent = child;
+	}
+	heap_i[parent] = i;
+	heap_j[parent] = j;
+	heap_p[parent] = p;
+}
+
+
+int isoDalton_enrichment_sweep(struct molecule_info *pMolecule, struct element_list *pElements, int AtomicNumber, int MassNumber, int Nlevels, double *fraction, int Mstates, struct istates_info *pisostates, int log10flag){
+	struct element_info *pElement;
+	struct molecule_info Rest;
+	struct istates_info RestStates;
+	int *rest_AtomCount,*rest_AtomicNumber,*rest_MassNumber;
+	int Natoms;
+	int Nother;
+	int swept_index;
+	int index1,index2,index3;
+	int level_index;
+	int k;
+	double swept_mass;
+	double other_sum;
+	double *other_mass,*other_fraction;
+	double *log_binomial;
+	double log_f,log_g;
+	double weight;
+	//---------------------------------------------------------
+	// States of the other isotopes for m = 0..Natoms atoms,
+	// stored one after the other (log10 probabilities)
+	//---------------------------------------------------------
+	double *other_state_mass,*other_state_prob;
+	int *other_offset,*other_count;
+	int other_total;
+	double *state1_mass,*state1_prob,*state2_mass,*state2_prob,*state3_mass,*state3_prob;
+	int Nstate1,Nstate2;
+	//---------------------------------------------------------
+	// Element states of one level and the merge heap
+	//---------------------------------------------------------
+	double *element_mass,*element_prob;
+	int Nelement;
+	int *heap_i,*heap_j;
+	double *heap_p;
+	int Nheap;
+	int Nout;
+	int i,j;
+
+	//---------------------------------------------------------
+	// Check the arguments
+	//---------------------------------------------------------
+	if( (AtomicNumber < 1) || (AtomicNumber >= ELEMENT_TOTAL) ){
+		data_error("Error : enrichment sweep : atomic number %d is not valid\n",AtomicNumber);
+		return -1;
+	}
+	pElement    = &pElements->Element[AtomicNumber];
+	swept_index = isoDalton_get_isotope_index(pElement, MassNumber);
+	if( swept_index < 0 ){
+		data_error("Error : enrichment sweep : isotope %d of atomic number %d is not in the element list\n",MassNumber,AtomicNumber);
+		return -1;
+	}
+	for(level_index=0; level_index<Nlevels; level_index++){
+		if( (fraction[level_index] < 0) || (1.0 < fraction[level_index]) ){
+			data_error("Error : enrichment sweep : fraction %f is not in [0,1]\n",fraction[level_index]);
+			return -1;
+		}
+	}
+
+	//---------------------------------------------------------
+	// Split the molecule into the swept element and the rest
+	//---------------------------------------------------------
+	rest_AtomCount    = (int *)malloc((pMolecule->ElementTotal+1)*sizeof(int));
+	rest_AtomicNumber = (int *)malloc((pMolecule->ElementTotal+1)*sizeof(int));
+	rest_MassNumber   = (int *)malloc((pMolecule->ElementTotal+1)*sizeof(int));
+	Rest.Formula      = pMolecule->Formula;
+	Rest.ElementTotal = 0;
+	Rest.AtomCount    = rest_AtomCount;
+	Rest.AtomicNumber = rest_AtomicNumber;
+	Rest.MassNumber   = rest_MassNumber;
+	Natoms = 0;
+	for(index1=0; index1<pMolecule->ElementTotal; index1++){
+		index2 = (NULL == pMolecule->MassNumber) ? 0 : pMolecule->MassNumber[index1];
+		if( (AtomicNumber == pMolecule->AtomicNumber[index1]) && (0 == index2) ){
+			Natoms += pMolecule->AtomCount[index1];
+		}else{
+			rest_AtomCount[Rest.ElementTotal]    = pMolecule->AtomCount[index1];
+			rest_AtomicNumber[Rest.ElementTotal] = pMolecule->AtomicNumber[index1];
+			rest_MassNumber[Rest.ElementTotal]   = index2;
+			Rest.ElementTotal++;
+		}
+	}
+	if( 0 == Natoms ){
+		data_error("Error : enrichment sweep : %s is not in molecule [%s]\n",pElement->Name,pMolecule->Formula);
+		free(rest_AtomCount);
+		free(rest_AtomicNumber);
+		free(rest_MassNumber);
+		return -1;
+	}
+
+	//---------------------------------------------------------
+	// The rest of the molecule, computed once
+	//---------------------------------------------------------
+	RestStates.StateTotal = Mstates;
+	RestStates.mass = (double *)malloc(Mstates*sizeof(double));
+	RestStates.prob = (double *)malloc(Mstates*sizeof(double));
+	isoDalton_exact_mass(&Rest, pElements, Mstates, &RestStates, 1);
+
+	//---------------------------------------------------------
+	// Other isotopes of the swept element with renormalized
+	// fractions
+	//---------------------------------------------------------
+	swept_mass     = pElement->Isotope[swept_index]->AtomicMass;
+	other_mass     = (double *)malloc((pElement->IsotopeTotal+1)*sizeof(double));
+	other_fraction = (double *)malloc((pElement->IsotopeTotal+1)*sizeof(double));
+	Nother    = 0;
+	other_sum = 0;
+	for(index1=0; index1<pElement->NonzeroIsotopeTotal; index1++){
+		index3 = pElement->NonzeroIsotopeIndex[index1];
+		if( index3 != swept_index ){
+			other_mass[Nother]     = pElement->Isotope[index3]->AtomicMass;
+			other_fraction[Nother] = pElement->Isotope[index3]->CompositionFraction;
+			other_sum += other_fraction[Nother];
+			Nother++;
+		}
+	}
+	for(index1=0; index1<Nother; index1++){
+		other_fraction[index1] = other_fraction[index1]/other_sum;
+	}
+
+	//---------------------------------------------------------
+	// Trellis over the other isotopes, keeping the states
+	// after each atom
+	//---------------------------------------------------------
+	state1_mass = (double *)malloc(Mstates*(Nother+1)*sizeof(double));
+	state1_prob = (double *)malloc(Mstates*(Nother+1)*sizeof(double));
+	state2_mass = (double *)malloc(Mstates*(Nother+1)*sizeof(double));
+	state2_prob = (double *)malloc(Mstates*(Nother+1)*sizeof(double));
+	other_offset = (int *)malloc((Natoms+1)*sizeof(int));
+	other_count  = (int *)malloc((Natoms+1)*sizeof(int));
+	other_total  = 0;
+	other_state_mass = NULL;
+	other_state_prob = NULL;
+	state1_mass[0] = 0;
+	state1_prob[0] = 0;
+	Nstate1 = 1;
+	for(index1=0; index1<=Natoms; index1++){
+		other_offset[index1] = other_total;
+		other_count[index1]  = Nstate1;
+		other_total         += Nstate1;
+		other_state_mass = (double *)realloc(other_state_mass,other_total*sizeof(double));
+		other_state_prob = (double *)realloc(other_state_prob,other_total*sizeof(double));
+		for(index2=0; index2<Nstate1; index2++){
+			other_state_mass[other_offset[index1]+index2] = state1_mass[index2];
+			other_state_prob[other_offset[index1]+index2] = state1_prob[index2];
+		}
+		if( index1 == Natoms ){
+			break;
+		}
+		Nstate2 = isoDalton_trellis_step(Nstate1, state1_mass, state1_prob, Nother, other_mass, other_fraction, state2_mass, state2_prob, 1);
+		state3_mass = state1_mass;
+		state3_prob = state1_prob;
+		state1_mass = state2_mass;
+		state1_prob = state2_prob;
+		state2_mass = state3_mass;
+		state2_prob = state3_prob;
+		Nstate1 = (Nstate2 > Mstates) ? Mstates : Nstate2;
+	}
+	free(state1_mass);
+	free(state1_prob);
+	free(state2_mass);
+	free(state2_prob);
+
+	//---------------------------------------------------------
+	// log10 C(Natoms,k)
+	//---------------------------------------------------------
+	log_binomial = (double *)malloc((Natoms+1)*sizeof(double));
+	log_binomial[0] = 0;
+	for(k=1; k<=Natoms; k++){
+		log_binomial[k] = log_binomial[k-1] + log10((double)(Natoms-k+1)) - log10((double)k);
+	}
+
+	element_mass = (double *)malloc(other_total*sizeof(double));
+	element_prob = (double *)malloc(other_total*sizeof(double));
+	heap_i = (int *)malloc((Mstates+2)*sizeof(int));
+	heap_j = (int *)malloc((Mstates+2)*sizeof(int));
+	heap_p = (double *)malloc((Mstates+2)*sizeof(double));
+
+	for(level_index=0; level_index<Nlevels; level_index++){
+		//-----------------------------------------------------
+		// Re-weight the element states for this level.  A
+		// level of 0 or 1 only has the k = 0 or k = n term;
+		// with no other isotopes only k = n is possible.
+		//-----------------------------------------------------
+		log_f = (fraction[level_index] > 0)   ? log10(fraction[level_index])     : 0;
+		log_g = (fraction[level_index] < 1.0) ? log10(1.0-fraction[level_index]) : 0;
+		Nelement = 0;
+		for(k=0; k<=Natoms; k++){
+			if( ((k > 0) && (fraction[level_index] <= 0)) || ((k < Natoms) && (fraction[level_index] >= 1.0)) ){
+				continue;
+			}
+			if( (0 == Nother) && (k < Natoms) ){
+				continue;
+			}
+			weight = log_binomial[k] + (double)k*log_f + (double)(Natoms-k)*log_g;
+			index1 = other_offset[Natoms-k];
+			for(index2=0; index2<other_count[Natoms-k]; index2++){
+				element_mass[Nelement] = other_state_mass[index1+index2] + (double)k*swept_mass;
+				element_prob[Nelement] = other_state_prob[index1+index2] + weight;
+				Nelement++;
+			}
+		}
+		heapsort_2dbl_down(Nelement, element_prob, element_mass);
+		if( Nelement > Mstates ){
+			Nelement = Mstates;
+		}
+
+		//-----------------------------------------------------
+		// The Mstates most probable (rest, element) pairs.
+		// Both lists are sorted by decreasing probability so
+		// the pairs come out of the heap in that order.
+		//-----------------------------------------------------
+		Nheap = 0;
+		Nout  = 0;
+		if( (RestStates.StateTotal > 0) && (Nelement > 0) ){
+			sweep_heap_push(&Nheap, heap_i, heap_j, heap_p, 0, 0, RestStates.prob[0]+element_prob[0]);
+		}
+		while( (Nheap > 0) && (Nout < Mstates) ){
+			i = heap_i[0];
+			j = heap_j[0];
+			pisostates[level_index].mass[Nout] = RestStates.mass[i] + element_mass[j];
+			pisostates[level_index].prob[Nout] = heap_p[0];
+			Nout++;
+			sweep_heap_pop(&Nheap, heap_i, heap_j, heap_p);
+			if( j+1 < Nelement ){
+				sweep_heap_push(&Nheap, heap_i, heap_j, heap_p, i, j+1, RestStates.prob[i]+element_prob[j+1]);
+			}
+			if( (0 == j) && (i+1 < RestStates.StateTotal) ){
+				sweep_heap_push(&Nheap, heap_i, heap_j, heap_p, i+1, 0, RestStates.prob[i+1]+element_prob[0]);
+			}
+		}
+		for(index1=0; index1<Mstates; index1++){
+			if( index1 < Nout ){
+				if(1 != log10flag ){
+					pisostates[level_index].prob[index1] = pow(10.0,pisostates[level_index].prob[index1]);
+				}
+			}else{
+				pisostates[level_index].mass[index1] = 0;
+				pisostates[level_index].prob[index1] = (1 == log10flag) ? -DBL_MAX : 0;
+			}
+		}
+		pisostates[level_index].StateTotal = Nout;
+	}
+
+	free(heap_i);
+	free(heap_j);
+	free(heap_p);
+	free(element_mass);
+	free(element_prob);
+	free(log_binomial);
+	free(other_state_mass);
+	free(other_state_prob);
+	free(other_offset);
+	free(other_count);
+	free(other_mass);
+	free(other_fraction);
+	free(RestStates.mass);
+	free(RestStates.prob);
+	free(rest_AtomCount);
+	free(rest_AtomicNumber);
+	free(rest_MassNumber);
+	return 0;
+}
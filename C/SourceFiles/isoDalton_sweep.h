@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_sweep.h                                       */
+/*               Header file for isoDalton_sweep.cpp, which computes the */
+/*               isotope distributions of a molecule over a list of      */
+/*               enrichment levels of one isotope in a single pass       */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_SWEEP
+#define ISODALTON_SWEEP
+
+#include "data.h"
+
+//---------------------------------------------------------------------------------------------
+// Enrichment sweep
+//   pMolecule       molecule (entries of the swept element with a fixed isotope, e.g. [13C],
+//                   are not swept)
+//   AtomicNumber    swept element, e.g. 6
+//   MassNumber      swept isotope, e.g. 13
+//   Nlevels         number of enrichment levels
+//   fraction        fraction of the swept isotope at each level, in [0,1].  The other
+//                   isotopes of the element keep their relative natural fractions.
+//   Mstates         number of states of each distribution
+//   pisostates      Nlevels results; mass and prob of each must hold Mstates values
+// Returns 0 on success and -1 on error.
+//---------------------------------------------------------------------------------------------
+int isoDalton_enrichment_sweep(struct molecule_info *, struct element_list *, int, int, int, double *, int, struct istates_info *, int);
+
+#endif
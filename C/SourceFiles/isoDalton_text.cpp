@@ -0,0 +1,286 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_text.cpp                                      */
+/*               Buffered TSV, CSV and NDJSON writers.  Each line is     */
+/*               formatted directly into a large buffer that is written  */
+/*               with one fwrite when it fills, and the numbers use the  */
+/*               shortest round trip formatting of format.cpp instead of */
+/*               fprintf.                                                */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton.h"
+#include "isoDalton_text.h"
+#include "format.h"
+#include <math.h>
+
+// Longest text of one state: two numbers, two separators and the line end
+#define TEXT_STATE_MAX (2*FORMAT_DOUBLE_MAX + 4)
+#define TEXT_FIELD_MAX 2048   // formula fields up to this size are kept on the stack
+
+//--------------------------------------------------------
+// Write out the buffer
+//--------------------------------------------------------
+static void text_flush(struct text_writer *pWriter){
+	if( 0 < pWriter->Used ){
+		if( pWriter->Used != fwrite(pWriter->Buffer, 1, pWriter->Used, pWriter->pFile) ){
+			pWriter->WriteError = 1;
+		}
+		pWriter->Used = 0;
+	}
+}
+
+//--------------------------------------------------------
+// Make room for Nbytes (Nbytes <= TEXT_BUFFER_SIZE)
+//--------------------------------------------------------
+static char *text_reserve(struct text_writer *pWriter, size_t Nbytes){
+	if( pWriter->Used + Nbytes > TEXT_BUFFER_SIZE ){
+		text_flush(pWriter);
+	}
+	return &pWriter->Buffer[pWriter->Used];
+}
+
+static void text_append(struct text_writer *pWriter, const char *text, size_t length){
+	if( length > TEXT_BUFFER_SIZE/2 ){
+		text_flush(pWriter);
+		if( length != fwrite(text, 1, length, pWriter->pFile) ){
+			pWriter->WriteError = 1;
+		}
+		return;
+	}
+	memcpy(text_reserve(pWriter, length), text, length);
+	pWriter->Used += length;
+}
+
+static void text_append_char(struct text_writer *pWriter, char ch){
+	*text_reserve(pWriter, 1) = ch;
+	pWriter->Used++;
+}
+
+//--------------------------------------------------------
+// Formula field of a TSV or CSV line.  field must hold
+// 2*strlen(text)+3 characters.  Returns the length.
+//--------------------------------------------------------
+static size_t text_format_field(int Format, const char *text, char *field){
+	const char *pChar;
+	size_t length;
+
+	length = 0;
+	if( TEXT_FORMAT_TSV == Format ){
+		//------------------------------------------------
+		// TSV has no quoting: tabs and line breaks become
+		// spaces
+		//------------------------------------------------
+		for(pChar=text; '\0'!=*pChar; pChar++){
+			field[length++] = (('\t' == *pChar) || ('\n' == *pChar) || ('\r' == *pChar)) ? ' ' : *pChar;
+		}
+		return length;
+	}
+	if( NULL == strpbrk(text, ",\"\r\n") ){
+		length = strlen(text);
+		memcpy(field, text, length);
+		return length;
+	}
+	field[length++] = '"';
+	for(pChar=text; '\0'!=*pChar; pChar++){
+		if( '"' == *pChar ){
+			field[length++] = '"';
+		}
+		field[length++] = *pChar;
+	}
+	field[length++] = '"';
+	return length;
+}
+
+static void text_append_json_string(struct text_writer *pWriter, const char *text){
+	const char *pChar;
+	char escape[8];
+	const char *hex = "0123456789abcdef";
+
+	text_append_char(pWriter, '"');
+	for(pChar=text; '\0'!=*pChar; pChar++){
+		if( ('"' == *pChar) || ('\\' == *pChar) ){
+			text_append_char(pWriter, '\\');
+			text_append_char(pWriter, *pChar);
+		}else if( (unsigned char)*pChar < 0x20 ){
+			escape[0] = '\\';
+			escape[1] = 'u';
+			escape[2] = '0';
+			escape[3] = '0';
+			escape[4] = hex[(*pChar >> 4) & 0xF];
+			escape[5] = hex[*pChar & 0xF];
+			text_append(pWriter, escape, 6);
+		}else{
+			text_append_char(pWriter, *pChar);
+		}
+	}
+	text_append_char(pWriter, '"');
+}
+
+//--------------------------------------------------------
+// JSON has no infinity or NaN
+//--------------------------------------------------------
+static int text_format_json_number(double value, char *buffer){
+	if( (value != value) || (value - value != 0.0) ){
+		strcpy(buffer, "null");
+		return 4;
+	}
+	return format_double(value, buffer);
+}
+
+//--------------------------------------------------------
+// Returns 0 on success and -1 if the buffer could not be
+// allocated.  TSV and CSV start with a header line.
+//--------------------------------------------------------
+int isoDalton_text_writer_open(struct text_writer *pWriter, FILE *pFile, int Format, int log10flag){
+	const char *header;
+
+	pWriter->pFile      = pFile;
+	pWriter->Format     = Format;
+	pWriter->log10flag  = log10flag;
+	pWriter->Used       = 0;
+	pWriter->WriteError = 0;
+	pWriter->Buffer     = (char *)malloc(TEXT_BUFFER_SIZE);
+	if( NULL == pWriter->Buffer ){
+		data_error("Error : could not allocate the text output buffer\n");
+		return -1;
+	}
+	if( TEXT_FORMAT_TSV == Format ){
+		header = log10flag ? "formula\tmass\tlog10_probability\n" : "formula\tmass\tprobability\n";
+		text_append(pWriter, header, strlen(header));
+	}else if( TEXT_FORMAT_CSV == Format ){
+		header = log10flag ? "formula,mass,log10_probability\n" : "formula,mass,probability\n";
+		text_append(pWriter, header, strlen(header));
+	}
+	return 0;
+}
+
+//--------------------------------------------------------
+// Append the states of one molecule.  Returns 0, or -1
+// after a write error.
+//--------------------------------------------------------
+int isoDalton_text_write(struct text_writer *pWriter, const char *formula, struct istates_info *pStates){
+	char field[TEXT_FIELD_MAX];
+	char *pField;
+	char *pOut;
+	char separator;
+	size_t field_length;
+	size_t length;
+	int state_index;
+
+	if( TEXT_FORMAT_NDJSON == pWriter->Format ){
+		text_append(pWriter, "{\"formula\":", 11);
+		text_append_json_string(pWriter, formula);
+		text_append(pWriter, ",\"states\":", 10);
+		pOut = text_reserve(pWriter, FORMAT_DOUBLE_MAX);
+		pWriter->Used += format_int(pStates->StateTotal, pOut);
+		text_append(pWriter, ",\"mass\":[", 9);
+		for(state_index=0; state_index<pStates->StateTotal; state_index++){
+			pOut = text_reserve(pWriter, FORMAT_DOUBLE_MAX + 1);
+			if( 0 < state_index ){
+				*pOut++ = ',';
+				pWriter->Used++;
+			}
+			pWriter->Used += text_format_json_number(pStates->mass[state_index], pOut);
+		}
+		if( pWriter->log10flag ){
+			text_append(pWriter, "],\"log10_prob\":[", 16);
+		}else{
+			text_append(pWriter, "],\"prob\":[", 10);
+		}
+		for(state_index=0; state_index<pStates->StateTotal; state_index++){
+			pOut = text_reserve(pWriter, FORMAT_DOUBLE_MAX + 1);
+			if( 0 < state_index ){
+				*pOut++ = ',';
+				pWriter->Used++;
+			}
+			pWriter->Used += text_format_json_number(pStates->prob[state_index], pOut);
+		}
+		text_append(pWriter, "]}\n", 3);
+		return pWriter->WriteError ? -1 : 0;
+	}
+
+	//----------------------------------------------------
+	// TSV and CSV: the formula field is formatted once
+	// and copied to each line
+	//----------------------------------------------------
+	separator = (TEXT_FORMAT_TSV == pWriter->Format) ? '\t' : ',';
+	pField    = field;
+	if( 2*strlen(formula) + 3 > TEXT_FIELD_MAX ){
+		pField = (char *)malloc(2*strlen(formula) + 3);
+		if( NULL == pField ){
+			data_error("Error : could not allocate the formula field\n");
+			return -1;
+		}
+	}
+	field_length = text_format_field(pWriter->Format, formula, pField);
+	for(state_index=0; state_index<pStates->StateTotal; state_index++){
+		text_append(pWriter, pField, field_length);
+		pOut = text_reserve(pWriter, TEXT_STATE_MAX);
+		length  = 0;
+		pOut[length++] = separator;
+		length += format_double(pStates->mass[state_index], &pOut[length]);
+		pOut[length++] = separator;
+		length += format_double(pStates->prob[state_index], &pOut[length]);
+		pOut[length++] = '\n';
+		pWriter->Used += length;
+	}
+	if( field != pField ){
+		free(pField);
+	}
+	return pWriter->WriteError ? -1 : 0;
+}
+
+//--------------------------------------------------------
+// NDJSON records the error in the stream; TSV and CSV
+// have no place for it and write nothing
+//--------------------------------------------------------
+int isoDalton_text_write_error(struct text_writer *pWriter, const char *formula, const char *message){
+	if( TEXT_FORMAT_NDJSON == pWriter->Format ){
+		text_append(pWriter, "{\"formula\":", 11);
+		text_append_json_string(pWriter, formula);
+		text_append(pWriter, ",\"error\":", 9);
+		text_append_json_string(pWriter, message);
+		text_append(pWriter, "}\n", 2);
+	}
+	return pWriter->WriteError ? -1 : 0;
+}
+
+//--------------------------------------------------------
+// Flush and free the buffer (the file stays open).
+// Returns 0, or -1 if any write failed.
+//--------------------------------------------------------
+int isoDalton_text_writer_close(struct text_writer *pWriter){
+	text_flush(pWriter);
+	free(pWriter->Buffer);
+	pWriter->Buffer = NULL;
+	if( 0 != fflush(pWriter->pFile) ){
+		pWriter->WriteError = 1;
+	}
+	return pWriter->WriteError ? -1 : 0;
+}
+
+//--------------------------------------------------------
+// "tsv", "csv" or "ndjson" to a TEXT_FORMAT code, or -1
+//--------------------------------------------------------
+int isoDalton_text_format_code(const char *name){
+	if( 0 == strcmp(name, "tsv") ){
+		return TEXT_FORMAT_TSV;
+	}
+	if( 0 == strcmp(name, "csv") ){
+		return TEXT_FORMAT_CSV;
+	}
+	if( 0 == strcmp(name, "ndjson") ){
+		return TEXT_FORMAT_NDJSON;
+	}
+	return -1;
+}
@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_text.h                                        */
+/*               Header file for isoDalton_text.cpp, buffered TSV, CSV   */
+/*               and NDJSON writers for isotope distributions            */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_TEXT
+#define ISODALTON_TEXT
+
+#include "data.h"
+
+//---------------------------------------------------------------------------------------------
+// Formats.  Masses and probabilities are written with the fewest digits that read back
+// (strtod) as the same double, so the files are lossless.
+//
+//   TEXT_FORMAT_TSV     header line, then one line per state:  formula<TAB>mass<TAB>probability
+//   TEXT_FORMAT_CSV     the same with commas; a formula with , " or a line break is quoted
+//   TEXT_FORMAT_NDJSON  one JSON object per molecule and line:
+//                       {"formula":"C2H6O","states":2,"mass":[46.0418,47.0452],"prob":[0.97,0.02]}
+//                       {"formula":"Qq","error":"unknown element"}
+//
+// The probability column is named log10_probability (TSV, CSV) or "log10_prob" (NDJSON) when
+// the probabilities are log10 values.  A log10 probability of -infinity is written as -inf in
+// TSV and CSV and as null in NDJSON.
+//---------------------------------------------------------------------------------------------
+#define TEXT_FORMAT_TSV      0
+#define TEXT_FORMAT_CSV      1
+#define TEXT_FORMAT_NDJSON   2
+#define TEXT_BUFFER_SIZE     (1<<20)   // bytes collected before each fwrite
+
+struct text_writer {
+	FILE  *pFile;
+	int    Format;
+	int    log10flag;
+	char  *Buffer;      // TEXT_BUFFER_SIZE bytes
+	size_t Used;
+	int    WriteError;  // 1 after a failed fwrite
+};
+
+int isoDalton_text_writer_open(struct text_writer *, FILE *, int, int);
+int isoDalton_text_write(struct text_writer *, const char *, struct istates_info *);
+int isoDalton_text_write_error(struct text_writer *, const char *, const char *);
+int isoDalton_text_writer_close(struct text_writer *);
+int isoDalton_text_format_code(const char *);
+
+#endif
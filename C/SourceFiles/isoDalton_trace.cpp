@@ -0,0 +1,277 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_trace.cpp                                     */
+/*               Instrumentation of the trellis: wall time per stage and */
+/*               per element and the state counts of every step, with    */
+/*               JSON and CSV export, and the probability loss report.   */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#include "isoDalton_trace.h"
+#include "format.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TraceStageName[TRACE_STAGE_TOTAL] = {"expand","mass_sort","combine","prob_sort","truncate"};
+
+void isoDalton_trace_init(struct exact_mass_trace *pTrace){
+	memset(pTrace, 0, sizeof(struct exact_mass_trace));
+	pTrace->Step = NULL;
+}
+
+void isoDalton_trace_free(struct exact_mass_trace *pTrace){
+	free(pTrace->Step);
+	pTrace->Step         = NULL;
+	pTrace->StepCapacity = 0;
+	pTrace->StepTotal    = 0;
+}
+
+//--------------------------------------------------------
+// Called by the engine at the start of a computation
+//--------------------------------------------------------
+void isoDalton_trace_reset(struct exact_mass_trace *pTrace, int Mstates, int log10flag){
+	int stage_index;
+
+	pTrace->Mstates      = Mstates;
+	pTrace->log10flag    = log10flag;
+	pTrace->TotalSeconds = 0;
+	pTrace->SetupSeconds = 0;
+	for(stage_index=0; stage_index<TRACE_STAGE_TOTAL; stage_index++){
+		pTrace->Seconds[stage_index] = 0;
+	}
+	pTrace->ElementTotal = 0;
+	pTrace->StepTotal    = 0;
+}
+
+//--------------------------------------------------------
+// Append a trellis element, returns its index
+//--------------------------------------------------------
+int isoDalton_trace_add_element(struct exact_mass_trace *pTrace, int AtomicNumber, int AtomCount, int IsotopeTotal){
+	struct trace_element *pElement;
+	int stage_index;
+
+	pElement = &pTrace->Element[pTrace->ElementTotal];
+	pElement->AtomicNumber = AtomicNumber;
+	pElement->AtomCount    = AtomCount;
+	pElement->IsotopeTotal = IsotopeTotal;
+	for(stage_index=0; stage_index<TRACE_STAGE_TOTAL; stage_index++){
+		pElement->Seconds[stage_index] = 0;
+	}
+	pElement->Generated = 0;
+	pElement->Combined  = 0;
+	pElement->Kept      = 0;
+	return pTrace->ElementTotal++;
+}
+
+//--------------------------------------------------------
+// Record one step and add its stage times
+//--------------------------------------------------------
+void isoDalton_trace_add_step(struct exact_mass_trace *pTrace, int element, int atom, int generated, int combined, int kept, double *stage_seconds){
+	struct trace_element *pElement;
+	struct trace_step *pStep;
+	int stage_index;
+
+	if( pTrace->StepTotal == pTrace->StepCapacity ){
+		pTrace->StepCapacity = (0 == pTrace->StepCapacity) ? 1024 : 2*pTrace->StepCapacity;
+		pTrace->Step = (struct trace_step *)realloc(pTrace->Step, pTrace->StepCapacity*sizeof(struct trace_step));
+	}
+	pStep = &pTrace->Step[pTrace->StepTotal++];
+	pStep->Element   = element;
+	pStep->Atom      = atom;
+	pStep->Generated = generated;
+	pStep->Combined  = combined;
+	pStep->Kept      = kept;
+
+	pElement = &pTrace->Element[element];
+	pElement->Generated += generated;
+	pElement->Combined  += combined;
+	pElement->Kept      += kept;
+	for(stage_index=0; stage_index<TRACE_STAGE_TOTAL; stage_index++){
+		pElement->Seconds[stage_index] += stage_seconds[stage_index];
+		pTrace->Seconds[stage_index]   += stage_seconds[stage_index];
+	}
+}
+
+const char *isoDalton_trace_stage_name(int stage){
+	return ((0 <= stage) && (stage < TRACE_STAGE_TOTAL)) ? TraceStageName[stage] : "unknown";
+}
+
+//--------------------------------------------------------
+// Numbers in the shortest form that reads back exactly
+//--------------------------------------------------------
+static void trace_write_number(FILE *pFile, double value){
+	char number[FORMAT_DOUBLE_MAX];
+
+	format_double(value, number);
+	fputs(number, pFile);
+}
+
+static void trace_write_stage_seconds(FILE *pFile, double *seconds){
+	int stage_index;
+
+	fputc('{', pFile);
+	for(stage_index=0; stage_index<TRACE_STAGE_TOTAL; stage_index++){
+		fprintf(pFile,"%s\"%s\":",(0 < stage_index) ? "," : "",TraceStageName[stage_index]);
+		trace_write_number(pFile, seconds[stage_index]);
+	}
+	fputc('}', pFile);
+}
+
+//--------------------------------------------------------
+// One JSON object on one line.  The formula is written as
+// given (formulas do not contain quotes or backslashes).
+//--------------------------------------------------------
+void isoDalton_trace_write_json(struct exact_mass_trace *pTrace, const char *formula, FILE *pFile){
+	struct trace_element *pElement;
+	struct trace_step *pStep;
+	int element_index;
+	int step_index;
+
+	fprintf(pFile,"{\"formula\":\"%s\",\"Mstates\":%d,\"log10\":%d,\"total_s\":",formula,pTrace->Mstates,pTrace->log10flag);
+	trace_write_number(pFile, pTrace->TotalSeconds);
+	fprintf(pFile,",\"setup_s\":");
+	trace_write_number(pFile, pTrace->SetupSeconds);
+	fprintf(pFile,",\"stage_s\":");
+	trace_write_stage_seconds(pFile, pTrace->Seconds);
+	fprintf(pFile,",\"elements\":[");
+	for(element_index=0; element_index<pTrace->ElementTotal; element_index++){
+		pElement = &pTrace->Element[element_index];
+		fprintf(pFile,"%s{\"atomic_number\":%d,\"atoms\":%d,\"isotopes\":%d,\"generated\":%.0f,\"combined\":%.0f,\"kept\":%.0f,\"stage_s\":",
+			(0 < element_index) ? "," : "",pElement->AtomicNumber,pElement->AtomCount,pElement->IsotopeTotal,pElement->Generated,pElement->Combined,pElement->Kept);
+		trace_write_stage_seconds(pFile, pElement->Seconds);
+		fputc('}', pFile);
+	}
+	//----------------------------------------------------
+	// Steps as parallel arrays to keep long traces short
+	//----------------------------------------------------
+	fprintf(pFile,"],\"steps\":{\"element\":[");
+	for(step_index=0, pStep=pTrace->Step; step_index<pTrace->StepTotal; step_index++, pStep++){
+		fprintf(pFile,"%s%d",(0 < step_index) ? "," : "",pStep->Element);
+	}
+	fprintf(pFile,"],\"generated\":[");
+	for(step_index=0, pStep=pTrace->Step; step_index<pTrace->StepTotal; step_index++, pStep++){
+		fprintf(pFile,"%s%d",(0 < step_index) ? "," : "",pStep->Generated);
+	}
+	fprintf(pFile,"],\"combined\":[");
+	for(step_index=0, pStep=pTrace->Step; step_index<pTrace->StepTotal; step_index++, pStep++){
+		fprintf(pFile,"%s%d",(0 < step_index) ? "," : "",pStep->Combined);
+	}
+	fprintf(pFile,"],\"kept\":[");
+	for(step_index=0, pStep=pTrace->Step; step_index<pTrace->StepTotal; step_index++, pStep++){
+		fprintf(pFile,"%s%d",(0 < step_index) ? "," : "",pStep->Kept);
+	}
+	fprintf(pFile,"]}}\n");
+}
+
+//--------------------------------------------------------
+// CSV: one "element" row per trellis element (counts are
+// sums, times per stage) followed by one "step" row per
+// atom (counts only)
+//--------------------------------------------------------
+void isoDalton_trace_write_csv_header(FILE *pFile){
+	int stage_index;
+
+	fprintf(pFile,"formula,record,element,atomic_number,atom,generated,combined,kept");
+	for(stage_index=0; stage_index<TRACE_STAGE_TOTAL; stage_index++){
+		fprintf(pFile,",%s_s",TraceStageName[stage_index]);
+	}
+	fputc('\n', pFile);
+}
+
+void isoDalton_trace_write_csv(struct exact_mass_trace *pTrace, const char *formula, FILE *pFile){
+	struct trace_element *pElement;
+	struct trace_step *pStep;
+	int element_index;
+	int step_index;
+	int stage_index;
+
+	for(element_index=0; element_index<pTrace->ElementTotal; element_index++){
+		pElement = &pTrace->Element[element_index];
+		fprintf(pFile,"%s,element,%d,%d,%d,%.0f,%.0f,%.0f",formula,element_index,pElement->AtomicNumber,pElement->AtomCount,pElement->Generated,pElement->Combined,pElement->Kept);
+		for(stage_index=0; stage_index<TRACE_STAGE_TOTAL; stage_index++){
+			fputc(',', pFile);
+			trace_write_number(pFile, pElement->Seconds[stage_index]);
+		}
+		fputc('\n', pFile);
+	}
+	for(step_index=0, pStep=pTrace->Step; step_index<pTrace->StepTotal; step_index++, pStep++){
+		fprintf(pFile,"%s,step,%d,%d,%d,%d,%d,%d,,,,,\n",formula,pStep->Element,pTrace->Element[pStep->Element].AtomicNumber,pStep->Atom,pStep->Generated,pStep->Combined,pStep->Kept);
+	}
+}
+
+//--------------------------------------------------------
+// Budget and action of isoDalton_exact_mass_loss
+//--------------------------------------------------------
+void isoDalton_loss_init(struct exact_mass_loss *pLoss, double Budget, int Action, int MaxStates){
+	memset(pLoss, 0, sizeof(struct exact_mass_loss));
+	pLoss->Budget    = Budget;
+	pLoss->Action    = Action;
+	pLoss->MaxStates = MaxStates;
+}
+
+void isoDalton_loss_write_json(struct exact_mass_loss *pLoss, const char *formula, FILE *pFile){
+	struct loss_element *pElement;
+	int element_index;
+
+	fprintf(pFile,"{\"formula\":\"%s\",\"Mstates\":%d,\"attempts\":%d,\"over_budget\":%d,\"aborted\":%d,\"truncations\":%d,\"discarded\":",
+		formula,pLoss->Mstates,pLoss->Attempts,pLoss->OverBudget,pLoss->Aborted,pLoss->TruncationTotal);
+	trace_write_number(pFile, pLoss->Discarded);
+	fprintf(pFile,",\"max_discarded\":");
+	trace_write_number(pFile, pLoss->MaxDiscarded);
+	fprintf(pFile,",\"retained\":");
+	trace_write_number(pFile, pLoss->Retained);
+	fprintf(pFile,",\"elements\":[");
+	for(element_index=0; element_index<pLoss->ElementTotal; element_index++){
+		pElement = &pLoss->Element[element_index];
+		fprintf(pFile,"%s{\"atomic_number\":%d,\"discarded\":",(0 < element_index) ? "," : "",pElement->AtomicNumber);
+		trace_write_number(pFile, pElement->Discarded);
+		fprintf(pFile,",\"max_discarded\":");
+		trace_write_number(pFile, pElement->MaxDiscarded);
+		fputc('}', pFile);
+	}
+	fprintf(pFile,"]}\n");
+}
+
+//--------------------------------------------------------
+// Budget, action and precision of the memory report
+//--------------------------------------------------------
+void isoDalton_memory_init(struct exact_mass_memory *pMemory, double Budget, int Action, int Precision){
+	memset(pMemory, 0, sizeof(struct exact_mass_memory));
+	pMemory->Budget    = Budget;
+	pMemory->Action    = Action;
+	pMemory->Precision = Precision;
+}
+
+//--------------------------------------------------------
+// Mass window of MassLow to MassHigh daltons, or of the
+// M+Offset cluster
+//--------------------------------------------------------
+void isoDalton_window_init(struct exact_mass_window *pWindow, double MassLow, double MassHigh){
+	memset(pWindow, 0, sizeof(struct exact_mass_window));
+	pWindow->MassLow       = MassLow;
+	pWindow->MassHigh      = MassHigh;
+	pWindow->NominalOffset = -1;
+}
+
+void isoDalton_window_nominal_init(struct exact_mass_window *pWindow, int Offset){
+	memset(pWindow, 0, sizeof(struct exact_mass_window));
+	pWindow->NominalOffset = Offset;
+}
+
+//--------------------------------------------------------
+// Probability bound keeping the ResultStates most
+// probable states
+//--------------------------------------------------------
+void isoDalton_bound_init(struct exact_mass_bound *pBound, int ResultStates){
+	memset(pBound, 0, sizeof(struct exact_mass_bound));
+	pBound->ResultStates = ResultStates;
+}
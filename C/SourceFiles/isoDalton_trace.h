@@ -0,0 +1,207 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT                               */
+/*-----------------------------------------------------------------------*/
+/* Description:  isoDalton_trace.h                                       */
+/*               Header file for isoDalton_trace.cpp, optional reports   */
+/*               and budgets of one computation: timing and state counts */
+/*               of the trellis, the probability discarded by its cap    */
+/*               and its peak memory                                     */
+/*-----------------------------------------------------------------------*/
+/* This software is associated with the following paper:                 */
+/* Snider,R.K. Efficient Calculation of Exact Mass Isotopic Distributions*/
+/* J Am Soc Mass Spectrom 2007, Vol 18/8 pp. 1511-1515.                  */
+/* The digital object identifier (DOI) link to the paper is:             */
+/* http://dx.doi.org/10.1016/j.jasms.2007.05.016                         */
+/*-----------------------------------------------------------------------*/
+/* Create Date:  October 2026                                            */
+/* Revision:     1.0                                                     */
+/* License:      GPL-2.0 or MIT  (opensource.org/licenses/MIT)           */
+/*-----------------------------------------------------------------------*/
+
+#ifndef ISODALTON_TRACE
+#define ISODALTON_TRACE
+
+#include <stdio.h>
+#include "isotopes.h"
+
+//---------------------------------------------------------------------------------------------
+// Stages of one trellis step (isoDalton_trellis_step_timed) and of the cap that follows it
+//---------------------------------------------------------------------------------------------
+#define TRACE_STAGE_EXPAND     0   // every state times every isotope
+#define TRACE_STAGE_MASS_SORT  1   // sort by increasing mass
+#define TRACE_STAGE_COMBINE    2   // merge equal masses
+#define TRACE_STAGE_PROB_SORT  3   // sort by decreasing probability
+#define TRACE_STAGE_TRUNCATE   4   // keep the Mstates most probable states
+#define TRACE_STAGE_TOTAL      5
+
+//---------------------------------------------------------------------------------------------
+// One trellis step (one atom)
+//---------------------------------------------------------------------------------------------
+struct trace_step {
+	int Element;     // index into exact_mass_trace.Element
+	int Atom;        // atom of that element, from 0
+	int Generated;   // states after the expansion
+	int Combined;    // states after equal masses were merged
+	int Kept;        // states after the cap at Mstates
+};
+
+//---------------------------------------------------------------------------------------------
+// One trellis element (single isotope elements are not in the trellis)
+//---------------------------------------------------------------------------------------------
+struct trace_element {
+	int    AtomicNumber;
+	int    AtomCount;
+	int    IsotopeTotal;                   // nonzero isotopes
+	double Seconds[TRACE_STAGE_TOTAL];
+	double Generated;                      // sums over the atoms of the element
+	double Combined;
+	double Kept;
+};
+
+//---------------------------------------------------------------------------------------------
+// Instrumentation of one isoDalton_exact_mass_traced call.  Times are monotonic wall times.
+// The structure is reset by every call and the step array is reused, so one trace can be
+// passed to any number of calls.
+//---------------------------------------------------------------------------------------------
+struct exact_mass_trace {
+	int    Mstates;
+	int    log10flag;
+	double TotalSeconds;                   // the whole call
+	double SetupSeconds;                   // element ordering and allocation before the trellis
+	double Seconds[TRACE_STAGE_TOTAL];     // sums over all steps
+	int    ElementTotal;
+	struct trace_element Element[ELEMENT_TOTAL];
+	int    StepTotal;
+	int    StepCapacity;
+	struct trace_step *Step;
+};
+
+//---------------------------------------------------------------------------------------------
+// Probability discarded by the cap at Mstates.  Combining equal masses keeps the probability
+// of the merged states, so all of the loss happens at the truncations.  Probabilities are
+// fractions of the total probability of the molecule (the trellis starts from 1, before the
+// single isotope elements are applied).  No peak of the result is underestimated by more than
+// Discarded; MaxDiscarded is the most probable state that was dropped.
+//---------------------------------------------------------------------------------------------
+#define LOSS_ACTION_REPORT 0   // compute with Mstates and report the loss
+#define LOSS_ACTION_ABORT  1   // stop the trellis as soon as the loss is over Budget
+#define LOSS_ACTION_GROW   2   // double Mstates, up to MaxStates, until the loss is within Budget
+
+struct loss_element {
+	int    AtomicNumber;
+	double Discarded;
+	double MaxDiscarded;
+};
+
+struct exact_mass_loss {
+	double Budget;            // set by the caller: largest allowed Discarded, 0 = no budget
+	int    Action;            // set by the caller: LOSS_ACTION_*
+	int    MaxStates;         // set by the caller: largest Mstates of LOSS_ACTION_GROW (the
+	                          // result must hold this many states)
+	int    Mstates;           // Mstates of the returned result
+	int    Attempts;          // computations run, more than 1 only with LOSS_ACTION_GROW
+	int    OverBudget;        // 1 = Discarded is over Budget
+	int    Aborted;           // 1 = the trellis was stopped and the result has no states
+	int    TruncationTotal;   // steps that discarded states
+	double Discarded;
+	double MaxDiscarded;
+	double Retained;          // probability of the returned states
+	int    ElementTotal;
+	struct loss_element Element[ELEMENT_TOTAL];
+};
+
+//---------------------------------------------------------------------------------------------
+// Peak memory of the trellis: Mstates*maxNisotopes states, where maxNisotopes is the largest
+// isotope count in the molecule, of 16 bytes (two doubles) or of the packed records of
+// isoDalton_compact.h, plus the isotopes of one element (isoDalton_exact_mass_peak_bytes gives
+// it for doubles without computing).  Bytes are doubles so that sizes over 4 GB can be given
+// on 32 bit systems.
+//---------------------------------------------------------------------------------------------
+#define MEMORY_ACTION_REFUSE        0   // compute nothing if Mstates does not fit in Budget
+#define MEMORY_ACTION_FIT           1   // lower Mstates to the largest that fits in Budget
+#define MEMORY_ACTION_FIT_PRECISION 2   // go from full to compact precision and then, if
+                                        // still needed, lower Mstates
+
+struct exact_mass_memory {
+	double Budget;            // set by the caller: largest peak bytes, 0 = no budget
+	int    Action;            // set by the caller: MEMORY_ACTION_*
+	int    Precision;         // set by the caller and updated: STATE_PRECISION_* used
+	double RequestedBytes;    // peak bytes the requested Mstates needs
+	double PeakBytes;         // peak bytes of the computation (0 if refused)
+	int    Mstates;           // Mstates of the computation
+	int    Fitted;            // 1 = Mstates was lowered to fit
+	int    Refused;           // 1 = nothing was computed and the result has no states
+};
+
+//---------------------------------------------------------------------------------------------
+// Mass window.  Only the states of MassLow to MassHigh daltons are wanted: after every step the
+// states whose mass, plus the lightest or heaviest mass the atoms still to add can give, can no
+// longer land in the window are dropped, so Mstates is spent on the window alone.  With
+// NominalOffset k >= 0 the window is the M+k cluster, the lightest mass of the molecule plus k
+// (+-WINDOW_NOMINAL_HALF_WIDTH), and MassLow and MassHigh are set to it.  The window is applied
+// by the in memory trellis of full precision states, which is used whenever it is given:
+// pExternal, pClusters and the precision of pMemory are then not used, and the result has up
+// to Mstates states.
+//---------------------------------------------------------------------------------------------
+#define WINDOW_NOMINAL_HALF_WIDTH 0.5
+
+struct exact_mass_window {
+	double MassLow;          // set by the caller (or from NominalOffset): daltons
+	double MassHigh;
+	int    NominalOffset;    // set by the caller: k of the M+k window, -1 = MassLow to MassHigh
+	double Outside;          // probability of the states dropped as out of reach
+	int    DroppedTotal;     // states dropped as out of reach
+};
+
+//---------------------------------------------------------------------------------------------
+// Probability bound.  Only the ResultStates most probable states are wanted.  Once the atoms of
+// an element are all added, a state of log10 probability p is a composition of the elements so
+// far and can at best become p plus the most probable compositions (multinomial modes) of the
+// elements still to add, and that completion exists.  So the ResultStates-th largest such
+// completion is a lower bound (Cutoff) on the last wanted state, and at the end of each element
+// the states whose best completion is below the highest Cutoff so far are dropped: they cannot
+// reach the result (unless their mass coincides with another composition).  It is not used
+// with a mass window, whose states may complete outside it, and it runs on the in memory
+// trellis of full precision states: pExternal, pClusters and the precision of pMemory are then
+// not used, and the result has up to Mstates states.
+//---------------------------------------------------------------------------------------------
+#define BOUND_SLACK 1e-12   // log10 margin for rounding
+
+struct exact_mass_bound {
+	int    ResultStates;   // set by the caller: states wanted, 0 = Mstates
+	double Cutoff;         // log10 lower bound on the probability of the last wanted state
+	double Pruned;         // probability of the states dropped by the bound
+	int    PrunedTotal;    // states dropped by the bound
+	int    LargestStep;    // most states kept after one atom
+};
+
+//---------------------------------------------------------------------------------------------
+// Reports and budgets of isoDalton_exact_mass_report (a NULL pointer turns one off)
+//---------------------------------------------------------------------------------------------
+struct exact_mass_reports {
+	struct exact_mass_trace    *pTrace;
+	struct exact_mass_loss     *pLoss;
+	struct exact_mass_memory   *pMemory;
+	struct exact_mass_external *pExternal;   // states in spill files (isoDalton_external.h)
+	struct exact_mass_clusters *pClusters;   // states by nominal mass cluster (isoDalton_cluster.h)
+	struct exact_mass_window   *pWindow;     // only the states of a mass window
+	struct exact_mass_bound    *pBound;      // only the most probable states, pruned by bound
+	struct exact_mass_schedule *pSchedule;   // element order by cost model (isoDalton_schedule.h)
+};
+
+void isoDalton_trace_init(struct exact_mass_trace *);
+void isoDalton_trace_free(struct exact_mass_trace *);
+void isoDalton_trace_reset(struct exact_mass_trace *, int, int);
+int  isoDalton_trace_add_element(struct exact_mass_trace *, int, int, int);
+void isoDalton_trace_add_step(struct exact_mass_trace *, int, int, int, int, int, double *);
+const char *isoDalton_trace_stage_name(int);
+void isoDalton_trace_write_json(struct exact_mass_trace *, const char *, FILE *);
+void isoDalton_trace_write_csv_header(FILE *);
+void isoDalton_trace_write_csv(struct exact_mass_trace *, const char *, FILE *);
+void isoDalton_loss_init(struct exact_mass_loss *, double, int, int);
+void isoDalton_loss_write_json(struct exact_mass_loss *, const char *, FILE *);
+void isoDalton_memory_init(struct exact_mass_memory *, double, int, int);
+void isoDalton_window_init(struct exact_mass_window *, double, double);
+void isoDalton_window_nominal_init(struct exact_mass_window *, int);
+void isoDalton_bound_init(struct exact_mass_bound *, int);
+
+#endif